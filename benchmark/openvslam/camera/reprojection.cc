@@ -0,0 +1,78 @@
+#include "openvslam/camera/equirectangular.h"
+#include "openvslam/camera/perspective.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+
+using namespace openvslam;
+
+static std::unique_ptr<camera::base> create_camera(const int model) {
+  if (model == 0) {
+    return std::unique_ptr<camera::base>(new camera::perspective(
+        "perspective", camera::setup_type_t::Monocular,
+        camera::color_order_t::Gray, 640, 480, 30.0, 500.0, 500.0, 320.0,
+        240.0, 0.0, 0.0, 0.0, 0.0, 0.0));
+  } else {
+    return std::unique_ptr<camera::base>(new camera::equirectangular(
+        "equirectangular", camera::color_order_t::RGB, 1920, 960, 30.0));
+  }
+}
+
+static eigen_alloc_vector<Vec3_t> create_points(const unsigned int num_pts) {
+  std::mt19937 mt(0);
+  std::uniform_real_distribution<> rand_xy(-10.0, 10.0);
+  std::uniform_real_distribution<> rand_z(1.0, 30.0);
+  eigen_alloc_vector<Vec3_t> pos_ws(num_pts);
+  for (auto& pos_w : pos_ws) {
+    pos_w = Vec3_t{rand_xy(mt), rand_xy(mt), rand_z(mt)};
+  }
+  return pos_ws;
+}
+
+// state.range(0): camera model (0: perspective, 1: equirectangular)
+// state.range(1): number of points
+static void BM_camera_reproject_to_image(benchmark::State& state) {
+  const auto camera = create_camera(state.range(0));
+  const auto pos_ws = create_points(state.range(1));
+  const Mat33_t rot_cw = Mat33_t::Identity();
+  const Vec3_t trans_cw = Vec3_t::Zero();
+
+  eigen_alloc_vector<Vec2_t> reprojs(pos_ws.size());
+  std::vector<float> x_rights(pos_ws.size());
+  std::vector<unsigned char> in_image(pos_ws.size());
+  for (auto _ : state) {
+    for (unsigned int i = 0; i < pos_ws.size(); ++i) {
+      in_image[i] = camera->reproject_to_image(rot_cw, trans_cw, pos_ws[i],
+                                               reprojs[i], x_rights[i]);
+    }
+    benchmark::DoNotOptimize(in_image.data());
+  }
+  state.SetItemsProcessed(state.iterations() * pos_ws.size());
+}
+BENCHMARK(BM_camera_reproject_to_image)
+    ->Args({0, 10000})
+    ->Args({1, 10000})
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_camera_reproject_points_to_image(benchmark::State& state) {
+  const auto camera = create_camera(state.range(0));
+  const auto pos_ws = create_points(state.range(1));
+  const Mat33_t rot_cw = Mat33_t::Identity();
+  const Vec3_t trans_cw = Vec3_t::Zero();
+
+  eigen_alloc_vector<Vec2_t> reprojs;
+  std::vector<float> x_rights;
+  std::vector<unsigned char> in_image;
+  for (auto _ : state) {
+    camera->reproject_points_to_image(rot_cw, trans_cw, pos_ws, reprojs,
+                                      x_rights, in_image);
+    benchmark::DoNotOptimize(in_image.data());
+  }
+  state.SetItemsProcessed(state.iterations() * pos_ws.size());
+}
+BENCHMARK(BM_camera_reproject_points_to_image)
+    ->Args({0, 10000})
+    ->Args({1, 10000})
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,124 @@
+#include "openvslam/data/bow_vocabulary.h"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <thread>
+
+#include "openvslam/data/speculative_bow.h"
+#include "openvslam/feature/orb_extractor.h"
+
+#ifdef USE_DBOW2
+#include <DBoW2/BowVector.h>
+#include <DBoW2/FeatureVector.h>
+#else
+#include <fbow/bow_feat_vector.h>
+#include <fbow/bow_vector.h>
+#endif
+
+using namespace openvslam;
+
+namespace {
+
+// the benchmarks are run with the backend selected by BOW_FRAMEWORK
+#ifdef USE_DBOW2
+const char* const bow_framework_name = "DBoW2";
+#else
+const char* const bow_framework_name = "FBoW";
+#endif
+
+//! Load the vocabulary from BOW_VOCAB once in the process
+std::shared_ptr<data::bow_vocabulary> get_bow_vocab() {
+  static const auto bow_vocab = []() {
+    const auto vocab_file_path_env = std::getenv("BOW_VOCAB");
+    if (vocab_file_path_env == nullptr) {
+      return std::shared_ptr<data::bow_vocabulary>(nullptr);
+    }
+    return data::bow_vocabulary_util::load_vocabulary(vocab_file_path_env);
+  }();
+  return bow_vocab;
+}
+
+//! Extract the descriptors from the test image
+cv::Mat extract_descriptors(const unsigned int max_num_keypts) {
+  const auto params = feature::orb_params("ORB setting for benchmark");
+  auto extractor = feature::orb_extractor(&params, max_num_keypts);
+  const auto img =
+      cv::imread(std::string(TEST_DATA_DIR) + "./equirectangular_image_001.jpg",
+                 cv::IMREAD_GRAYSCALE);
+  std::vector<cv::KeyPoint> keypts;
+  cv::Mat desc;
+  if (!img.empty()) {
+    extractor.extract(img, cv::Mat(), keypts, desc);
+  }
+  return desc;
+}
+
+}  // unnamed namespace
+
+static void BM_bow_vocabulary_compute_bow(benchmark::State& state) {
+  const auto bow_vocab = get_bow_vocab();
+  if (!bow_vocab) {
+    state.SkipWithError("BOW_VOCAB is not set or wrong");
+    return;
+  }
+  const auto desc = extract_descriptors(state.range(0));
+  if (desc.empty()) {
+    state.SkipWithError("cannot load the test image");
+    return;
+  }
+
+  data::bow_vector bow_vec;
+  data::bow_feature_vector bow_feat_vec;
+  for (auto _ : state) {
+    data::bow_vocabulary_util::compute_bow(bow_vocab.get(), desc, bow_vec,
+                                           bow_feat_vec);
+    benchmark::DoNotOptimize(bow_vec);
+  }
+  state.SetLabel(bow_framework_name);
+  state.counters["num_keypts"] = desc.rows;
+  state.counters["num_words"] = bow_vec.size();
+}
+BENCHMARK(BM_bow_vocabulary_compute_bow)
+    ->Arg(1000)
+    ->Arg(2000)
+    ->Arg(4000)
+    ->Unit(benchmark::kMicrosecond);
+
+// time which the tracking thread spends on BoW when the result of the
+// speculative worker is consumed after the given delay
+static void BM_bow_vocabulary_speculative_bow(benchmark::State& state) {
+  const auto bow_vocab = get_bow_vocab();
+  if (!bow_vocab) {
+    state.SkipWithError("BOW_VOCAB is not set or wrong");
+    return;
+  }
+  const auto desc = extract_descriptors(2000);
+  if (desc.empty()) {
+    state.SkipWithError("cannot load the test image");
+    return;
+  }
+
+  data::speculative_bow_worker worker(bow_vocab.get());
+  data::bow_vector bow_vec;
+  data::bow_feature_vector bow_feat_vec;
+  for (auto _ : state) {
+    state.PauseTiming();
+    const auto speculative_bow = worker.request(desc);
+    // tracking runs in the meantime
+    std::this_thread::sleep_for(std::chrono::milliseconds(state.range(0)));
+    state.ResumeTiming();
+    speculative_bow->get(bow_vocab.get(), bow_vec, bow_feat_vec);
+    benchmark::DoNotOptimize(bow_vec);
+  }
+  state.SetLabel(bow_framework_name);
+}
+BENCHMARK(BM_bow_vocabulary_speculative_bow)
+    ->Arg(0)
+    ->Arg(5)
+    ->Arg(20)
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,59 @@
+#include "openvslam/feature/orb_extractor.h"
+
+#include <benchmark/benchmark.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+using namespace openvslam;
+
+static void BM_orb_extractor_extract(benchmark::State& state) {
+  const auto params = feature::orb_params("ORB setting for benchmark");
+  auto extractor = feature::orb_extractor(&params, state.range(0));
+
+  const auto img =
+      cv::imread(std::string(TEST_DATA_DIR) + "./equirectangular_image_001.jpg",
+                 cv::IMREAD_GRAYSCALE);
+  if (img.empty()) {
+    state.SkipWithError("cannot load the test image");
+    return;
+  }
+  const auto mask = cv::Mat();
+
+  std::vector<cv::KeyPoint> keypts;
+  cv::Mat desc;
+  for (auto _ : state) {
+    extractor.extract(img, mask, keypts, desc);
+    benchmark::DoNotOptimize(desc.data);
+  }
+  state.counters["num_keypts"] = keypts.size();
+}
+BENCHMARK(BM_orb_extractor_extract)
+    ->Arg(1000)
+    ->Arg(2000)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_orb_extractor_extract_with_mask(benchmark::State& state) {
+  const auto params = feature::orb_params("ORB setting for benchmark");
+  // mask (Mask the top and bottom 20%)
+  auto extractor = feature::orb_extractor(
+      &params, 2000, {{0.0, 0.2, 0.0, 1.0}, {0.8, 1.0, 0.0, 1.0}});
+
+  const auto img =
+      cv::imread(std::string(TEST_DATA_DIR) + "./equirectangular_image_002.jpg",
+                 cv::IMREAD_GRAYSCALE);
+  if (img.empty()) {
+    state.SkipWithError("cannot load the test image");
+    return;
+  }
+  const auto mask = cv::Mat();
+
+  std::vector<cv::KeyPoint> keypts;
+  cv::Mat desc;
+  for (auto _ : state) {
+    extractor.extract(img, mask, keypts, desc);
+    benchmark::DoNotOptimize(desc.data);
+  }
+  state.counters["num_keypts"] = keypts.size();
+}
+BENCHMARK(BM_orb_extractor_extract_with_mask)->Unit(benchmark::kMillisecond);
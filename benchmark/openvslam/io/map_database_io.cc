@@ -0,0 +1,98 @@
+#include "openvslam/io/map_database_io.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "helper/scene.h"
+#include "openvslam/data/bow_database.h"
+#include "openvslam/data/bow_vocabulary.h"
+#include "openvslam/data/camera_database.h"
+#include "openvslam/data/keyframe.h"
+#include "openvslam/data/map_database.h"
+#include "openvslam/data/orb_params_database.h"
+
+using namespace openvslam;
+
+static void BM_map_database_io_save(benchmark::State& state) {
+  synthetic_scene scene(state.range(0), state.range(1));
+  data::camera_database cam_db(scene.camera_.get());
+  data::orb_params_database orb_params_db(scene.orb_params_.get());
+
+  io::map_database_io map_db_io(&cam_db, &orb_params_db, scene.map_db_.get(),
+                                nullptr, nullptr);
+  const std::string path = "bench_map_database_io.msg";
+  for (auto _ : state) {
+    map_db_io.save_message_pack(path);
+  }
+  std::remove(path.c_str());
+}
+BENCHMARK(BM_map_database_io_save)
+    ->Args({20, 4000})
+    ->Args({100, 20000})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_map_database_io_load(benchmark::State& state) {
+  // loading requires a vocabulary to compute BoW of the keyframes
+  const auto vocab_file_path_env = std::getenv("BOW_VOCAB");
+  if (vocab_file_path_env == nullptr) {
+    state.SkipWithError("BOW_VOCAB is not set");
+    return;
+  }
+#ifdef USE_DBOW2
+  auto bow_vocab = std::unique_ptr<data::bow_vocabulary>(
+      new data::bow_vocabulary());
+  try {
+    bow_vocab->loadFromBinaryFile(vocab_file_path_env);
+  } catch (const std::exception&) {
+    state.SkipWithError("wrong path to vocabulary");
+    return;
+  }
+#else
+  auto bow_vocab = std::unique_ptr<data::bow_vocabulary>(
+      new fbow::Vocabulary());
+  bow_vocab->readFromFile(vocab_file_path_env);
+  if (!bow_vocab->isValid()) {
+    state.SkipWithError("wrong path to vocabulary");
+    return;
+  }
+#endif
+
+  synthetic_scene scene(state.range(0), state.range(1));
+  // the BoW stored in the map is used instead of computing it
+  if (state.range(2)) {
+    for (const auto& keyfrm : scene.keyfrms_) {
+      keyfrm->compute_bow(bow_vocab.get());
+    }
+  }
+  const std::string path = "bench_map_database_io.msg";
+  {
+    data::camera_database cam_db(scene.camera_.get());
+    data::orb_params_database orb_params_db(scene.orb_params_.get());
+    io::map_database_io map_db_io(&cam_db, &orb_params_db,
+                                  scene.map_db_.get(), nullptr, nullptr);
+    map_db_io.save_message_pack(path);
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    data::camera_database cam_db(scene.camera_.get());
+    data::orb_params_database orb_params_db(scene.orb_params_.get());
+    data::map_database map_db;
+    data::bow_database bow_db(bow_vocab.get());
+    io::map_database_io map_db_io(&cam_db, &orb_params_db, &map_db, &bow_db,
+                                  bow_vocab.get());
+    state.ResumeTiming();
+    map_db_io.load_message_pack(path);
+  }
+  std::remove(path.c_str());
+}
+BENCHMARK(BM_map_database_io_load)
+    ->Args({20, 4000, 0})
+    ->Args({20, 4000, 1})
+    ->Args({100, 20000, 0})
+    ->Args({100, 20000, 1})
+    ->ArgNames({"num_keyfrms", "num_lms", "stored_bow"})
+    ->Unit(benchmark::kMillisecond);
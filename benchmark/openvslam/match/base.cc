@@ -0,0 +1,35 @@
+#include "openvslam/match/base.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include <opencv2/core.hpp>
+
+using namespace openvslam;
+
+static void BM_compute_descriptor_distance_32(benchmark::State& state) {
+  const unsigned int num_descs = 1024;
+  std::mt19937 mt(0);
+  std::uniform_int_distribution<int> rand_byte(0, 255);
+  cv::Mat descs(num_descs, 32, CV_8U);
+  for (unsigned int i = 0; i < num_descs; ++i) {
+    for (unsigned int j = 0; j < 32; ++j) {
+      descs.at<uchar>(i, j) = static_cast<uchar>(rand_byte(mt));
+    }
+  }
+
+  // compute the distances of all the pairs
+  for (auto _ : state) {
+    unsigned int sum = 0;
+    for (unsigned int i = 0; i < num_descs; ++i) {
+      const auto desc_1 = descs.row(i);
+      for (unsigned int j = 0; j < num_descs; ++j) {
+        sum += match::compute_descriptor_distance_32(desc_1, descs.row(j));
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * num_descs * num_descs);
+}
+BENCHMARK(BM_compute_descriptor_distance_32)->Unit(benchmark::kMillisecond);
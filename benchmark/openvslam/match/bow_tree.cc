@@ -0,0 +1,54 @@
+#include "openvslam/match/bow_tree.h"
+
+#include <benchmark/benchmark.h>
+
+#include "helper/scene.h"
+#include "openvslam/data/frame.h"
+#include "openvslam/data/keyframe.h"
+
+using namespace openvslam;
+
+static void BM_bow_tree_match_frame_and_keyframe(benchmark::State& state) {
+  synthetic_scene scene(10, state.range(0));
+
+  std::vector<unsigned int> lm_indices;
+  auto curr_frm = scene.create_frame(
+      scene.get_cam_pose(scene.keyfrm_xs_.back() + 0.1), lm_indices);
+  const auto& keyfrm = scene.keyfrms_.back();
+
+  const match::bow_tree bow_matcher(0.7, true);
+  std::vector<std::shared_ptr<data::landmark>> matched_lms_in_frm;
+  unsigned int num_matches = 0;
+  for (auto _ : state) {
+    num_matches = bow_matcher.match_frame_and_keyframe(keyfrm, curr_frm,
+                                                       matched_lms_in_frm);
+    benchmark::DoNotOptimize(num_matches);
+  }
+  state.counters["num_keypts"] = curr_frm.frm_obs_.num_keypts_;
+  state.counters["num_matches"] = num_matches;
+}
+BENCHMARK(BM_bow_tree_match_frame_and_keyframe)
+    ->Arg(2000)
+    ->Arg(8000)
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_bow_tree_match_keyframes(benchmark::State& state) {
+  synthetic_scene scene(10, state.range(0));
+
+  const auto& keyfrm_1 = scene.keyfrms_.front();
+  const auto& keyfrm_2 = scene.keyfrms_.back();
+
+  const match::bow_tree bow_matcher(0.9, true);
+  std::vector<std::shared_ptr<data::landmark>> matched_lms_in_keyfrm_1;
+  unsigned int num_matches = 0;
+  for (auto _ : state) {
+    num_matches = bow_matcher.match_keyframes(keyfrm_1, keyfrm_2,
+                                              matched_lms_in_keyfrm_1);
+    benchmark::DoNotOptimize(num_matches);
+  }
+  state.counters["num_matches"] = num_matches;
+}
+BENCHMARK(BM_bow_tree_match_keyframes)
+    ->Arg(2000)
+    ->Arg(8000)
+    ->Unit(benchmark::kMicrosecond);
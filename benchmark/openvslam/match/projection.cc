@@ -0,0 +1,96 @@
+#include "openvslam/match/projection.h"
+
+#include <benchmark/benchmark.h>
+
+#include "helper/scene.h"
+#include "openvslam/data/frame.h"
+#include "openvslam/data/landmark.h"
+#include "openvslam/data/landmark_snapshot.h"
+
+using namespace openvslam;
+
+static void BM_projection_match_frame_and_landmarks(benchmark::State& state) {
+  synthetic_scene scene(10, state.range(0));
+
+  // the current frame is located just after the last keyframe
+  std::vector<unsigned int> lm_indices;
+  const auto curr_frm_orig = scene.create_frame(
+      scene.get_cam_pose(scene.keyfrm_xs_.back() + 0.1), lm_indices);
+
+  // find the landmarks which are observable from the current frame
+  std::vector<std::shared_ptr<data::landmark>> local_landmarks;
+  eigen_alloc_unord_map<unsigned int, Vec2_t> lm_to_reproj;
+  std::unordered_map<unsigned int, float> lm_to_x_right;
+  std::unordered_map<unsigned int, int> lm_to_scale;
+  for (const auto& lm : scene.lms_) {
+    if (!lm) {
+      continue;
+    }
+    Vec2_t reproj;
+    float x_right;
+    unsigned int pred_scale_level;
+    if (curr_frm_orig.can_observe(lm, 0.5, reproj, x_right,
+                                  pred_scale_level)) {
+      local_landmarks.push_back(lm);
+      lm_to_reproj[lm->id_] = reproj;
+      lm_to_x_right[lm->id_] = x_right;
+      lm_to_scale[lm->id_] = pred_scale_level;
+    }
+  }
+
+  const match::projection projection_matcher(0.8);
+  unsigned int num_matches = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto curr_frm = curr_frm_orig;
+    state.ResumeTiming();
+    num_matches = projection_matcher.match_frame_and_landmarks(
+        curr_frm, local_landmarks, lm_to_reproj, lm_to_x_right, lm_to_scale,
+        5.0);
+    benchmark::DoNotOptimize(num_matches);
+  }
+  state.counters["num_local_landmarks"] = local_landmarks.size();
+  state.counters["num_matches"] = num_matches;
+}
+BENCHMARK(BM_projection_match_frame_and_landmarks)
+    ->Arg(2000)
+    ->Arg(8000)
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_projection_match_frame_and_landmark_snapshot(
+    benchmark::State& state) {
+  synthetic_scene scene(10, state.range(0));
+
+  std::vector<unsigned int> lm_indices;
+  const auto curr_frm_orig = scene.create_frame(
+      scene.get_cam_pose(scene.keyfrm_xs_.back() + 0.1), lm_indices);
+
+  std::vector<std::shared_ptr<data::landmark>> local_landmarks;
+  for (const auto& lm : scene.lms_) {
+    if (lm) {
+      local_landmarks.push_back(lm);
+    }
+  }
+  data::landmark_snapshot snapshot;
+  snapshot.build(local_landmarks);
+
+  // the visibility check is included in the measurement
+  const match::projection projection_matcher(0.8);
+  const std::unordered_set<unsigned int> excluded_ids;
+  unsigned int num_matches = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto curr_frm = curr_frm_orig;
+    state.ResumeTiming();
+    snapshot.cull(curr_frm, 0.5, excluded_ids);
+    num_matches =
+        projection_matcher.match_frame_and_landmarks(curr_frm, snapshot, 5.0);
+    benchmark::DoNotOptimize(num_matches);
+  }
+  state.counters["num_local_landmarks"] = snapshot.size();
+  state.counters["num_matches"] = num_matches;
+}
+BENCHMARK(BM_projection_match_frame_and_landmark_snapshot)
+    ->Arg(2000)
+    ->Arg(8000)
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,44 @@
+#include "openvslam/optimize/local_bundle_adjuster.h"
+
+#include <benchmark/benchmark.h>
+
+#include "helper/scene.h"
+#include "openvslam/data/keyframe.h"
+#include "openvslam/data/landmark.h"
+
+using namespace openvslam;
+
+static void BM_local_bundle_adjuster_optimize(benchmark::State& state) {
+  synthetic_scene scene(state.range(0), state.range(1));
+
+  // store the initial state to restore it in each iteration
+  eigen_alloc_vector<Mat44_t> keyfrm_poses;
+  for (const auto& keyfrm : scene.keyfrms_) {
+    keyfrm_poses.push_back(keyfrm->get_cam_pose());
+  }
+  eigen_alloc_vector<Vec3_t> lm_positions;
+  for (const auto& lm : scene.lms_) {
+    lm_positions.push_back(lm ? lm->get_pos_in_world() : Vec3_t::Zero());
+  }
+
+  const optimize::local_bundle_adjuster local_bundle_adjuster;
+  bool force_stop_flag = false;
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (unsigned int i = 0; i < scene.keyfrms_.size(); ++i) {
+      scene.keyfrms_.at(i)->set_cam_pose(keyfrm_poses.at(i));
+    }
+    for (unsigned int i = 0; i < scene.lms_.size(); ++i) {
+      if (scene.lms_.at(i)) {
+        scene.lms_.at(i)->set_pos_in_world(lm_positions.at(i));
+      }
+    }
+    state.ResumeTiming();
+    local_bundle_adjuster.optimize(scene.map_db_.get(), scene.keyfrms_.back(),
+                                   &force_stop_flag);
+  }
+}
+BENCHMARK(BM_local_bundle_adjuster_optimize)
+    ->Args({10, 2000})
+    ->Args({20, 4000})
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,40 @@
+#include "openvslam/optimize/pose_optimizer.h"
+
+#include <benchmark/benchmark.h>
+
+#include "helper/scene.h"
+#include "openvslam/data/frame.h"
+
+using namespace openvslam;
+
+static void BM_pose_optimizer_optimize(benchmark::State& state) {
+  synthetic_scene scene(10, state.range(0));
+
+  // associate the keypoints of the current frame with the ground-truth
+  // landmarks
+  std::vector<unsigned int> lm_indices;
+  auto curr_frm_orig = scene.create_frame(
+      scene.get_cam_pose(scene.keyfrm_xs_.back() + 0.1), lm_indices);
+  for (unsigned int idx = 0; idx < lm_indices.size(); ++idx) {
+    curr_frm_orig.landmarks_.at(idx) = scene.lms_.at(lm_indices.at(idx));
+  }
+  // perturb the initial pose
+  Mat44_t init_cam_pose_cw = curr_frm_orig.get_cam_pose();
+  init_cam_pose_cw.block<3, 1>(0, 3) += Vec3_t{0.05, -0.03, 0.04};
+  curr_frm_orig.set_cam_pose(init_cam_pose_cw);
+
+  const optimize::pose_optimizer optimizer;
+  unsigned int num_valid_obs = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto curr_frm = curr_frm_orig;
+    state.ResumeTiming();
+    num_valid_obs = optimizer.optimize(curr_frm);
+    benchmark::DoNotOptimize(num_valid_obs);
+  }
+  state.counters["num_valid_obs"] = num_valid_obs;
+}
+BENCHMARK(BM_pose_optimizer_optimize)
+    ->Arg(1000)
+    ->Arg(4000)
+    ->Unit(benchmark::kMicrosecond);
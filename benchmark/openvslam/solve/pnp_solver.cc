@@ -0,0 +1,48 @@
+#include "openvslam/solve/pnp_solver.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include "helper/bearing_vector.h"
+#include "helper/landmark.h"
+#include "openvslam/util/converter.h"
+
+using namespace openvslam;
+
+static void BM_pnp_solver_find_via_ransac(benchmark::State& state) {
+  const unsigned int num_landmarks = state.range(0);
+  const double outlier_ratio = state.range(1) / 100.0;
+
+  const auto landmarks = create_random_landmarks_in_space(num_landmarks, 100);
+  const Mat33_t rot_gt = util::converter::to_rot_mat(
+      97.37 * M_PI / 180 * Vec3_t{9.0, -8.5, 1.1}.normalized());
+  const Vec3_t trans_gt = Vec3_t(-67.5, 84.6, -68.0);
+
+  eigen_alloc_vector<Vec3_t> bearings;
+  create_bearing_vectors(rot_gt, trans_gt, landmarks, bearings, 0.001);
+
+  // replace a part of the bearings with random directions
+  std::mt19937 mt(0);
+  std::uniform_real_distribution<> rand(-1.0, 1.0);
+  const auto num_outliers =
+      static_cast<unsigned int>(outlier_ratio * num_landmarks);
+  for (unsigned int i = 0; i < num_outliers; ++i) {
+    bearings.at(i) = Vec3_t{rand(mt), rand(mt), rand(mt)}.normalized();
+  }
+
+  std::vector<cv::KeyPoint> keypts(num_landmarks);
+  const std::vector<float> scale_factors{1.0};
+
+  for (auto _ : state) {
+    solve::pnp_solver solver(bearings, keypts, landmarks, scale_factors, 10,
+                             true);
+    solver.find_via_ransac(30);
+    benchmark::DoNotOptimize(solver.solution_is_valid());
+  }
+}
+BENCHMARK(BM_pnp_solver_find_via_ransac)
+    ->Args({100, 0})
+    ->Args({100, 30})
+    ->Args({500, 30})
+    ->Unit(benchmark::kMicrosecond);
@@ -39,6 +39,8 @@ void mono_localization(const std::shared_ptr<openvslam::config>& cfg,
 
   // build a SLAM system
   openvslam::system SLAM(cfg, vocab_file_path);
+  // the frames are read into new buffers, so they are shared with the viewer
+  SLAM.enable_image_sharing();
   // load the prebuilt map
   SLAM.load_map_database(map_db_path);
   // startup the SLAM process (it does not need initialization of a map)
@@ -69,7 +71,6 @@ void mono_localization(const std::shared_ptr<openvslam::config>& cfg,
     return;
   }
 
-  cv::Mat frame;
   double timestamp = 0.0;
   std::vector<double> track_times;
 
@@ -84,6 +85,8 @@ void mono_localization(const std::shared_ptr<openvslam::config>& cfg,
         break;
       }
 
+      // the frame is shared with the viewer, so it is read into a new buffer
+      cv::Mat frame;
       is_not_end = video.read(frame);
       if (frame.empty()) {
         continue;
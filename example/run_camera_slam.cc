@@ -39,6 +39,8 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
 
   // build a SLAM system
   openvslam::system SLAM(cfg, vocab_file_path);
+  // the frames are read into new buffers, so they are shared with the viewer
+  SLAM.enable_image_sharing();
   // startup the SLAM process
   SLAM.startup();
 
@@ -61,7 +63,6 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
     return;
   }
 
-  cv::Mat frame;
   double timestamp = 0.0;
   std::vector<double> track_times;
 
@@ -76,6 +77,8 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
         break;
       }
 
+      // the frame is shared with the viewer, so it is read into a new buffer
+      cv::Mat frame;
       is_not_end = video.read(frame);
       if (frame.empty()) {
         continue;
@@ -142,6 +145,8 @@ void stereo_tracking(const std::shared_ptr<openvslam::config>& cfg,
                            : cv::imread(mask_img_path, cv::IMREAD_GRAYSCALE);
   // build a SLAM system
   openvslam::system SLAM(cfg, vocab_file_path);
+  // the frames are read into new buffers, so they are shared with the viewer
+  SLAM.enable_image_sharing();
   // startup the SLAM process
   SLAM.startup();
 
@@ -169,8 +174,6 @@ void stereo_tracking(const std::shared_ptr<openvslam::config>& cfg,
 
   const openvslam::util::stereo_rectifier rectifier(cfg);
 
-  cv::Mat frames[2];
-  cv::Mat frames_rectified[2];
   double timestamp = 0.0;
   std::vector<double> track_times;
   unsigned int num_frame = 0;
@@ -184,6 +187,10 @@ void stereo_tracking(const std::shared_ptr<openvslam::config>& cfg,
         break;
       }
 
+      // the frames are shared with the viewer, so they are read into new
+      // buffers
+      cv::Mat frames[2];
+      cv::Mat frames_rectified[2];
       is_not_end = videos[0].read(frames[0]) && videos[1].read(frames[1]);
       if (frames[0].empty() || frames[1].empty()) {
         continue;
@@ -1,4 +1,6 @@
+#include "util/benchmark_util.h"
 #include "util/euroc_util.h"
+#include "util/prefetch_reader.h"
 
 #ifdef USE_PANGOLIN_VIEWER
 #include "pangolin_viewer/viewer.h"
@@ -20,7 +22,6 @@
 
 #include "openvslam/config.h"
 #include "openvslam/system.h"
-#include "openvslam/util/image_converter.h"
 #include "openvslam/util/stereo_rectifier.h"
 #include "openvslam/util/yaml.h"
 
@@ -37,7 +38,9 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
                    const std::string& sequence_dir_path,
                    const unsigned int frame_skip, const bool no_sleep,
                    const bool auto_term, const bool eval_log,
-                   const std::string& map_db_path, const bool equal_hist) {
+                   const std::string& map_db_path, const bool equal_hist,
+                   const std::string& benchmark_path,
+                   const std::string& feature_stream_path) {
   const euroc_sequence sequence(sequence_dir_path);
   const auto frames = sequence.get_frames();
 
@@ -45,6 +48,10 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
   openvslam::system SLAM(cfg, vocab_file_path);
   // startup the SLAM process
   SLAM.startup();
+  if (!feature_stream_path.empty()) {
+    // record the extracted features to replay them with run_replay_slam
+    SLAM.start_feature_stream_recording(feature_stream_path);
+  }
 
   // create a viewer object
   // and pass the frame_publisher and the map_publisher
@@ -61,32 +68,50 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
   std::vector<double> track_times;
   track_times.reserve(frames.size());
 
+  // decode the images ahead of the tracking in background threads
+  std::vector<std::vector<std::string>> img_paths;
+  img_paths.reserve(frames.size());
+  for (const auto& frame : frames) {
+    img_paths.push_back({frame.left_img_path_});
+  }
+  prefetch_reader reader(
+      img_paths, {equal_hist ? cv::IMREAD_UNCHANGED : cv::IMREAD_GRAYSCALE},
+      {equal_hist}, frame_skip);
+
+  benchmark_recorder recorder;
+
   // run the SLAM in another thread
   std::thread thread([&]() {
+    recorder.start();
     for (unsigned int i = 0; i < frames.size(); ++i) {
       const auto& frame = frames.at(i);
-      cv::Mat img;
-      if (equal_hist) {
-        img = cv::imread(frame.left_img_path_, cv::IMREAD_UNCHANGED);
-        openvslam::util::equalize_histogram(img);
-      } else {
-        img = cv::imread(frame.left_img_path_, cv::IMREAD_GRAYSCALE);
-      }
 
-      const auto tp_1 = std::chrono::steady_clock::now();
+      double track_time = 0.0;
+      if (i % frame_skip == 0) {
+        const auto tp_0 = std::chrono::steady_clock::now();
+        const auto& buffer = reader.acquire(i);
+        const auto& img = buffer.imgs_.at(0);
 
-      if (!img.empty() && (i % frame_skip == 0)) {
-        // input the current frame and estimate the camera pose
-        SLAM.feed_monocular_frame(img, frame.timestamp_);
-      }
+        const auto tp_1 = std::chrono::steady_clock::now();
 
-      const auto tp_2 = std::chrono::steady_clock::now();
+        if (!img.empty()) {
+          // input the current frame and estimate the camera pose
+          SLAM.feed_monocular_frame(img, frame.timestamp_);
+        }
 
-      const auto track_time =
-          std::chrono::duration_cast<std::chrono::duration<double>>(tp_2 - tp_1)
-              .count();
-      if (i % frame_skip == 0) {
+        const auto tp_2 = std::chrono::steady_clock::now();
+
+        track_time = std::chrono::duration_cast<std::chrono::duration<double>>(
+                         tp_2 - tp_1)
+                         .count();
         track_times.push_back(track_time);
+
+        recorder.record("decode", buffer.decode_time_);
+        recorder.record("wait", tp_0, tp_1);
+        recorder.record("track", track_time);
+        recorder.finish_frame();
+
+        reader.release(i);
       }
 
       // wait until the timestamp of the next frame
@@ -104,6 +129,7 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
         break;
       }
     }
+    recorder.stop();
 
     // wait until the loop BA is finished
     while (SLAM.loop_BA_is_running()) {
@@ -153,6 +179,15 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
     SLAM.save_map_database(map_db_path);
   }
 
+  if (!benchmark_path.empty()) {
+    // output the throughput statistics
+    if (recorder.write(benchmark_path)) {
+      spdlog::info("benchmark results are written to {}", benchmark_path);
+    } else {
+      spdlog::warn("cannot write the benchmark results to {}", benchmark_path);
+    }
+  }
+
   std::sort(track_times.begin(), track_times.end());
   const auto total_track_time =
       std::accumulate(track_times.begin(), track_times.end(), 0.0);
@@ -167,7 +202,9 @@ void stereo_tracking(const std::shared_ptr<openvslam::config>& cfg,
                      const std::string& sequence_dir_path,
                      const unsigned int frame_skip, const bool no_sleep,
                      const bool auto_term, const bool eval_log,
-                     const std::string& map_db_path, const bool equal_hist) {
+                     const std::string& map_db_path, const bool equal_hist,
+                     const std::string& benchmark_path,
+                     const std::string& feature_stream_path) {
   const euroc_sequence sequence(sequence_dir_path);
   const auto frames = sequence.get_frames();
 
@@ -175,8 +212,15 @@ void stereo_tracking(const std::shared_ptr<openvslam::config>& cfg,
 
   // build a SLAM system
   openvslam::system SLAM(cfg, vocab_file_path);
+  // the images are rectified into new buffers, so they are shared with the
+  // viewer
+  SLAM.enable_image_sharing();
   // startup the SLAM process
   SLAM.startup();
+  if (!feature_stream_path.empty()) {
+    // record the extracted features to replay them with run_replay_slam
+    SLAM.start_feature_stream_recording(feature_stream_path);
+  }
 
   // create a viewer object
   // and pass the frame_publisher and the map_publisher
@@ -193,43 +237,62 @@ void stereo_tracking(const std::shared_ptr<openvslam::config>& cfg,
   std::vector<double> track_times;
   track_times.reserve(frames.size());
 
-  cv::Mat left_img_rect, right_img_rect;
+  // decode the images ahead of the tracking in background threads
+  std::vector<std::vector<std::string>> img_paths;
+  img_paths.reserve(frames.size());
+  for (const auto& frame : frames) {
+    img_paths.push_back({frame.left_img_path_, frame.right_img_path_});
+  }
+  const int imread_flags =
+      equal_hist ? cv::IMREAD_UNCHANGED : cv::IMREAD_GRAYSCALE;
+  prefetch_reader reader(img_paths, {imread_flags, imread_flags},
+                         {equal_hist, equal_hist}, frame_skip);
+
+  benchmark_recorder recorder;
 
   // run the SLAM in another thread
   std::thread thread([&]() {
+    recorder.start();
     for (unsigned int i = 0; i < frames.size(); ++i) {
       const auto& frame = frames.at(i);
-      cv::Mat left_img, right_img;
-      if (equal_hist) {
-        left_img = cv::imread(frame.left_img_path_, cv::IMREAD_UNCHANGED);
-        right_img = cv::imread(frame.right_img_path_, cv::IMREAD_UNCHANGED);
-        openvslam::util::equalize_histogram(left_img);
-        openvslam::util::equalize_histogram(right_img);
-      } else {
-        left_img = cv::imread(frame.left_img_path_, cv::IMREAD_GRAYSCALE);
-        right_img = cv::imread(frame.right_img_path_, cv::IMREAD_GRAYSCALE);
-      }
 
-      if (left_img.empty() || right_img.empty()) {
-        continue;
-      }
+      double track_time = 0.0;
+      if (i % frame_skip == 0) {
+        const auto tp_0 = std::chrono::steady_clock::now();
+        const auto& buffer = reader.acquire(i);
+        const auto& left_img = buffer.imgs_.at(0);
+        const auto& right_img = buffer.imgs_.at(1);
+
+        if (left_img.empty() || right_img.empty()) {
+          reader.release(i);
+          continue;
+        }
 
-      rectifier.rectify(left_img, right_img, left_img_rect, right_img_rect);
+        const auto tp_rect = std::chrono::steady_clock::now();
+        // the rectified images are shared with the viewer, so they are
+        // rectified into new buffers
+        cv::Mat left_img_rect, right_img_rect;
+        rectifier.rectify(left_img, right_img, left_img_rect, right_img_rect);
 
-      const auto tp_1 = std::chrono::steady_clock::now();
+        const auto tp_1 = std::chrono::steady_clock::now();
 
-      if (i % frame_skip == 0) {
         // input the current frame and estimate the camera pose
         SLAM.feed_stereo_frame(left_img_rect, right_img_rect, frame.timestamp_);
-      }
 
-      const auto tp_2 = std::chrono::steady_clock::now();
+        const auto tp_2 = std::chrono::steady_clock::now();
 
-      const auto track_time =
-          std::chrono::duration_cast<std::chrono::duration<double>>(tp_2 - tp_1)
-              .count();
-      if (i % frame_skip == 0) {
+        track_time = std::chrono::duration_cast<std::chrono::duration<double>>(
+                         tp_2 - tp_1)
+                         .count();
         track_times.push_back(track_time);
+
+        recorder.record("decode", buffer.decode_time_);
+        recorder.record("wait", tp_0, tp_rect);
+        recorder.record("rectify", tp_rect, tp_1);
+        recorder.record("track", track_time);
+        recorder.finish_frame();
+
+        reader.release(i);
       }
 
       // wait until the timestamp of the next frame
@@ -247,6 +310,7 @@ void stereo_tracking(const std::shared_ptr<openvslam::config>& cfg,
         break;
       }
     }
+    recorder.stop();
 
     // wait until the loop BA is finished
     while (SLAM.loop_BA_is_running()) {
@@ -296,6 +360,15 @@ void stereo_tracking(const std::shared_ptr<openvslam::config>& cfg,
     SLAM.save_map_database(map_db_path);
   }
 
+  if (!benchmark_path.empty()) {
+    // output the throughput statistics
+    if (recorder.write(benchmark_path)) {
+      spdlog::info("benchmark results are written to {}", benchmark_path);
+    } else {
+      spdlog::warn("cannot write the benchmark results to {}", benchmark_path);
+    }
+  }
+
   std::sort(track_times.begin(), track_times.end());
   const auto total_track_time =
       std::accumulate(track_times.begin(), track_times.end(), 0.0);
@@ -333,6 +406,14 @@ int main(int argc, char* argv[]) {
       "p", "map-db", "store a map database at this path after SLAM", "");
   auto equal_hist =
       op.add<popl::Switch>("", "equal-hist", "apply histogram equalization");
+  auto benchmark_path = op.add<popl::Value<std::string>>(
+      "", "benchmark",
+      "run without real-time waits and store the throughput statistics to "
+      "this JSON file",
+      "");
+  auto record_features = op.add<popl::Value<std::string>>(
+      "", "record-features",
+      "record the extracted features to this feature stream file", "");
 
   try {
     op.parse(argc, argv);
@@ -380,15 +461,19 @@ int main(int argc, char* argv[]) {
   // run tracking
   if (cfg->camera_->setup_type_ == openvslam::camera::setup_type_t::Monocular) {
     mono_tracking(cfg, vocab_file_path->value(), data_dir_path->value(),
-                  frame_skip->value(), no_sleep->is_set(), auto_term->is_set(),
-                  eval_log->is_set(), map_db_path->value(),
-                  equal_hist->is_set());
+                  frame_skip->value(),
+                  no_sleep->is_set() || benchmark_path->is_set(),
+                  auto_term->is_set(), eval_log->is_set(), map_db_path->value(),
+                  equal_hist->is_set(), benchmark_path->value(),
+                  record_features->value());
   } else if (cfg->camera_->setup_type_ ==
              openvslam::camera::setup_type_t::Stereo) {
     stereo_tracking(cfg, vocab_file_path->value(), data_dir_path->value(),
-                    frame_skip->value(), no_sleep->is_set(),
+                    frame_skip->value(),
+                    no_sleep->is_set() || benchmark_path->is_set(),
                     auto_term->is_set(), eval_log->is_set(),
-                    map_db_path->value(), equal_hist->is_set());
+                    map_db_path->value(), equal_hist->is_set(),
+                    benchmark_path->value(), record_features->value());
   } else {
     throw std::runtime_error("Invalid setup type: " +
                              cfg->camera_->get_setup_type_string());
@@ -0,0 +1,249 @@
+#include "util/benchmark_util.h"
+
+#ifdef USE_PANGOLIN_VIEWER
+#include "pangolin_viewer/viewer.h"
+#elif USE_SOCKET_PUBLISHER
+#include "socket_publisher/publisher.h"
+#endif
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <popl.hpp>
+
+#include "openvslam/config.h"
+#include "openvslam/data/frame_observation.h"
+#include "openvslam/io/feature_stream.h"
+#include "openvslam/system.h"
+#include "openvslam/util/yaml.h"
+
+#ifdef USE_STACK_TRACE_LOGGER
+#include <glog/logging.h>
+#endif
+
+#ifdef USE_GOOGLE_PERFTOOLS
+#include <gperftools/profiler.h>
+#endif
+
+void replay_tracking(const std::shared_ptr<openvslam::config>& cfg,
+                     const std::string& vocab_file_path,
+                     const std::string& feature_stream_path,
+                     const bool auto_term, const bool eval_log,
+                     const std::string& map_db_path,
+                     const std::string& benchmark_path) {
+  openvslam::io::feature_stream_reader reader(feature_stream_path);
+
+  // build a SLAM system
+  openvslam::system SLAM(cfg, vocab_file_path);
+  // startup the SLAM process
+  SLAM.startup();
+
+#ifdef USE_PANGOLIN_VIEWER
+  pangolin_viewer::viewer viewer(
+      openvslam::util::yaml_optional_ref(cfg->yaml_node_, "PangolinViewer"),
+      &SLAM, SLAM.get_frame_publisher(), SLAM.get_map_publisher());
+#elif USE_SOCKET_PUBLISHER
+  socket_publisher::publisher publisher(
+      openvslam::util::yaml_optional_ref(cfg->yaml_node_, "SocketPublisher"),
+      &SLAM, SLAM.get_frame_publisher(), SLAM.get_map_publisher());
+#endif
+
+  std::vector<double> track_times;
+
+  benchmark_recorder recorder;
+
+  // run the SLAM in another thread
+  std::thread thread([&]() {
+    // the frames are fed as fast as possible, because ORB extraction is skipped
+    double timestamp;
+    openvslam::data::frame_observation frm_obs;
+    recorder.start();
+    while (true) {
+      const auto tp_0 = std::chrono::steady_clock::now();
+      if (!reader.read(timestamp, frm_obs)) {
+        break;
+      }
+
+      const auto tp_1 = std::chrono::steady_clock::now();
+
+      // input the current frame and estimate the camera pose
+      SLAM.feed_recorded_frame(frm_obs, timestamp);
+
+      const auto tp_2 = std::chrono::steady_clock::now();
+
+      const auto track_time =
+          std::chrono::duration_cast<std::chrono::duration<double>>(tp_2 -
+                                                                    tp_1)
+              .count();
+      track_times.push_back(track_time);
+
+      recorder.record("read", tp_0, tp_1);
+      recorder.record("track", track_time);
+      recorder.finish_frame();
+
+      // check if the termination of SLAM system is requested or not
+      if (SLAM.terminate_is_requested()) {
+        break;
+      }
+    }
+    recorder.stop();
+
+    // wait until the loop BA is finished
+    while (SLAM.loop_BA_is_running()) {
+      std::this_thread::sleep_for(std::chrono::microseconds(5000));
+    }
+
+    // automatically close the viewer
+#ifdef USE_PANGOLIN_VIEWER
+    if (auto_term) {
+      viewer.request_terminate();
+    }
+#elif USE_SOCKET_PUBLISHER
+    if (auto_term) {
+      publisher.request_terminate();
+    }
+#endif
+  });
+
+  // run the viewer in the current thread
+#ifdef USE_PANGOLIN_VIEWER
+  viewer.run();
+#elif USE_SOCKET_PUBLISHER
+  publisher.run();
+#endif
+
+  thread.join();
+
+  // shutdown the SLAM process
+  SLAM.shutdown();
+
+  if (eval_log) {
+    // output the trajectories for evaluation
+    SLAM.save_frame_trajectory("frame_trajectory.txt", "TUM");
+    SLAM.save_keyframe_trajectory("keyframe_trajectory.txt", "TUM");
+    // output the tracking times for evaluation
+    std::ofstream ofs("track_times.txt", std::ios::out);
+    if (ofs.is_open()) {
+      for (const auto track_time : track_times) {
+        ofs << track_time << std::endl;
+      }
+      ofs.close();
+    }
+  }
+
+  if (!map_db_path.empty()) {
+    // output the map database
+    SLAM.save_map_database(map_db_path);
+  }
+
+  if (!benchmark_path.empty()) {
+    // output the throughput statistics
+    if (recorder.write(benchmark_path)) {
+      spdlog::info("benchmark results are written to {}", benchmark_path);
+    } else {
+      spdlog::warn("cannot write the benchmark results to {}", benchmark_path);
+    }
+  }
+
+  if (track_times.empty()) {
+    spdlog::warn("the feature stream contains no frames");
+    return;
+  }
+  std::sort(track_times.begin(), track_times.end());
+  const auto total_track_time =
+      std::accumulate(track_times.begin(), track_times.end(), 0.0);
+  std::cout << "median tracking time: "
+            << track_times.at(track_times.size() / 2) << "[s]" << std::endl;
+  std::cout << "mean tracking time: " << total_track_time / track_times.size()
+            << "[s]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+#ifdef USE_STACK_TRACE_LOGGER
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+#endif
+
+  // create options
+  popl::OptionParser op("Allowed options");
+  auto help = op.add<popl::Switch>("h", "help", "produce help message");
+  auto vocab_file_path =
+      op.add<popl::Value<std::string>>("v", "vocab", "vocabulary file path");
+  auto feature_stream_path = op.add<popl::Value<std::string>>(
+      "s", "stream", "feature stream file path");
+  auto config_file_path =
+      op.add<popl::Value<std::string>>("c", "config", "config file path");
+  auto auto_term = op.add<popl::Switch>("", "auto-term",
+                                        "automatically terminate the viewer");
+  auto debug_mode = op.add<popl::Switch>("", "debug", "debug mode");
+  auto eval_log = op.add<popl::Switch>(
+      "", "eval-log", "store trajectory and tracking times for evaluation");
+  auto map_db_path = op.add<popl::Value<std::string>>(
+      "p", "map-db", "store a map database at this path after SLAM", "");
+  auto benchmark_path = op.add<popl::Value<std::string>>(
+      "", "benchmark", "store the throughput statistics to this JSON file",
+      "");
+
+  try {
+    op.parse(argc, argv);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    std::cerr << std::endl;
+    std::cerr << op << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // check validness of options
+  if (help->is_set()) {
+    std::cerr << op << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!vocab_file_path->is_set() || !feature_stream_path->is_set() ||
+      !config_file_path->is_set()) {
+    std::cerr << "invalid arguments" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << op << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // setup logger
+  spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] %^[%L] %v%$");
+  if (debug_mode->is_set()) {
+    spdlog::set_level(spdlog::level::debug);
+  } else {
+    spdlog::set_level(spdlog::level::info);
+  }
+
+  // load configuration
+  std::shared_ptr<openvslam::config> cfg;
+  try {
+    cfg = std::make_shared<openvslam::config>(config_file_path->value());
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+#ifdef USE_GOOGLE_PERFTOOLS
+  ProfilerStart("slam.prof");
+#endif
+
+  // run tracking
+  // (the configuration must be the same as the one used for the recording)
+  try {
+    replay_tracking(cfg, vocab_file_path->value(), feature_stream_path->value(),
+                    auto_term->is_set(), eval_log->is_set(),
+                    map_db_path->value(), benchmark_path->value());
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+#ifdef USE_GOOGLE_PERFTOOLS
+  ProfilerStop();
+#endif
+
+  return EXIT_SUCCESS;
+}
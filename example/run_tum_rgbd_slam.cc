@@ -1,3 +1,5 @@
+#include "util/benchmark_util.h"
+#include "util/prefetch_reader.h"
 #include "util/tum_rgbd_util.h"
 
 #ifdef USE_PANGOLIN_VIEWER
@@ -35,7 +37,9 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
                    const std::string& sequence_dir_path,
                    const unsigned int frame_skip, const bool no_sleep,
                    const bool auto_term, const bool eval_log,
-                   const std::string& map_db_path) {
+                   const std::string& map_db_path,
+                   const std::string& benchmark_path,
+                   const std::string& feature_stream_path) {
   tum_rgbd_sequence sequence(sequence_dir_path);
   const auto frames = sequence.get_frames();
 
@@ -43,6 +47,10 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
   openvslam::system SLAM(cfg, vocab_file_path);
   // startup the SLAM process
   SLAM.startup();
+  if (!feature_stream_path.empty()) {
+    // record the extracted features to replay them with run_replay_slam
+    SLAM.start_feature_stream_recording(feature_stream_path);
+  }
 
   // create a viewer object
   // and pass the frame_publisher and the map_publisher
@@ -59,27 +67,49 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
   std::vector<double> track_times;
   track_times.reserve(frames.size());
 
+  // decode the images ahead of the tracking in background threads
+  std::vector<std::vector<std::string>> img_paths;
+  img_paths.reserve(frames.size());
+  for (const auto& frame : frames) {
+    img_paths.push_back({frame.rgb_img_path_});
+  }
+  prefetch_reader reader(img_paths, {cv::IMREAD_UNCHANGED}, {false},
+                         frame_skip);
+
+  benchmark_recorder recorder;
+
   // run the SLAM in another thread
   std::thread thread([&]() {
+    recorder.start();
     for (unsigned int i = 0; i < frames.size(); ++i) {
       const auto& frame = frames.at(i);
-      const auto rgb_img =
-          cv::imread(frame.rgb_img_path_, cv::IMREAD_UNCHANGED);
 
-      const auto tp_1 = std::chrono::steady_clock::now();
+      double track_time = 0.0;
+      if (i % frame_skip == 0) {
+        const auto tp_0 = std::chrono::steady_clock::now();
+        const auto& buffer = reader.acquire(i);
+        const auto& rgb_img = buffer.imgs_.at(0);
 
-      if (!rgb_img.empty() && (i % frame_skip == 0)) {
-        // input the current frame and estimate the camera pose
-        SLAM.feed_monocular_frame(rgb_img, frame.timestamp_);
-      }
+        const auto tp_1 = std::chrono::steady_clock::now();
 
-      const auto tp_2 = std::chrono::steady_clock::now();
+        if (!rgb_img.empty()) {
+          // input the current frame and estimate the camera pose
+          SLAM.feed_monocular_frame(rgb_img, frame.timestamp_);
+        }
 
-      const auto track_time =
-          std::chrono::duration_cast<std::chrono::duration<double>>(tp_2 - tp_1)
-              .count();
-      if (i % frame_skip == 0) {
+        const auto tp_2 = std::chrono::steady_clock::now();
+
+        track_time = std::chrono::duration_cast<std::chrono::duration<double>>(
+                         tp_2 - tp_1)
+                         .count();
         track_times.push_back(track_time);
+
+        recorder.record("decode", buffer.decode_time_);
+        recorder.record("wait", tp_0, tp_1);
+        recorder.record("track", track_time);
+        recorder.finish_frame();
+
+        reader.release(i);
       }
 
       // wait until the timestamp of the next frame
@@ -97,6 +127,7 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
         break;
       }
     }
+    recorder.stop();
 
     // wait until the loop BA is finished
     while (SLAM.loop_BA_is_running()) {
@@ -146,6 +177,15 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
     SLAM.save_map_database(map_db_path);
   }
 
+  if (!benchmark_path.empty()) {
+    // output the throughput statistics
+    if (recorder.write(benchmark_path)) {
+      spdlog::info("benchmark results are written to {}", benchmark_path);
+    } else {
+      spdlog::warn("cannot write the benchmark results to {}", benchmark_path);
+    }
+  }
+
   std::sort(track_times.begin(), track_times.end());
   const auto total_track_time =
       std::accumulate(track_times.begin(), track_times.end(), 0.0);
@@ -160,7 +200,9 @@ void rgbd_tracking(const std::shared_ptr<openvslam::config>& cfg,
                    const std::string& sequence_dir_path,
                    const unsigned int frame_skip, const bool no_sleep,
                    const bool auto_term, const bool eval_log,
-                   const std::string& map_db_path) {
+                   const std::string& map_db_path,
+                   const std::string& benchmark_path,
+                   const std::string& feature_stream_path) {
   tum_rgbd_sequence sequence(sequence_dir_path);
   const auto frames = sequence.get_frames();
 
@@ -168,6 +210,10 @@ void rgbd_tracking(const std::shared_ptr<openvslam::config>& cfg,
   openvslam::system SLAM(cfg, vocab_file_path);
   // startup the SLAM process
   SLAM.startup();
+  if (!feature_stream_path.empty()) {
+    // record the extracted features to replay them with run_replay_slam
+    SLAM.start_feature_stream_recording(feature_stream_path);
+  }
 
   // create a viewer object
   // and pass the frame_publisher and the map_publisher
@@ -184,29 +230,51 @@ void rgbd_tracking(const std::shared_ptr<openvslam::config>& cfg,
   std::vector<double> track_times;
   track_times.reserve(frames.size());
 
+  // decode the images ahead of the tracking in background threads
+  std::vector<std::vector<std::string>> img_paths;
+  img_paths.reserve(frames.size());
+  for (const auto& frame : frames) {
+    img_paths.push_back({frame.rgb_img_path_, frame.depth_img_path_});
+  }
+  prefetch_reader reader(img_paths,
+                         {cv::IMREAD_UNCHANGED, cv::IMREAD_UNCHANGED},
+                         {false, false}, frame_skip);
+
+  benchmark_recorder recorder;
+
   // run the SLAM in another thread
   std::thread thread([&]() {
+    recorder.start();
     for (unsigned int i = 0; i < frames.size(); ++i) {
       const auto& frame = frames.at(i);
-      const auto rgb_img =
-          cv::imread(frame.rgb_img_path_, cv::IMREAD_UNCHANGED);
-      const auto depth_img =
-          cv::imread(frame.depth_img_path_, cv::IMREAD_UNCHANGED);
 
-      const auto tp_1 = std::chrono::steady_clock::now();
+      double track_time = 0.0;
+      if (i % frame_skip == 0) {
+        const auto tp_0 = std::chrono::steady_clock::now();
+        const auto& buffer = reader.acquire(i);
+        const auto& rgb_img = buffer.imgs_.at(0);
+        const auto& depth_img = buffer.imgs_.at(1);
 
-      if (!rgb_img.empty() && !depth_img.empty() && (i % frame_skip == 0)) {
-        // input the current frame and estimate the camera pose
-        SLAM.feed_RGBD_frame(rgb_img, depth_img, frame.timestamp_);
-      }
+        const auto tp_1 = std::chrono::steady_clock::now();
 
-      const auto tp_2 = std::chrono::steady_clock::now();
+        if (!rgb_img.empty() && !depth_img.empty()) {
+          // input the current frame and estimate the camera pose
+          SLAM.feed_RGBD_frame(rgb_img, depth_img, frame.timestamp_);
+        }
 
-      const auto track_time =
-          std::chrono::duration_cast<std::chrono::duration<double>>(tp_2 - tp_1)
-              .count();
-      if (i % frame_skip == 0) {
+        const auto tp_2 = std::chrono::steady_clock::now();
+
+        track_time = std::chrono::duration_cast<std::chrono::duration<double>>(
+                         tp_2 - tp_1)
+                         .count();
         track_times.push_back(track_time);
+
+        recorder.record("decode", buffer.decode_time_);
+        recorder.record("wait", tp_0, tp_1);
+        recorder.record("track", track_time);
+        recorder.finish_frame();
+
+        reader.release(i);
       }
 
       // wait until the timestamp of the next frame
@@ -224,6 +292,7 @@ void rgbd_tracking(const std::shared_ptr<openvslam::config>& cfg,
         break;
       }
     }
+    recorder.stop();
 
     // wait until the loop BA is finished
     while (SLAM.loop_BA_is_running()) {
@@ -273,6 +342,15 @@ void rgbd_tracking(const std::shared_ptr<openvslam::config>& cfg,
     SLAM.save_map_database(map_db_path);
   }
 
+  if (!benchmark_path.empty()) {
+    // output the throughput statistics
+    if (recorder.write(benchmark_path)) {
+      spdlog::info("benchmark results are written to {}", benchmark_path);
+    } else {
+      spdlog::warn("cannot write the benchmark results to {}", benchmark_path);
+    }
+  }
+
   std::sort(track_times.begin(), track_times.end());
   const auto total_track_time =
       std::accumulate(track_times.begin(), track_times.end(), 0.0);
@@ -308,6 +386,15 @@ int main(int argc, char* argv[]) {
       "", "eval-log", "store trajectory and tracking times for evaluation");
   auto map_db_path = op.add<popl::Value<std::string>>(
       "p", "map-db", "store a map database at this path after SLAM", "");
+  auto benchmark_path = op.add<popl::Value<std::string>>(
+      "", "benchmark",
+      "run without real-time waits and store the throughput statistics to "
+      "this JSON file",
+      "");
+  auto record_features = op.add<popl::Value<std::string>>(
+      "", "record-features",
+      "record the extracted features to this feature stream file", "");
+
   try {
     op.parse(argc, argv);
   } catch (const std::exception& e) {
@@ -354,13 +441,17 @@ int main(int argc, char* argv[]) {
   // run tracking
   if (cfg->camera_->setup_type_ == openvslam::camera::setup_type_t::Monocular) {
     mono_tracking(cfg, vocab_file_path->value(), data_dir_path->value(),
-                  frame_skip->value(), no_sleep->is_set(), auto_term->is_set(),
-                  eval_log->is_set(), map_db_path->value());
+                  frame_skip->value(),
+                  no_sleep->is_set() || benchmark_path->is_set(),
+                  auto_term->is_set(), eval_log->is_set(), map_db_path->value(),
+                  benchmark_path->value(), record_features->value());
   } else if (cfg->camera_->setup_type_ ==
              openvslam::camera::setup_type_t::RGBD) {
     rgbd_tracking(cfg, vocab_file_path->value(), data_dir_path->value(),
-                  frame_skip->value(), no_sleep->is_set(), auto_term->is_set(),
-                  eval_log->is_set(), map_db_path->value());
+                  frame_skip->value(),
+                  no_sleep->is_set() || benchmark_path->is_set(),
+                  auto_term->is_set(), eval_log->is_set(), map_db_path->value(),
+                  benchmark_path->value(), record_features->value());
   } else {
     throw std::runtime_error("Invalid setup type: " +
                              cfg->camera_->get_setup_type_string());
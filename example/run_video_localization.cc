@@ -30,7 +30,8 @@ void mono_localization(const std::shared_ptr<openvslam::config>& cfg,
                        const std::string& vocab_file_path,
                        const std::string& video_file_path,
                        const std::string& mask_img_path,
-                       const std::string& map_db_path, const bool mapping,
+                       const std::string& map_db_path, const bool tiled,
+                       const bool mapping,
                        const unsigned int frame_skip, const bool no_sleep,
                        const bool auto_term) {
   // load the mask image
@@ -40,8 +41,15 @@ void mono_localization(const std::shared_ptr<openvslam::config>& cfg,
 
   // build a SLAM system
   openvslam::system SLAM(cfg, vocab_file_path);
+  // the frames are read into new buffers, so they are shared with the viewer
+  SLAM.enable_image_sharing();
   // load the prebuilt map
-  SLAM.load_map_database(map_db_path);
+  if (tiled) {
+    // the tiles are paged in around the tracked pose
+    SLAM.load_tiled_map_database(map_db_path);
+  } else {
+    SLAM.load_map_database(map_db_path);
+  }
   // startup the SLAM process (it does not need initialization of a map)
   SLAM.startup(false);
   // select to activate the mapping module or not
@@ -66,7 +74,6 @@ void mono_localization(const std::shared_ptr<openvslam::config>& cfg,
   auto video = cv::VideoCapture(video_file_path, cv::CAP_FFMPEG);
   std::vector<double> track_times;
 
-  cv::Mat frame;
   double timestamp = 0.0;
 
   unsigned int num_frame = 0;
@@ -75,6 +82,8 @@ void mono_localization(const std::shared_ptr<openvslam::config>& cfg,
   // run the SLAM in another thread
   std::thread thread([&]() {
     while (is_not_end) {
+      // the frame is shared with the viewer, so it is read into a new buffer
+      cv::Mat frame;
       is_not_end = video.read(frame);
 
       const auto tp_1 = std::chrono::steady_clock::now();
@@ -166,6 +175,8 @@ int main(int argc, char* argv[]) {
       op.add<popl::Value<std::string>>("c", "config", "config file path");
   auto map_db_path = op.add<popl::Value<std::string>>(
       "p", "map-db", "path to a prebuilt map database");
+  auto tiled = op.add<popl::Switch>(
+      "", "tiled", "the map database is a directory of the map tiles");
   auto mapping = op.add<popl::Switch>(
       "", "mapping", "perform mapping as well as localization");
   auto mask_img_path =
@@ -198,6 +209,13 @@ int main(int argc, char* argv[]) {
     std::cerr << op << std::endl;
     return EXIT_FAILURE;
   }
+  if (tiled->is_set() && mapping->is_set()) {
+    std::cerr << "the tiled map database cannot be used with mapping"
+              << std::endl;
+    std::cerr << std::endl;
+    std::cerr << op << std::endl;
+    return EXIT_FAILURE;
+  }
 
   // setup logger
   spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] %^[%L] %v%$");
@@ -224,7 +242,7 @@ int main(int argc, char* argv[]) {
   if (cfg->camera_->setup_type_ == openvslam::camera::setup_type_t::Monocular) {
     mono_localization(cfg, vocab_file_path->value(), video_file_path->value(),
                       mask_img_path->value(), map_db_path->value(),
-                      mapping->is_set(), frame_skip->value(),
+                      tiled->is_set(), mapping->is_set(), frame_skip->value(),
                       no_sleep->is_set(), auto_term->is_set());
   } else {
     throw std::runtime_error("Invalid setup type: " +
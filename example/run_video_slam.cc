@@ -33,7 +33,8 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
                    const std::string& mask_img_path,
                    const unsigned int frame_skip, const bool no_sleep,
                    const bool auto_term, const bool eval_log,
-                   const std::string& map_db_path) {
+                   const std::string& map_db_path,
+                   const std::string& map_tiles_dir, const double tile_size) {
   // load the mask image
   const cv::Mat mask = mask_img_path.empty()
                            ? cv::Mat{}
@@ -41,6 +42,8 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
 
   // build a SLAM system
   openvslam::system SLAM(cfg, vocab_file_path);
+  // the frames are read into new buffers, so they are shared with the viewer
+  SLAM.enable_image_sharing();
   // startup the SLAM process
   SLAM.startup();
 
@@ -59,7 +62,6 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
   auto video = cv::VideoCapture(video_file_path, cv::CAP_FFMPEG);
   std::vector<double> track_times;
 
-  cv::Mat frame;
   double timestamp = 0.0;
 
   unsigned int num_frame = 0;
@@ -68,6 +70,8 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
   // run the SLAM in another thread
   std::thread thread([&]() {
     while (is_not_end) {
+      // the frame is shared with the viewer, so it is read into a new buffer
+      cv::Mat frame;
       is_not_end = video.read(frame);
 
       const auto tp_1 = std::chrono::steady_clock::now();
@@ -152,6 +156,11 @@ void mono_tracking(const std::shared_ptr<openvslam::config>& cfg,
     SLAM.save_map_database(map_db_path);
   }
 
+  if (!map_tiles_dir.empty()) {
+    // output the map database as the tiles for localization with paging
+    SLAM.save_tiled_map_database(map_tiles_dir, tile_size);
+  }
+
   std::sort(track_times.begin(), track_times.end());
   const auto total_track_time =
       std::accumulate(track_times.begin(), track_times.end(), 0.0);
@@ -189,6 +198,11 @@ int main(int argc, char* argv[]) {
       "", "eval-log", "store trajectory and tracking times for evaluation");
   auto map_db_path = op.add<popl::Value<std::string>>(
       "p", "map-db", "store a map database at this path after SLAM", "");
+  auto map_tiles_dir = op.add<popl::Value<std::string>>(
+      "", "map-tiles",
+      "store a tiled map database in this existing directory after SLAM", "");
+  auto tile_size = op.add<popl::Value<double>>(
+      "", "tile-size", "edge length of the map tiles [m]", 10.0);
   try {
     op.parse(argc, argv);
   } catch (const std::exception& e) {
@@ -237,7 +251,8 @@ int main(int argc, char* argv[]) {
     mono_tracking(cfg, vocab_file_path->value(), video_file_path->value(),
                   mask_img_path->value(), frame_skip->value(),
                   no_sleep->is_set(), auto_term->is_set(), eval_log->is_set(),
-                  map_db_path->value());
+                  map_db_path->value(), map_tiles_dir->value(),
+                  tile_size->value());
   } else {
     throw std::runtime_error("Invalid setup type: " +
                              cfg->camera_->get_setup_type_string());
@@ -0,0 +1,97 @@
+#include "benchmark_util.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <nlohmann/json.hpp>
+#include <numeric>
+
+namespace {
+
+//! nearest-rank percentile of the sorted values
+double percentile(const std::vector<double>& sorted_vals, const double ratio) {
+  if (sorted_vals.empty()) {
+    return 0.0;
+  }
+  const auto rank = static_cast<unsigned int>(
+      std::ceil(ratio * static_cast<double>(sorted_vals.size())));
+  return sorted_vals.at(std::max(rank, 1u) - 1);
+}
+
+}  // namespace
+
+void benchmark_recorder::start() {
+  start_ = std::chrono::steady_clock::now();
+  end_ = start_;
+}
+
+void benchmark_recorder::stop() { end_ = std::chrono::steady_clock::now(); }
+
+void benchmark_recorder::record(const std::string& stage,
+                                const double elapsed) {
+  stage_times_[stage].push_back(elapsed);
+}
+
+void benchmark_recorder::record(
+    const std::string& stage,
+    const std::chrono::steady_clock::time_point& tp_begin,
+    const std::chrono::steady_clock::time_point& tp_end) {
+  record(stage, std::chrono::duration_cast<std::chrono::duration<double>>(
+                    tp_end - tp_begin)
+                    .count());
+}
+
+void benchmark_recorder::finish_frame() { ++num_frames_; }
+
+nlohmann::json benchmark_recorder::to_json() const {
+  const auto wall_time =
+      std::chrono::duration_cast<std::chrono::duration<double>>(end_ - start_)
+          .count();
+
+  nlohmann::json stages = nlohmann::json::object();
+  for (const auto& stage_times : stage_times_) {
+    auto times = stage_times.second;
+    std::sort(times.begin(), times.end());
+    const auto total = std::accumulate(times.begin(), times.end(), 0.0);
+    // the latencies are reported in milliseconds
+    stages[stage_times.first] = {
+        {"count", times.size()},
+        {"mean_ms", times.empty() ? 0.0 : 1e3 * total / times.size()},
+        {"p50_ms", 1e3 * percentile(times, 0.50)},
+        {"p95_ms", 1e3 * percentile(times, 0.95)},
+        {"p99_ms", 1e3 * percentile(times, 0.99)},
+        {"max_ms", times.empty() ? 0.0 : 1e3 * times.back()}};
+  }
+
+  return {{"num_frames", num_frames_},
+          {"wall_time_s", wall_time},
+          {"fps", 0.0 < wall_time ? num_frames_ / wall_time : 0.0},
+          {"peak_rss_mb", get_peak_rss()},
+          {"stages", stages}};
+}
+
+bool benchmark_recorder::write(const std::string& json_path) const {
+  std::ofstream ofs(json_path, std::ios::out);
+  if (!ofs.is_open()) {
+    return false;
+  }
+  ofs << std::setw(4) << to_json() << std::endl;
+  return ofs.good();
+}
+
+double benchmark_recorder::get_peak_rss() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0.0;
+  }
+#ifdef __APPLE__
+  // ru_maxrss is in bytes on macOS
+  return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+  // ru_maxrss is in kilobytes on Linux
+  return usage.ru_maxrss / 1024.0;
+#endif
+}
@@ -0,0 +1,49 @@
+#ifndef EXAMPLE_UTIL_BENCHMARK_UTIL_H
+#define EXAMPLE_UTIL_BENCHMARK_UTIL_H
+
+#include <chrono>
+#include <map>
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+#include <vector>
+
+class benchmark_recorder {
+ public:
+  benchmark_recorder() = default;
+
+  virtual ~benchmark_recorder() = default;
+
+  //! start measuring the wall-clock time
+  void start();
+
+  //! stop measuring the wall-clock time
+  void stop();
+
+  //! record the elapsed time [s] of the stage for the current frame
+  void record(const std::string& stage, const double elapsed);
+
+  //! record the elapsed time between the time points as the stage
+  void record(const std::string& stage,
+              const std::chrono::steady_clock::time_point& tp_begin,
+              const std::chrono::steady_clock::time_point& tp_end);
+
+  //! count up the number of the processed frames
+  void finish_frame();
+
+  //! get the statistics (per-stage latency percentiles, FPS, peak RSS)
+  nlohmann::json to_json() const;
+
+  //! write the statistics to the JSON file
+  bool write(const std::string& json_path) const;
+
+  //! get the peak resident set size of this process [MB]
+  static double get_peak_rss();
+
+ private:
+  std::map<std::string, std::vector<double>> stage_times_;
+  unsigned int num_frames_ = 0;
+  std::chrono::steady_clock::time_point start_;
+  std::chrono::steady_clock::time_point end_;
+};
+
+#endif  // EXAMPLE_UTIL_BENCHMARK_UTIL_H
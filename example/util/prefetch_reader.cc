@@ -0,0 +1,141 @@
+#include "prefetch_reader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <opencv2/imgcodecs.hpp>
+
+#include "openvslam/util/image_converter.h"
+
+prefetch_reader::prefetch_reader(
+    const std::vector<std::vector<std::string>>& img_paths,
+    const std::vector<int>& imread_flags, const std::vector<bool>& equal_hist,
+    const unsigned int frame_skip, const unsigned int num_prefetch,
+    const unsigned int num_threads)
+    : img_paths_(img_paths),
+      imread_flags_(imread_flags),
+      equal_hist_(equal_hist),
+      frame_skip_(std::max(frame_skip, 1u)),
+      num_seqs_((img_paths.size() + frame_skip_ - 1) / frame_skip_),
+      buffers_(std::max(num_prefetch, 1u)) {
+  assert(imread_flags_.size() == equal_hist_.size());
+
+  for (unsigned int i = 0; i < buffers_.size(); ++i) {
+    auto& buf = buffers_.at(i);
+    buf.imgs_.resize(imread_flags_.size());
+    buf.bytes_.resize(imread_flags_.size());
+    buf.seq_ = i;
+  }
+
+  for (unsigned int i = 0; i < std::max(num_threads, 1u); ++i) {
+    threads_.emplace_back(&prefetch_reader::run, this);
+  }
+}
+
+prefetch_reader::~prefetch_reader() {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    terminate_is_requested_ = true;
+  }
+  cond_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+const prefetch_reader::buffer& prefetch_reader::acquire(
+    const unsigned int frame_idx) {
+  assert(frame_idx % frame_skip_ == 0);
+  const unsigned int seq = frame_idx / frame_skip_;
+  auto& buf = buffers_.at(seq % buffers_.size());
+
+  std::unique_lock<std::mutex> lock(mtx_);
+  cond_.wait(lock, [&] { return buf.seq_ == seq && buf.is_ready_; });
+  return buf;
+}
+
+void prefetch_reader::release(const unsigned int frame_idx) {
+  const unsigned int seq = frame_idx / frame_skip_;
+  auto& buf = buffers_.at(seq % buffers_.size());
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    assert(buf.seq_ == seq);
+    // assign the next lap of the ring to this buffer
+    buf.seq_ += buffers_.size();
+    buf.is_ready_ = false;
+  }
+  cond_.notify_all();
+}
+
+void prefetch_reader::run() {
+  while (true) {
+    unsigned int seq;
+    buffer* buf;
+    {
+      std::unique_lock<std::mutex> lock(mtx_);
+      if (terminate_is_requested_ || num_seqs_ <= next_seq_) {
+        return;
+      }
+      seq = next_seq_++;
+      buf = &buffers_.at(seq % buffers_.size());
+      // wait until the consumer gives back the buffer
+      cond_.wait(lock, [&] {
+        return terminate_is_requested_ || (buf->seq_ == seq && !buf->is_ready_);
+      });
+      if (terminate_is_requested_) {
+        return;
+      }
+    }
+
+    // the buffer is owned by this thread until it is marked as ready
+    decode(seq * frame_skip_, *buf);
+
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      buf->is_ready_ = true;
+    }
+    cond_.notify_all();
+  }
+}
+
+void prefetch_reader::decode(const unsigned int frame_idx, buffer& buf) const {
+  const auto tp_1 = std::chrono::steady_clock::now();
+
+  const auto& paths = img_paths_.at(frame_idx);
+  for (unsigned int i = 0; i < imread_flags_.size(); ++i) {
+    auto& bytes = buf.bytes_.at(i);
+    auto& img = buf.imgs_.at(i);
+
+    // read the whole file into the recycled byte buffer
+    std::ifstream ifs(paths.at(i), std::ios::in | std::ios::binary);
+    if (!ifs.is_open()) {
+      img.release();
+      continue;
+    }
+    ifs.seekg(0, std::ios::end);
+    bytes.resize(static_cast<size_t>(ifs.tellg()));
+    ifs.seekg(0, std::ios::beg);
+    ifs.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+    if (!ifs || bytes.empty()) {
+      img.release();
+      continue;
+    }
+
+    // decode into the recycled image (reallocated only if the size changes)
+    // (the buffer is given back by release(), so the fed images must be copied
+    // by the SLAM system, which is the default of system)
+    if (cv::imdecode(bytes, imread_flags_.at(i), &img).empty()) {
+      img.release();
+      continue;
+    }
+    if (equal_hist_.at(i)) {
+      openvslam::util::equalize_histogram(img);
+    }
+  }
+
+  const auto tp_2 = std::chrono::steady_clock::now();
+  buf.decode_time_ =
+      std::chrono::duration_cast<std::chrono::duration<double>>(tp_2 - tp_1)
+          .count();
+}
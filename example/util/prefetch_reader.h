@@ -0,0 +1,93 @@
+#ifndef EXAMPLE_UTIL_PREFETCH_READER_H
+#define EXAMPLE_UTIL_PREFETCH_READER_H
+
+#include <condition_variable>
+#include <mutex>
+#include <opencv2/core/core.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+class prefetch_reader {
+ public:
+  struct buffer {
+    //! decoded images of the frame
+    std::vector<cv::Mat> imgs_;
+    //! elapsed time to read and decode the images [s]
+    double decode_time_ = 0.0;
+
+   private:
+    friend class prefetch_reader;
+    //! encoded file contents (recycled over the frames)
+    std::vector<std::vector<unsigned char>> bytes_;
+    //! sequential index of the frame which is assigned to this buffer
+    unsigned int seq_ = 0;
+    //! the images are decoded or not
+    bool is_ready_ = false;
+  };
+
+  /**
+   * Constructor
+   * (NOTE: only the frames whose indices are multiples of frame_skip are
+   * decoded)
+   * @param img_paths image paths of each frame
+   * @param imread_flags flags used to decode each image of a frame
+   * @param equal_hist apply histogram equalization to each image of a frame
+   * or not
+   * @param frame_skip
+   * @param num_prefetch number of frames decoded ahead
+   * @param num_threads number of decoding threads
+   */
+  prefetch_reader(const std::vector<std::vector<std::string>>& img_paths,
+                  const std::vector<int>& imread_flags,
+                  const std::vector<bool>& equal_hist,
+                  const unsigned int frame_skip = 1,
+                  const unsigned int num_prefetch = 8,
+                  const unsigned int num_threads = 2);
+
+  /**
+   * Destructor (stops the decoding threads)
+   */
+  virtual ~prefetch_reader();
+
+  /**
+   * Wait until the images of the specified frame are decoded
+   * (NOTE: the returned buffer is valid until release() is called)
+   */
+  const buffer& acquire(const unsigned int frame_idx);
+
+  /**
+   * Give back the buffer of the specified frame to the decoding threads
+   * (NOTE: the images are overwritten by the following frames, so they must
+   * not be shared after this call, e.g. with system::enable_image_sharing())
+   */
+  void release(const unsigned int frame_idx);
+
+ private:
+  //! main loop of the decoding threads
+  void run();
+
+  //! read and decode the images of the specified frame into the buffer
+  void decode(const unsigned int frame_idx, buffer& buf) const;
+
+  const std::vector<std::vector<std::string>> img_paths_;
+  const std::vector<int> imread_flags_;
+  const std::vector<bool> equal_hist_;
+  const unsigned int frame_skip_;
+
+  //! number of frames to be decoded
+  const unsigned int num_seqs_;
+
+  //! ring of the buffers (the frame of seq is stored in buffers_[seq % size])
+  std::vector<buffer> buffers_;
+
+  std::mutex mtx_;
+  std::condition_variable cond_;
+  //! next sequential index to be decoded
+  unsigned int next_seq_ = 0;
+  bool terminate_is_requested_ = false;
+
+  std::vector<std::thread> threads_;
+};
+
+#endif  // EXAMPLE_UTIL_PREFETCH_READER_H
@@ -184,5 +184,44 @@ void base::convert_bearings_to_points(
                  });
 }
 
+void base::reproject_points_to_image(
+    const Mat33_t& rot_cw, const Vec3_t& trans_cw,
+    const eigen_alloc_vector<Vec3_t>& pos_ws,
+    eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights,
+    std::vector<unsigned char>& is_valid) const {
+  reprojs.resize(pos_ws.size());
+  x_rights.resize(pos_ws.size());
+  is_valid.resize(pos_ws.size());
+  for (unsigned long idx = 0; idx < pos_ws.size(); ++idx) {
+    is_valid.at(idx) = reproject_to_image(rot_cw, trans_cw, pos_ws.at(idx),
+                                          reprojs.at(idx), x_rights.at(idx));
+  }
+}
+
+void base::reproject_points_to_bearings(
+    const Mat33_t& rot_cw, const Vec3_t& trans_cw,
+    const eigen_alloc_vector<Vec3_t>& pos_ws,
+    eigen_alloc_vector<Vec3_t>& reprojs,
+    std::vector<unsigned char>& is_valid) const {
+  reprojs.resize(pos_ws.size());
+  is_valid.resize(pos_ws.size());
+  for (unsigned long idx = 0; idx < pos_ws.size(); ++idx) {
+    is_valid.at(idx) = reproject_to_bearing(rot_cw, trans_cw, pos_ws.at(idx),
+                                            reprojs.at(idx));
+  }
+}
+
+Eigen::Matrix<double, Eigen::Dynamic, 3> base::transform_points_to_camera(
+    const Mat33_t& rot_cw, const Vec3_t& trans_cw,
+    const eigen_alloc_vector<Vec3_t>& pos_ws) {
+  if (pos_ws.empty()) {
+    return Eigen::Matrix<double, Eigen::Dynamic, 3>(0, 3);
+  }
+  // Vec3_t is not padded, so the points can be viewed as a 3 x N matrix
+  const Eigen::Map<const Eigen::Matrix<double, 3, Eigen::Dynamic>> pos_ws_mat(
+      pos_ws.front().data(), 3, pos_ws.size());
+  return (rot_cw * pos_ws_mat).transpose().rowwise() + trans_cw.transpose();
+}
+
 }  // namespace camera
 }  // namespace openvslam
@@ -203,6 +203,32 @@ class base {
   virtual void convert_bearings_to_points(
       const eigen_alloc_vector<Vec3_t>& bearings,
       std::vector<cv::Point2f>& undist_pts) const;
+
+  //! Reproject the specified 3D points to image using camera pose and
+  //! projection model (is_valid[i] is set to 1 if the i-th point is
+  //! reprojected to inside of image, otherwise 0)
+  virtual void reproject_points_to_image(
+      const Mat33_t& rot_cw, const Vec3_t& trans_cw,
+      const eigen_alloc_vector<Vec3_t>& pos_ws,
+      eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights,
+      std::vector<unsigned char>& is_valid) const;
+
+  //! Reproject the specified 3D points to bearing vectors using camera pose
+  //! (is_valid[i] is set to 1 if the i-th point is reprojected to inside of
+  //! image, otherwise 0)
+  virtual void reproject_points_to_bearings(
+      const Mat33_t& rot_cw, const Vec3_t& trans_cw,
+      const eigen_alloc_vector<Vec3_t>& pos_ws,
+      eigen_alloc_vector<Vec3_t>& reprojs,
+      std::vector<unsigned char>& is_valid) const;
+
+ protected:
+  //! Transform the 3D points to the camera-coordinates at once
+  //! (each column of the returned N x 3 matrix is contiguous, so that the
+  //! projection models can be applied with vectorized array operations)
+  static Eigen::Matrix<double, Eigen::Dynamic, 3> transform_points_to_camera(
+      const Mat33_t& rot_cw, const Vec3_t& trans_cw,
+      const eigen_alloc_vector<Vec3_t>& pos_ws);
 };
 
 std::ostream& operator<<(std::ostream& os, const base& params);
@@ -136,5 +136,61 @@ void equirectangular::undistort_keypoints(
   undist_keypts = dist_keypts;
 }
 
+void equirectangular::convert_keypoints_to_bearings(
+    const std::vector<cv::KeyPoint>& undist_keypts,
+    eigen_alloc_vector<Vec3_t>& bearings) const {
+  bearings.reserve(bearings.size() + undist_keypts.size());
+  for (const auto& undist_keypt : undist_keypts) {
+    // call the final overrider directly to avoid the virtual dispatch
+    bearings.push_back(
+        equirectangular::convert_point_to_bearing(undist_keypt.pt));
+  }
+}
+
+void equirectangular::reproject_points_to_image(
+    const Mat33_t& rot_cw, const Vec3_t& trans_cw,
+    const eigen_alloc_vector<Vec3_t>& pos_ws,
+    eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights,
+    std::vector<unsigned char>& is_valid) const {
+  // convert to camera-coordinates
+  const auto pos_cs = transform_points_to_camera(rot_cw, trans_cw, pos_ws);
+  const Eigen::ArrayXd norms = pos_cs.rowwise().norm().array();
+
+  // convert to unit polar coordinates
+  const Eigen::ArrayXd latitudes = -(pos_cs.col(1).array() / norms).asin();
+
+  // convert to pixel image coordinated
+  // (atan2 is evaluated per point because Eigen has no array version of it)
+  const auto num_pts = pos_ws.size();
+  reprojs.resize(num_pts);
+  x_rights.resize(num_pts);
+  is_valid.resize(num_pts);
+  for (unsigned long idx = 0; idx < num_pts; ++idx) {
+    const auto longitude = std::atan2(pos_cs(idx, 0) / norms(idx),
+                                      pos_cs(idx, 2) / norms(idx));
+    reprojs[idx] = Vec2_t{cols_ * (0.5 + longitude / (2.0 * M_PI)),
+                          rows_ * (0.5 - latitudes(idx) / M_PI)};
+    x_rights[idx] = 0.0;
+    is_valid[idx] = 1;
+  }
+}
+
+void equirectangular::reproject_points_to_bearings(
+    const Mat33_t& rot_cw, const Vec3_t& trans_cw,
+    const eigen_alloc_vector<Vec3_t>& pos_ws,
+    eigen_alloc_vector<Vec3_t>& reprojs,
+    std::vector<unsigned char>& is_valid) const {
+  // convert to camera-coordinates
+  const auto pos_cs = transform_points_to_camera(rot_cw, trans_cw, pos_ws);
+  const Eigen::ArrayXd norms = pos_cs.rowwise().norm().array();
+
+  const auto num_pts = pos_ws.size();
+  reprojs.resize(num_pts);
+  is_valid.assign(num_pts, 1);
+  for (unsigned long idx = 0; idx < num_pts; ++idx) {
+    reprojs[idx] = pos_cs.row(idx).transpose() / norms(idx);
+  }
+}
+
 }  // namespace camera
 }  // namespace openvslam
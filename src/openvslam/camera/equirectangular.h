@@ -45,6 +45,20 @@ class equirectangular final : public base {
   void undistort_keypoints(
       const std::vector<cv::KeyPoint>& dist_keypts,
       std::vector<cv::KeyPoint>& undist_keypts) const override final;
+
+  void convert_keypoints_to_bearings(
+      const std::vector<cv::KeyPoint>& undist_keypts,
+      eigen_alloc_vector<Vec3_t>& bearings) const override final;
+  void reproject_points_to_image(
+      const Mat33_t& rot_cw, const Vec3_t& trans_cw,
+      const eigen_alloc_vector<Vec3_t>& pos_ws,
+      eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights,
+      std::vector<unsigned char>& is_valid) const override final;
+  void reproject_points_to_bearings(
+      const Mat33_t& rot_cw, const Vec3_t& trans_cw,
+      const eigen_alloc_vector<Vec3_t>& pos_ws,
+      eigen_alloc_vector<Vec3_t>& reprojs,
+      std::vector<unsigned char>& is_valid) const override final;
 };
 
 std::ostream& operator<<(std::ostream& os, const equirectangular& params);
@@ -53,6 +53,20 @@ class fisheye final : public base {
       const std::vector<cv::KeyPoint>& dist_keypt,
       std::vector<cv::KeyPoint>& undist_keypt) const override final;
 
+  void convert_keypoints_to_bearings(
+      const std::vector<cv::KeyPoint>& undist_keypts,
+      eigen_alloc_vector<Vec3_t>& bearings) const override final;
+  void reproject_points_to_image(
+      const Mat33_t& rot_cw, const Vec3_t& trans_cw,
+      const eigen_alloc_vector<Vec3_t>& pos_ws,
+      eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights,
+      std::vector<unsigned char>& is_valid) const override final;
+  void reproject_points_to_bearings(
+      const Mat33_t& rot_cw, const Vec3_t& trans_cw,
+      const eigen_alloc_vector<Vec3_t>& pos_ws,
+      eigen_alloc_vector<Vec3_t>& reprojs,
+      std::vector<unsigned char>& is_valid) const override final;
+
   //-------------------------
   // Parameters specific to this model
 
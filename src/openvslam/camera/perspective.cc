@@ -304,5 +304,71 @@ void perspective::undistort_keypoints(
   }
 }
 
+void perspective::convert_keypoints_to_bearings(
+    const std::vector<cv::KeyPoint>& undist_keypts,
+    eigen_alloc_vector<Vec3_t>& bearings) const {
+  bearings.reserve(bearings.size() + undist_keypts.size());
+  for (const auto& undist_keypt : undist_keypts) {
+    // call the final overrider directly to avoid the virtual dispatch
+    bearings.push_back(perspective::convert_point_to_bearing(undist_keypt.pt));
+  }
+}
+
+void perspective::reproject_points_to_image(
+    const Mat33_t& rot_cw, const Vec3_t& trans_cw,
+    const eigen_alloc_vector<Vec3_t>& pos_ws,
+    eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights,
+    std::vector<unsigned char>& is_valid) const {
+  // convert to camera-coordinates
+  const auto pos_cs = transform_points_to_camera(rot_cw, trans_cw, pos_ws);
+
+  // reproject onto the image
+  const Eigen::ArrayXd z_invs = pos_cs.col(2).array().inverse();
+  const Eigen::ArrayXd xs = fx_ * pos_cs.col(0).array() * z_invs + cx_;
+  const Eigen::ArrayXd ys = fy_ * pos_cs.col(1).array() * z_invs + cy_;
+  const Eigen::ArrayXd xs_right = xs - focal_x_baseline_ * z_invs;
+
+  // check if the points are visible
+  const auto num_pts = pos_ws.size();
+  reprojs.resize(num_pts);
+  x_rights.resize(num_pts);
+  is_valid.resize(num_pts);
+  for (unsigned long idx = 0; idx < num_pts; ++idx) {
+    reprojs[idx] = Vec2_t{xs(idx), ys(idx)};
+    x_rights[idx] = xs_right(idx);
+    is_valid[idx] = 0.0 < pos_cs(idx, 2) && img_bounds_.min_x_ < xs(idx) &&
+                    xs(idx) < img_bounds_.max_x_ &&
+                    img_bounds_.min_y_ < ys(idx) &&
+                    ys(idx) < img_bounds_.max_y_;
+  }
+}
+
+void perspective::reproject_points_to_bearings(
+    const Mat33_t& rot_cw, const Vec3_t& trans_cw,
+    const eigen_alloc_vector<Vec3_t>& pos_ws,
+    eigen_alloc_vector<Vec3_t>& reprojs,
+    std::vector<unsigned char>& is_valid) const {
+  // convert to camera-coordinates
+  const auto pos_cs = transform_points_to_camera(rot_cw, trans_cw, pos_ws);
+
+  // reproject onto the image
+  const Eigen::ArrayXd z_invs = pos_cs.col(2).array().inverse();
+  const Eigen::ArrayXd xs = fx_ * pos_cs.col(0).array() * z_invs + cx_;
+  const Eigen::ArrayXd ys = fy_ * pos_cs.col(1).array() * z_invs + cy_;
+  const Eigen::ArrayXd norms = pos_cs.rowwise().norm().array();
+
+  // convert to bearings and check if the points are visible
+  const auto num_pts = pos_ws.size();
+  reprojs.resize(num_pts);
+  is_valid.resize(num_pts);
+  for (unsigned long idx = 0; idx < num_pts; ++idx) {
+    reprojs[idx] = pos_cs.row(idx).transpose() / norms(idx);
+    is_valid[idx] = 0.0 < pos_cs(idx, 2) && img_bounds_.min_x_ < xs(idx) &&
+                    xs(idx) < img_bounds_.max_x_ &&
+                    img_bounds_.min_y_ < ys(idx) &&
+                    ys(idx) < img_bounds_.max_y_;
+  }
+}
+
 }  // namespace camera
 }  // namespace openvslam
@@ -4,6 +4,30 @@ namespace openvslam {
 namespace data {
 namespace bow_vocabulary_util {
 
+std::shared_ptr<data::bow_vocabulary> load_vocabulary(const std::string& path) {
+  auto bow_vocab = std::make_shared<data::bow_vocabulary>();
+  if (!load_vocabulary(bow_vocab.get(), path)) {
+    return nullptr;
+  }
+  return bow_vocab;
+}
+
+bool load_vocabulary(data::bow_vocabulary* bow_vocab, const std::string& path) {
+  try {
+#ifdef USE_DBOW2
+    bow_vocab->loadFromBinaryFile(path);
+#else
+    bow_vocab->readFromFile(path);
+    if (!bow_vocab->isValid()) {
+      return false;
+    }
+#endif
+  } catch (const std::exception&) {
+    return false;
+  }
+  return true;
+}
+
 void compute_bow(data::bow_vocabulary* bow_vocab, const cv::Mat& descriptors,
                  data::bow_vector& bow_vec,
                  data::bow_feature_vector& bow_feat_vec) {
@@ -10,10 +10,32 @@
 #include <fbow/vocabulary.h>
 #endif  // USE_DBOW2
 
+#include <memory>
+#include <string>
+
 namespace openvslam {
 namespace data {
 namespace bow_vocabulary_util {
 
+/**
+ * Load the vocabulary from the file
+ * (the vocabulary is never modified after loading, so one vocabulary can be
+ * shared among the SLAM systems in the process)
+ * @param path
+ * @return the vocabulary, or nullptr if the file cannot be loaded
+ */
+std::shared_ptr<data::bow_vocabulary> load_vocabulary(const std::string& path);
+
+/**
+ * Load the vocabulary from the file into the constructed vocabulary
+ * (used to load the vocabulary in the background while the system is
+ * constructed)
+ * @param bow_vocab
+ * @param path
+ * @return true if the vocabulary is loaded
+ */
+bool load_vocabulary(data::bow_vocabulary* bow_vocab, const std::string& path);
+
 void compute_bow(data::bow_vocabulary* bow_vocab, const cv::Mat& descriptors,
                  data::bow_vector& bow_vec,
                  data::bow_feature_vector& bow_feat_vec);
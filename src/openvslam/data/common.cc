@@ -2,9 +2,30 @@
 
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+
+#ifdef USE_DBOW2
+#include <DBoW2/BowVector.h>
+#include <DBoW2/FeatureVector.h>
+#else
+#include <fbow/bow_feat_vector.h>
+#include <fbow/bow_vector.h>
+#endif
+
 namespace openvslam {
 namespace data {
 
+namespace {
+
+//! type of the weights of the visual words
+#ifdef USE_DBOW2
+using bow_weight_t = double;
+#else
+using bow_weight_t = float;
+#endif
+
+}  // unnamed namespace
+
 nlohmann::json convert_rotation_to_json(const Mat33_t& rot_cw) {
   const Quat_t quat_cw(rot_cw);
   return {quat_cw.x(), quat_cw.y(), quat_cw.z(), quat_cw.w()};
@@ -100,6 +121,86 @@ cv::Mat convert_json_to_descriptors(const nlohmann::json& json_descriptors) {
   return descriptors;
 }
 
+nlohmann::json convert_bow_to_json(const bow_vector& bow_vec,
+                                   const bow_feature_vector& bow_feat_vec) {
+  std::vector<unsigned int> words;
+  std::vector<bow_weight_t> weights;
+  words.reserve(bow_vec.size());
+  weights.reserve(bow_vec.size());
+  for (const auto& word_weight : bow_vec) {
+    words.push_back(word_weight.first);
+    weights.push_back(static_cast<bow_weight_t>(word_weight.second));
+  }
+
+  std::vector<unsigned int> nodes;
+  std::vector<std::vector<unsigned int>> idxs;
+  nodes.reserve(bow_feat_vec.size());
+  idxs.reserve(bow_feat_vec.size());
+  for (const auto& node_idxs : bow_feat_vec) {
+    nodes.push_back(node_idxs.first);
+    idxs.emplace_back(node_idxs.second.begin(), node_idxs.second.end());
+  }
+
+  return {{"words", words},
+          {"weights", weights},
+          {"nodes", nodes},
+          {"idxs", idxs}};
+}
+
+void convert_json_to_bow(const nlohmann::json& json_bow, bow_vector& bow_vec,
+                         bow_feature_vector& bow_feat_vec) {
+  const auto& json_words = json_bow.at("words");
+  const auto& json_weights = json_bow.at("weights");
+  assert(json_words.size() == json_weights.size());
+  bow_vec.clear();
+  for (unsigned int i = 0; i < json_words.size(); ++i) {
+    bow_weight_t weight = json_weights.at(i).get<bow_weight_t>();
+    bow_vec[json_words.at(i).get<unsigned int>()] = weight;
+  }
+
+  const auto& json_nodes = json_bow.at("nodes");
+  const auto& json_idxs = json_bow.at("idxs");
+  assert(json_nodes.size() == json_idxs.size());
+  bow_feat_vec.clear();
+  for (unsigned int i = 0; i < json_nodes.size(); ++i) {
+    auto& idxs = bow_feat_vec[json_nodes.at(i).get<unsigned int>()];
+    for (const auto& json_idx : json_idxs.at(i)) {
+      idxs.push_back(json_idx.get<unsigned int>());
+    }
+  }
+}
+
+bool bow_is_equal(const bow_vector& bow_vec_1,
+                  const bow_feature_vector& bow_feat_vec_1,
+                  const bow_vector& bow_vec_2,
+                  const bow_feature_vector& bow_feat_vec_2) {
+  if (bow_vec_1.size() != bow_vec_2.size() ||
+      bow_feat_vec_1.size() != bow_feat_vec_2.size()) {
+    return false;
+  }
+  // the weights are compared exactly because they are stored losslessly
+  auto itr_1 = bow_vec_1.begin();
+  auto itr_2 = bow_vec_2.begin();
+  for (; itr_1 != bow_vec_1.end(); ++itr_1, ++itr_2) {
+    if (itr_1->first != itr_2->first ||
+        static_cast<bow_weight_t>(itr_1->second) !=
+            static_cast<bow_weight_t>(itr_2->second)) {
+      return false;
+    }
+  }
+  auto feat_itr_1 = bow_feat_vec_1.begin();
+  auto feat_itr_2 = bow_feat_vec_2.begin();
+  for (; feat_itr_1 != bow_feat_vec_1.end(); ++feat_itr_1, ++feat_itr_2) {
+    if (feat_itr_1->first != feat_itr_2->first ||
+        feat_itr_1->second.size() != feat_itr_2->second.size() ||
+        !std::equal(feat_itr_1->second.begin(), feat_itr_1->second.end(),
+                    feat_itr_2->second.begin())) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void assign_keypoints_to_grid(
     camera::base* camera, const std::vector<cv::KeyPoint>& undist_keypts,
     std::vector<std::vector<std::vector<unsigned int>>>&
@@ -134,42 +235,55 @@ auto assign_keypoints_to_grid(camera::base* camera,
   return keypt_indices_in_cells;
 }
 
-std::vector<unsigned int> get_keypoints_in_cell(
-    camera::base* camera, const std::vector<cv::KeyPoint>& undist_keypts,
-    const std::vector<std::vector<std::vector<unsigned int>>>&
-        keypt_indices_in_cells,
-    const float ref_x, const float ref_y, const float margin,
-    const int min_level, const int max_level) {
-  std::vector<unsigned int> indices;
-  indices.reserve(undist_keypts.size());
-
-  const int min_cell_idx_x =
+bool get_cell_range(camera::base* camera, const float ref_x, const float ref_y,
+                    const float margin, int& min_cell_idx_x,
+                    int& max_cell_idx_x, int& min_cell_idx_y,
+                    int& max_cell_idx_y) {
+  min_cell_idx_x =
       std::max(0, cvFloor((ref_x - camera->img_bounds_.min_x_ - margin) *
                           camera->inv_cell_width_));
   if (static_cast<int>(camera->num_grid_cols_) <= min_cell_idx_x) {
-    return indices;
+    return false;
   }
 
-  const int max_cell_idx_x =
+  max_cell_idx_x =
       std::min(static_cast<int>(camera->num_grid_cols_ - 1),
                cvCeil((ref_x - camera->img_bounds_.min_x_ + margin) *
                       camera->inv_cell_width_));
   if (max_cell_idx_x < 0) {
-    return indices;
+    return false;
   }
 
-  const int min_cell_idx_y =
+  min_cell_idx_y =
       std::max(0, cvFloor((ref_y - camera->img_bounds_.min_y_ - margin) *
                           camera->inv_cell_height_));
   if (static_cast<int>(camera->num_grid_rows_) <= min_cell_idx_y) {
-    return indices;
+    return false;
   }
 
-  const int max_cell_idx_y =
+  max_cell_idx_y =
       std::min(static_cast<int>(camera->num_grid_rows_ - 1),
                cvCeil((ref_y - camera->img_bounds_.min_y_ + margin) *
                       camera->inv_cell_height_));
   if (max_cell_idx_y < 0) {
+    return false;
+  }
+
+  return true;
+}
+
+std::vector<unsigned int> get_keypoints_in_cell(
+    camera::base* camera, const std::vector<cv::KeyPoint>& undist_keypts,
+    const std::vector<std::vector<std::vector<unsigned int>>>&
+        keypt_indices_in_cells,
+    const float ref_x, const float ref_y, const float margin,
+    const int min_level, const int max_level) {
+  std::vector<unsigned int> indices;
+  indices.reserve(undist_keypts.size());
+
+  int min_cell_idx_x, max_cell_idx_x, min_cell_idx_y, max_cell_idx_y;
+  if (!get_cell_range(camera, ref_x, ref_y, margin, min_cell_idx_x,
+                      max_cell_idx_x, min_cell_idx_y, max_cell_idx_y)) {
     return indices;
   }
 
@@ -210,5 +324,55 @@ std::vector<unsigned int> get_keypoints_in_cell(
   return indices;
 }
 
+std::vector<unsigned int> get_keypoints_in_cell(
+    camera::base* camera, const packed_keypoints& undist_keypts,
+    const keypoint_grid& keypt_indices_in_cells, const float ref_x,
+    const float ref_y, const float margin, const int min_level,
+    const int max_level) {
+  std::vector<unsigned int> indices;
+  indices.reserve(undist_keypts.size());
+
+  int min_cell_idx_x, max_cell_idx_x, min_cell_idx_y, max_cell_idx_y;
+  if (!get_cell_range(camera, ref_x, ref_y, margin, min_cell_idx_x,
+                      max_cell_idx_x, min_cell_idx_y, max_cell_idx_y)) {
+    return indices;
+  }
+
+  const bool check_level = (0 < min_level) || (0 <= max_level);
+
+  for (int cell_idx_x = min_cell_idx_x; cell_idx_x <= max_cell_idx_x;
+       ++cell_idx_x) {
+    for (int cell_idx_y = min_cell_idx_y; cell_idx_y <= max_cell_idx_y;
+         ++cell_idx_y) {
+      const auto cell_end =
+          keypt_indices_in_cells.cell_end(cell_idx_x, cell_idx_y);
+      for (auto itr = keypt_indices_in_cells.cell_begin(cell_idx_x, cell_idx_y);
+           itr != cell_end; ++itr) {
+        const auto idx = *itr;
+
+        if (check_level) {
+          const auto octave = undist_keypts.octave(idx);
+          if (octave < min_level) {
+            continue;
+          }
+          if (0 <= max_level && max_level < octave) {
+            continue;
+          }
+        }
+
+        const auto& undist_pt = undist_keypts.pt(idx);
+        const float dist_x = undist_pt.x - ref_x;
+        const float dist_y = undist_pt.y - ref_y;
+
+        if (std::abs(dist_x) < margin && std::abs(dist_y) < margin) {
+          indices.push_back(idx);
+        }
+      }
+    }
+  }
+
+  return indices;
+}
+
 }  // namespace data
 }  // namespace openvslam
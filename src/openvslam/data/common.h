@@ -5,6 +5,8 @@
 #include <opencv2/core.hpp>
 
 #include "openvslam/camera/base.h"
+#include "openvslam/data/bow_vocabulary_fwd.h"
+#include "openvslam/data/keyframe_observation.h"
 #include "openvslam/type.h"
 
 namespace openvslam {
@@ -35,6 +37,33 @@ nlohmann::json convert_descriptors_to_json(const cv::Mat& descriptors);
 
 cv::Mat convert_json_to_descriptors(const nlohmann::json& json_descriptors);
 
+/**
+ * Convert the BoW representation to JSON
+ * (stored with the keyframe so that it is not recomputed when loading)
+ * @param bow_vec
+ * @param bow_feat_vec
+ * @return
+ */
+nlohmann::json convert_bow_to_json(const bow_vector& bow_vec,
+                                   const bow_feature_vector& bow_feat_vec);
+
+/**
+ * Convert JSON to the BoW representation
+ * @param json_bow
+ * @param bow_vec
+ * @param bow_feat_vec
+ */
+void convert_json_to_bow(const nlohmann::json& json_bow, bow_vector& bow_vec,
+                         bow_feature_vector& bow_feat_vec);
+
+/**
+ * Returns true if the BoW representations are identical
+ */
+bool bow_is_equal(const bow_vector& bow_vec_1,
+                  const bow_feature_vector& bow_feat_vec_1,
+                  const bow_vector& bow_vec_2,
+                  const bow_feature_vector& bow_feat_vec_2);
+
 /**
  * Assign all keypoints to cells to accelerate projection matching
  * @param camera
@@ -76,6 +105,24 @@ inline bool get_cell_indices(camera::base* camera, const cv::KeyPoint& keypt,
           cell_idx_y < static_cast<int>(camera->num_grid_rows_));
 }
 
+/**
+ * Get the range of the cells which the square with the specified center and
+ * margin overlaps
+ * @param camera
+ * @param ref_x
+ * @param ref_y
+ * @param margin
+ * @param min_cell_idx_x
+ * @param max_cell_idx_x
+ * @param min_cell_idx_y
+ * @param max_cell_idx_y
+ * @return false if the square is out of the grid
+ */
+bool get_cell_range(camera::base* camera, const float ref_x, const float ref_y,
+                    const float margin, int& min_cell_idx_x,
+                    int& max_cell_idx_x, int& min_cell_idx_y,
+                    int& max_cell_idx_y);
+
 /**
  * Get keypoint indices in cell(s) in which the specified point is located
  * @param camera
@@ -95,6 +142,25 @@ std::vector<unsigned int> get_keypoints_in_cell(
     const float ref_x, const float ref_y, const float margin,
     const int min_level = -1, const int max_level = -1);
 
+/**
+ * Get keypoint indices in cell(s) in which the specified point is located
+ * (for the packed keypoints of keyframe_observation)
+ * @param camera
+ * @param undist_keypts
+ * @param keypt_indices_in_cells
+ * @param ref_x
+ * @param ref_y
+ * @param margin
+ * @param min_level
+ * @param max_level
+ * @return
+ */
+std::vector<unsigned int> get_keypoints_in_cell(
+    camera::base* camera, const packed_keypoints& undist_keypts,
+    const keypoint_grid& keypt_indices_in_cells, const float ref_x,
+    const float ref_y, const float margin, const int min_level = -1,
+    const int max_level = -1);
+
 }  // namespace data
 }  // namespace openvslam
 
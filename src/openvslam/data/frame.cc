@@ -11,17 +11,17 @@
 #include "openvslam/data/common.h"
 #include "openvslam/data/keyframe.h"
 #include "openvslam/data/landmark.h"
+#include "openvslam/data/speculative_bow.h"
 #include "openvslam/feature/orb_extractor.h"
 #include "openvslam/match/stereo.h"
 
 namespace openvslam {
 namespace data {
 
-std::atomic<unsigned int> frame::next_id_{0};
-
-frame::frame(const double timestamp, camera::base* camera,
-             feature::orb_params* orb_params, const frame_observation frm_obs)
-    : id_(next_id_++),
+frame::frame(const unsigned int id, const double timestamp,
+             camera::base* camera, feature::orb_params* orb_params,
+             const frame_observation frm_obs)
+    : id_(id),
       timestamp_(timestamp),
       camera_(camera),
       orb_params_(orb_params),
@@ -66,6 +66,11 @@ bool frame::bow_is_available() const {
 }
 
 void frame::compute_bow(bow_vocabulary* bow_vocab) {
+  if (speculative_bow_) {
+    speculative_bow_->get(bow_vocab, bow_vec_, bow_feat_vec_);
+    speculative_bow_ = nullptr;
+    return;
+  }
   bow_vocabulary_util::compute_bow(bow_vocab, frm_obs_.descriptors_, bow_vec_,
                                    bow_feat_vec_);
 }
@@ -37,6 +37,7 @@ namespace data {
 
 class keyframe;
 class landmark;
+class speculative_bow;
 
 class frame {
  public:
@@ -49,12 +50,13 @@ class frame {
 
   /**
    * Constructor for monocular frame
+   * @param id
    * @param timestamp
    * @param camera
    * @param orb_params
    * @param frm_obs
    */
-  frame(const double timestamp, camera::base* camera,
+  frame(const unsigned int id, const double timestamp, camera::base* camera,
         feature::orb_params* orb_params, const frame_observation frm_obs);
 
   /**
@@ -103,6 +105,7 @@ class frame {
 
   /**
    * Compute BoW representation
+   * (the speculative result is used if it is set)
    */
   void compute_bow(bow_vocabulary* bow_vocab);
 
@@ -134,11 +137,9 @@ class frame {
   Vec3_t triangulate_stereo(const unsigned int idx) const;
 
   //! current frame ID
+  //! (issued by map_database::next_frame_id_)
   unsigned int id_;
 
-  //! next frame ID
-  static std::atomic<unsigned int> next_id_;
-
   //! timestamp
   double timestamp_;
 
@@ -159,6 +160,9 @@ class frame {
   fbow::BoWVector bow_vec_;
   fbow::BoWFeatVector bow_feat_vec_;
 #endif
+  //! BoW representation computed ahead on the worker thread
+  //! (nullptr if it is not requested or already consumed)
+  std::shared_ptr<speculative_bow> speculative_bow_ = nullptr;
 
   //! landmarks, whose nullptr indicates no-association
   std::vector<std::shared_ptr<landmark>> landmarks_;
@@ -1,7 +1,10 @@
 #include "openvslam/data/graph_node.h"
 
+#include <algorithm>
+
 #include "openvslam/data/keyframe.h"
 #include "openvslam/data/landmark.h"
+#include "openvslam/data/map_database.h"
 
 namespace openvslam {
 namespace data {
@@ -9,151 +12,179 @@ namespace data {
 graph_node::graph_node(std::shared_ptr<keyframe>& keyfrm,
                        const bool spanning_parent_is_not_set)
     : owner_keyfrm_(keyfrm),
+      map_db_(keyfrm->map_db_),
       spanning_parent_is_not_set_(spanning_parent_is_not_set) {}
 
 void graph_node::add_connection(const std::shared_ptr<keyframe>& keyfrm,
                                 const unsigned int weight) {
   std::lock_guard<std::mutex> lock(mtx_);
+  const auto itr = connected_keyfrms_and_weights_.find(keyfrm->id_);
   bool need_update = false;
-  if (!connected_keyfrms_and_weights_.count(keyfrm)) {
+  if (itr == connected_keyfrms_and_weights_.end()) {
     // if `keyfrm` not exists
-    connected_keyfrms_and_weights_[keyfrm] = weight;
+    connected_keyfrms_and_weights_.emplace(keyfrm->id_,
+                                           std::make_pair(keyfrm, weight));
     need_update = true;
-  } else if (connected_keyfrms_and_weights_.at(keyfrm) != weight) {
+  } else if (itr->second.second != weight) {
     // if the weight is updated
-    connected_keyfrms_and_weights_.at(keyfrm) = weight;
+    itr->second.second = weight;
     need_update = true;
   }
 
   if (need_update) {
-    update_covisibility_orders_impl();
+    covisibility_orders_are_outdated_ = true;
+    ++map_db_->graph_epoch_;
   }
 }
 
 void graph_node::erase_connection(const std::shared_ptr<keyframe>& keyfrm) {
   std::lock_guard<std::mutex> lock(mtx_);
-  bool need_update = false;
-  if (connected_keyfrms_and_weights_.count(keyfrm)) {
-    connected_keyfrms_and_weights_.erase(keyfrm);
-    need_update = true;
-  }
-
-  if (need_update) {
-    update_covisibility_orders_impl();
+  if (connected_keyfrms_and_weights_.erase(keyfrm->id_)) {
+    covisibility_orders_are_outdated_ = true;
+    ++map_db_->graph_epoch_;
   }
 }
 
 void graph_node::erase_all_connections() {
   // remote myself from the connected keyframes
-  for (const auto& keyfrm_and_weight : connected_keyfrms_and_weights_) {
-    if (keyfrm_and_weight.first.expired()) {
+  for (const auto& id_and_keyfrm_weight : connected_keyfrms_and_weights_) {
+    const auto keyfrm = id_and_keyfrm_weight.second.first.lock();
+    if (!keyfrm) {
       continue;
     }
-    keyfrm_and_weight.first.lock()->graph_node_->erase_connection(
-        owner_keyfrm_.lock());
+    keyfrm->graph_node_->erase_connection(owner_keyfrm_.lock());
   }
   // remove the buffers
-  connected_keyfrms_and_weights_.clear();
-  ordered_covisibilities_.clear();
-  ordered_weights_.clear();
-}
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    connected_keyfrms_and_weights_.clear();
+    ordered_covisibilities_.clear();
+    ordered_weights_.clear();
+    covisibility_orders_are_outdated_ = false;
+  }
 
-void graph_node::update_connections() {
-  const auto landmarks = owner_keyfrm_.lock()->get_landmarks();
+  ++map_db_->graph_epoch_;
+}
 
-  std::map<std::weak_ptr<keyframe>, unsigned int,
-           std::owner_less<std::weak_ptr<keyframe>>>
-      keyfrm_weights;
-  for (const auto& lm : landmarks) {
-    if (!lm) {
-      continue;
-    }
-    if (lm->will_be_erased()) {
-      continue;
+void graph_node::update_num_shared_landmarks(
+    const std::shared_ptr<keyframe>& keyfrm, const int delta) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto itr = num_shared_lms_.find(keyfrm->id_);
+  if (itr == num_shared_lms_.end()) {
+    if (delta <= 0) {
+      return;
     }
+    itr = num_shared_lms_.emplace(keyfrm->id_, std::make_pair(keyfrm, 0u))
+              .first;
+  }
 
-    const auto observations = lm->get_observations();
-
-    for (const auto& obs : observations) {
-      auto keyfrm = obs.first;
-
-      if (*keyfrm.lock() == *owner_keyfrm_.lock()) {
-        continue;
-      }
-      // count up weight of `keyfrm`
-      keyfrm_weights[keyfrm]++;
-    }
+  const int num_shared_lms = static_cast<int>(itr->second.second) + delta;
+  if (num_shared_lms <= 0) {
+    num_shared_lms_.erase(itr);
+  } else {
+    itr->second.second = static_cast<unsigned int>(num_shared_lms);
   }
+}
 
-  if (keyfrm_weights.empty()) {
-    return;
+unsigned int graph_node::get_num_shared_landmarks(
+    const std::shared_ptr<keyframe>& keyfrm) const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  const auto itr = num_shared_lms_.find(keyfrm->id_);
+  if (itr == num_shared_lms_.end()) {
+    return 0;
   }
+  return itr->second.second;
+}
+
+void graph_node::update_connections() {
+  const auto owner_keyfrm = owner_keyfrm_.lock();
 
-  unsigned int max_weight = 0;
-  std::shared_ptr<keyframe> nearest_covisibility = nullptr;
+  // the numbers of the shared landmarks are used as the weights
+  // (they are maintained incrementally by the landmarks, so the observations
+  // of the landmarks do not need to be scanned here)
+  keyframe_weights_t keyfrm_weights;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    keyfrm_weights = num_shared_lms_;
+  }
 
   // vector for sorting
   std::vector<std::pair<unsigned int, std::shared_ptr<keyframe>>>
-      weight_covisibility_pairs;
-  weight_covisibility_pairs.reserve(keyfrm_weights.size());
-  for (const auto& keyfrm_weight : keyfrm_weights) {
-    auto keyfrm = keyfrm_weight.first.lock();
-    const auto weight = keyfrm_weight.second;
-
-    if (max_weight <= weight) {
-      max_weight = weight;
-      nearest_covisibility = keyfrm;
-    }
-
-    if (weight_thr_ < weight) {
-      weight_covisibility_pairs.emplace_back(std::make_pair(weight, keyfrm));
+      weight_keyfrm_pairs;
+  weight_keyfrm_pairs.reserve(keyfrm_weights.size());
+  for (auto itr = keyfrm_weights.begin(); itr != keyfrm_weights.end();) {
+    auto keyfrm = itr->second.first.lock();
+    if (!keyfrm || *keyfrm == *owner_keyfrm) {
+      itr = keyfrm_weights.erase(itr);
+      continue;
     }
-  }
-  // add ONE node at least
-  if (weight_covisibility_pairs.empty()) {
-    weight_covisibility_pairs.emplace_back(
-        std::make_pair(max_weight, nearest_covisibility));
+    weight_keyfrm_pairs.emplace_back(itr->second.second, keyfrm);
+    ++itr;
   }
 
-  // add connection from the covisibility to myself
-  for (const auto& weight_covisibility : weight_covisibility_pairs) {
-    auto covisibility = weight_covisibility.second;
-    const auto weight = weight_covisibility.first;
-    covisibility->graph_node_->add_connection(owner_keyfrm_.lock(), weight);
+  if (weight_keyfrm_pairs.empty()) {
+    return;
   }
 
-  // sort with weights
-  std::sort(weight_covisibility_pairs.rbegin(),
-            weight_covisibility_pairs.rend());
+  sort_by_weights(weight_keyfrm_pairs);
+  const auto nearest_covisibility = weight_keyfrm_pairs.front().second;
+
+  // the covisibilities have the weights over the threshold
+  // (add ONE node at least)
+  auto num_covisibilities = static_cast<unsigned int>(
+      std::find_if(weight_keyfrm_pairs.begin(), weight_keyfrm_pairs.end(),
+                   [](const std::pair<unsigned int,
+                                      std::shared_ptr<keyframe>>& pair) {
+                     return pair.first <= weight_thr_;
+                   }) -
+      weight_keyfrm_pairs.begin());
+  num_covisibilities = std::max(num_covisibilities, 1u);
 
   decltype(ordered_covisibilities_) ordered_covisibilities;
-  ordered_covisibilities.reserve(weight_covisibility_pairs.size());
+  ordered_covisibilities.reserve(num_covisibilities);
   decltype(ordered_weights_) ordered_weights;
-  ordered_weights.reserve(weight_covisibility_pairs.size());
-  for (const auto& weight_keyfrm_pair : weight_covisibility_pairs) {
+  ordered_weights.reserve(num_covisibilities);
+  for (unsigned int i = 0; i < num_covisibilities; ++i) {
+    const auto& weight_keyfrm_pair = weight_keyfrm_pairs.at(i);
+    // add connection from the covisibility to myself
+    weight_keyfrm_pair.second->graph_node_->add_connection(
+        owner_keyfrm, weight_keyfrm_pair.first);
     ordered_covisibilities.push_back(weight_keyfrm_pair.second);
     ordered_weights.push_back(weight_keyfrm_pair.first);
   }
 
+  bool graph_is_changed = false;
   {
     std::lock_guard<std::mutex> lock(mtx_);
 
-    connected_keyfrms_and_weights_ =
-        std::map<std::weak_ptr<keyframe>, unsigned int,
-                 std::owner_less<std::weak_ptr<keyframe>>>(
-            keyfrm_weights.begin(), keyfrm_weights.end());
-    ordered_covisibilities_ = ordered_covisibilities;
-    ordered_weights_ = ordered_weights;
+    // the local maps of the tracking are rebuilt only if the weights of the
+    // connections are changed
+    graph_is_changed =
+        keyfrm_weights.size() != connected_keyfrms_and_weights_.size();
+    for (auto itr = keyfrm_weights.begin();
+         !graph_is_changed && itr != keyfrm_weights.end(); ++itr) {
+      const auto connected = connected_keyfrms_and_weights_.find(itr->first);
+      graph_is_changed = connected == connected_keyfrms_and_weights_.end() ||
+                         connected->second.second != itr->second.second;
+    }
+
+    connected_keyfrms_and_weights_ = std::move(keyfrm_weights);
+    ordered_covisibilities_ = std::move(ordered_covisibilities);
+    ordered_weights_ = std::move(ordered_weights);
+    covisibility_orders_are_outdated_ = false;
 
-    if (spanning_parent_is_not_set_ && owner_keyfrm_.lock()->id_ != 0) {
+    if (spanning_parent_is_not_set_ && owner_keyfrm->id_ != 0) {
       // set the parent of spanning tree
-      assert(*nearest_covisibility == *ordered_covisibilities.front().lock());
       spanning_parent_ = nearest_covisibility;
-      nearest_covisibility->graph_node_->add_spanning_child(
-          owner_keyfrm_.lock());
+      nearest_covisibility->graph_node_->add_spanning_child(owner_keyfrm);
       spanning_parent_is_not_set_ = false;
+      graph_is_changed = true;
     }
   }
+
+  if (graph_is_changed) {
+    ++map_db_->graph_epoch_;
+  }
 }
 
 void graph_node::update_covisibility_orders() {
@@ -161,18 +192,21 @@ void graph_node::update_covisibility_orders() {
   update_covisibility_orders_impl();
 }
 
-void graph_node::update_covisibility_orders_impl() {
+void graph_node::update_covisibility_orders_impl() const {
   std::vector<std::pair<unsigned int, std::shared_ptr<keyframe>>>
       weight_keyfrm_pairs;
   weight_keyfrm_pairs.reserve(connected_keyfrms_and_weights_.size());
 
-  for (const auto& keyfrm_and_weight : connected_keyfrms_and_weights_) {
-    weight_keyfrm_pairs.emplace_back(std::make_pair(
-        keyfrm_and_weight.second, keyfrm_and_weight.first.lock()));
+  for (const auto& id_and_keyfrm_weight : connected_keyfrms_and_weights_) {
+    const auto keyfrm = id_and_keyfrm_weight.second.first.lock();
+    if (!keyfrm) {
+      continue;
+    }
+    weight_keyfrm_pairs.emplace_back(id_and_keyfrm_weight.second.second,
+                                     keyfrm);
   }
 
-  // sort with weights
-  std::sort(weight_keyfrm_pairs.rbegin(), weight_keyfrm_pairs.rend());
+  sort_by_weights(weight_keyfrm_pairs);
 
   ordered_covisibilities_.clear();
   ordered_covisibilities_.reserve(weight_keyfrm_pairs.size());
@@ -182,6 +216,27 @@ void graph_node::update_covisibility_orders_impl() {
     ordered_covisibilities_.push_back(weight_keyfrm_pair.second);
     ordered_weights_.push_back(weight_keyfrm_pair.first);
   }
+
+  covisibility_orders_are_outdated_ = false;
+}
+
+void graph_node::update_covisibility_orders_if_outdated() const {
+  if (covisibility_orders_are_outdated_) {
+    update_covisibility_orders_impl();
+  }
+}
+
+void graph_node::sort_by_weights(
+    std::vector<std::pair<unsigned int, std::shared_ptr<keyframe>>>&
+        weight_keyfrm_pairs) {
+  std::sort(weight_keyfrm_pairs.begin(), weight_keyfrm_pairs.end(),
+            [](const std::pair<unsigned int, std::shared_ptr<keyframe>>& a,
+               const std::pair<unsigned int, std::shared_ptr<keyframe>>& b) {
+              if (a.first != b.first) {
+                return a.first > b.first;
+              }
+              return a.second->id_ < b.second->id_;
+            });
 }
 
 std::set<std::shared_ptr<keyframe>> graph_node::get_connected_keyframes()
@@ -189,8 +244,8 @@ std::set<std::shared_ptr<keyframe>> graph_node::get_connected_keyframes()
   std::lock_guard<std::mutex> lock(mtx_);
   std::set<std::shared_ptr<keyframe>> keyfrms;
 
-  for (const auto& keyfrm_and_weight : connected_keyfrms_and_weights_) {
-    keyfrms.insert(keyfrm_and_weight.first.lock());
+  for (const auto& id_and_keyfrm_weight : connected_keyfrms_and_weights_) {
+    keyfrms.insert(id_and_keyfrm_weight.second.first.lock());
   }
 
   return keyfrms;
@@ -198,6 +253,7 @@ std::set<std::shared_ptr<keyframe>> graph_node::get_connected_keyframes()
 
 std::vector<std::shared_ptr<keyframe>> graph_node::get_covisibilities() const {
   std::lock_guard<std::mutex> lock(mtx_);
+  update_covisibility_orders_if_outdated();
   std::vector<std::shared_ptr<keyframe>> covisibilities;
 
   for (const auto& covisibility : ordered_covisibilities_) {
@@ -212,6 +268,7 @@ std::vector<std::shared_ptr<keyframe>> graph_node::get_covisibilities() const {
 std::vector<std::shared_ptr<keyframe>> graph_node::get_top_n_covisibilities(
     const unsigned int num_covisibilities) const {
   std::lock_guard<std::mutex> lock(mtx_);
+  update_covisibility_orders_if_outdated();
   std::vector<std::shared_ptr<keyframe>> covisibilities;
   unsigned int i = 0;
   for (const auto& covisibility : ordered_covisibilities_) {
@@ -230,6 +287,7 @@ std::vector<std::shared_ptr<keyframe>> graph_node::get_top_n_covisibilities(
 std::vector<std::shared_ptr<keyframe>>
 graph_node::get_covisibilities_over_weight(const unsigned int weight) const {
   std::lock_guard<std::mutex> lock(mtx_);
+  update_covisibility_orders_if_outdated();
 
   if (ordered_covisibilities_.empty()) {
     return std::vector<std::shared_ptr<keyframe>>();
@@ -249,16 +307,17 @@ graph_node::get_covisibilities_over_weight(const unsigned int weight) const {
 unsigned int graph_node::get_weight(
     const std::shared_ptr<keyframe>& keyfrm) const {
   std::lock_guard<std::mutex> lock(mtx_);
-  if (connected_keyfrms_and_weights_.count(keyfrm)) {
-    return connected_keyfrms_and_weights_.at(keyfrm);
-  } else {
+  const auto itr = connected_keyfrms_and_weights_.find(keyfrm->id_);
+  if (itr == connected_keyfrms_and_weights_.end()) {
     return 0;
   }
+  return itr->second.second;
 }
 
 void graph_node::set_spanning_parent(const std::shared_ptr<keyframe>& keyfrm) {
   std::lock_guard<std::mutex> lock(mtx_);
   spanning_parent_ = keyfrm;
+  ++map_db_->graph_epoch_;
 }
 
 std::shared_ptr<keyframe> graph_node::get_spanning_parent() const {
@@ -276,11 +335,13 @@ void graph_node::change_spanning_parent(
 void graph_node::add_spanning_child(const std::shared_ptr<keyframe>& keyfrm) {
   std::lock_guard<std::mutex> lock(mtx_);
   spanning_children_.insert(keyfrm);
+  ++map_db_->graph_epoch_;
 }
 
 void graph_node::erase_spanning_child(const std::shared_ptr<keyframe>& keyfrm) {
   std::lock_guard<std::mutex> lock(mtx_);
   spanning_children_.erase(keyfrm);
+  ++map_db_->graph_epoch_;
 }
 
 void graph_node::recover_spanning_connections() {
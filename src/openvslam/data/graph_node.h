@@ -1,16 +1,18 @@
 #ifndef OPENVSLAM_DATA_GRAPH_NODE_H
 #define OPENVSLAM_DATA_GRAPH_NODE_H
 
-#include <map>
 #include <memory>
 #include <mutex>
 #include <set>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace openvslam {
 namespace data {
 
 class keyframe;
+class map_database;
 
 class graph_node {
  public:
@@ -45,8 +47,21 @@ class graph_node {
   void erase_all_connections();
 
   /**
-   * Update the connections and the covisibilities by referring landmark
-   * observations
+   * Add the delta to the number of the landmarks shared with the keyframe
+   * (called by the landmarks whenever their observations are changed)
+   */
+  void update_num_shared_landmarks(const std::shared_ptr<keyframe>& keyfrm,
+                                   const int delta);
+
+  /**
+   * Get the number of the landmarks shared with the keyframe
+   */
+  unsigned int get_num_shared_landmarks(
+      const std::shared_ptr<keyframe>& keyfrm) const;
+
+  /**
+   * Update the connections and the covisibilities by referring the numbers of
+   * the shared landmarks
    */
   void update_connections();
 
@@ -147,11 +162,30 @@ class graph_node {
   bool has_loop_edge() const;
 
  private:
+  //! keyframes and their weights keyed by the keyframe IDs
+  using keyframe_weights_t =
+      std::unordered_map<unsigned int,
+                         std::pair<std::weak_ptr<keyframe>, unsigned int>>;
+
   /**
    * Update the order of the covisibilities (without mutex)
    * (NOTE: the new keyframe won't inserted)
    */
-  void update_covisibility_orders_impl();
+  void update_covisibility_orders_impl() const;
+
+  /**
+   * Update the order of the covisibilities if the connections have been
+   * changed since the last update (without mutex)
+   */
+  void update_covisibility_orders_if_outdated() const;
+
+  /**
+   * Sort the pairs of the weights and the keyframes in descending order of the
+   * weights (the ties are sorted in ascending order of the IDs)
+   */
+  static void sort_by_weights(
+      std::vector<std::pair<unsigned int, std::shared_ptr<keyframe>>>&
+          weight_keyfrm_pairs);
 
   /**
    * Extract intersection from the two lists of keyframes
@@ -163,17 +197,26 @@ class graph_node {
   //! keyframe of this node
   std::weak_ptr<keyframe> const owner_keyfrm_;
 
+  //! map database which the keyframe belongs to
+  //! (its graph epoch is incremented when this node is modified)
+  map_database* const map_db_;
+
+  //! numbers of the landmarks shared with the other keyframes
+  //! (maintained incrementally by the landmarks)
+  keyframe_weights_t num_shared_lms_;
+
   //! all connected keyframes and their weights
-  std::map<std::weak_ptr<keyframe>, unsigned int,
-           std::owner_less<std::weak_ptr<keyframe>>>
-      connected_keyfrms_and_weights_;
+  keyframe_weights_t connected_keyfrms_and_weights_;
 
   //! minimum threshold for covisibility graph connection
   static constexpr unsigned int weight_thr_ = 15;
   //! covisibility keyframe in descending order ot weights
-  std::vector<std::weak_ptr<keyframe>> ordered_covisibilities_;
+  //! (sorted lazily when the covisibilities are accessed)
+  mutable std::vector<std::weak_ptr<keyframe>> ordered_covisibilities_;
   //! weights in descending order
-  std::vector<unsigned int> ordered_weights_;
+  mutable std::vector<unsigned int> ordered_weights_;
+  //! the connections have been changed since the last sort or not
+  mutable bool covisibility_orders_are_outdated_ = false;
 
   //! parent of spanning tree
   std::weak_ptr<keyframe> spanning_parent_;
@@ -11,23 +11,25 @@
 #include "openvslam/data/frame.h"
 #include "openvslam/data/landmark.h"
 #include "openvslam/data/map_database.h"
+#include "openvslam/data/speculative_bow.h"
 #include "openvslam/feature/orb_params.h"
 #include "openvslam/util/converter.h"
 
 namespace openvslam {
 namespace data {
 
-std::atomic<unsigned int> keyframe::next_id_{0};
-
-keyframe::keyframe(const frame& frm)
-    : id_(next_id_++),
+keyframe::keyframe(const unsigned int id, const frame& frm,
+                   map_database* map_db)
+    : id_(id),
       src_frm_id_(frm.id_),
       timestamp_(frm.timestamp_),
+      map_db_(map_db),
       camera_(frm.camera_),
       orb_params_(frm.orb_params_),
       frm_obs_(frm.frm_obs_),
       bow_vec_(frm.bow_vec_),
       bow_feat_vec_(frm.bow_feat_vec_),
+      speculative_bow_(frm.speculative_bow_),
       landmarks_(frm.landmarks_) {
   // set pose parameters (cam_pose_wc_, cam_center_) using frm.cam_pose_cw_
   set_cam_pose(frm.cam_pose_cw_);
@@ -37,10 +39,12 @@ keyframe::keyframe(const unsigned int id, const unsigned int src_frm_id,
                    const double timestamp, const Mat44_t& cam_pose_cw,
                    camera::base* camera, const feature::orb_params* orb_params,
                    const frame_observation& frm_obs, const bow_vector& bow_vec,
-                   const bow_feature_vector& bow_feat_vec)
+                   const bow_feature_vector& bow_feat_vec,
+                   map_database* map_db)
     : id_(id),
       src_frm_id_(src_frm_id),
       timestamp_(timestamp),
+      map_db_(map_db),
       camera_(camera),
       orb_params_(orb_params),
       frm_obs_(frm_obs),
@@ -61,9 +65,11 @@ keyframe::keyframe(const unsigned int id, const unsigned int src_frm_id,
 
 keyframe::~keyframe() {}
 
-std::shared_ptr<keyframe> keyframe::make_keyframe(const frame& frm) {
-  auto ptr =
-      std::allocate_shared<keyframe>(Eigen::aligned_allocator<keyframe>(), frm);
+std::shared_ptr<keyframe> keyframe::make_keyframe(const unsigned int id,
+                                                  const frame& frm,
+                                                  map_database* map_db) {
+  auto ptr = std::allocate_shared<keyframe>(
+      Eigen::aligned_allocator<keyframe>(), id, frm, map_db);
   // covisibility graph node (connections is not assigned yet)
   ptr->graph_node_ = openvslam::make_unique<graph_node>(ptr, true);
   return ptr;
@@ -73,16 +79,17 @@ std::shared_ptr<keyframe> keyframe::make_keyframe(
     const unsigned int id, const unsigned int src_frm_id,
     const double timestamp, const Mat44_t& cam_pose_cw, camera::base* camera,
     const feature::orb_params* orb_params, const frame_observation& frm_obs,
-    const bow_vector& bow_vec, const bow_feature_vector& bow_feat_vec) {
+    const bow_vector& bow_vec, const bow_feature_vector& bow_feat_vec,
+    map_database* map_db) {
   auto ptr = std::allocate_shared<keyframe>(
       Eigen::aligned_allocator<keyframe>(), id, src_frm_id, timestamp,
-      cam_pose_cw, camera, orb_params, frm_obs, bow_vec, bow_feat_vec);
+      cam_pose_cw, camera, orb_params, frm_obs, bow_vec, bow_feat_vec, map_db);
   // covisibility graph node (connections is not assigned yet)
   ptr->graph_node_ = openvslam::make_unique<graph_node>(ptr, false);
   return ptr;
 }
 
-nlohmann::json keyframe::to_json() const {
+nlohmann::json keyframe::to_json(const bool store_bow) const {
   // extract landmark IDs
   std::vector<int> landmark_ids(landmarks_.size(), -1);
   for (unsigned int i = 0; i < landmark_ids.size(); ++i) {
@@ -109,7 +116,7 @@ nlohmann::json keyframe::to_json() const {
     loop_edge_ids.push_back(loop_edge->id_);
   }
 
-  return {
+  nlohmann::json json_keyfrm = {
       {"src_frm_id", src_frm_id_},
       {"ts", timestamp_},
       {"cam", camera_->name_},
@@ -119,8 +126,9 @@ nlohmann::json keyframe::to_json() const {
       {"trans_cw", convert_translation_to_json(cam_pose_cw_.block<3, 1>(0, 3))},
       // features and observations
       {"n_keypts", frm_obs_.num_keypts_},
-      {"keypts", convert_keypoints_to_json(frm_obs_.keypts_)},
-      {"undists", convert_undistorted_to_json(frm_obs_.undist_keypts_)},
+      {"keypts", convert_keypoints_to_json(frm_obs_.keypts_.unpack())},
+      {"undists",
+       convert_undistorted_to_json(frm_obs_.undist_keypts_.unpack())},
       {"x_rights", frm_obs_.stereo_x_right_},
       {"depths", frm_obs_.depths_},
       {"descs", convert_descriptors_to_json(frm_obs_.descriptors_)},
@@ -129,6 +137,11 @@ nlohmann::json keyframe::to_json() const {
       {"span_parent", spanning_parent ? spanning_parent->id_ : -1},
       {"span_children", spanning_child_ids},
       {"loop_edges", loop_edge_ids}};
+  // the BoW representation is cached to skip computing it when loading
+  if (store_bow && bow_is_available()) {
+    json_keyfrm["bow"] = convert_bow_to_json(bow_vec_, bow_feat_vec_);
+  }
+  return json_keyfrm;
 }
 
 void keyframe::set_cam_pose(const Mat44_t& cam_pose_cw) {
@@ -179,6 +192,11 @@ bool keyframe::bow_is_available() const {
 }
 
 void keyframe::compute_bow(bow_vocabulary* bow_vocab) {
+  if (speculative_bow_) {
+    speculative_bow_->get(bow_vocab, bow_vec_, bow_feat_vec_);
+    speculative_bow_ = nullptr;
+    return;
+  }
   bow_vocabulary_util::compute_bow(bow_vocab, frm_obs_.descriptors_, bow_vec_,
                                    bow_feat_vec_);
 }
@@ -277,6 +295,17 @@ std::vector<unsigned int> keyframe::get_keypoints_in_cell(
                                      ref_y, margin);
 }
 
+Vec3_t keyframe::get_bearing(const unsigned int idx) const {
+  return camera_->convert_point_to_bearing(frm_obs_.undist_keypts_.pt(idx));
+}
+
+eigen_alloc_vector<Vec3_t> keyframe::get_bearings() const {
+  eigen_alloc_vector<Vec3_t> bearings;
+  camera_->convert_keypoints_to_bearings(frm_obs_.undist_keypts_.unpack(),
+                                         bearings);
+  return bearings;
+}
+
 Vec3_t keyframe::triangulate_stereo(const unsigned int idx) const {
   assert(camera_->setup_type_ != camera::setup_type_t::Monocular);
 
@@ -378,6 +407,27 @@ bool keyframe::depth_is_avaliable() const {
   return camera_->setup_type_ != camera::setup_type_t::Monocular;
 }
 
+bool keyframe::observation_is_checked_for_redundancy(
+    const unsigned int idx) const {
+  if (!depth_is_avaliable()) {
+    return true;
+  }
+  const auto depth = frm_obs_.depths_.at(idx);
+  return 0.0 <= depth && depth <= camera_->depth_thr_;
+}
+
+void keyframe::update_redundant_observation_counts(
+    const int num_valid_obs_delta, const int num_redundant_obs_delta) {
+  num_valid_obs_ += num_valid_obs_delta;
+  num_redundant_obs_ += num_redundant_obs_delta;
+}
+
+void keyframe::get_redundant_observation_counts(
+    unsigned int& num_valid_obs, unsigned int& num_redundant_obs) const {
+  num_valid_obs = static_cast<unsigned int>(num_valid_obs_.load());
+  num_redundant_obs = static_cast<unsigned int>(num_redundant_obs_.load());
+}
+
 void keyframe::set_not_to_be_erased() { cannot_be_erased_ = true; }
 
 void keyframe::set_to_be_erased() {
@@ -388,7 +438,7 @@ void keyframe::set_to_be_erased() {
 
 void keyframe::prepare_for_erasing(map_database* map_db, bow_database* bow_db) {
   // cannot erase the origin
-  if (*this == *(map_db->origin_keyfrm_)) {
+  if (map_db->origin_keyfrm_ && *this == *(map_db->origin_keyfrm_)) {
     return;
   }
 
@@ -431,6 +481,8 @@ void keyframe::prepare_for_erasing(map_database* map_db, bow_database* bow_db) {
   bow_db->erase_keyframe(shared_from_this());
 }
 
+void keyframe::prepare_for_eviction() { will_be_erased_ = true; }
+
 bool keyframe::will_be_erased() { return will_be_erased_; }
 
 }  // namespace data
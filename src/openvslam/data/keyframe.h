@@ -12,6 +12,7 @@
 #include "openvslam/camera/base.h"
 #include "openvslam/data/bow_vocabulary.h"
 #include "openvslam/data/frame_observation.h"
+#include "openvslam/data/keyframe_observation.h"
 #include "openvslam/data/graph_node.h"
 #include "openvslam/feature/orb_params.h"
 #include "openvslam/type.h"
@@ -36,6 +37,7 @@ class frame;
 class landmark;
 class map_database;
 class bow_database;
+class speculative_bow;
 
 class keyframe : public std::enable_shared_from_this<keyframe> {
  public:
@@ -44,7 +46,7 @@ class keyframe : public std::enable_shared_from_this<keyframe> {
   /**
    * Constructor for building from a frame
    */
-  explicit keyframe(const frame& frm);
+  keyframe(const unsigned int id, const frame& frm, map_database* map_db);
 
   /**
    * Constructor for map loading
@@ -55,16 +57,19 @@ class keyframe : public std::enable_shared_from_this<keyframe> {
            const double timestamp, const Mat44_t& cam_pose_cw,
            camera::base* camera, const feature::orb_params* orb_params,
            const frame_observation& frm_obs, const bow_vector& bow_vec,
-           const bow_feature_vector& bow_feat_vec);
+           const bow_feature_vector& bow_feat_vec, map_database* map_db);
   virtual ~keyframe();
 
   // Factory method for create keyframe
-  static std::shared_ptr<keyframe> make_keyframe(const frame& frm);
+  static std::shared_ptr<keyframe> make_keyframe(const unsigned int id,
+                                                 const frame& frm,
+                                                 map_database* map_db);
   static std::shared_ptr<keyframe> make_keyframe(
       const unsigned int id, const unsigned int src_frm_id,
       const double timestamp, const Mat44_t& cam_pose_cw, camera::base* camera,
       const feature::orb_params* orb_params, const frame_observation& frm_obs,
-      const bow_vector& bow_vec, const bow_feature_vector& bow_feat_vec);
+      const bow_vector& bow_vec, const bow_feature_vector& bow_feat_vec,
+      map_database* map_db);
 
   // operator overrides
   bool operator==(const keyframe& keyfrm) const { return id_ == keyfrm.id_; }
@@ -76,8 +81,10 @@ class keyframe : public std::enable_shared_from_this<keyframe> {
 
   /**
    * Encode this keyframe information as JSON
+   * @param store_bow if true, the BoW representation is also stored to skip
+   * computing it when loading
    */
-  nlohmann::json to_json() const;
+  nlohmann::json to_json(const bool store_bow = true) const;
 
   //-----------------------------------------
   // camera pose
@@ -127,6 +134,7 @@ class keyframe : public std::enable_shared_from_this<keyframe> {
 
   /**
    * Compute BoW representation
+   * (the speculative result inherited from the frame is used if it is set)
    */
   void compute_bow(bow_vocabulary* bow_vocab);
 
@@ -180,6 +188,17 @@ class keyframe : public std::enable_shared_from_this<keyframe> {
                                                   const float ref_y,
                                                   const float margin) const;
 
+  /**
+   * Get the bearing vector of the keypoint
+   * (computed from the undistorted keypoint because it is not stored)
+   */
+  Vec3_t get_bearing(const unsigned int idx) const;
+
+  /**
+   * Get the bearing vectors of all of the keypoints
+   */
+  eigen_alloc_vector<Vec3_t> get_bearings() const;
+
   /**
    * Triangulate the keypoint using the disparity
    */
@@ -195,6 +214,28 @@ class keyframe : public std::enable_shared_from_this<keyframe> {
    */
   bool depth_is_avaliable() const;
 
+  //-----------------------------------------
+  // redundancy of observations
+
+  /**
+   * Whether the observation at keypoint idx is checked for the redundancy
+   * (the observation out of the valid depth range is not checked)
+   */
+  bool observation_is_checked_for_redundancy(const unsigned int idx) const;
+
+  /**
+   * Update the numbers of the valid and the redundant observations
+   * (called by the landmarks whenever their observations are changed)
+   */
+  void update_redundant_observation_counts(const int num_valid_obs_delta,
+                                           const int num_redundant_obs_delta);
+
+  /**
+   * Get the numbers of the valid and the redundant observations
+   */
+  void get_redundant_observation_counts(unsigned int& num_valid_obs,
+                                        unsigned int& num_redundant_obs) const;
+
   //-----------------------------------------
   // flags
 
@@ -213,6 +254,13 @@ class keyframe : public std::enable_shared_from_this<keyframe> {
    */
   void prepare_for_erasing(map_database* map_db, bow_database* bow_db);
 
+  /**
+   * Raise the flag of erasing without modifying the map
+   * (used when the keyframe is evicted with its map tile, which is detached
+   * from the map by map_database::erase_tile())
+   */
+  void prepare_for_eviction();
+
   /**
    * Whether this keyframe will be erased shortly or not
    */
@@ -222,9 +270,8 @@ class keyframe : public std::enable_shared_from_this<keyframe> {
   // meta information
 
   //! keyframe ID
+  //! (issued by map_database::next_keyframe_id_)
   unsigned int id_;
-  //! next keyframe ID
-  static std::atomic<unsigned int> next_id_;
 
   //! source frame ID
   const unsigned int src_frm_id_;
@@ -232,6 +279,9 @@ class keyframe : public std::enable_shared_from_this<keyframe> {
   //! timestamp in seconds
   const double timestamp_;
 
+  //! map database which the keyframe belongs to
+  map_database* const map_db_;
+
   //-----------------------------------------
   // camera parameters
 
@@ -247,7 +297,8 @@ class keyframe : public std::enable_shared_from_this<keyframe> {
   //-----------------------------------------
   // constant observations
 
-  const frame_observation frm_obs_;
+  //! observations packed into the compact arrays
+  const keyframe_observation frm_obs_;
 
   //! BoW features (DBoW2 or FBoW)
 #ifdef USE_DBOW2
@@ -257,6 +308,9 @@ class keyframe : public std::enable_shared_from_this<keyframe> {
   fbow::BoWVector bow_vec_;
   fbow::BoWFeatVector bow_feat_vec_;
 #endif
+  //! BoW representation computed ahead for the source frame
+  //! (nullptr if it is not inherited or already consumed)
+  std::shared_ptr<speculative_bow> speculative_bow_ = nullptr;
 
   //-----------------------------------------
   // covisibility graph
@@ -285,6 +339,11 @@ class keyframe : public std::enable_shared_from_this<keyframe> {
   //! observed landmarks
   std::vector<std::shared_ptr<landmark>> landmarks_;
 
+  //! number of the observations which are checked for the redundancy
+  std::atomic<int> num_valid_obs_{0};
+  //! number of the observations which are redundant
+  std::atomic<int> num_redundant_obs_{0};
+
   //-----------------------------------------
   // flags
 
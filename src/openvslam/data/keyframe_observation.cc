@@ -0,0 +1,88 @@
+#include "openvslam/data/keyframe_observation.h"
+
+#include <cassert>
+#include <limits>
+
+#include "openvslam/data/frame_observation.h"
+
+namespace openvslam {
+namespace data {
+
+packed_keypoints::packed_keypoints(const std::vector<cv::KeyPoint>& keypts) {
+  pts_.reserve(keypts.size());
+  angles_.reserve(keypts.size());
+  octaves_.reserve(keypts.size());
+  for (const auto& keypt : keypts) {
+    assert(0 <= keypt.octave &&
+           keypt.octave <= std::numeric_limits<unsigned char>::max());
+    pts_.push_back(keypt.pt);
+    angles_.push_back(keypt.angle);
+    octaves_.push_back(static_cast<unsigned char>(keypt.octave));
+  }
+}
+
+std::vector<cv::KeyPoint> packed_keypoints::unpack() const {
+  std::vector<cv::KeyPoint> keypts;
+  keypts.reserve(pts_.size());
+  for (unsigned int idx = 0; idx < pts_.size(); ++idx) {
+    keypts.push_back(at(idx));
+  }
+  return keypts;
+}
+
+std::size_t packed_keypoints::get_memory_footprint() const {
+  return pts_.capacity() * sizeof(cv::Point2f) +
+         angles_.capacity() * sizeof(float) +
+         octaves_.capacity() * sizeof(unsigned char);
+}
+
+keypoint_grid::keypoint_grid(
+    const std::vector<std::vector<std::vector<unsigned int>>>&
+        keypt_indices_in_cells) {
+  num_rows_ =
+      keypt_indices_in_cells.empty() ? 0 : keypt_indices_in_cells.front().size();
+
+  // Count the keypoints in each of the cells
+  offsets_.reserve(keypt_indices_in_cells.size() * num_rows_ + 1);
+  offsets_.push_back(0);
+  for (const auto& keypt_indices_in_row : keypt_indices_in_cells) {
+    assert(keypt_indices_in_row.size() == num_rows_);
+    for (const auto& keypt_indices_in_cell : keypt_indices_in_row) {
+      offsets_.push_back(offsets_.back() + keypt_indices_in_cell.size());
+    }
+  }
+
+  // Concatenate the keypoint indices with keeping the order in each cell
+  indices_.reserve(offsets_.back());
+  for (const auto& keypt_indices_in_row : keypt_indices_in_cells) {
+    for (const auto& keypt_indices_in_cell : keypt_indices_in_row) {
+      indices_.insert(indices_.end(), keypt_indices_in_cell.begin(),
+                      keypt_indices_in_cell.end());
+    }
+  }
+}
+
+std::size_t keypoint_grid::get_memory_footprint() const {
+  return (offsets_.capacity() + indices_.capacity()) * sizeof(unsigned int);
+}
+
+keyframe_observation::keyframe_observation(const frame_observation& frm_obs)
+    : num_keypts_(frm_obs.num_keypts_),
+      keypts_(frm_obs.keypts_),
+      descriptors_(frm_obs.descriptors_),
+      undist_keypts_(frm_obs.undist_keypts_),
+      stereo_x_right_(frm_obs.stereo_x_right_),
+      depths_(frm_obs.depths_),
+      keypt_indices_in_cells_(frm_obs.keypt_indices_in_cells_) {}
+
+std::size_t keyframe_observation::get_memory_footprint() const {
+  return sizeof(keyframe_observation) + keypts_.get_memory_footprint() +
+         descriptors_.total() * descriptors_.elemSize() +
+         undist_keypts_.get_memory_footprint() +
+         stereo_x_right_.capacity() * sizeof(float) +
+         depths_.capacity() * sizeof(float) +
+         keypt_indices_in_cells_.get_memory_footprint();
+}
+
+}  // namespace data
+}  // namespace openvslam
@@ -0,0 +1,164 @@
+#ifndef OPENVSLAM_DATA_KEYFRAME_OBSERVATION_H
+#define OPENVSLAM_DATA_KEYFRAME_OBSERVATION_H
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+#include "openvslam/type.h"
+
+namespace openvslam {
+namespace data {
+
+struct frame_observation;
+
+/**
+ * Keypoints packed into the arrays of the positions, the orientations and the
+ * scale levels
+ * (the size and the response of the keypoints are not retained)
+ */
+class packed_keypoints {
+ public:
+  /**
+   * Constructor
+   */
+  packed_keypoints() = default;
+
+  /**
+   * Constructor for packing the keypoints
+   */
+  explicit packed_keypoints(const std::vector<cv::KeyPoint>& keypts);
+
+  /**
+   * Get the keypoint restored from the packed arrays
+   */
+  cv::KeyPoint at(const unsigned int idx) const {
+    return cv::KeyPoint(pts_.at(idx), 0, angles_.at(idx), 0,
+                        octaves_.at(idx));
+  }
+
+  /**
+   * Get the position of the keypoint
+   */
+  const cv::Point2f& pt(const unsigned int idx) const { return pts_.at(idx); }
+
+  /**
+   * Get the scale level of the keypoint
+   */
+  int octave(const unsigned int idx) const { return octaves_.at(idx); }
+
+  /**
+   * Get the number of the keypoints
+   */
+  unsigned int size() const { return pts_.size(); }
+
+  /**
+   * Returns true if there is no keypoint
+   */
+  bool empty() const { return pts_.empty(); }
+
+  /**
+   * Restore all of the keypoints
+   */
+  std::vector<cv::KeyPoint> unpack() const;
+
+  /**
+   * Get the number of bytes allocated for the arrays
+   */
+  std::size_t get_memory_footprint() const;
+
+ private:
+  //! positions
+  std::vector<cv::Point2f> pts_;
+  //! orientations [deg]
+  std::vector<float> angles_;
+  //! scale levels
+  std::vector<unsigned char> octaves_;
+};
+
+/**
+ * Keypoint indices in each of the cells, which are stored in one array in the
+ * compressed sparse row format
+ */
+class keypoint_grid {
+ public:
+  /**
+   * Constructor
+   */
+  keypoint_grid() = default;
+
+  /**
+   * Constructor for compressing the keypoint indices in each of the cells
+   */
+  explicit keypoint_grid(
+      const std::vector<std::vector<std::vector<unsigned int>>>&
+          keypt_indices_in_cells);
+
+  /**
+   * Get the pointer to the first keypoint index in the cell
+   */
+  const unsigned int* cell_begin(const unsigned int cell_idx_x,
+                                 const unsigned int cell_idx_y) const {
+    return indices_.data() + offsets_.at(cell_idx_x * num_rows_ + cell_idx_y);
+  }
+
+  /**
+   * Get the pointer to the next of the last keypoint index in the cell
+   */
+  const unsigned int* cell_end(const unsigned int cell_idx_x,
+                               const unsigned int cell_idx_y) const {
+    return indices_.data() +
+           offsets_.at(cell_idx_x * num_rows_ + cell_idx_y + 1);
+  }
+
+  /**
+   * Get the number of bytes allocated for the arrays
+   */
+  std::size_t get_memory_footprint() const;
+
+ private:
+  //! number of the rows of the grid
+  unsigned int num_rows_ = 0;
+  //! offsets of the cells in indices_ (the cells are ordered column by column)
+  std::vector<unsigned int> offsets_;
+  //! keypoint indices of all of the cells
+  std::vector<unsigned int> indices_;
+};
+
+/**
+ * Compact copy of frame_observation retained by a keyframe
+ * (the bearings are not stored because they can be computed from the
+ * undistorted keypoints with the camera model)
+ */
+struct keyframe_observation {
+  keyframe_observation() = default;
+
+  /**
+   * Constructor for packing the observation of a frame
+   */
+  explicit keyframe_observation(const frame_observation& frm_obs);
+
+  /**
+   * Get the number of bytes allocated for the observation
+   */
+  std::size_t get_memory_footprint() const;
+
+  //! number of keypoints
+  unsigned int num_keypts_ = 0;
+  //! keypoints of monocular or stereo left image
+  packed_keypoints keypts_;
+  //! descriptors
+  cv::Mat descriptors_;
+  //! undistorted keypoints of monocular or stereo left image
+  packed_keypoints undist_keypts_;
+  //! disparities
+  std::vector<float> stereo_x_right_;
+  //! depths
+  std::vector<float> depths_;
+  //! keypoint indices in each of the cells
+  keypoint_grid keypt_indices_in_cells_;
+};
+
+}  // namespace data
+}  // namespace openvslam
+
+#endif  // OPENVSLAM_DATA_KEYFRAME_OBSERVATION_H
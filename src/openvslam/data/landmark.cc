@@ -1,5 +1,6 @@
 #include "openvslam/data/landmark.h"
 
+#include <algorithm>
 #include <nlohmann/json.hpp>
 
 #include "openvslam/data/frame.h"
@@ -10,12 +11,10 @@
 namespace openvslam {
 namespace data {
 
-std::atomic<unsigned int> landmark::next_id_{0};
-
 landmark::landmark(const Vec3_t& pos_w,
                    const std::shared_ptr<keyframe>& ref_keyfrm,
                    map_database* map_db)
-    : id_(next_id_++),
+    : id_(map_db->next_landmark_id_++),
       first_keyfrm_id_(ref_keyfrm->id_),
       pos_w_(pos_w),
       ref_keyfrm_(ref_keyfrm),
@@ -61,16 +60,33 @@ void landmark::add_observation(const std::shared_ptr<keyframe>& keyfrm,
     return;
   }
   observations_[keyfrm] = idx;
+  update_num_shared_landmarks(keyfrm, 1);
 
   if (0 <= keyfrm->frm_obs_.stereo_x_right_.at(idx)) {
     num_observations_ += 2;
   } else {
     num_observations_ += 1;
   }
+
+  if (keyfrm->observation_is_checked_for_redundancy(idx)) {
+    obs_is_redundant_[keyfrm] = false;
+    keyfrm->update_redundant_observation_counts(1, 0);
+  }
+  update_redundancy();
 }
 
 void landmark::erase_observation(map_database* map_db,
                                  const std::shared_ptr<keyframe>& keyfrm) {
+  if (erase_observation_impl(keyfrm)) {
+    prepare_for_erasing(map_db);
+  }
+}
+
+void landmark::detach_observation(const std::shared_ptr<keyframe>& keyfrm) {
+  erase_observation_impl(keyfrm);
+}
+
+bool landmark::erase_observation_impl(const std::shared_ptr<keyframe>& keyfrm) {
   bool discard = false;
   {
     std::lock_guard<std::mutex> lock(mtx_observations_);
@@ -83,7 +99,10 @@ void landmark::erase_observation(map_database* map_db,
         num_observations_ -= 1;
       }
 
+      update_num_shared_landmarks(keyfrm, -1);
+      withdraw_redundancy(keyfrm);
       observations_.erase(keyfrm);
+      update_redundancy();
 
       if (ref_keyfrm_.lock() == keyfrm) {
         if (observations_.begin() != observations_.end())
@@ -96,11 +115,94 @@ void landmark::erase_observation(map_database* map_db,
     }
   }
 
-  if (discard) {
-    prepare_for_erasing(map_db);
+  return discard;
+}
+
+void landmark::update_num_shared_landmarks(
+    const std::shared_ptr<keyframe>& keyfrm, const int delta) {
+  for (const auto& obs : observations_) {
+    const auto ngh_keyfrm = obs.first.lock();
+    if (!ngh_keyfrm || *ngh_keyfrm == *keyfrm) {
+      continue;
+    }
+    keyfrm->graph_node_->update_num_shared_landmarks(ngh_keyfrm, delta);
+    ngh_keyfrm->graph_node_->update_num_shared_landmarks(keyfrm, delta);
   }
 }
 
+void landmark::clear_observations() {
+  // withdraw the observations one by one so that each pair of the observers
+  // is counted once
+  while (!observations_.empty()) {
+    const auto keyfrm = observations_.begin()->first.lock();
+    observations_.erase(observations_.begin());
+    if (keyfrm) {
+      update_num_shared_landmarks(keyfrm, -1);
+    }
+  }
+  clear_redundancy();
+}
+
+void landmark::update_redundancy() {
+  // if the number of keyframes that observe this landmark with more reliable
+  // scale than a keyframe does is not less than the threshold, the
+  // observation by the keyframe is considered as redundant
+  constexpr unsigned int num_better_obs_thr = 3;
+
+  // sorted scale levels of all of the observations
+  std::vector<int> scale_levels;
+  if (num_better_obs_thr < num_observations_) {
+    scale_levels.reserve(observations_.size());
+    for (const auto& obs : observations_) {
+      const auto keyfrm = obs.first.lock();
+      scale_levels.push_back(
+          keyfrm->frm_obs_.undist_keypts_.at(obs.second).octave);
+    }
+    std::sort(scale_levels.begin(), scale_levels.end());
+  }
+
+  for (auto& keyfrm_and_flag : obs_is_redundant_) {
+    const auto keyfrm = keyfrm_and_flag.first.lock();
+    bool is_redundant = false;
+    if (!scale_levels.empty()) {
+      const auto scale_level =
+          keyfrm->frm_obs_.undist_keypts_.at(observations_.at(keyfrm)).octave;
+      // the other observations with the scale level not larger than
+      // `scale_level + 1` are more reliable (the observation by `keyfrm` is
+      // excluded)
+      const auto num_better_obs =
+          std::upper_bound(scale_levels.begin(), scale_levels.end(),
+                           scale_level + 1) -
+          scale_levels.begin() - 1;
+      is_redundant = num_better_obs_thr <= num_better_obs;
+    }
+    if (is_redundant != keyfrm_and_flag.second) {
+      keyfrm_and_flag.second = is_redundant;
+      keyfrm->update_redundant_observation_counts(0, is_redundant ? 1 : -1);
+    }
+  }
+}
+
+void landmark::withdraw_redundancy(const std::shared_ptr<keyframe>& keyfrm) {
+  const auto itr = obs_is_redundant_.find(keyfrm);
+  if (itr == obs_is_redundant_.end()) {
+    return;
+  }
+  keyfrm->update_redundant_observation_counts(-1, itr->second ? -1 : 0);
+  obs_is_redundant_.erase(itr);
+}
+
+void landmark::clear_redundancy() {
+  for (const auto& keyfrm_and_flag : obs_is_redundant_) {
+    const auto keyfrm = keyfrm_and_flag.first.lock();
+    if (keyfrm) {
+      keyfrm->update_redundant_observation_counts(
+          -1, keyfrm_and_flag.second ? -1 : 0);
+    }
+  }
+  obs_is_redundant_.clear();
+}
+
 landmark::observations_t landmark::get_observations() const {
   std::lock_guard<std::mutex> lock(mtx_observations_);
   return observations_;
@@ -258,6 +360,21 @@ float landmark::get_max_valid_distance() const {
   return 1.3 * max_valid_dist_;
 }
 
+bool landmark::get_geometry(Vec3_t& pos_w, Vec3_t& mean_normal,
+                            float& min_valid_dist,
+                            float& max_valid_dist) const {
+  // will_be_erased_ is modified with both of the mutexes
+  std::lock_guard<std::mutex> lock(mtx_position_);
+  if (will_be_erased_) {
+    return false;
+  }
+  pos_w = pos_w_;
+  mean_normal = mean_normal_;
+  min_valid_dist = min_valid_dist_;
+  max_valid_dist = max_valid_dist_;
+  return true;
+}
+
 unsigned int landmark::predict_scale_level(const float cam_to_lm_dist,
                                            float num_scale_levels,
                                            float log_scale_factor) const {
@@ -284,7 +401,7 @@ void landmark::prepare_for_erasing(map_database* map_db) {
     std::lock_guard<std::mutex> lock1(mtx_observations_);
     std::lock_guard<std::mutex> lock2(mtx_position_);
     observations = observations_;
-    observations_.clear();
+    clear_observations();
     will_be_erased_ = true;
   }
 
@@ -313,7 +430,7 @@ void landmark::replace(std::shared_ptr<landmark> lm) {
     std::lock_guard<std::mutex> lock1(mtx_observations_);
     std::lock_guard<std::mutex> lock2(mtx_position_);
     observations = observations_;
-    observations_.clear();
+    clear_observations();
     will_be_erased_ = true;
     num_observable = num_observable_;
     num_observed = num_observed_;
@@ -26,7 +26,7 @@ class landmark {
   using observations_t = std::map<std::weak_ptr<keyframe>, unsigned int,
                                   std::owner_less<std::weak_ptr<keyframe>>>;
 
-  //! constructor
+  //! constructor (the ID is issued by the map database)
   landmark(const Vec3_t& pos_w, const std::shared_ptr<keyframe>& ref_keyfrm,
            map_database* map_db);
 
@@ -54,6 +54,9 @@ class landmark {
   //! erase observation
   void erase_observation(map_database* map_db,
                          const std::shared_ptr<keyframe>& keyfrm);
+  //! erase observation without discarding this landmark
+  //! (used when the keyframe is paged out of the map database)
+  void detach_observation(const std::shared_ptr<keyframe>& keyfrm);
 
   //! get observations (keyframe and keypoint idx)
   observations_t get_observations() const;
@@ -88,6 +91,11 @@ class landmark {
   //! get min valid distance between landmark and camera
   float get_max_valid_distance() const;
 
+  //! get the position, the mean normal and the raw min/max valid distances at
+  //! once (return false if this landmark will be erased)
+  bool get_geometry(Vec3_t& pos_w, Vec3_t& mean_normal, float& min_valid_dist,
+                    float& max_valid_dist) const;
+
   //! predict scale level assuming this landmark is observed in the specified
   //! frame/keyframe
   unsigned int predict_scale_level(const float cam_to_lm_dist,
@@ -113,17 +121,42 @@ class landmark {
 
  public:
   unsigned int id_;
-  static std::atomic<unsigned int> next_id_;
   unsigned int first_keyfrm_id_ = 0;
   unsigned int num_observations_ = 0;
 
  private:
+  //! erase observation and return true if this landmark should be discarded
+  bool erase_observation_impl(const std::shared_ptr<keyframe>& keyfrm);
+
+  //! update the numbers of the landmarks shared between the keyframe and the
+  //! other observers (mtx_observations_ must be locked)
+  void update_num_shared_landmarks(const std::shared_ptr<keyframe>& keyfrm,
+                                   const int delta);
+  //! erase all of the observations and withdraw them from the shared landmark
+  //! counts and the redundancy counts (mtx_observations_ must be locked)
+  void clear_observations();
+  //! update the redundancy flags of the observations and the counts in the
+  //! observing keyframes (mtx_observations_ must be locked)
+  void update_redundancy();
+  //! withdraw the observation by the keyframe from the redundancy counts
+  //! (mtx_observations_ must be locked)
+  void withdraw_redundancy(const std::shared_ptr<keyframe>& keyfrm);
+  //! withdraw all of the observations from the redundancy counts
+  //! (mtx_observations_ must be locked)
+  void clear_redundancy();
+
   //! world coordinates of this landmark
   Vec3_t pos_w_;
 
   //! observations (keyframe and keypoint index)
   observations_t observations_;
 
+  //! whether the observations, which are checked for the redundancy, are
+  //! redundant or not (see keyframe::get_redundant_observation_counts())
+  std::map<std::weak_ptr<keyframe>, bool,
+           std::owner_less<std::weak_ptr<keyframe>>>
+      obs_is_redundant_;
+
   //! Normalized average vector (unit vector) of keyframe->lm, for keyframes
   //! such that observe the 3D point.
   Vec3_t mean_normal_ = Vec3_t::Zero();
@@ -0,0 +1,155 @@
+#include "openvslam/data/landmark_snapshot.h"
+
+#include <cmath>
+
+#include "openvslam/camera/base.h"
+#include "openvslam/data/frame.h"
+#include "openvslam/data/landmark.h"
+#include "openvslam/feature/orb_params.h"
+
+namespace openvslam {
+namespace data {
+
+void landmark_snapshot::build(
+    const std::vector<std::shared_ptr<landmark>>& lms) {
+  clear();
+
+  lms_.reserve(lms.size());
+  ids_.reserve(lms.size());
+  pos_x_.reserve(lms.size());
+  pos_y_.reserve(lms.size());
+  pos_z_.reserve(lms.size());
+  normal_x_.reserve(lms.size());
+  normal_y_.reserve(lms.size());
+  normal_z_.reserve(lms.size());
+  min_valid_dists_.reserve(lms.size());
+  max_valid_dists_.reserve(lms.size());
+  max_dists_for_scale_.reserve(lms.size());
+
+  Vec3_t pos_w;
+  Vec3_t mean_normal;
+  float min_valid_dist;
+  float max_valid_dist;
+  for (const auto& lm : lms) {
+    if (!lm->get_geometry(pos_w, mean_normal, min_valid_dist,
+                          max_valid_dist)) {
+      continue;
+    }
+    lms_.push_back(lm);
+    ids_.push_back(lm->id_);
+    pos_x_.push_back(pos_w(0));
+    pos_y_.push_back(pos_w(1));
+    pos_z_.push_back(pos_w(2));
+    normal_x_.push_back(mean_normal(0));
+    normal_y_.push_back(mean_normal(1));
+    normal_z_.push_back(mean_normal(2));
+    // the same margins as landmark::get_min/max_valid_distance()
+    min_valid_dists_.push_back(0.7 * min_valid_dist);
+    max_valid_dists_.push_back(1.3 * max_valid_dist);
+    max_dists_for_scale_.push_back(max_valid_dist);
+  }
+}
+
+void landmark_snapshot::clear() {
+  lms_.clear();
+  ids_.clear();
+  pos_x_.clear();
+  pos_y_.clear();
+  pos_z_.clear();
+  normal_x_.clear();
+  normal_y_.clear();
+  normal_z_.clear();
+  min_valid_dists_.clear();
+  max_valid_dists_.clear();
+  max_dists_for_scale_.clear();
+  visible_indices_.clear();
+  reprojs_.clear();
+  x_rights_.clear();
+  pred_scale_levels_.clear();
+}
+
+unsigned int landmark_snapshot::cull(
+    const frame& frm, const float ray_cos_thr,
+    const std::unordered_set<unsigned int>& excluded_ids) {
+  const unsigned int num_lms = lms_.size();
+
+  visible_indices_.clear();
+  reprojs_.clear();
+  x_rights_.clear();
+  pred_scale_levels_.clear();
+
+  const Vec3_t cam_center = frm.get_cam_center();
+  const double cx = cam_center(0);
+  const double cy = cam_center(1);
+  const double cz = cam_center(2);
+
+  // 1. check the distances and the view angles over the arrays
+  // (the loop has no branches so that the compiler can vectorize it)
+  dists_.resize(num_lms);
+  passed_.resize(num_lms);
+  for (unsigned int i = 0; i < num_lms; ++i) {
+    const double dx = pos_x_[i] - cx;
+    const double dy = pos_y_[i] - cy;
+    const double dz = pos_z_[i] - cz;
+    const double dist = std::sqrt(dx * dx + dy * dy + dz * dz);
+    const double ray_cos =
+        (dx * normal_x_[i] + dy * normal_y_[i] + dz * normal_z_[i]) / dist;
+    const float dist_f = dist;
+    dists_[i] = dist;
+    passed_[i] = (min_valid_dists_[i] <= dist_f) &
+                 (dist_f <= max_valid_dists_[i]) & (ray_cos_thr <= ray_cos);
+  }
+
+  // 2. reproject the remaining landmarks at once
+  candidate_indices_.clear();
+  candidate_pos_ws_.clear();
+  for (unsigned int i = 0; i < num_lms; ++i) {
+    if (!passed_[i]) {
+      continue;
+    }
+    if (!excluded_ids.empty() && excluded_ids.count(ids_[i])) {
+      continue;
+    }
+    candidate_indices_.push_back(i);
+    candidate_pos_ws_.emplace_back(pos_x_[i], pos_y_[i], pos_z_[i]);
+  }
+
+  const Mat44_t cam_pose_cw = frm.get_cam_pose();
+  const Mat33_t rot_cw = cam_pose_cw.block<3, 3>(0, 0);
+  const Vec3_t trans_cw = cam_pose_cw.block<3, 1>(0, 3);
+  frm.camera_->reproject_points_to_image(rot_cw, trans_cw, candidate_pos_ws_,
+                                         candidate_reprojs_,
+                                         candidate_x_rights_, in_image_);
+
+  const auto num_scale_levels = frm.orb_params_->num_levels_;
+  const auto log_scale_factor = frm.orb_params_->log_scale_factor_;
+  for (unsigned int j = 0; j < candidate_indices_.size(); ++j) {
+    if (!in_image_[j]) {
+      continue;
+    }
+    const auto i = candidate_indices_[j];
+
+    // 3. predict the scale level (the same as landmark::predict_scale_level())
+    const float ratio = max_dists_for_scale_[i] / static_cast<float>(dists_[i]);
+    const auto scale_level =
+        static_cast<int>(std::ceil(std::log(ratio) / log_scale_factor));
+    unsigned int pred_scale_level;
+    if (scale_level < 0) {
+      pred_scale_level = 0;
+    } else if (num_scale_levels <= static_cast<unsigned int>(scale_level)) {
+      pred_scale_level = num_scale_levels - 1;
+    } else {
+      pred_scale_level = static_cast<unsigned int>(scale_level);
+    }
+
+    visible_indices_.push_back(i);
+    reprojs_.push_back(candidate_reprojs_[j]);
+    x_rights_.push_back(candidate_x_rights_[j]);
+    pred_scale_levels_.push_back(pred_scale_level);
+  }
+
+  return visible_indices_.size();
+}
+
+}  // namespace data
+}  // namespace openvslam
@@ -0,0 +1,101 @@
+#ifndef OPENVSLAM_DATA_LANDMARK_SNAPSHOT_H
+#define OPENVSLAM_DATA_LANDMARK_SNAPSHOT_H
+
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "openvslam/type.h"
+
+namespace openvslam {
+namespace data {
+
+class frame;
+class landmark;
+
+/**
+ * Snapshot of the geometric attributes of the landmarks in the
+ * structure-of-arrays layout
+ * (each landmark is locked only once when the snapshot is taken, then the
+ * observability checks run over the contiguous arrays without any locks)
+ */
+class landmark_snapshot {
+ public:
+  /**
+   * Constructor
+   */
+  landmark_snapshot() = default;
+
+  /**
+   * Destructor
+   */
+  ~landmark_snapshot() = default;
+
+  /**
+   * Take the snapshot of the landmarks
+   * (the landmarks which will be erased are excluded)
+   * @param lms
+   */
+  void build(const std::vector<std::shared_ptr<landmark>>& lms);
+
+  /**
+   * Clear the snapshot and the culling results
+   */
+  void clear();
+
+  /**
+   * Get the number of the landmarks in the snapshot
+   */
+  unsigned int size() const { return lms_.size(); }
+
+  /**
+   * Find the landmarks which can be observed from the frame
+   * (this is equivalent to calling frame::can_observe() for each landmark,
+   * and the results are stored in visible_indices_, reprojs_, x_rights_ and
+   * pred_scale_levels_)
+   * @param frm
+   * @param ray_cos_thr
+   * @param excluded_ids IDs of the landmarks to skip
+   * @return the number of the observable landmarks
+   */
+  unsigned int cull(const frame& frm, const float ray_cos_thr,
+                    const std::unordered_set<unsigned int>& excluded_ids);
+
+  //! landmarks
+  std::vector<std::shared_ptr<landmark>> lms_;
+  //! landmark IDs
+  std::vector<unsigned int> ids_;
+  //! positions in the world coordinates
+  std::vector<double> pos_x_, pos_y_, pos_z_;
+  //! mean normals of the observations
+  std::vector<double> normal_x_, normal_y_, normal_z_;
+  //! min/max distances which are valid in the ORB scale pyramid
+  //! (including the margins of landmark::get_min/max_valid_distance())
+  std::vector<float> min_valid_dists_, max_valid_dists_;
+  //! raw max distances which are used to predict the scale levels
+  std::vector<float> max_dists_for_scale_;
+
+  //! indices of the observable landmarks in the snapshot
+  std::vector<unsigned int> visible_indices_;
+  //! reprojections of the observable landmarks
+  eigen_alloc_vector<Vec2_t> reprojs_;
+  //! x_right of the observable landmarks
+  std::vector<float> x_rights_;
+  //! predicted scale levels of the observable landmarks
+  std::vector<unsigned int> pred_scale_levels_;
+
+ private:
+  //! buffers which are recycled in the culling
+  std::vector<double> dists_;
+  std::vector<unsigned char> passed_;
+  std::vector<unsigned int> candidate_indices_;
+  eigen_alloc_vector<Vec3_t> candidate_pos_ws_;
+  eigen_alloc_vector<Vec2_t> candidate_reprojs_;
+  std::vector<float> candidate_x_rights_;
+  std::vector<unsigned char> in_image_;
+};
+
+}  // namespace data
+}  // namespace openvslam
+
+#endif  // OPENVSLAM_DATA_LANDMARK_SNAPSHOT_H
@@ -17,8 +17,6 @@
 namespace openvslam {
 namespace data {
 
-std::mutex map_database::mtx_database_;
-
 map_database::map_database() { spdlog::debug("CONSTRUCT: data::map_database"); }
 
 map_database::~map_database() {
@@ -35,6 +33,7 @@ void map_database::add_keyframe(const std::shared_ptr<keyframe>& keyfrm) {
 void map_database::erase_keyframe(const std::shared_ptr<keyframe>& keyfrm) {
   std::lock_guard<std::mutex> lock(mtx_map_access_);
   keyframes_.erase(keyfrm->id_);
+  ++graph_epoch_;
 }
 
 void map_database::add_landmark(std::shared_ptr<landmark>& lm) {
@@ -45,6 +44,7 @@ void map_database::add_landmark(std::shared_ptr<landmark>& lm) {
 void map_database::erase_landmark(unsigned int id) {
   std::lock_guard<std::mutex> lock(mtx_map_access_);
   landmarks_.erase(id);
+  ++graph_epoch_;
 }
 
 void map_database::set_local_landmarks(
@@ -126,11 +126,53 @@ std::vector<std::shared_ptr<keyframe>> map_database::get_close_keyframes(
   return filtered_keyframes;
 }
 
+std::shared_ptr<keyframe> map_database::get_keyframe(
+    const unsigned int id) const {
+  std::lock_guard<std::mutex> lock(mtx_map_access_);
+  const auto itr = keyframes_.find(id);
+  if (itr == keyframes_.end()) {
+    return nullptr;
+  }
+  return itr->second;
+}
+
+std::shared_ptr<landmark> map_database::get_landmark(
+    const unsigned int id) const {
+  std::lock_guard<std::mutex> lock(mtx_map_access_);
+  const auto itr = landmarks_.find(id);
+  if (itr == landmarks_.end()) {
+    return nullptr;
+  }
+  return itr->second;
+}
+
 unsigned int map_database::get_num_keyframes() const {
   std::lock_guard<std::mutex> lock(mtx_map_access_);
   return keyframes_.size();
 }
 
+std::size_t map_database::get_keyframe_memory_footprint() const {
+  std::lock_guard<std::mutex> lock(mtx_map_access_);
+  std::size_t footprint = 0;
+  for (const auto& id_keyfrm : keyframes_) {
+    footprint += id_keyfrm.second->frm_obs_.get_memory_footprint();
+  }
+  return footprint;
+}
+
+void map_database::log_keyframe_memory_footprint() const {
+  if (keyframes_.empty()) {
+    return;
+  }
+  std::size_t footprint = 0;
+  for (const auto& id_keyfrm : keyframes_) {
+    footprint += id_keyfrm.second->frm_obs_.get_memory_footprint();
+  }
+  spdlog::info(
+      "keyframe observations occupy {:.1f} MB ({} bytes per keyframe)",
+      footprint / (1024.0 * 1024.0), footprint / keyframes_.size());
+}
+
 std::vector<std::shared_ptr<landmark>> map_database::get_all_landmarks() const {
   std::lock_guard<std::mutex> lock(mtx_map_access_);
   std::vector<std::shared_ptr<landmark>> landmarks;
@@ -161,6 +203,7 @@ void map_database::clear() {
   origin_keyfrm_ = nullptr;
 
   frm_stats_.clear();
+  ++graph_epoch_;
 
   spdlog::info("clear map database");
 }
@@ -169,7 +212,8 @@ void map_database::from_json(camera_database* cam_db,
                              orb_params_database* orb_params_db,
                              bow_vocabulary* bow_vocab,
                              const nlohmann::json& json_keyfrms,
-                             const nlohmann::json& json_landmarks) {
+                             const nlohmann::json& json_landmarks,
+                             const std::function<void()>& wait_for_bow_vocab) {
   std::lock_guard<std::mutex> lock(mtx_map_access_);
 
   // Step 1. delete all the data in map database
@@ -191,14 +235,30 @@ void map_database::from_json(camera_database* cam_db,
   // Step 2. Register keyframes
   // If the object does not exist at this step, the corresponding pointer is set
   // as nullptr.
+  // (the stored BoW representations are read, and the vocabulary is not used
+  // until Step 8)
   spdlog::info("decoding {} keyframes to load", json_keyfrms.size());
+  std::vector<std::pair<int, const nlohmann::json*>> ids_json_keyfrms;
+  ids_json_keyfrms.reserve(json_keyfrms.size());
   for (const auto& json_id_keyfrm : json_keyfrms.items()) {
     const auto id = std::stoi(json_id_keyfrm.key());
     assert(0 <= id);
-    const auto json_keyfrm = json_id_keyfrm.value();
-
-    register_keyframe(cam_db, orb_params_db, bow_vocab, id, json_keyfrm);
+    ids_json_keyfrms.emplace_back(id, &json_id_keyfrm.value());
   }
+  // the keyframes are decoded independently
+  std::vector<std::shared_ptr<keyframe>> keyfrms(ids_json_keyfrms.size());
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (unsigned int i = 0; i < ids_json_keyfrms.size(); ++i) {
+    keyfrms.at(i) = decode_keyframe(cam_db, orb_params_db, nullptr,
+                                    ids_json_keyfrms.at(i).first,
+                                    *ids_json_keyfrms.at(i).second, true);
+  }
+  for (const auto& keyfrm : keyfrms) {
+    register_keyframe(keyfrm);
+  }
+  log_keyframe_memory_footprint();
 
   // Step 3. Register 3D landmark point
   // If the object does not exist at this step, the corresponding pointer is set
@@ -257,13 +317,172 @@ void map_database::from_json(camera_database* cam_db,
     lm->update_mean_normal_and_obs_scale_variance();
     lm->compute_descriptor();
   }
+
+  // Step 8. Validate or compute BoW
+  // (the vocabulary is used only to validate the stored BoW representations
+  // if they were computed with it)
+  if (wait_for_bow_vocab) {
+    wait_for_bow_vocab();
+  }
+  const auto use_bow_cache = bow_cache_is_valid(bow_vocab, json_keyfrms);
+  if (use_bow_cache) {
+    spdlog::info("use the BoW stored in the map");
+  } else {
+    spdlog::info("compute BoW of the keyframes (not stored in the map or "
+                 "stored with another vocabulary)");
+  }
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (unsigned int i = 0; i < keyfrms.size(); ++i) {
+    const auto& keyfrm = keyfrms.at(i);
+    if (!use_bow_cache || !keyfrm->bow_is_available()) {
+      keyfrm->compute_bow(bow_vocab);
+    }
+  }
 }
 
-void map_database::register_keyframe(camera_database* cam_db,
-                                     orb_params_database* orb_params_db,
-                                     bow_vocabulary* bow_vocab,
-                                     const unsigned int id,
-                                     const nlohmann::json& json_keyfrm) {
+std::vector<std::shared_ptr<keyframe>> map_database::add_tile(
+    const std::vector<std::shared_ptr<keyframe>>& keyfrms,
+    const nlohmann::json& json_keyfrms, const nlohmann::json& json_landmarks) {
+  std::lock_guard<std::mutex> lock(mtx_map_access_);
+
+  // Step 1. Register the keyframes which are not resident
+  std::vector<std::shared_ptr<keyframe>> new_keyfrms;
+  for (const auto& keyfrm : keyfrms) {
+    if (keyframes_.count(keyfrm->id_)) {
+      continue;
+    }
+    register_keyframe(keyfrm);
+    new_keyfrms.push_back(keyfrm);
+  }
+  if (new_keyfrms.empty()) {
+    return new_keyfrms;
+  }
+
+  // Step 2. Register the landmarks which are not resident
+  // (the landmarks shared with the resident tiles are reused)
+  std::vector<std::shared_ptr<landmark>> lms;
+  lms.reserve(json_landmarks.size());
+  for (const auto& json_id_landmark : json_landmarks.items()) {
+    const auto id = std::stoi(json_id_landmark.key());
+    assert(0 <= id);
+    if (!landmarks_.count(id)) {
+      register_landmark(id, json_id_landmark.value());
+    }
+    lms.push_back(landmarks_.at(id));
+  }
+
+  // Step 3. Register the spanning tree between the resident keyframes
+  for (const auto& keyfrm : new_keyfrms) {
+    const auto& json_keyfrm = json_keyfrms.at(std::to_string(keyfrm->id_));
+    const auto spanning_parent_id = json_keyfrm.at("span_parent").get<int>();
+    if (0 <= spanning_parent_id && keyframes_.count(spanning_parent_id)) {
+      const auto& parent = keyframes_.at(spanning_parent_id);
+      keyfrm->graph_node_->set_spanning_parent(parent);
+      parent->graph_node_->add_spanning_child(keyfrm);
+    }
+    for (const auto spanning_child_id :
+         json_keyfrm.at("span_children").get<std::vector<int>>()) {
+      if (keyframes_.count(spanning_child_id)) {
+        const auto& child = keyframes_.at(spanning_child_id);
+        keyfrm->graph_node_->add_spanning_child(child);
+        child->graph_node_->set_spanning_parent(keyfrm);
+      }
+    }
+  }
+
+  // Step 4. Register association between keyframs and 3D points
+  for (const auto& keyfrm : new_keyfrms) {
+    register_association(keyfrm->id_,
+                         json_keyfrms.at(std::to_string(keyfrm->id_)));
+  }
+
+  // Step 5. Update graph
+  for (const auto& keyfrm : new_keyfrms) {
+    keyfrm->graph_node_->update_connections();
+    keyfrm->graph_node_->update_covisibility_orders();
+  }
+
+  // Step 6. Update geometry
+  for (const auto& lm : lms) {
+    lm->update_mean_normal_and_obs_scale_variance();
+    lm->compute_descriptor();
+  }
+
+  return new_keyfrms;
+}
+
+std::vector<std::shared_ptr<keyframe>> map_database::erase_tile(
+    const std::vector<unsigned int>& keyfrm_ids) {
+  // Step 1. Remove the keyframes from the database
+  std::vector<std::shared_ptr<keyframe>> erased_keyfrms;
+  {
+    std::lock_guard<std::mutex> lock(mtx_map_access_);
+    for (const auto id : keyfrm_ids) {
+      if (!keyframes_.count(id)) {
+        continue;
+      }
+      const auto keyfrm = keyframes_.at(id);
+      // the origin is not evicted because the map is anchored to it
+      if (origin_keyfrm_ == keyfrm) {
+        continue;
+      }
+      // the modules which still hold the keyframe skip it from now on
+      keyfrm->prepare_for_eviction();
+      keyframes_.erase(id);
+      erased_keyfrms.push_back(keyfrm);
+      if (last_inserted_keyfrm_ == keyfrm) {
+        last_inserted_keyfrm_ = nullptr;
+      }
+    }
+    ++graph_epoch_;
+  }
+
+  // Step 2. Detach the keyframes from the landmarks
+  // (NOTE: mtx_map_access_ must not be locked because the landmarks might
+  // call erase_landmark())
+  std::unordered_map<unsigned int, std::shared_ptr<landmark>> lms;
+  for (const auto& keyfrm : erased_keyfrms) {
+    for (const auto& lm : keyfrm->get_landmarks()) {
+      if (!lm) {
+        continue;
+      }
+      lm->detach_observation(keyfrm);
+      lms[lm->id_] = lm;
+    }
+  }
+
+  // Step 3. Detach the keyframes from the graph
+  for (const auto& keyfrm : erased_keyfrms) {
+    const auto parent = keyfrm->graph_node_->get_spanning_parent();
+    if (parent) {
+      parent->graph_node_->erase_spanning_child(keyfrm);
+    }
+    for (const auto& child : keyfrm->graph_node_->get_spanning_children()) {
+      if (child && child->graph_node_->get_spanning_parent() == keyfrm) {
+        child->graph_node_->set_spanning_parent(nullptr);
+      }
+    }
+    keyfrm->graph_node_->erase_all_connections();
+  }
+
+  // Step 4. Erase the landmarks which are not observed from the resident
+  // keyframes
+  for (const auto& id_lm : lms) {
+    const auto& lm = id_lm.second;
+    if (!lm->has_observation() && !lm->will_be_erased()) {
+      lm->prepare_for_erasing(this);
+    }
+  }
+
+  return erased_keyfrms;
+}
+
+std::shared_ptr<keyframe> map_database::decode_keyframe(
+    camera_database* cam_db, orb_params_database* orb_params_db,
+    bow_vocabulary* bow_vocab, const unsigned int id,
+    const nlohmann::json& json_keyfrm, const bool use_bow_cache) {
   // Metadata
   const auto src_frm_id = json_keyfrm.at("src_frm_id").get<unsigned int>();
   const auto timestamp = json_keyfrm.at("ts").get<double>();
@@ -286,12 +505,11 @@ void map_database::register_keyframe(camera_database* cam_db,
   assert(keypts.size() == num_keypts);
   // undist_keypts
   const auto json_undist_keypts = json_keyfrm.at("undists");
-  const auto undist_keypts = convert_json_to_undistorted(json_undist_keypts);
+  const auto undist_keypts =
+      convert_json_to_undistorted(json_undist_keypts, keypts);
   assert(undist_keypts.size() == num_keypts);
-  // bearings
-  auto bearings = eigen_alloc_vector<Vec3_t>(num_keypts);
-  assert(bearings.size() == num_keypts);
-  camera->convert_keypoints_to_bearings(undist_keypts, bearings);
+  // bearings are not stored in the keyframe (see keyframe::get_bearing())
+  const eigen_alloc_vector<Vec3_t> bearings;
   // stereo_x_right
   const auto stereo_x_right =
       json_keyfrm.at("x_rights").get<std::vector<float>>();
@@ -314,12 +532,43 @@ void map_database::register_keyframe(camera_database* cam_db,
   frame_observation frm_obs{
       num_keypts, keypts,         descriptors, undist_keypts,
       bearings,   stereo_x_right, depths,      keypt_indices_in_cells};
-  // Compute BoW
-  data::bow_vocabulary_util::compute_bow(bow_vocab, descriptors, bow_vec,
-                                         bow_feat_vec);
-  auto keyfrm = data::keyframe::make_keyframe(id, src_frm_id, timestamp,
-                                              cam_pose_cw, camera, orb_params,
-                                              frm_obs, bow_vec, bow_feat_vec);
+  // Read or compute BoW
+  if (use_bow_cache && json_keyfrm.count("bow")) {
+    convert_json_to_bow(json_keyfrm.at("bow"), bow_vec, bow_feat_vec);
+  } else {
+    if (bow_vocab) {
+      data::bow_vocabulary_util::compute_bow(bow_vocab, descriptors, bow_vec,
+                                             bow_feat_vec);
+    }
+  }
+  return data::keyframe::make_keyframe(id, src_frm_id, timestamp, cam_pose_cw,
+                                       camera, orb_params, frm_obs, bow_vec,
+                                       bow_feat_vec, this);
+}
+
+bool map_database::bow_cache_is_valid(bow_vocabulary* bow_vocab,
+                                      const nlohmann::json& json_keyfrms) {
+  for (const auto& json_id_keyfrm : json_keyfrms.items()) {
+    const auto& json_keyfrm = json_id_keyfrm.value();
+    if (!json_keyfrm.count("bow")) {
+      continue;
+    }
+    bow_vector cached_bow_vec, bow_vec;
+    bow_feature_vector cached_bow_feat_vec, bow_feat_vec;
+    convert_json_to_bow(json_keyfrm.at("bow"), cached_bow_vec,
+                        cached_bow_feat_vec);
+    const auto descriptors =
+        convert_json_to_descriptors(json_keyfrm.at("descs"));
+    data::bow_vocabulary_util::compute_bow(bow_vocab, descriptors, bow_vec,
+                                           bow_feat_vec);
+    return bow_is_equal(cached_bow_vec, cached_bow_feat_vec, bow_vec,
+                        bow_feat_vec);
+  }
+  return false;
+}
+
+void map_database::register_keyframe(const std::shared_ptr<keyframe>& keyfrm) {
+  const auto id = keyfrm->id_;
 
   // Append to map database
   assert(!keyframes_.count(id));
@@ -395,11 +644,13 @@ void map_database::register_association(const unsigned int keyfrm_id,
 }
 
 void map_database::to_json(nlohmann::json& json_keyfrms,
-                           nlohmann::json& json_landmarks) {
+                           nlohmann::json& json_landmarks,
+                           const bool store_bow) {
   std::lock_guard<std::mutex> lock(mtx_map_access_);
 
   // Save each keyframe as json
   spdlog::info("encoding {} keyframes to store", keyframes_.size());
+  log_keyframe_memory_footprint();
   std::map<std::string, nlohmann::json> keyfrms;
   for (const auto& id_keyfrm : keyframes_) {
     const auto id = id_keyfrm.first;
@@ -409,7 +660,7 @@ void map_database::to_json(nlohmann::json& json_keyfrms,
     assert(!keyfrm->will_be_erased());
     keyfrm->graph_node_->update_connections();
     assert(!keyfrms.count(std::to_string(id)));
-    keyfrms[std::to_string(id)] = keyfrm->to_json();
+    keyfrms[std::to_string(id)] = keyfrm->to_json(store_bow);
   }
   json_keyfrms = keyfrms;
 
@@ -1,6 +1,8 @@
 #ifndef OPENVSLAM_DATA_MAP_DATABASE_H
 #define OPENVSLAM_DATA_MAP_DATABASE_H
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <nlohmann/json_fwd.hpp>
@@ -80,6 +82,20 @@ class map_database {
    */
   std::vector<std::shared_ptr<keyframe>> get_all_keyframes() const;
 
+  /**
+   * Get the keyframe with the specified ID
+   * @param id
+   * @return the keyframe, or nullptr if it is not in the database
+   */
+  std::shared_ptr<keyframe> get_keyframe(const unsigned int id) const;
+
+  /**
+   * Get the landmark with the specified ID
+   * @param id
+   * @return the landmark, or nullptr if it is not in the database
+   */
+  std::shared_ptr<landmark> get_landmark(const unsigned int id) const;
+
   /**
    * Get closest keyframes to a given 2d pose
    * @param pose Given 2d pose
@@ -111,6 +127,12 @@ class map_database {
    */
   unsigned get_num_keyframes() const;
 
+  /**
+   * Get the number of bytes allocated for the observations of the keyframes
+   * @return
+   */
+  std::size_t get_keyframe_memory_footprint() const;
+
   /**
    * Get all of the landmarks in the database
    * @return
@@ -172,39 +194,111 @@ class map_database {
    * @param bow_vocab
    * @param json_keyfrms
    * @param json_landmarks
+   * @param wait_for_bow_vocab called before the vocabulary is used first, so
+   * that the vocabulary can be loaded while the map is decoded
    */
   void from_json(camera_database* cam_db, orb_params_database* orb_params_db,
                  bow_vocabulary* bow_vocab, const nlohmann::json& json_keyfrms,
-                 const nlohmann::json& json_landmarks);
+                 const nlohmann::json& json_landmarks,
+                 const std::function<void()>& wait_for_bow_vocab = nullptr);
+
+  /**
+   * Decode a keyframe of this map from JSON without registering it
+   * (used to decode the keyframes of a map tile without locking the database,
+   * and the database is not accessed)
+   * @param cam_db
+   * @param orb_params_db
+   * @param bow_vocab if nullptr, the BoW representation is not computed
+   * @param id
+   * @param json_keyfrm
+   * @param use_bow_cache if true, the stored BoW representation is used instead
+   * of computing it (see bow_cache_is_valid())
+   * @return
+   */
+  std::shared_ptr<keyframe> decode_keyframe(
+      camera_database* cam_db, orb_params_database* orb_params_db,
+      bow_vocabulary* bow_vocab, const unsigned int id,
+      const nlohmann::json& json_keyfrm, const bool use_bow_cache = false);
+
+  /**
+   * Check whether the BoW representations stored with the keyframes were
+   * computed with the vocabulary
+   * (the representation of one keyframe is recomputed and compared)
+   * @param bow_vocab
+   * @param json_keyfrms
+   * @return false if the keyframes have no stored representation
+   */
+  static bool bow_cache_is_valid(bow_vocabulary* bow_vocab,
+                                 const nlohmann::json& json_keyfrms);
+
+  /**
+   * Add the keyframes and the landmarks of a map tile to the database
+   * (the resident keyframes and landmarks are kept, and the loop edges are not
+   * restored)
+   * @param keyfrms decoded keyframes of the tile
+   * @param json_keyfrms
+   * @param json_landmarks
+   * @return keyframes which are newly added to the database
+   */
+  std::vector<std::shared_ptr<keyframe>> add_tile(
+      const std::vector<std::shared_ptr<keyframe>>& keyfrms,
+      const nlohmann::json& json_keyfrms, const nlohmann::json& json_landmarks);
+
+  /**
+   * Erase the keyframes of a map tile and the landmarks which are not observed
+   * from the other resident keyframes
+   * (the origin keyframe stays resident, and the erased keyframes and
+   * landmarks are marked before the removal)
+   * @param keyfrm_ids
+   * @return keyframes which are erased from the database
+   */
+  std::vector<std::shared_ptr<keyframe>> erase_tile(
+      const std::vector<unsigned int>& keyfrm_ids);
 
   /**
    * Dump keyframes and landmarks as JSON
    * @param json_keyfrms
    * @param json_landmarks
+   * @param store_bow if true, the BoW representations of the keyframes are
+   * also dumped
    */
-  void to_json(nlohmann::json& json_keyfrms, nlohmann::json& json_landmarks);
+  void to_json(nlohmann::json& json_keyfrms, nlohmann::json& json_landmarks,
+               const bool store_bow = true);
 
   //! origin keyframe
   std::shared_ptr<keyframe> origin_keyfrm_ = nullptr;
 
   //! mutex for locking ALL access to the database
   //! (NOTE: cannot used in map_database class)
-  static std::mutex mtx_database_;
+  mutable std::mutex mtx_database_;
+
+  //! counters of the IDs of the frames, the keyframes and the landmarks which
+  //! are created for this map
+  std::atomic<unsigned int> next_frame_id_{0};
+  std::atomic<unsigned int> next_keyframe_id_{0};
+  std::atomic<unsigned int> next_landmark_id_{0};
+
+  //! counter which is incremented whenever an observation or a connection of
+  //! the graph is modified (used to detect changes of the local map)
+  std::atomic<unsigned int> graph_epoch_{0};
+
+  //! counter which is incremented after the loop BA applies its corrections
+  //! to the keyframes and the landmarks (used to discard the results of the
+  //! local BA which started from the poses before the corrections)
+  std::atomic<unsigned int> correction_epoch_{0};
 
  private:
   /**
-   * Decode JSON and register keyframe information to the map database
-   * (NOTE: objects which are not constructed yet will be set as nullptr)
-   * @param cam_db
-   * @param orb_params_db
-   * @param bow_vocab
-   * @param id
-   * @param json_keyfrm
+   * Log the memory footprint of the keyframe observations
+   * (NOTE: mtx_map_access_ must be locked by the caller)
+   */
+  void log_keyframe_memory_footprint() const;
+
+  /**
+   * Register the decoded keyframe to the map database
+   * @param keyfrm
    */
-  void register_keyframe(camera_database* cam_db,
-                         orb_params_database* orb_params_db,
-                         bow_vocabulary* bow_vocab, const unsigned int id,
-                         const nlohmann::json& json_keyfrm);
+  void register_keyframe(const std::shared_ptr<keyframe>& keyfrm);
 
   /**
    * Decode JSON and register landmark information to the map database
@@ -0,0 +1,132 @@
+#include "openvslam/data/speculative_bow.h"
+
+#include <spdlog/spdlog.h>
+
+namespace openvslam {
+namespace data {
+
+namespace {
+
+speculative_bow::compute_bow_t bind_vocabulary(bow_vocabulary* bow_vocab) {
+  return [bow_vocab](const cv::Mat& descriptors, bow_vector& bow_vec,
+                     bow_feature_vector& bow_feat_vec) {
+    bow_vocabulary_util::compute_bow(bow_vocab, descriptors, bow_vec,
+                                     bow_feat_vec);
+  };
+}
+
+}  // unnamed namespace
+
+speculative_bow::speculative_bow(const cv::Mat& descriptors)
+    : descriptors_(descriptors) {}
+
+void speculative_bow::compute(bow_vocabulary* bow_vocab) {
+  compute(bind_vocabulary(bow_vocab));
+}
+
+void speculative_bow::compute(const compute_bow_t& compute_bow) {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (status_ != status_t::Queued) {
+      return;
+    }
+    status_ = status_t::Running;
+  }
+
+  // the results are written only by the thread which changed the status
+  compute_bow(descriptors_, bow_vec_, bow_feat_vec_);
+
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    status_ = status_t::Finished;
+  }
+  cv_finished_.notify_all();
+}
+
+bool speculative_bow::is_ready() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return status_ == status_t::Finished;
+}
+
+void speculative_bow::get(bow_vocabulary* bow_vocab, bow_vector& bow_vec,
+                          bow_feature_vector& bow_feat_vec) {
+  get(bind_vocabulary(bow_vocab), bow_vec, bow_feat_vec);
+}
+
+void speculative_bow::get(const compute_bow_t& compute_bow,
+                          bow_vector& bow_vec,
+                          bow_feature_vector& bow_feat_vec) {
+  compute(compute_bow);
+
+  std::unique_lock<std::mutex> lock(mtx_);
+  cv_finished_.wait(lock, [this] { return status_ == status_t::Finished; });
+  // copy the results because the keyframe can inherit this object
+  bow_vec = bow_vec_;
+  bow_feat_vec = bow_feat_vec_;
+}
+
+speculative_bow_worker::speculative_bow_worker(
+    bow_vocabulary* bow_vocab, const unsigned int max_num_queued)
+    : speculative_bow_worker(bind_vocabulary(bow_vocab), max_num_queued) {}
+
+speculative_bow_worker::speculative_bow_worker(
+    const speculative_bow::compute_bow_t& compute_bow,
+    const unsigned int max_num_queued)
+    : compute_bow_(compute_bow), max_num_queued_(max_num_queued) {
+  spdlog::debug("CONSTRUCT: data::speculative_bow_worker");
+  worker_ = std::thread(&speculative_bow_worker::run, this);
+}
+
+speculative_bow_worker::~speculative_bow_worker() {
+  {
+    std::lock_guard<std::mutex> lock(mtx_queue_);
+    terminate_is_requested_ = true;
+    // the queued requests are computed on demand
+    queue_.clear();
+  }
+  cv_queue_.notify_all();
+  worker_.join();
+  spdlog::debug("DESTRUCT: data::speculative_bow_worker");
+}
+
+std::shared_ptr<speculative_bow> speculative_bow_worker::request(
+    const cv::Mat& descriptors) {
+  auto task = std::make_shared<speculative_bow>(descriptors);
+  {
+    std::lock_guard<std::mutex> lock(mtx_queue_);
+    if (terminate_is_requested_) {
+      return task;
+    }
+    queue_.push_back(task);
+    while (max_num_queued_ < queue_.size()) {
+      queue_.pop_front();
+    }
+  }
+  cv_queue_.notify_one();
+  return task;
+}
+
+void speculative_bow_worker::run() {
+  std::unique_lock<std::mutex> lock(mtx_queue_);
+  while (true) {
+    cv_queue_.wait(
+        lock, [this] { return terminate_is_requested_ || !queue_.empty(); });
+    if (terminate_is_requested_) {
+      break;
+    }
+
+    // the newest frame is the most likely to need the BoW representation
+    const auto task = queue_.back().lock();
+    queue_.pop_back();
+    if (!task) {
+      continue;
+    }
+
+    lock.unlock();
+    task->compute(compute_bow_);
+    lock.lock();
+  }
+}
+
+}  // namespace data
+}  // namespace openvslam
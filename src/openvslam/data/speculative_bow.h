@@ -0,0 +1,135 @@
+#ifndef OPENVSLAM_DATA_SPECULATIVE_BOW_H
+#define OPENVSLAM_DATA_SPECULATIVE_BOW_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <opencv2/core.hpp>
+#include <thread>
+
+#include "openvslam/data/bow_vocabulary.h"
+
+#ifdef USE_DBOW2
+#include <DBoW2/BowVector.h>
+#include <DBoW2/FeatureVector.h>
+#else
+#include <fbow/bow_feat_vector.h>
+#include <fbow/bow_vector.h>
+#endif
+
+namespace openvslam {
+namespace data {
+
+/**
+ * BoW representation of the descriptors which is computed ahead of use
+ * (computed by speculative_bow_worker, or by the caller of get() if the worker
+ * has not started it yet)
+ */
+class speculative_bow {
+ public:
+  //! Function which computes the BoW representation of the descriptors
+  using compute_bow_t = std::function<void(
+      const cv::Mat& descriptors, bow_vector& bow_vec,
+      bow_feature_vector& bow_feat_vec)>;
+
+  //! Constructor
+  explicit speculative_bow(const cv::Mat& descriptors);
+
+  //! Compute the BoW representation if nobody has started it yet
+  void compute(bow_vocabulary* bow_vocab);
+
+  //! Compute the BoW representation with the function if nobody has started
+  //! it yet
+  void compute(const compute_bow_t& compute_bow);
+
+  //! Returns true if the BoW representation has been computed
+  bool is_ready() const;
+
+  /**
+   * Get the BoW representation
+   * (computed on the caller thread if the worker has not started it yet,
+   * otherwise blocks until the worker finishes it)
+   * @param bow_vocab
+   * @param bow_vec
+   * @param bow_feat_vec
+   */
+  void get(bow_vocabulary* bow_vocab, bow_vector& bow_vec,
+           bow_feature_vector& bow_feat_vec);
+
+  //! Get the BoW representation
+  //! (computed with the function on the caller thread if the worker has not
+  //! started it yet)
+  void get(const compute_bow_t& compute_bow, bow_vector& bow_vec,
+           bow_feature_vector& bow_feat_vec);
+
+ private:
+  enum class status_t { Queued, Running, Finished };
+
+  //! descriptors (shared with the frame)
+  const cv::Mat descriptors_;
+
+  //! mutex to access the members below
+  mutable std::mutex mtx_;
+  //! notified when the computation finishes
+  std::condition_variable cv_finished_;
+  status_t status_ = status_t::Queued;
+
+  //! BoW features (DBoW2 or FBoW)
+  bow_vector bow_vec_;
+  bow_feature_vector bow_feat_vec_;
+};
+
+/**
+ * Worker which computes the BoW representations of the frames in parallel
+ * with tracking
+ * (the newest request is computed first, and the requests whose results are
+ * no longer referenced are skipped)
+ */
+class speculative_bow_worker {
+ public:
+  //! Constructor (the worker thread is launched)
+  explicit speculative_bow_worker(bow_vocabulary* bow_vocab,
+                                  const unsigned int max_num_queued = 8);
+
+  //! Constructor with the function which computes the BoW representations
+  explicit speculative_bow_worker(
+      const speculative_bow::compute_bow_t& compute_bow,
+      const unsigned int max_num_queued = 8);
+
+  //! Destructor (the worker thread is joined)
+  ~speculative_bow_worker();
+
+  speculative_bow_worker(const speculative_bow_worker&) = delete;
+  speculative_bow_worker& operator=(const speculative_bow_worker&) = delete;
+
+  //! Request the computation of the BoW representation of the descriptors
+  //! (returns immediately)
+  std::shared_ptr<speculative_bow> request(const cv::Mat& descriptors);
+
+ private:
+  //! Main loop of the worker thread
+  void run();
+
+  //! function which computes the BoW representations
+  const speculative_bow::compute_bow_t compute_bow_;
+  //! maximum number of the queued requests
+  //! (the oldest one is dropped and computed on demand)
+  const unsigned int max_num_queued_;
+
+  //! mutex to access the queue
+  std::mutex mtx_queue_;
+  std::condition_variable cv_queue_;
+  //! queued requests (the newest one is at the back)
+  std::deque<std::weak_ptr<speculative_bow>> queue_;
+  bool terminate_is_requested_ = false;
+
+  //! worker thread
+  std::thread worker_;
+};
+
+}  // namespace data
+}  // namespace openvslam
+
+#endif  // OPENVSLAM_DATA_SPECULATIVE_BOW_H
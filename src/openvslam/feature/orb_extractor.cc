@@ -35,6 +35,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "openvslam/feature/orb_extractor.h"
 
+#include <algorithm>
 #include <opencv2/core.hpp>
 #include <opencv2/features2d.hpp>
 #include <opencv2/imgproc.hpp>
@@ -106,10 +107,12 @@ void orb_extractor::extract(const cv::_InputArray& in_image,
 
   cv::Mat descriptors;
 
-  unsigned int num_keypts = 0;
+  // the offset of each level in the descriptors
+  std::vector<unsigned int> offsets(orb_params_->num_levels_ + 1, 0);
   for (unsigned int level = 0; level < orb_params_->num_levels_; ++level) {
-    num_keypts += all_keypts.at(level).size();
+    offsets.at(level + 1) = offsets.at(level) + all_keypts.at(level).size();
   }
+  const unsigned int num_keypts = offsets.back();
   if (num_keypts == 0) {
     out_descriptors.release();
   } else {
@@ -117,31 +120,33 @@ void orb_extractor::extract(const cv::_InputArray& in_image,
     descriptors = out_descriptors.getMat();
   }
 
-  keypts.clear();
-  keypts.reserve(num_keypts);
-
-  unsigned int offset = 0;
+  // blur each level into the persistent buffer and compute the descriptors
+  // (the levels are independent of each other)
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
   for (unsigned int level = 0; level < orb_params_->num_levels_; ++level) {
     auto& keypts_at_level = all_keypts.at(level);
-    const auto num_keypts_at_level = keypts_at_level.size();
-
-    if (num_keypts_at_level == 0) {
+    if (keypts_at_level.empty()) {
       continue;
     }
 
-    cv::Mat blurred_image = image_pyramid_.at(level).clone();
-    cv::GaussianBlur(blurred_image, blurred_image, cv::Size(7, 7), 2, 2,
-                     cv::BORDER_REFLECT_101);
+    auto& blurred_image = blurred_image_pyramid_.at(level);
+    cv::GaussianBlur(image_pyramid_.at(level), blurred_image, cv::Size(7, 7), 2,
+                     2, cv::BORDER_REFLECT_101);
 
     cv::Mat descriptors_at_level =
-        descriptors.rowRange(offset, offset + num_keypts_at_level);
+        descriptors.rowRange(offsets.at(level), offsets.at(level + 1));
     compute_orb_descriptors(blurred_image, keypts_at_level,
                             descriptors_at_level);
 
-    offset += num_keypts_at_level;
-
     correct_keypoint_scale(keypts_at_level, level);
+  }
 
+  keypts.clear();
+  keypts.reserve(num_keypts);
+  for (unsigned int level = 0; level < orb_params_->num_levels_; ++level) {
+    const auto& keypts_at_level = all_keypts.at(level);
     keypts.insert(keypts.end(), keypts_at_level.begin(), keypts_at_level.end());
   }
 }
@@ -158,6 +163,7 @@ void orb_extractor::set_max_num_keypoints(const unsigned int max_num_keypts) {
 void orb_extractor::initialize() {
   // resize buffers according to the number of levels
   image_pyramid_.resize(orb_params_->num_levels_);
+  blurred_image_pyramid_.resize(orb_params_->num_levels_);
   num_keypts_per_level_.resize(orb_params_->num_levels_);
 
   // compute the desired number of keypoints per scale
@@ -212,6 +218,8 @@ void orb_extractor::create_rectangle_mask(const unsigned int cols,
 }
 
 void orb_extractor::compute_image_pyramid(const cv::Mat& image) {
+  // the input image is not copied, and the buffers of the other levels are
+  // reused as long as the image size is unchanged
   image_pyramid_.at(0) = image;
   for (unsigned int level = 1; level < orb_params_->num_levels_; ++level) {
     // determine the size of an image
@@ -235,7 +243,6 @@ void orb_extractor::compute_fast_keypoints(
     return mask.at<unsigned char>(y * scale_factor, x * scale_factor) == 0;
   };
 
-  constexpr unsigned int overlap = 6;
   constexpr unsigned int cell_size = 64;
 
 #ifdef USE_OPENMP
@@ -254,85 +261,74 @@ void orb_extractor::compute_fast_keypoints(
     const unsigned int width = max_border_x - min_border_x;
     const unsigned int height = max_border_y - min_border_y;
 
-    const unsigned int num_cols = std::ceil(width / cell_size) + 1;
-    const unsigned int num_rows = std::ceil(height / cell_size) + 1;
-
-    std::vector<cv::KeyPoint> keypts_to_distribute;
-    keypts_to_distribute.reserve(max_num_keypts_ * 10);
-
-#ifdef USE_OPENMP
-#pragma omp parallel for
-#endif
-    for (unsigned int i = 0; i < num_rows; ++i) {
-      const unsigned int min_y = min_border_y + i * cell_size;
-      if (max_border_y - overlap <= min_y) {
-        continue;
-      }
-      unsigned int max_y = min_y + cell_size + overlap;
-      if (max_border_y < max_y) {
-        max_y = max_border_y;
+    const unsigned int num_cols = width / cell_size + 1;
+    const unsigned int num_rows = height / cell_size + 1;
+
+    // Detect FAST keypoints over the whole level at once with the minimum
+    // threshold (the score of each keypoint is stored as the response and does
+    // not depend on the threshold)
+    std::vector<cv::KeyPoint> fast_keypts;
+    cv::FAST(image_pyramid_.at(level)
+                 .rowRange(min_border_y, max_border_y)
+                 .colRange(min_border_x, max_border_x),
+             fast_keypts, orb_params_->min_fast_thr_, true);
+
+    // Bucket the keypoints into the cells
+    std::vector<unsigned int> cell_indices(fast_keypts.size());
+    // The cell has a keypoint which passes the initial threshold or not
+    std::vector<bool> cell_is_strong(num_rows * num_cols, false);
+    for (unsigned int idx = 0; idx < fast_keypts.size(); ++idx) {
+      const auto& keypt = fast_keypts.at(idx);
+      const unsigned int i = static_cast<unsigned int>(keypt.pt.y) / cell_size;
+      const unsigned int j = static_cast<unsigned int>(keypt.pt.x) / cell_size;
+      cell_indices.at(idx) = i * num_cols + j;
+      if (orb_params_->ini_fast_thr_ <= keypt.response) {
+        cell_is_strong.at(cell_indices.at(idx)) = true;
       }
+    }
 
-#ifdef USE_OPENMP
-#pragma omp parallel for
-#endif
-      for (unsigned int j = 0; j < num_cols; ++j) {
-        const unsigned int min_x = min_border_x + j * cell_size;
-        if (max_border_x - overlap <= min_x) {
-          continue;
-        }
-        unsigned int max_x = min_x + cell_size + overlap;
-        if (max_border_x < max_x) {
-          max_x = max_border_x;
-        }
-
-        // Pass FAST computation if one of the corners of a patch is in the mask
-        if (!mask.empty()) {
-          if (is_in_mask(min_y, min_x, scale_factor) ||
+    // Pass the cells if one of the corners of a cell is in the mask
+    std::vector<bool> cell_is_masked(num_rows * num_cols, false);
+    if (!mask.empty()) {
+      for (unsigned int i = 0; i < num_rows; ++i) {
+        const unsigned int min_y = min_border_y + i * cell_size;
+        const unsigned int max_y =
+            std::min(min_y + cell_size, max_border_y - 1);
+        for (unsigned int j = 0; j < num_cols; ++j) {
+          const unsigned int min_x = min_border_x + j * cell_size;
+          const unsigned int max_x =
+              std::min(min_x + cell_size, max_border_x - 1);
+          cell_is_masked.at(i * num_cols + j) =
+              is_in_mask(min_y, min_x, scale_factor) ||
               is_in_mask(max_y, min_x, scale_factor) ||
               is_in_mask(min_y, max_x, scale_factor) ||
-              is_in_mask(max_y, max_x, scale_factor)) {
-            continue;
-          }
-        }
-
-        std::vector<cv::KeyPoint> keypts_in_cell;
-        cv::FAST(image_pyramid_.at(level)
-                     .rowRange(min_y, max_y)
-                     .colRange(min_x, max_x),
-                 keypts_in_cell, orb_params_->ini_fast_thr_, true);
-
-        // Re-compute FAST keypoint with reduced threshold if enough keypoint
-        // was not got
-        if (keypts_in_cell.empty()) {
-          cv::FAST(image_pyramid_.at(level)
-                       .rowRange(min_y, max_y)
-                       .colRange(min_x, max_x),
-                   keypts_in_cell, orb_params_->min_fast_thr_, true);
-        }
-
-        if (keypts_in_cell.empty()) {
-          continue;
+              is_in_mask(max_y, max_x, scale_factor);
         }
+      }
+    }
 
-        // Collect keypoints for every scale
-#ifdef USE_OPENMP
-#pragma omp critical
-#endif
-        {
-          for (auto& keypt : keypts_in_cell) {
-            keypt.pt.x += j * cell_size;
-            keypt.pt.y += i * cell_size;
-            // Check if the keypoint is in the mask
-            if (!mask.empty() &&
-                is_in_mask(min_border_y + keypt.pt.y, min_border_x + keypt.pt.x,
-                           scale_factor)) {
-              continue;
-            }
-            keypts_to_distribute.push_back(keypt);
-          }
-        }
+    // Collect the keypoints which pass the initial threshold, or the minimum
+    // threshold in the cells which have no keypoints with the initial one
+    // (this is equivalent to re-computing FAST with the reduced threshold)
+    std::vector<cv::KeyPoint> keypts_to_distribute;
+    keypts_to_distribute.reserve(fast_keypts.size());
+    for (unsigned int idx = 0; idx < fast_keypts.size(); ++idx) {
+      const auto& keypt = fast_keypts.at(idx);
+      const auto cell_idx = cell_indices.at(idx);
+      if (cell_is_masked.at(cell_idx)) {
+        continue;
+      }
+      if (cell_is_strong.at(cell_idx) &&
+          keypt.response < orb_params_->ini_fast_thr_) {
+        continue;
+      }
+      // Check if the keypoint is in the mask
+      if (!mask.empty() &&
+          is_in_mask(min_border_y + keypt.pt.y, min_border_x + keypt.pt.x,
+                     scale_factor)) {
+        continue;
       }
+      keypts_to_distribute.push_back(keypt);
     }
 
     std::vector<cv::KeyPoint>& keypts_at_level = all_keypts.at(level);
@@ -367,12 +363,16 @@ std::vector<cv::KeyPoint> orb_extractor::distribute_keypoints_via_tree(
     const std::vector<cv::KeyPoint>& keypts_to_distribute, const int min_x,
     const int max_x, const int min_y, const int max_y,
     const unsigned int num_keypts) const {
-  auto nodes =
-      initialize_nodes(keypts_to_distribute, min_x, max_x, min_y, max_y);
-
-  // Forkable leaf nodes list
+  // The nodes refer to the ranges of the keypoints, which are partitioned in
+  // place when the nodes are divided
+  std::vector<orb_extractor_keypt_ref> keypt_refs;
+  orb_extractor_node_list nodes(2 * num_keypts + 64);
+  initialize_nodes(keypts_to_distribute, min_x, max_x, min_y, max_y,
+                   keypt_refs, nodes);
+
+  // Forkable leaf nodes list (the number of keypoints and the node index)
   // The pool is used when a forking makes nodes more than a limited number
-  std::vector<std::pair<int, orb_extractor_node*>> leaf_nodes_pool;
+  std::vector<std::pair<unsigned int, int>> leaf_nodes_pool;
   leaf_nodes_pool.reserve(nodes.size() * 10);
 
   // A flag denotes if enough keypoints have been distributed
@@ -381,21 +381,22 @@ std::vector<cv::KeyPoint> orb_extractor::distribute_keypoints_via_tree(
   while (true) {
     const unsigned int prev_size = nodes.size();
 
-    auto iter = nodes.begin();
     leaf_nodes_pool.clear();
 
     // Fork node and remove the old one from nodes
-    while (iter != nodes.end()) {
-      if (iter->is_leaf_node_) {
-        iter++;
-        continue;
+    // (the child nodes are added to the front, so they are not visited here)
+    int idx = nodes.front();
+    while (0 <= idx) {
+      const int next_idx = nodes.at(idx).next_;
+      if (!nodes.at(idx).is_leaf_node_) {
+        // Divide node and assign to the leaf node pool
+        const auto child_nodes =
+            nodes.at(idx).divide_node(keypt_refs);
+        assign_child_nodes(child_nodes, nodes, leaf_nodes_pool);
+        // Remove the old node
+        nodes.erase(idx);
       }
-
-      // Divide node and assign to the leaf node pool
-      const auto child_nodes = iter->divide_node();
-      assign_child_nodes(child_nodes, nodes, leaf_nodes_pool);
-      // Remove the old node
-      iter = nodes.erase(iter);
+      idx = next_idx;
     }
 
     // Stop iteration when the number of nodes is over the designated size or
@@ -413,36 +414,52 @@ std::vector<cv::KeyPoint> orb_extractor::distribute_keypoints_via_tree(
     }
   }
 
+  // Priority queue of the leaf nodes
+  // (the number of keypoints and the negated position in the pool, so that the
+  // node which has much more keypoints and was added earlier comes first)
+  std::vector<std::pair<unsigned int, int>> prev_leaf_nodes_pool;
+  std::vector<std::pair<unsigned int, int>> queue;
+
   while (!is_filled) {
     // Select nodes so that keypoint number is just same as designeted number
     const unsigned int prev_size = nodes.size();
 
-    auto prev_leaf_nodes_pool = leaf_nodes_pool;
+    prev_leaf_nodes_pool.swap(leaf_nodes_pool);
     leaf_nodes_pool.clear();
 
-    int max_num_keypts = 0;
-    for (const auto& prev_leaf_node : prev_leaf_nodes_pool) {
-      if (max_num_keypts < prev_leaf_node.first) {
-        max_num_keypts = prev_leaf_node.first;
-      }
+    queue.clear();
+    for (unsigned int i = 0; i < prev_leaf_nodes_pool.size(); ++i) {
+      queue.emplace_back(prev_leaf_nodes_pool.at(i).first,
+                         -static_cast<int>(i));
     }
+    std::make_heap(queue.begin(), queue.end());
 
     // Do processes from the node which has much more keypoints
-    for (int target_num_keypts = max_num_keypts; target_num_keypts > 0;
-         --target_num_keypts) {
-      for (const auto& prev_leaf_node : prev_leaf_nodes_pool) {
-        if (prev_leaf_node.first == target_num_keypts) {
-          // Divide node and assign to the leaf node pool
-          const auto child_nodes = prev_leaf_node.second->divide_node();
-          assign_child_nodes(child_nodes, nodes, leaf_nodes_pool);
-          // Remove the old node
-          nodes.erase(prev_leaf_node.second->iter_);
-
-          if (num_keypts <= nodes.size()) {
-            is_filled = true;
-            break;
-          }
-        }
+    // (after the designated number is reached, only the first node of each of
+    // the smaller numbers of keypoints is divided, as the former list-based
+    // implementation did)
+    unsigned int last_num_keypts = 0;
+    while (!queue.empty()) {
+      std::pop_heap(queue.begin(), queue.end());
+      const auto num_keypts_in_node = queue.back().first;
+      const auto pool_idx = -queue.back().second;
+      queue.pop_back();
+
+      if (is_filled && num_keypts_in_node == last_num_keypts) {
+        continue;
+      }
+      last_num_keypts = num_keypts_in_node;
+
+      // Divide node and assign to the leaf node pool
+      const int node_idx = prev_leaf_nodes_pool.at(pool_idx).second;
+      const auto child_nodes =
+          nodes.at(node_idx).divide_node(keypt_refs);
+      assign_child_nodes(child_nodes, nodes, leaf_nodes_pool);
+      // Remove the old node
+      nodes.erase(node_idx);
+
+      if (num_keypts <= nodes.size()) {
+        is_filled = true;
       }
     }
 
@@ -454,12 +471,15 @@ std::vector<cv::KeyPoint> orb_extractor::distribute_keypoints_via_tree(
     }
   }
 
-  return find_keypoints_with_max_response(nodes);
+  return find_keypoints_with_max_response(keypts_to_distribute, keypt_refs,
+                                          nodes);
 }
 
-std::list<orb_extractor_node> orb_extractor::initialize_nodes(
+void orb_extractor::initialize_nodes(
     const std::vector<cv::KeyPoint>& keypts_to_distribute, const int min_x,
-    const int max_x, const int min_y, const int max_y) const {
+    const int max_x, const int min_y, const int max_y,
+    std::vector<orb_extractor_keypt_ref>& keypt_refs,
+    orb_extractor_node_list& nodes) const {
   // The aspect ratio of the target area for keypoint detection
   const auto ratio = static_cast<double>(max_x - min_x) / (max_y - min_y);
   // The width and height of the patches allocated to the initial node
@@ -486,15 +506,39 @@ std::list<orb_extractor_node> orb_extractor::initialize_nodes(
   // The number of the initial nodes
   const unsigned int num_initial_nodes = num_x_grid * num_y_grid;
 
-  // A list of node
-  std::list<orb_extractor_node> nodes;
+  // Count the keypoints in each of the initial nodes which own keypoint's
+  // position
+  std::vector<unsigned int> node_idx_of_keypts(keypts_to_distribute.size());
+  std::vector<unsigned int> offsets(num_initial_nodes + 1, 0);
+  for (unsigned int i = 0; i < keypts_to_distribute.size(); ++i) {
+    const auto& keypt = keypts_to_distribute.at(i);
+    // x / y index of the patch where the keypt is placed
+    const unsigned int ix = keypt.pt.x / delta_x;
+    const unsigned int iy = keypt.pt.y / delta_y;
 
-  // Initial node objects
-  std::vector<orb_extractor_node*> initial_nodes;
-  initial_nodes.resize(num_initial_nodes);
+    const unsigned int node_idx = ix + iy * num_x_grid;
+    ++offsets.at(node_idx + 1);
+    node_idx_of_keypts.at(i) = node_idx;
+  }
+  for (unsigned int i = 0; i < num_initial_nodes; ++i) {
+    offsets.at(i + 1) += offsets.at(i);
+  }
+
+  // Sort the keypoints by the initial nodes
+  keypt_refs.resize(keypts_to_distribute.size());
+  std::vector<unsigned int> cursors(offsets.begin(), offsets.end() - 1);
+  for (unsigned int i = 0; i < keypts_to_distribute.size(); ++i) {
+    keypt_refs.at(cursors.at(node_idx_of_keypts.at(i))++) =
+        orb_extractor_keypt_ref(keypts_to_distribute.at(i), i);
+  }
 
   // Create initial node substances
   for (unsigned int i = 0; i < num_initial_nodes; ++i) {
+    // Remove empty nodes
+    if (offsets.at(i) == offsets.at(i + 1)) {
+      continue;
+    }
+
     orb_extractor_node node;
 
     // x / y index of the node's patch in the grid
@@ -503,76 +547,57 @@ std::list<orb_extractor_node> orb_extractor::initialize_nodes(
 
     node.pt_begin_ = cv::Point2i(delta_x * ix, delta_y * iy);
     node.pt_end_ = cv::Point2i(delta_x * (ix + 1), delta_y * (iy + 1));
-    node.keypts_.reserve(keypts_to_distribute.size());
+    node.begin_ = offsets.at(i);
+    node.end_ = offsets.at(i + 1);
+    // Set the leaf node flag if the node has only one keypoint
+    node.is_leaf_node_ = (node.size() == 1);
 
     nodes.push_back(node);
-    initial_nodes.at(i) = &nodes.back();
   }
-
-  // Assign all keypoints to initial nodes which own keypoint's position
-  for (const auto& keypt : keypts_to_distribute) {
-    // x / y index of the patch where the keypt is placed
-    const unsigned int ix = keypt.pt.x / delta_x;
-    const unsigned int iy = keypt.pt.y / delta_y;
-
-    const unsigned int node_idx = ix + iy * num_x_grid;
-    initial_nodes.at(node_idx)->keypts_.push_back(keypt);
-  }
-
-  auto iter = nodes.begin();
-  while (iter != nodes.end()) {
-    // Remove empty nodes
-    if (iter->keypts_.empty()) {
-      iter = nodes.erase(iter);
-      continue;
-    }
-    // Set the leaf node flag if the node has only one keypoint
-    iter->is_leaf_node_ = (iter->keypts_.size() == 1);
-    iter++;
-  }
-
-  return nodes;
 }
 
 void orb_extractor::assign_child_nodes(
     const std::array<orb_extractor_node, 4>& child_nodes,
-    std::list<orb_extractor_node>& nodes,
-    std::vector<std::pair<int, orb_extractor_node*>>& leaf_nodes) const {
+    orb_extractor_node_list& nodes,
+    std::vector<std::pair<unsigned int, int>>& leaf_nodes) const {
   for (const auto& child_node : child_nodes) {
-    if (child_node.keypts_.empty()) {
+    if (child_node.size() == 0) {
       continue;
     }
-    nodes.push_front(child_node);
-    if (child_node.keypts_.size() == 1) {
+    const int idx = nodes.push_front(child_node);
+    if (child_node.size() == 1) {
       continue;
     }
-    leaf_nodes.emplace_back(
-        std::make_pair(child_node.keypts_.size(), &nodes.front()));
-    // Keep the self iterator to remove from std::list randomly
-    nodes.front().iter_ = nodes.begin();
+    leaf_nodes.emplace_back(child_node.size(), idx);
   }
 }
 
 std::vector<cv::KeyPoint> orb_extractor::find_keypoints_with_max_response(
-    std::list<orb_extractor_node>& nodes) const {
+    const std::vector<cv::KeyPoint>& keypts_to_distribute,
+    const std::vector<orb_extractor_keypt_ref>& keypt_refs,
+    const orb_extractor_node_list& nodes) const {
   // A vector contains result keypoint
   std::vector<cv::KeyPoint> result_keypts;
   result_keypts.reserve(nodes.size());
 
   // Store keypoints which has maximum response in the node patch
-  for (auto& node : nodes) {
-    auto& node_keypts = node.keypts_;
-    auto& keypt = node_keypts.at(0);
-    double max_response = keypt.response;
-
-    for (unsigned int k = 1; k < node_keypts.size(); ++k) {
-      if (node_keypts.at(k).response > max_response) {
-        keypt = node_keypts.at(k);
-        max_response = node_keypts.at(k).response;
+  // (the first one in the input order is selected if the responses are tied)
+  for (int idx = nodes.front(); 0 <= idx; idx = nodes.at(idx).next_) {
+    const auto& node = nodes.at(idx);
+    unsigned int best_keypt_idx = keypt_refs.at(node.begin_).idx_;
+    double max_response = keypts_to_distribute.at(best_keypt_idx).response;
+
+    for (unsigned int k = node.begin_ + 1; k < node.end_; ++k) {
+      const auto keypt_idx = keypt_refs.at(k).idx_;
+      const auto response = keypts_to_distribute.at(keypt_idx).response;
+      if (response > max_response ||
+          (response == max_response && keypt_idx < best_keypt_idx)) {
+        best_keypt_idx = keypt_idx;
+        max_response = response;
       }
     }
 
-    result_keypts.push_back(keypt);
+    result_keypts.push_back(keypts_to_distribute.at(best_keypt_idx));
   }
 
   return result_keypts;
@@ -43,6 +43,9 @@ class orb_extractor {
 
   //! Image pyramid
   std::vector<cv::Mat> image_pyramid_;
+  //! Image pyramid smoothed by Gaussian filter, which is used for descriptors
+  //! (only the levels which have keypoints are updated in each extraction)
+  std::vector<cv::Mat> blurred_image_pyramid_;
 
  private:
   //! Initialize orb extractor
@@ -69,19 +72,24 @@ class orb_extractor {
       const unsigned int num_keypts) const;
 
   //! Initialize nodes that used for keypoint distribution tree
-  std::list<orb_extractor_node> initialize_nodes(
-      const std::vector<cv::KeyPoint>& keypts_to_distribute, const int min_x,
-      const int max_x, const int min_y, const int max_y) const;
+  //! (the keypoints are sorted by the initial nodes)
+  void initialize_nodes(const std::vector<cv::KeyPoint>& keypts_to_distribute,
+                        const int min_x, const int max_x, const int min_y,
+                        const int max_y,
+                        std::vector<orb_extractor_keypt_ref>& keypt_refs,
+                        orb_extractor_node_list& nodes) const;
 
   //! Assign child nodes to the all node list
   void assign_child_nodes(
       const std::array<orb_extractor_node, 4>& child_nodes,
-      std::list<orb_extractor_node>& nodes,
-      std::vector<std::pair<int, orb_extractor_node*>>& leaf_nodes) const;
+      orb_extractor_node_list& nodes,
+      std::vector<std::pair<unsigned int, int>>& leaf_nodes) const;
 
   //! Find keypoint which has maximum value of response
   std::vector<cv::KeyPoint> find_keypoints_with_max_response(
-      std::list<orb_extractor_node>& nodes) const;
+      const std::vector<cv::KeyPoint>& keypts_to_distribute,
+      const std::vector<orb_extractor_keypt_ref>& keypt_refs,
+      const orb_extractor_node_list& nodes) const;
 
   //! Compute orientation for each keypoint
   void compute_orientation(const cv::Mat& image,
@@ -1,9 +1,12 @@
 #include "openvslam/feature/orb_extractor_node.h"
 
+#include <algorithm>
+
 namespace openvslam {
 namespace feature {
 
-std::array<orb_extractor_node, 4> orb_extractor_node::divide_node() {
+std::array<orb_extractor_node, 4> orb_extractor_node::divide_node(
+    std::vector<orb_extractor_keypt_ref>& keypt_refs) const {
   // Half width/height of the allocated patch area
   const unsigned int half_x = cvCeil((pt_end_.x - pt_begin_.x) / 2.0);
   const unsigned int half_y = cvCeil((pt_end_.y - pt_begin_.y) / 2.0);
@@ -30,25 +33,84 @@ std::array<orb_extractor_node, 4> orb_extractor_node::divide_node() {
   child_nodes.at(3).pt_begin_ = pt_center;
   child_nodes.at(3).pt_end_ = pt_end_;
 
-  // Memory reservation for child nodes
-  for (auto& node : child_nodes) {
-    node.keypts_.reserve(keypts_.size());
-  }
-
   // Distribute keypoints to child nodes
-  for (const auto& keypt : keypts_) {
-    unsigned int idx = 0;
-    if (pt_begin_.x + half_x <= keypt.pt.x) {
-      idx += 1;
-    }
-    if (pt_begin_.y + half_y <= keypt.pt.y) {
-      idx += 2;
-    }
-    child_nodes.at(idx).keypts_.push_back(keypt);
+  // (partition the range into top-left, top-right, bottom-left and
+  // bottom-right)
+  const auto is_top = [&](const orb_extractor_keypt_ref& keypt) {
+    return !(pt_begin_.y + half_y <= keypt.pt_.y);
+  };
+  const auto is_left = [&](const orb_extractor_keypt_ref& keypt) {
+    return !(pt_begin_.x + half_x <= keypt.pt_.x);
+  };
+  const auto first = keypt_refs.begin() + begin_;
+  const auto last = keypt_refs.begin() + end_;
+  const auto middle = std::partition(first, last, is_top);
+  const auto top_middle = std::partition(first, middle, is_left);
+  const auto bottom_middle = std::partition(middle, last, is_left);
+
+  const unsigned int bounds[5] = {
+      begin_, static_cast<unsigned int>(top_middle - keypt_refs.begin()),
+      static_cast<unsigned int>(middle - keypt_refs.begin()),
+      static_cast<unsigned int>(bottom_middle - keypt_refs.begin()), end_};
+  for (unsigned int i = 0; i < 4; ++i) {
+    child_nodes.at(i).begin_ = bounds[i];
+    child_nodes.at(i).end_ = bounds[i + 1];
   }
 
   return child_nodes;
 }
 
+orb_extractor_node_list::orb_extractor_node_list(
+    const unsigned int num_reserved_nodes) {
+  nodes_.reserve(num_reserved_nodes);
+}
+
+int orb_extractor_node_list::push_front(const orb_extractor_node& node) {
+  const int idx = nodes_.size();
+  nodes_.push_back(node);
+  nodes_.back().prev_ = -1;
+  nodes_.back().next_ = front_;
+  if (0 <= front_) {
+    nodes_.at(front_).prev_ = idx;
+  } else {
+    back_ = idx;
+  }
+  front_ = idx;
+  ++size_;
+  return idx;
+}
+
+int orb_extractor_node_list::push_back(const orb_extractor_node& node) {
+  const int idx = nodes_.size();
+  nodes_.push_back(node);
+  nodes_.back().prev_ = back_;
+  nodes_.back().next_ = -1;
+  if (0 <= back_) {
+    nodes_.at(back_).next_ = idx;
+  } else {
+    front_ = idx;
+  }
+  back_ = idx;
+  ++size_;
+  return idx;
+}
+
+void orb_extractor_node_list::erase(const int idx) {
+  auto& node = nodes_.at(idx);
+  if (0 <= node.prev_) {
+    nodes_.at(node.prev_).next_ = node.next_;
+  } else {
+    front_ = node.next_;
+  }
+  if (0 <= node.next_) {
+    nodes_.at(node.next_).prev_ = node.prev_;
+  } else {
+    back_ = node.prev_;
+  }
+  node.prev_ = -1;
+  node.next_ = -1;
+  --size_;
+}
+
 }  // namespace feature
 }  // namespace openvslam
@@ -2,33 +2,90 @@
 #define OPENVSLAM_FEATURE_ORB_EXTRACTOR_NODE_H
 
 #include <array>
-#include <list>
 #include <opencv2/core/types.hpp>
+#include <vector>
 
 namespace openvslam {
 namespace feature {
 
+//! Position and index of the keypoint to distribute
+struct orb_extractor_keypt_ref {
+  //! Constructor
+  orb_extractor_keypt_ref() = default;
+
+  //! Constructor with initialization
+  orb_extractor_keypt_ref(const cv::KeyPoint& keypt, const unsigned int idx)
+      : pt_(keypt.pt), idx_(idx) {}
+
+  //! position of the keypoint
+  cv::Point2f pt_;
+  //! index of the keypoint in the input vector
+  unsigned int idx_ = 0;
+};
+
 class orb_extractor_node {
  public:
   //! Constructor
   orb_extractor_node() = default;
 
   //! Divide node to four child nodes
-  std::array<orb_extractor_node, 4> divide_node();
+  //! (the keypoints in the range of this node are partitioned in place)
+  std::array<orb_extractor_node, 4> divide_node(
+      std::vector<orb_extractor_keypt_ref>& keypt_refs) const;
 
-  //! Keypoints which distributed into this node
-  std::vector<cv::KeyPoint> keypts_;
+  //! Get the number of the keypoints which distributed into this node
+  unsigned int size() const { return end_ - begin_; }
+
+  //! Range of the keypoints which distributed into this node
+  unsigned int begin_ = 0, end_ = 0;
 
   //! Begin and end of the allocated area on the image
   cv::Point2i pt_begin_, pt_end_;
 
-  //! A iterator pointing to self, used for removal on list
-  std::list<orb_extractor_node>::iterator iter_;
+  //! Previous and next nodes on the list (-1 if not exist)
+  int prev_ = -1, next_ = -1;
 
   //! A flag designating if this node is a leaf node
   bool is_leaf_node_ = false;
 };
 
+/**
+ * List of the nodes, which are allocated in one array and linked by the
+ * array indices (the erased nodes are not reused)
+ */
+class orb_extractor_node_list {
+ public:
+  //! Constructor
+  explicit orb_extractor_node_list(const unsigned int num_reserved_nodes);
+
+  //! Add the node to the front of the list and return its index
+  int push_front(const orb_extractor_node& node);
+
+  //! Add the node to the back of the list and return its index
+  int push_back(const orb_extractor_node& node);
+
+  //! Remove the node from the list
+  void erase(const int idx);
+
+  //! Get the node
+  orb_extractor_node& at(const int idx) { return nodes_.at(idx); }
+  const orb_extractor_node& at(const int idx) const { return nodes_.at(idx); }
+
+  //! Get the index of the first node (-1 if the list is empty)
+  int front() const { return front_; }
+
+  //! Get the number of the nodes on the list
+  unsigned int size() const { return size_; }
+
+ private:
+  //! node storage
+  std::vector<orb_extractor_node> nodes_;
+  //! first and last nodes on the list
+  int front_ = -1, back_ = -1;
+  //! number of the nodes on the list
+  unsigned int size_ = 0;
+};
+
 }  // namespace feature
 }  // namespace openvslam
 
@@ -16,19 +16,19 @@ global_optimization_module::global_optimization_module(
     data::map_database* map_db, data::bow_database* bow_db,
     data::bow_vocabulary* bow_vocab, const YAML::Node& yaml_node,
     const bool fix_scale)
-    : loop_detector_(new module::loop_detector(
+    : map_db_(map_db),
+      loop_detector_(new module::loop_detector(
           bow_db, bow_vocab, util::yaml_optional_ref(yaml_node, "LoopDetector"),
           fix_scale)),
-      loop_bundle_adjuster_(new module::loop_bundle_adjuster(map_db)),
+      loop_bundle_adjuster_(new module::loop_bundle_adjuster(
+          map_db, util::yaml_optional_ref(yaml_node, "LoopBundleAdjuster"))),
       graph_optimizer_(new optimize::graph_optimizer(map_db, fix_scale)) {
   spdlog::debug("CONSTRUCT: global_optimization_module");
 }
 
 global_optimization_module::~global_optimization_module() {
   abort_loop_BA();
-  if (thread_for_loop_BA_) {
-    thread_for_loop_BA_->join();
-  }
+  wait_for_loop_BA();
   spdlog::debug("DESTRUCT: global_optimization_module");
 }
 
@@ -41,6 +41,11 @@ void global_optimization_module::set_mapping_module(mapping_module* mapper) {
   loop_bundle_adjuster_->set_mapping_module(mapper);
 }
 
+void global_optimization_module::set_job_scheduler(
+    optimize::job_scheduler* scheduler) {
+  scheduler_ = scheduler;
+}
+
 void global_optimization_module::enable_loop_detector() {
   spdlog::info("enable loop detector");
   loop_detector_->enable_loop_detector();
@@ -156,9 +161,7 @@ void global_optimization_module::correct_loop() {
   // pause the mapping module
   auto future_pause = mapper_->async_pause();
   // abort the previous loop bundle adjuster
-  if (thread_for_loop_BA_ || loop_bundle_adjuster_->is_running()) {
-    abort_loop_BA();
-  }
+  abort_loop_BA();
   // wait till the mapping module pauses
   future_pause.get();
 
@@ -186,7 +189,7 @@ void global_optimization_module::correct_loop() {
   const auto g2o_Sim3_cw_after_correction =
       loop_detector_->get_Sim3_world_to_current();
   {
-    std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+    std::lock_guard<std::mutex> lock(map_db_->mtx_database_);
 
     // camera pose of the current keyframe BEFORE loop correction
     const Mat44_t cam_pose_wc_before_correction =
@@ -221,25 +224,49 @@ void global_optimization_module::correct_loop() {
 
   // 4. pose graph optimization
 
-  graph_optimizer_->optimize(
+  // 4-1. copy the pose graph while the mapping module is paused
+
+  const auto snapshot = graph_optimizer_->create_snapshot(
       final_candidate_keyfrm, cur_keyfrm_, Sim3s_nw_before_correction,
-      Sim3s_nw_after_correction, new_connections, found_lm_to_ref_keyfrm_id);
+      Sim3s_nw_after_correction, new_connections);
 
   // add a loop edge
   final_candidate_keyfrm->graph_node_->add_loop_edge(cur_keyfrm_);
   cur_keyfrm_->graph_node_->add_loop_edge(final_candidate_keyfrm);
 
+  // 4-2. optimize the snapshot while the mapping module is running
+
+  mapper_->resume();
+  eigen_alloc_unord_map<unsigned int, g2o::Sim3> corrected_Sim3s_cw;
+  scheduler_
+      ->submit("pose graph optimization", optimize::job_priority_t::Normal,
+               [this, &snapshot,
+                &corrected_Sim3s_cw](const optimize::cancellation_token&) {
+                 corrected_Sim3s_cw = graph_optimizer_->solve(snapshot);
+               })
+      .wait();
+
+  // 4-3. commit the correction while the mapping module is paused again
+  //      (the keyframes inserted during the optimization are rebased)
+
+  future_pause = mapper_->async_pause();
+  future_pause.get();
+  graph_optimizer_->commit(snapshot, corrected_Sim3s_cw,
+                           found_lm_to_ref_keyfrm_id);
+
   // 5. launch loop BA
+  //    (it is preempted by the local BA when no worker is idle)
 
-  while (loop_bundle_adjuster_->is_running()) {
-    std::this_thread::sleep_for(std::chrono::microseconds(1000));
-  }
-  if (thread_for_loop_BA_) {
-    thread_for_loop_BA_->join();
-    thread_for_loop_BA_.reset(nullptr);
+  wait_for_loop_BA();
+  {
+    std::lock_guard<std::mutex> lock(mtx_loop_BA_);
+    loop_BA_job_ = scheduler_->submit(
+        "loop BA", optimize::job_priority_t::Low,
+        [this](const optimize::cancellation_token& token) {
+          loop_bundle_adjuster_->optimize(token);
+        },
+        true);
   }
-  thread_for_loop_BA_ = std::unique_ptr<std::thread>(new std::thread(
-      &module::loop_bundle_adjuster::optimize, loop_bundle_adjuster_.get()));
 
   // 6. post-processing
 
@@ -359,7 +386,7 @@ void global_optimization_module::replace_duplicated_landmarks(
   // resolve duplications of landmarks between the current keyframe and the loop
   // candidate
   {
-    std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+    std::lock_guard<std::mutex> lock(map_db_->mtx_database_);
 
     for (unsigned int idx = 0; idx < cur_keyfrm_->frm_obs_.num_keypts_; ++idx) {
       auto curr_match_lm_in_cand = curr_match_lms_observed_in_cand.at(idx);
@@ -402,7 +429,7 @@ void global_optimization_module::replace_duplicated_landmarks(
                              curr_match_lms_observed_in_cand_covis, 4,
                              lms_to_replace);
 
-    std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+    std::lock_guard<std::mutex> lock(map_db_->mtx_database_);
     // if any landmark duplication is found, replace it
     for (unsigned int i = 0; i < curr_match_lms_observed_in_cand_covis.size();
          ++i) {
@@ -540,11 +567,22 @@ void global_optimization_module::terminate() {
 }
 
 bool global_optimization_module::loop_BA_is_running() const {
-  return loop_bundle_adjuster_->is_running();
+  std::lock_guard<std::mutex> lock(mtx_loop_BA_);
+  return !loop_BA_job_.is_finished();
 }
 
 void global_optimization_module::abort_loop_BA() {
-  loop_bundle_adjuster_->abort();
+  std::lock_guard<std::mutex> lock(mtx_loop_BA_);
+  loop_BA_job_.cancel();
+}
+
+void global_optimization_module::wait_for_loop_BA() const {
+  optimize::job_scheduler::job_handle loop_BA_job;
+  {
+    std::lock_guard<std::mutex> lock(mtx_loop_BA_);
+    loop_BA_job = loop_BA_job_;
+  }
+  loop_BA_job.wait();
 }
 
 }  // namespace openvslam
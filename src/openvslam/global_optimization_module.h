@@ -12,6 +12,7 @@
 #include "openvslam/module/loop_detector.h"
 #include "openvslam/module/type.h"
 #include "openvslam/optimize/graph_optimizer.h"
+#include "openvslam/optimize/job_scheduler.h"
 #include "openvslam/type.h"
 
 namespace openvslam {
@@ -42,6 +43,9 @@ class global_optimization_module {
   //! Set the mapping module
   void set_mapping_module(mapping_module* mapper);
 
+  //! Set the scheduler of the optimization jobs
+  void set_job_scheduler(optimize::job_scheduler* scheduler);
+
   //-----------------------------------------
   // interfaces to ON/OFF loop detector
 
@@ -207,6 +211,9 @@ class global_optimization_module {
   //! mapping module
   mapping_module* mapper_ = nullptr;
 
+  //! map database
+  data::map_database* map_db_ = nullptr;
+
   //! loop detector
   std::unique_ptr<module::loop_detector> loop_detector_ = nullptr;
   //! loop bundle adjuster
@@ -232,11 +239,20 @@ class global_optimization_module {
   //! graph optimizer
   std::unique_ptr<optimize::graph_optimizer> graph_optimizer_ = nullptr;
 
+  //! scheduler of the optimization jobs
+  optimize::job_scheduler* scheduler_ = nullptr;
+
   //-----------------------------------------
   // variables for loop BA
 
-  //! thread for running loop BA
-  std::unique_ptr<std::thread> thread_for_loop_BA_ = nullptr;
+  //! Block until the latest loop BA finishes or is cancelled
+  void wait_for_loop_BA() const;
+
+  //! mutex for access to the job of loop BA
+  mutable std::mutex mtx_loop_BA_;
+
+  //! job of the latest loop BA
+  optimize::job_scheduler::job_handle loop_BA_job_;
 };
 
 }  // namespace openvslam
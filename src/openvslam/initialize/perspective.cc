@@ -2,8 +2,6 @@
 
 #include <spdlog/spdlog.h>
 
-#include <thread>
-
 #include "openvslam/camera/fisheye.h"
 #include "openvslam/camera/radial_division.h"
 #include "openvslam/data/frame.h"
@@ -59,12 +57,26 @@ bool perspective::initialize(const data::frame& cur_frm,
   auto fundamental_solver =
       solve::fundamental_solver(ref_undist_keypts_, cur_undist_keypts_,
                                 ref_cur_matches_, sigma, use_fixed_seed_);
-  std::thread thread_for_H(&solve::homography_solver::find_via_ransac,
-                           &homography_solver, num_ransac_iters_, true);
-  std::thread thread_for_F(&solve::fundamental_solver::find_via_ransac,
-                           &fundamental_solver, num_ransac_iters_, true);
-  thread_for_H.join();
-  thread_for_F.join();
+  // (the hypotheses of each solver are evaluated on the two threads, which
+  // keeps the parallelism of solving H and F concurrently)
+  constexpr unsigned int num_threads = 2;
+  homography_solver.find_via_ransac(num_ransac_iters_, true,
+                                    ransac_confidence_, num_threads);
+  fundamental_solver.find_via_ransac(num_ransac_iters_, true,
+                                     ransac_confidence_, num_threads);
+
+  // the best score grows with the number of the hypotheses, so the solver
+  // which has been terminated earlier is run again without the adaptive
+  // termination up to the same number of iterations as the other one
+  // (otherwise the selection below is biased toward the model which needs
+  // more iterations)
+  const auto num_iters_H = homography_solver.get_num_iterations();
+  const auto num_iters_F = fundamental_solver.get_num_iterations();
+  if (num_iters_H < num_iters_F) {
+    homography_solver.find_via_ransac(num_iters_F, true, 1.0, num_threads);
+  } else if (num_iters_F < num_iters_H) {
+    fundamental_solver.find_via_ransac(num_iters_H, true, 1.0, num_threads);
+  }
 
   // compute a score
   const auto score_H = homography_solver.get_best_score();
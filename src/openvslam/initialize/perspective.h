@@ -54,6 +54,9 @@ class perspective final : public base {
 
   //! Use fixed random seed for RANSAC if true
   const bool use_fixed_seed_;
+
+  //! confidence with which the RANSAC of H and F is terminated adaptively
+  static constexpr double ransac_confidence_ = 0.99;
 };
 
 }  // namespace initialize
@@ -0,0 +1,165 @@
+#include "openvslam/io/feature_stream.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "openvslam/data/frame_observation.h"
+
+namespace {
+
+constexpr char magic[4] = {'O', 'V', 'F', 'S'};
+constexpr uint32_t version = 1;
+
+//! size of a serialized keypoint
+constexpr size_t keypt_size = 5 * sizeof(float) + sizeof(int32_t);
+
+template <typename T>
+void put(char*& ptr, const T val) {
+  std::memcpy(ptr, &val, sizeof(T));
+  ptr += sizeof(T);
+}
+
+template <typename T>
+T get(const char*& ptr) {
+  T val;
+  std::memcpy(&val, ptr, sizeof(T));
+  ptr += sizeof(T);
+  return val;
+}
+
+}  // namespace
+
+namespace openvslam {
+namespace io {
+
+feature_stream_writer::feature_stream_writer(const std::string& path)
+    : ofs_(path, std::ios::out | std::ios::binary | std::ios::trunc) {
+  if (!ofs_.is_open()) {
+    spdlog::critical("cannot create a file at {}", path);
+    throw std::runtime_error("cannot create a file at " + path);
+  }
+  spdlog::info("record the feature stream to {}", path);
+  ofs_.write(magic, sizeof(magic));
+  ofs_.write(reinterpret_cast<const char*>(&version), sizeof(version));
+}
+
+feature_stream_writer::~feature_stream_writer() {
+  ofs_.flush();
+  spdlog::info("recorded {} frames to the feature stream", num_frames_);
+}
+
+void feature_stream_writer::write(const double timestamp,
+                                  const data::frame_observation& frm_obs) {
+  const uint32_t num_keypts = frm_obs.num_keypts_;
+  const uint32_t desc_length =
+      frm_obs.descriptors_.empty()
+          ? 0
+          : frm_obs.descriptors_.cols * frm_obs.descriptors_.elemSize();
+  assert(frm_obs.keypts_.size() == num_keypts);
+  assert(frm_obs.stereo_x_right_.size() == num_keypts);
+  assert(frm_obs.depths_.size() == num_keypts);
+
+  buffer_.resize(sizeof(double) + 2 * sizeof(uint32_t) +
+                 num_keypts * (keypt_size + desc_length + 2 * sizeof(float)));
+  char* ptr = buffer_.data();
+
+  put(ptr, timestamp);
+  put(ptr, num_keypts);
+  put(ptr, desc_length);
+  for (const auto& keypt : frm_obs.keypts_) {
+    put(ptr, keypt.pt.x);
+    put(ptr, keypt.pt.y);
+    put(ptr, keypt.size);
+    put(ptr, keypt.angle);
+    put(ptr, keypt.response);
+    put(ptr, static_cast<int32_t>(keypt.octave));
+  }
+  for (unsigned int idx = 0; idx < num_keypts; ++idx) {
+    std::memcpy(ptr, frm_obs.descriptors_.ptr(idx), desc_length);
+    ptr += desc_length;
+  }
+  std::memcpy(ptr, frm_obs.stereo_x_right_.data(), num_keypts * sizeof(float));
+  ptr += num_keypts * sizeof(float);
+  std::memcpy(ptr, frm_obs.depths_.data(), num_keypts * sizeof(float));
+
+  ofs_.write(buffer_.data(), buffer_.size());
+  ++num_frames_;
+}
+
+feature_stream_reader::feature_stream_reader(const std::string& path)
+    : ifs_(path, std::ios::in | std::ios::binary) {
+  if (!ifs_.is_open()) {
+    spdlog::critical("cannot load the file at {}", path);
+    throw std::runtime_error("cannot load the file at " + path);
+  }
+
+  char file_magic[sizeof(magic)];
+  uint32_t file_version = 0;
+  ifs_.read(file_magic, sizeof(file_magic));
+  ifs_.read(reinterpret_cast<char*>(&file_version), sizeof(file_version));
+  if (!ifs_ || std::memcmp(file_magic, magic, sizeof(magic)) != 0) {
+    throw std::runtime_error("not a feature stream: " + path);
+  }
+  if (file_version != version) {
+    throw std::runtime_error("unsupported version of the feature stream: " +
+                             std::to_string(file_version));
+  }
+  spdlog::info("replay the feature stream from {}", path);
+}
+
+bool feature_stream_reader::read(double& timestamp,
+                                 data::frame_observation& frm_obs) {
+  // read the fixed-length part of the record
+  constexpr size_t header_size = sizeof(double) + 2 * sizeof(uint32_t);
+  char header[header_size];
+  ifs_.read(header, header_size);
+  if (ifs_.gcount() == 0 && ifs_.eof()) {
+    return false;
+  }
+  if (!ifs_) {
+    throw std::runtime_error("the feature stream is truncated");
+  }
+  const char* ptr = header;
+  timestamp = get<double>(ptr);
+  const auto num_keypts = get<uint32_t>(ptr);
+  const auto desc_length = get<uint32_t>(ptr);
+
+  // read the variable-length part of the record
+  buffer_.resize(num_keypts * (keypt_size + desc_length + 2 * sizeof(float)));
+  ifs_.read(buffer_.data(), buffer_.size());
+  if (!ifs_) {
+    throw std::runtime_error("the feature stream is truncated");
+  }
+  ptr = buffer_.data();
+
+  frm_obs = data::frame_observation();
+  frm_obs.num_keypts_ = num_keypts;
+  frm_obs.keypts_.resize(num_keypts);
+  for (auto& keypt : frm_obs.keypts_) {
+    keypt.pt.x = get<float>(ptr);
+    keypt.pt.y = get<float>(ptr);
+    keypt.size = get<float>(ptr);
+    keypt.angle = get<float>(ptr);
+    keypt.response = get<float>(ptr);
+    keypt.octave = get<int32_t>(ptr);
+  }
+  frm_obs.descriptors_ = cv::Mat(num_keypts, desc_length, CV_8U);
+  for (unsigned int idx = 0; idx < num_keypts; ++idx) {
+    std::memcpy(frm_obs.descriptors_.ptr(idx), ptr, desc_length);
+    ptr += desc_length;
+  }
+  frm_obs.stereo_x_right_.resize(num_keypts);
+  std::memcpy(frm_obs.stereo_x_right_.data(), ptr, num_keypts * sizeof(float));
+  ptr += num_keypts * sizeof(float);
+  frm_obs.depths_.resize(num_keypts);
+  std::memcpy(frm_obs.depths_.data(), ptr, num_keypts * sizeof(float));
+
+  return true;
+}
+
+}  // namespace io
+}  // namespace openvslam
@@ -0,0 +1,93 @@
+#ifndef OPENVSLAM_IO_FEATURE_STREAM_H
+#define OPENVSLAM_IO_FEATURE_STREAM_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace openvslam {
+
+namespace data {
+struct frame_observation;
+}  // namespace data
+
+namespace io {
+
+/**
+ * Writer of the feature stream, which is a binary file of the per-frame
+ * extraction results (timestamp, keypoints, descriptors, x_right and depths)
+ *
+ * The layout is a header (magic "OVFS", version) followed by the records:
+ *   double timestamp, uint32 num_keypts, uint32 descriptor length,
+ *   num_keypts x {float x, y, size, angle, response, int32 octave},
+ *   num_keypts x descriptor length bytes of the descriptors,
+ *   num_keypts x float x_right, num_keypts x float depth
+ * (all the values are stored in the native byte order)
+ */
+class feature_stream_writer {
+ public:
+  /**
+   * Constructor (the file is truncated)
+   */
+  explicit feature_stream_writer(const std::string& path);
+
+  /**
+   * Destructor
+   */
+  ~feature_stream_writer();
+
+  /**
+   * Append the observation of a frame to the stream
+   */
+  void write(const double timestamp, const data::frame_observation& frm_obs);
+
+  /**
+   * Get the number of the written frames
+   */
+  unsigned int get_num_frames() const { return num_frames_; }
+
+ private:
+  //! output stream
+  std::ofstream ofs_;
+  //! number of the written frames
+  unsigned int num_frames_ = 0;
+  //! buffer which is recycled to serialize a record
+  std::vector<char> buffer_;
+};
+
+/**
+ * Reader of the feature stream written by feature_stream_writer
+ */
+class feature_stream_reader {
+ public:
+  /**
+   * Constructor
+   */
+  explicit feature_stream_reader(const std::string& path);
+
+  /**
+   * Destructor
+   */
+  ~feature_stream_reader() = default;
+
+  /**
+   * Read the next record
+   * (only the extraction results are filled in the observation, so the
+   * undistorted keypoints, the bearings and the grid have to be computed)
+   * @param timestamp
+   * @param frm_obs
+   * @return false if the stream reaches the end
+   */
+  bool read(double& timestamp, data::frame_observation& frm_obs);
+
+ private:
+  //! input stream
+  std::ifstream ifs_;
+  //! buffer which is recycled to deserialize a record
+  std::vector<char> buffer_;
+};
+
+}  // namespace io
+}  // namespace openvslam
+
+#endif  // OPENVSLAM_IO_FEATURE_STREAM_H
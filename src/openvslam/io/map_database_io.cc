@@ -20,32 +20,35 @@ map_database_io::map_database_io(data::camera_database* cam_db,
                                  data::orb_params_database* orb_params_db,
                                  data::map_database* map_db,
                                  data::bow_database* bow_db,
-                                 data::bow_vocabulary* bow_vocab)
+                                 data::bow_vocabulary* bow_vocab,
+                                 const bool store_bow)
     : cam_db_(cam_db),
       orb_params_db_(orb_params_db),
       map_db_(map_db),
       bow_db_(bow_db),
-      bow_vocab_(bow_vocab) {}
+      bow_vocab_(bow_vocab),
+      store_bow_(store_bow) {}
 
 void map_database_io::save_message_pack(const std::string& path) {
-  std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+  std::lock_guard<std::mutex> lock(map_db_->mtx_database_);
 
   assert(cam_db_ && orb_params_db_ && map_db_);
   const auto cameras = cam_db_->to_json();
   const auto orb_params = orb_params_db_->to_json();
   nlohmann::json keyfrms;
   nlohmann::json landmarks;
-  map_db_->to_json(keyfrms, landmarks);
+  map_db_->to_json(keyfrms, landmarks, store_bow_);
 
   nlohmann::json json{
       {"cameras", cameras},
       {"orb_params", orb_params},
       {"keyframes", keyfrms},
       {"landmarks", landmarks},
-      {"frame_next_id", static_cast<unsigned int>(data::frame::next_id_)},
-      {"keyframe_next_id", static_cast<unsigned int>(data::keyframe::next_id_)},
+      {"frame_next_id", static_cast<unsigned int>(map_db_->next_frame_id_)},
+      {"keyframe_next_id",
+       static_cast<unsigned int>(map_db_->next_keyframe_id_)},
       {"landmark_next_id",
-       static_cast<unsigned int>(data::landmark::next_id_)}};
+       static_cast<unsigned int>(map_db_->next_landmark_id_)}};
 
   std::ofstream ofs(path, std::ios::out | std::ios::binary);
 
@@ -60,8 +63,10 @@ void map_database_io::save_message_pack(const std::string& path) {
   }
 }
 
-void map_database_io::load_message_pack(const std::string& path) {
-  std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+void map_database_io::load_message_pack(
+    const std::string& path,
+    const std::function<void()>& wait_for_bow_vocab) {
+  std::lock_guard<std::mutex> lock(map_db_->mtx_database_);
 
   // 1. initialize database
 
@@ -95,10 +100,10 @@ void map_database_io::load_message_pack(const std::string& path) {
 
   // 4. load database
 
-  // load static variables
-  data::frame::next_id_ = json.at("frame_next_id").get<unsigned int>();
-  data::keyframe::next_id_ = json.at("keyframe_next_id").get<unsigned int>();
-  data::landmark::next_id_ = json.at("landmark_next_id").get<unsigned int>();
+  // load the ID counters
+  map_db_->next_frame_id_ = json.at("frame_next_id").get<unsigned int>();
+  map_db_->next_keyframe_id_ = json.at("keyframe_next_id").get<unsigned int>();
+  map_db_->next_landmark_id_ = json.at("landmark_next_id").get<unsigned int>();
   // load database
   const auto json_cameras = json.at("cameras");
   cam_db_->from_json(json_cameras);
@@ -107,7 +112,7 @@ void map_database_io::load_message_pack(const std::string& path) {
   const auto json_keyfrms = json.at("keyframes");
   const auto json_landmarks = json.at("landmarks");
   map_db_->from_json(cam_db_, orb_params_db_, bow_vocab_, json_keyfrms,
-                     json_landmarks);
+                     json_landmarks, wait_for_bow_vocab);
   const auto keyfrms = map_db_->get_all_keyframes();
   for (const auto& keyfrm : keyfrms) {
     bow_db_->add_keyframe(keyfrm);
@@ -1,6 +1,7 @@
 #ifndef OPENVSLAM_IO_MAP_DATABASE_IO_H
 #define OPENVSLAM_IO_MAP_DATABASE_IO_H
 
+#include <functional>
 #include <string>
 
 #include "openvslam/data/bow_vocabulary.h"
@@ -24,7 +25,8 @@ class map_database_io {
   map_database_io(data::camera_database* cam_db,
                   data::orb_params_database* orb_params_db,
                   data::map_database* map_db, data::bow_database* bow_db,
-                  data::bow_vocabulary* bow_vocab);
+                  data::bow_vocabulary* bow_vocab,
+                  const bool store_bow = true);
 
   /**
    * Destructor
@@ -38,8 +40,13 @@ class map_database_io {
 
   /**
    * Load the map database from MessagePack
+   * @param path
+   * @param wait_for_bow_vocab called before the vocabulary is used first, so
+   * that the vocabulary can be loaded while the file is decoded
    */
-  void load_message_pack(const std::string& path);
+  void load_message_pack(
+      const std::string& path,
+      const std::function<void()>& wait_for_bow_vocab = nullptr);
 
  private:
   //! camera database
@@ -52,6 +59,9 @@ class map_database_io {
   data::bow_database* const bow_db_ = nullptr;
   //! BoW vocabulary
   data::bow_vocabulary* const bow_vocab_ = nullptr;
+  //! if true, the BoW representations of the keyframes are saved
+  //! (loading gets faster, but the file gets larger)
+  const bool store_bow_ = true;
 };
 
 }  // namespace io
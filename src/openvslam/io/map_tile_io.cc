@@ -0,0 +1,247 @@
+#include "openvslam/io/map_tile_io.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <set>
+
+#include "openvslam/data/bow_database.h"
+#include "openvslam/data/camera_database.h"
+#include "openvslam/data/frame.h"
+#include "openvslam/data/keyframe.h"
+#include "openvslam/data/landmark.h"
+#include "openvslam/data/map_database.h"
+#include "openvslam/data/orb_params_database.h"
+
+namespace {
+using namespace openvslam;
+
+void write_message_pack(const std::string& path, const nlohmann::json& json) {
+  std::ofstream ofs(path, std::ios::out | std::ios::binary);
+  if (!ofs.is_open()) {
+    spdlog::critical("cannot create a file at {}", path);
+    throw std::runtime_error("cannot create a file at " + path);
+  }
+  const auto msgpack = nlohmann::json::to_msgpack(json);
+  ofs.write(reinterpret_cast<const char*>(msgpack.data()),
+            msgpack.size() * sizeof(uint8_t));
+}
+
+nlohmann::json read_message_pack(const std::string& path) {
+  std::ifstream ifs(path, std::ios::in | std::ios::binary);
+  if (!ifs.is_open()) {
+    spdlog::critical("cannot load the file at {}", path);
+    throw std::runtime_error("cannot load the file at " + path);
+  }
+  const std::vector<uint8_t> msgpack((std::istreambuf_iterator<char>(ifs)),
+                                     std::istreambuf_iterator<char>());
+  return nlohmann::json::from_msgpack(msgpack);
+}
+
+}  // unnamed namespace
+
+namespace openvslam {
+namespace io {
+
+map_tile_key map_tile_index::get_key(const Vec3_t& pos_w) const {
+  assert(0.0 < tile_size_);
+  map_tile_key key;
+  key.x_ = static_cast<int>(std::floor(pos_w(0) / tile_size_));
+  key.y_ = static_cast<int>(std::floor(pos_w(1) / tile_size_));
+  key.z_ = static_cast<int>(std::floor(pos_w(2) / tile_size_));
+  return key;
+}
+
+std::string map_tile_index::get_tile_path(const map_tile_key& key) const {
+  return dir_ + "/tile_" + std::to_string(key.x_) + "_" +
+         std::to_string(key.y_) + "_" + std::to_string(key.z_) + ".msgpack";
+}
+
+map_tile_io::map_tile_io(data::camera_database* cam_db,
+                         data::orb_params_database* orb_params_db,
+                         data::map_database* map_db,
+                         data::bow_database* bow_db,
+                         data::bow_vocabulary* bow_vocab,
+                         const bool store_bow)
+    : cam_db_(cam_db),
+      orb_params_db_(orb_params_db),
+      map_db_(map_db),
+      bow_db_(bow_db),
+      bow_vocab_(bow_vocab),
+      store_bow_(store_bow) {}
+
+void map_tile_io::save_tiles(const std::string& dir, const double tile_size) {
+  std::lock_guard<std::mutex> lock(map_db_->mtx_database_);
+
+  assert(cam_db_ && orb_params_db_ && map_db_);
+  if (tile_size <= 0.0) {
+    spdlog::critical("tile size must be positive");
+    throw std::runtime_error("tile size must be positive");
+  }
+
+  map_tile_index index;
+  index.dir_ = dir;
+  index.tile_size_ = tile_size;
+
+  // 1. assign the keyframes to the tiles
+
+  std::map<unsigned int, std::shared_ptr<data::keyframe>> keyfrms;
+  for (const auto& keyfrm : map_db_->get_all_keyframes()) {
+    if (keyfrm && !keyfrm->will_be_erased()) {
+      keyfrms[keyfrm->id_] = keyfrm;
+    }
+  }
+  for (const auto& id_keyfrm : keyfrms) {
+    const auto key = index.get_key(id_keyfrm.second->get_cam_center());
+    index.keyfrm_ids_in_tiles_[key].push_back(id_keyfrm.first);
+  }
+
+  spdlog::info("save {} keyframes into {} tiles of {} m to {}", keyfrms.size(),
+               index.keyfrm_ids_in_tiles_.size(), tile_size, dir);
+
+  // 2. save the tiles
+
+  nlohmann::json json_tiles = nlohmann::json::array();
+  std::map<unsigned int, std::set<unsigned int>> tile_indices_in_words;
+  for (const auto& key_keyfrm_ids : index.keyfrm_ids_in_tiles_) {
+    const auto& key = key_keyfrm_ids.first;
+    const auto& keyfrm_ids = key_keyfrm_ids.second;
+    const std::set<unsigned int> keyfrm_id_set(keyfrm_ids.begin(),
+                                               keyfrm_ids.end());
+    const unsigned int tile_idx = json_tiles.size();
+
+    std::map<std::string, nlohmann::json> json_keyfrms;
+    std::map<unsigned int, std::shared_ptr<data::landmark>> lms;
+    for (const auto keyfrm_id : keyfrm_ids) {
+      const auto& keyfrm = keyfrms.at(keyfrm_id);
+      json_keyfrms[std::to_string(keyfrm_id)] = keyfrm->to_json(store_bow_);
+      for (const auto& lm : keyfrm->get_landmarks()) {
+        if (lm && !lm->will_be_erased()) {
+          lms[lm->id_] = lm;
+        }
+      }
+      for (const auto& word_weight : keyfrm->bow_vec_) {
+        tile_indices_in_words[word_weight.first].insert(tile_idx);
+      }
+    }
+
+    // the landmarks observed from the other tiles are duplicated in each of the
+    // tiles, and their reference keyframes are replaced with the keyframes in
+    // this tile so that the tile can be loaded alone
+    std::map<std::string, nlohmann::json> json_landmarks;
+    for (const auto& id_lm : lms) {
+      const auto& lm = id_lm.second;
+      auto json_landmark = lm->to_json();
+      const auto ref_keyfrm = lm->get_ref_keyframe();
+      if (!ref_keyfrm || !keyfrm_id_set.count(ref_keyfrm->id_)) {
+        unsigned int new_ref_keyfrm_id = *keyfrm_id_set.rbegin();
+        for (const auto& obs : lm->get_observations()) {
+          const auto keyfrm = obs.first.lock();
+          if (keyfrm && keyfrm_id_set.count(keyfrm->id_)) {
+            new_ref_keyfrm_id = std::min(new_ref_keyfrm_id, keyfrm->id_);
+          }
+        }
+        json_landmark["ref_keyfrm"] = new_ref_keyfrm_id;
+      }
+      json_landmarks[std::to_string(id_lm.first)] = json_landmark;
+    }
+
+    const nlohmann::json json_tile{{"keyframes", json_keyfrms},
+                                   {"landmarks", json_landmarks}};
+    write_message_pack(index.get_tile_path(key), json_tile);
+
+    json_tiles.push_back({{"key", {key.x_, key.y_, key.z_}},
+                          {"keyfrm_ids", keyfrm_ids}});
+  }
+
+  // 3. save the index
+
+  std::map<std::string, std::vector<unsigned int>> json_words;
+  for (const auto& word_tile_indices : tile_indices_in_words) {
+    json_words[std::to_string(word_tile_indices.first)] =
+        std::vector<unsigned int>(word_tile_indices.second.begin(),
+                                  word_tile_indices.second.end());
+  }
+
+  const nlohmann::json json_index{
+      {"cameras", cam_db_->to_json()},
+      {"orb_params", orb_params_db_->to_json()},
+      {"tile_size", tile_size},
+      {"tiles", json_tiles},
+      {"words", json_words},
+      {"frame_next_id", static_cast<unsigned int>(map_db_->next_frame_id_)},
+      {"keyframe_next_id",
+       static_cast<unsigned int>(map_db_->next_keyframe_id_)},
+      {"landmark_next_id",
+       static_cast<unsigned int>(map_db_->next_landmark_id_)}};
+  write_message_pack(dir + "/index.msgpack", json_index);
+}
+
+map_tile_index map_tile_io::load_index(const std::string& dir) {
+  std::lock_guard<std::mutex> lock(map_db_->mtx_database_);
+
+  // 1. initialize database
+
+  assert(cam_db_ && orb_params_db_ && map_db_ && bow_db_);
+  map_db_->clear();
+  bow_db_->clear();
+
+  // 2. load the index
+
+  spdlog::info("load the index of the tiled map database from {}", dir);
+  const auto json = read_message_pack(dir + "/index.msgpack");
+
+  // load the ID counters
+  map_db_->next_frame_id_ = json.at("frame_next_id").get<unsigned int>();
+  map_db_->next_keyframe_id_ = json.at("keyframe_next_id").get<unsigned int>();
+  map_db_->next_landmark_id_ = json.at("landmark_next_id").get<unsigned int>();
+  // load database
+  const auto json_cameras = json.at("cameras");
+  cam_db_->from_json(json_cameras);
+  const auto json_orb_params = json.at("orb_params");
+  orb_params_db_->from_json(json_orb_params);
+
+  // 3. decode the tiles and the word index
+
+  map_tile_index index;
+  index.dir_ = dir;
+  index.tile_size_ = json.at("tile_size").get<double>();
+
+  std::vector<map_tile_key> keys;
+  for (const auto& json_tile : json.at("tiles")) {
+    const auto xyz = json_tile.at("key").get<std::vector<int>>();
+    assert(xyz.size() == 3);
+    map_tile_key key;
+    key.x_ = xyz.at(0);
+    key.y_ = xyz.at(1);
+    key.z_ = xyz.at(2);
+    index.keyfrm_ids_in_tiles_[key] =
+        json_tile.at("keyfrm_ids").get<std::vector<unsigned int>>();
+    keys.push_back(key);
+  }
+
+  for (const auto& json_word_tiles : json.at("words").items()) {
+    const auto word_id = std::stoul(json_word_tiles.key());
+    auto& keys_in_word = index.tiles_in_words_[word_id];
+    for (const auto tile_idx :
+         json_word_tiles.value().get<std::vector<unsigned int>>()) {
+      keys_in_word.push_back(keys.at(tile_idx));
+    }
+  }
+
+  spdlog::info("the tiled map database has {} tiles of {} m", keys.size(),
+               index.tile_size_);
+  return index;
+}
+
+nlohmann::json map_tile_io::load_tile(const std::string& path) {
+  spdlog::debug("load the map tile from {}", path);
+  return read_message_pack(path);
+}
+
+}  // namespace io
+}  // namespace openvslam
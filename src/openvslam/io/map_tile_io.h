@@ -0,0 +1,128 @@
+#ifndef OPENVSLAM_IO_MAP_TILE_IO_H
+#define OPENVSLAM_IO_MAP_TILE_IO_H
+
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "openvslam/data/bow_vocabulary.h"
+#include "openvslam/data/orb_params_database.h"
+#include "openvslam/type.h"
+
+namespace openvslam {
+
+namespace data {
+class camera_database;
+class map_database;
+class bow_database;
+}  // namespace data
+
+namespace io {
+
+/**
+ * Key of a map tile (indices of the cubic cell which contains the camera
+ * centers of the keyframes)
+ */
+struct map_tile_key {
+  int x_ = 0, y_ = 0, z_ = 0;
+
+  bool operator==(const map_tile_key& key) const {
+    return x_ == key.x_ && y_ == key.y_ && z_ == key.z_;
+  }
+};
+
+struct map_tile_key_hash {
+  std::size_t operator()(const map_tile_key& key) const {
+    // large primes of "Optimized Spatial Hashing for Collision Detection of
+    // Deformable Objects"
+    return (static_cast<std::size_t>(key.x_) * 73856093) ^
+           (static_cast<std::size_t>(key.y_) * 19349663) ^
+           (static_cast<std::size_t>(key.z_) * 83492791);
+  }
+};
+
+/**
+ * Index of the tiled map database
+ */
+struct map_tile_index {
+  /**
+   * Get the key of the tile which contains the position
+   */
+  map_tile_key get_key(const Vec3_t& pos_w) const;
+
+  /**
+   * Get the path of the tile file
+   */
+  std::string get_tile_path(const map_tile_key& key) const;
+
+  //! directory of the tiled map database
+  std::string dir_;
+  //! edge length of the tiles [m]
+  double tile_size_ = 0.0;
+  //! keyframe IDs in each of the tiles
+  std::unordered_map<map_tile_key, std::vector<unsigned int>, map_tile_key_hash>
+      keyfrm_ids_in_tiles_;
+  //! keys of the tiles which contain the visual word
+  std::unordered_map<unsigned int, std::vector<map_tile_key>> tiles_in_words_;
+};
+
+/**
+ * I/O of the map database which is split into the spatial tiles
+ * (each tile file contains the keyframes in the tile and all of the landmarks
+ * observed by them, so that any subset of the tiles can be loaded)
+ */
+class map_tile_io {
+ public:
+  /**
+   * Constructor
+   */
+  map_tile_io(data::camera_database* cam_db,
+              data::orb_params_database* orb_params_db,
+              data::map_database* map_db, data::bow_database* bow_db,
+              data::bow_vocabulary* bow_vocab,
+              const bool store_bow = true);
+
+  /**
+   * Destructor
+   */
+  ~map_tile_io() = default;
+
+  /**
+   * Save the map database into the existing directory as the index file and
+   * the tile files
+   */
+  void save_tiles(const std::string& dir, const double tile_size);
+
+  /**
+   * Clear the databases and load the index file, the cameras and the ORB
+   * parameters (the keyframes and the landmarks are loaded by module::map_pager)
+   */
+  map_tile_index load_index(const std::string& dir);
+
+  /**
+   * Load the tile file
+   * (the map database is not modified)
+   */
+  static nlohmann::json load_tile(const std::string& path);
+
+ private:
+  //! camera database
+  data::camera_database* const cam_db_ = nullptr;
+  //! orb_params database
+  data::orb_params_database* const orb_params_db_ = nullptr;
+  //! map_database
+  data::map_database* const map_db_ = nullptr;
+  //! BoW database
+  data::bow_database* const bow_db_ = nullptr;
+  //! BoW vocabulary
+  data::bow_vocabulary* const bow_vocab_ = nullptr;
+  //! if true, the BoW representations of the keyframes are saved
+  //! (loading gets faster, but the file gets larger)
+  const bool store_bow_ = true;
+};
+
+}  // namespace io
+}  // namespace openvslam
+
+#endif  // OPENVSLAM_IO_MAP_TILE_IO_H
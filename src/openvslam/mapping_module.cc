@@ -59,6 +59,10 @@ void mapping_module::set_global_optimization_module(
   global_optimizer_ = global_optimizer;
 }
 
+void mapping_module::set_job_scheduler(optimize::job_scheduler* scheduler) {
+  scheduler_ = scheduler;
+}
+
 void mapping_module::run() {
   spdlog::info("start mapping module");
 
@@ -125,7 +129,7 @@ void mapping_module::queue_keyframe(
     const std::shared_ptr<data::keyframe>& keyfrm) {
   std::lock_guard<std::mutex> lock(mtx_keyfrm_queue_);
   keyfrms_queue_.push_back(keyfrm);
-  abort_local_BA_ = true;
+  local_BA_job_.cancel();
 }
 
 unsigned int mapping_module::get_num_queued_keyframes() const {
@@ -147,7 +151,10 @@ bool mapping_module::is_skipping_localBA() const {
   return queued_keyframes >= queue_threshold_;
 }
 
-void mapping_module::abort_local_BA() { abort_local_BA_ = true; }
+void mapping_module::abort_local_BA() {
+  std::lock_guard<std::mutex> lock(mtx_keyfrm_queue_);
+  local_BA_job_.cancel();
+}
 
 void mapping_module::mapping_with_new_keyframe() {
   // dequeue
@@ -185,13 +192,23 @@ void mapping_module::mapping_with_new_keyframe() {
   }
 
   // local bundle adjustment
-  abort_local_BA_ = false;
   // If the processing speed is insufficient, skip localBA.
   if (2 < map_db_->get_num_keyframes()) {
     if (is_skipping_localBA()) {
       spdlog::debug("Skipped localBA due to insufficient performance");
     } else {
-      local_bundle_adjuster_->optimize(map_db_, cur_keyfrm_, &abort_local_BA_);
+      optimize::job_scheduler::job_handle local_BA_job;
+      {
+        std::lock_guard<std::mutex> lock(mtx_keyfrm_queue_);
+        local_BA_job_ = scheduler_->submit(
+            "local BA", optimize::job_priority_t::High,
+            [this](const optimize::cancellation_token& token) {
+              local_bundle_adjuster_->optimize(map_db_, cur_keyfrm_,
+                                               token.get_force_stop_flag());
+            });
+        local_BA_job = local_BA_job_;
+      }
+      local_BA_job.wait();
     }
   }
   local_map_cleaner_->remove_redundant_keyframes(cur_keyfrm_);
@@ -418,15 +435,32 @@ void mapping_module::fuse_landmark_duplication(
         fuse_tgt_keyfrms) {
   match::fuse matcher;
 
+  // The matches are detected in parallel without modifying the map, then
+  // applied in the same order as the targets are iterated. The landmarks
+  // modified while applying are matched again at their turns, so that the
+  // resulting map is the same as fusing the targets one by one.
+
   {
     // reproject the landmarks observed in the current keyframe to each of the
     // targets, and acquire
     // - additional matches
     // - duplication of matches
     // then, add matches and solve duplication
-    auto cur_landmarks = cur_keyfrm_->get_landmarks();
-    for (const auto& fuse_tgt_keyfrm : fuse_tgt_keyfrms) {
-      matcher.replace_duplication(fuse_tgt_keyfrm, cur_landmarks);
+    const auto cur_landmarks = cur_keyfrm_->get_landmarks();
+    const std::vector<std::shared_ptr<data::keyframe>> tgt_keyfrms(
+        fuse_tgt_keyfrms.begin(), fuse_tgt_keyfrms.end());
+    std::vector<match::fusion_proposal> proposals(tgt_keyfrms.size());
+
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (unsigned int i = 0; i < tgt_keyfrms.size(); ++i) {
+      proposals.at(i) = matcher.detect_fusion(tgt_keyfrms.at(i), cur_landmarks);
+    }
+
+    std::unordered_set<std::shared_ptr<data::landmark>> modified_lms;
+    for (const auto& proposal : proposals) {
+      matcher.apply_fusion(proposal, modified_lms);
     }
   }
 
@@ -459,7 +493,11 @@ void mapping_module::fuse_landmark_duplication(
       }
     }
 
-    matcher.replace_duplication(cur_keyfrm_, candidate_landmarks_to_fuse);
+    // the matches are detected in parallel for the chunks of the candidates
+    const std::vector<std::shared_ptr<data::landmark>> candidates(
+        candidate_landmarks_to_fuse.begin(), candidate_landmarks_to_fuse.end());
+    matcher.replace_duplication_in_chunks(cur_keyfrm_, candidates,
+                                          fusion_chunk_size_);
   }
 }
 
@@ -491,7 +529,7 @@ std::future<void> mapping_module::async_pause() {
   std::lock_guard<std::mutex> lock1(mtx_pause_);
   pause_is_requested_ = true;
   std::lock_guard<std::mutex> lock2(mtx_keyfrm_queue_);
-  abort_local_BA_ = true;
+  local_BA_job_.cancel();
   promises_pause_.emplace_back();
   return promises_pause_.back().get_future();
 }
@@ -12,6 +12,7 @@
 #include "openvslam/config.h"
 #include "openvslam/data/bow_vocabulary_fwd.h"
 #include "openvslam/module/local_map_cleaner.h"
+#include "openvslam/optimize/job_scheduler.h"
 #include "openvslam/optimize/local_bundle_adjuster.h"
 
 namespace openvslam {
@@ -46,6 +47,9 @@ class mapping_module {
   void set_global_optimization_module(
       global_optimization_module* global_optimizer);
 
+  //! Set the scheduler of the optimization jobs
+  void set_job_scheduler(optimize::job_scheduler* scheduler);
+
   //-----------------------------------------
   // main process
 
@@ -245,8 +249,11 @@ class mapping_module {
   std::unique_ptr<optimize::local_bundle_adjuster> local_bundle_adjuster_ =
       nullptr;
 
-  //! bridge flag to abort local BA
-  bool abort_local_BA_ = false;
+  //! scheduler of the optimization jobs
+  optimize::job_scheduler* scheduler_ = nullptr;
+
+  //! job of the running local BA (guarded by mtx_keyfrm_queue_)
+  optimize::job_scheduler::job_handle local_BA_job_;
 
   //-----------------------------------------
   // others
@@ -274,6 +281,10 @@ class mapping_module {
 
   //! If the size of the queue exceeds this threshold, skip the localBA
   const unsigned int queue_threshold_ = 2;
+
+  //! Number of the landmarks in each of the chunks whose fusion matches are
+  //! detected in parallel (the fusion result does not depend on it)
+  const unsigned int fusion_chunk_size_ = 256;
 };
 
 }  // namespace openvslam
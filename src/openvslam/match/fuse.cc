@@ -1,5 +1,7 @@
 #include "openvslam/match/fuse.h"
 
+#include <algorithm>
+#include <cassert>
 #include <unordered_set>
 #include <vector>
 
@@ -136,16 +138,84 @@ unsigned int fuse::detect_duplication(
   return num_fused;
 }
 
+void fusion_proposal::append(const fusion_proposal& proposal) {
+  assert(!keyfrm_ || keyfrm_ == proposal.keyfrm_);
+  keyfrm_ = proposal.keyfrm_;
+  lms_.insert(lms_.end(), proposal.lms_.begin(), proposal.lms_.end());
+  pos_ws_.insert(pos_ws_.end(), proposal.pos_ws_.begin(),
+                 proposal.pos_ws_.end());
+  reprojs_.insert(reprojs_.end(), proposal.reprojs_.begin(),
+                  proposal.reprojs_.end());
+  x_rights_.insert(x_rights_.end(), proposal.x_rights_.begin(),
+                   proposal.x_rights_.end());
+  in_image_.insert(in_image_.end(), proposal.in_image_.begin(),
+                   proposal.in_image_.end());
+  matched_idxs_.insert(matched_idxs_.end(), proposal.matched_idxs_.begin(),
+                       proposal.matched_idxs_.end());
+}
+
 template <typename T>
 unsigned int fuse::replace_duplication(
     const std::shared_ptr<data::keyframe>& keyfrm, const T& landmarks_to_check,
     const float margin) {
-  unsigned int num_fused = 0;
+  std::unordered_set<std::shared_ptr<data::landmark>> modified_lms;
+  return apply_fusion(detect_fusion(keyfrm, landmarks_to_check, margin),
+                      modified_lms, margin);
+}
+
+template unsigned int fuse::replace_duplication(
+    const std::shared_ptr<data::keyframe>&,
+    const std::vector<std::shared_ptr<data::landmark>>&, const float);
+template unsigned int fuse::replace_duplication(
+    const std::shared_ptr<data::keyframe>&,
+    const std::unordered_set<std::shared_ptr<data::landmark>>&, const float);
+
+unsigned int fuse::replace_duplication_in_chunks(
+    const std::shared_ptr<data::keyframe>& keyfrm,
+    const std::vector<std::shared_ptr<data::landmark>>& landmarks_to_check,
+    const unsigned int chunk_size, const float margin) {
+  assert(0 < chunk_size);
+  const unsigned int num_chunks =
+      (landmarks_to_check.size() + chunk_size - 1) / chunk_size;
+  std::vector<fusion_proposal> proposals(num_chunks);
+
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (unsigned int i = 0; i < num_chunks; ++i) {
+    const auto begin = landmarks_to_check.begin() + i * chunk_size;
+    const auto end =
+        landmarks_to_check.begin() +
+        std::min<std::size_t>((i + 1) * chunk_size, landmarks_to_check.size());
+    const std::vector<std::shared_ptr<data::landmark>> chunk(begin, end);
+    proposals.at(i) = detect_fusion(keyfrm, chunk, margin);
+  }
+
+  // the proposals are merged in order, so the matches are applied in the same
+  // order as replace_duplication()
+  fusion_proposal merged_proposal;
+  merged_proposal.keyfrm_ = keyfrm;
+  for (const auto& proposal : proposals) {
+    merged_proposal.append(proposal);
+  }
+  std::unordered_set<std::shared_ptr<data::landmark>> modified_lms;
+  return apply_fusion(merged_proposal, modified_lms, margin);
+}
+
+template <typename T>
+fusion_proposal fuse::detect_fusion(
+    const std::shared_ptr<data::keyframe>& keyfrm, const T& landmarks_to_check,
+    const float margin) const {
+  fusion_proposal proposal;
+  proposal.keyfrm_ = keyfrm;
 
   const Mat33_t rot_cw = keyfrm->get_rotation();
   const Vec3_t trans_cw = keyfrm->get_translation();
   const Vec3_t cam_center = keyfrm->get_cam_center();
 
+  // Collect the landmarks which are not observed in the keyframe
+  proposal.lms_.reserve(landmarks_to_check.size());
+  proposal.pos_ws_.reserve(landmarks_to_check.size());
   for (const auto& lm : landmarks_to_check) {
     if (!lm) {
       continue;
@@ -156,114 +226,77 @@ unsigned int fuse::replace_duplication(
     if (lm->is_observed_in_keyframe(keyfrm)) {
       continue;
     }
-
+    proposal.lms_.push_back(lm);
     // 3D point coordinates with the global reference
-    const Vec3_t pos_w = lm->get_pos_in_world();
+    proposal.pos_ws_.push_back(lm->get_pos_in_world());
+  }
 
-    // Reproject and compute visibility
-    Vec2_t reproj;
-    float x_right;
-    const bool in_image = keyfrm->camera_->reproject_to_image(
-        rot_cw, trans_cw, pos_w, reproj, x_right);
+  // Reproject and compute visibility at once
+  keyfrm->camera_->reproject_points_to_image(
+      rot_cw, trans_cw, proposal.pos_ws_, proposal.reprojs_,
+      proposal.x_rights_, proposal.in_image_);
 
+  // Find the matched keypoints
+  proposal.matched_idxs_.resize(proposal.lms_.size(), -1);
+  for (unsigned int i = 0; i < proposal.lms_.size(); ++i) {
     // Ignore if it is reprojected outside the image
-    if (!in_image) {
+    if (!proposal.in_image_.at(i)) {
       continue;
     }
+    proposal.matched_idxs_.at(i) = find_matched_keypoint(
+        keyfrm, cam_center, proposal.lms_.at(i), proposal.pos_ws_.at(i),
+        proposal.reprojs_.at(i), proposal.x_rights_.at(i), margin);
+  }
 
-    // Check if it's within ORB scale levels
-    const Vec3_t cam_to_lm_vec = pos_w - cam_center;
-    const auto cam_to_lm_dist = cam_to_lm_vec.norm();
-    const auto max_cam_to_lm_dist = lm->get_max_valid_distance();
-    const auto min_cam_to_lm_dist = lm->get_min_valid_distance();
+  return proposal;
+}
 
-    if (cam_to_lm_dist < min_cam_to_lm_dist ||
-        max_cam_to_lm_dist < cam_to_lm_dist) {
-      continue;
-    }
+template fusion_proposal fuse::detect_fusion(
+    const std::shared_ptr<data::keyframe>&,
+    const std::vector<std::shared_ptr<data::landmark>>&, const float) const;
+template fusion_proposal fuse::detect_fusion(
+    const std::shared_ptr<data::keyframe>&,
+    const std::unordered_set<std::shared_ptr<data::landmark>>&,
+    const float) const;
 
-    // Compute the angle formed by the average vector of the 3D point
-    // observation, and discard it if it is wider than the threshold value (60
-    // degrees)
-    const Vec3_t obs_mean_normal = lm->get_obs_mean_normal();
+unsigned int fuse::apply_fusion(
+    const fusion_proposal& proposal,
+    std::unordered_set<std::shared_ptr<data::landmark>>& modified_lms,
+    const float margin) const {
+  unsigned int num_fused = 0;
 
-    if (cam_to_lm_vec.dot(obs_mean_normal) < 0.5 * cam_to_lm_dist) {
-      continue;
+  const auto& keyfrm = proposal.keyfrm_;
+  const Vec3_t cam_center = keyfrm->get_cam_center();
+  const auto num_lms = proposal.lms_.size();
+
+  // Check the modified landmarks again, which are collected at the beginning
+  // of the fusion into the keyframe
+  std::vector<unsigned char> is_valid(num_lms, 1);
+  for (unsigned int i = 0; i < num_lms; ++i) {
+    const auto& lm = proposal.lms_.at(i);
+    if (modified_lms.count(lm)) {
+      is_valid.at(i) =
+          !lm->will_be_erased() && !lm->is_observed_in_keyframe(keyfrm);
     }
+  }
 
-    // Acquire keypoints in the cell where the reprojected 3D points exist
-    const auto pred_scale_level = lm->predict_scale_level(
-        cam_to_lm_dist, keyfrm->orb_params_->num_levels_,
-        keyfrm->orb_params_->log_scale_factor_);
-    const auto indices = keyfrm->get_keypoints_in_cell(
-        reproj(0), reproj(1),
-        margin * keyfrm->orb_params_->scale_factors_.at(pred_scale_level));
-
-    if (indices.empty()) {
+  for (unsigned int i = 0; i < num_lms; ++i) {
+    // Ignore if it is reprojected outside the image
+    if (!is_valid.at(i) || !proposal.in_image_.at(i)) {
       continue;
     }
 
-    // Find a keypoint with the closest descriptor
-    const auto lm_desc = lm->get_descriptor();
-
-    unsigned int best_dist = MAX_HAMMING_DIST;
-    int best_idx = -1;
-
-    for (const auto idx : indices) {
-      const auto& keypt = keyfrm->frm_obs_.undist_keypts_.at(idx);
-
-      const auto scale_level = static_cast<unsigned int>(keypt.octave);
-
-      // TODO: should determine the scale with 'keyfrm-> get_keypts_in_cell ()'
-      if (scale_level < pred_scale_level - 1 ||
-          pred_scale_level < scale_level) {
-        continue;
-      }
-
-      if (keyfrm->frm_obs_.stereo_x_right_.at(idx) >= 0) {
-        // Compute reprojection error with 3 degrees of freedom if a stereo
-        // match exists
-        const auto e_x = reproj(0) - keypt.pt.x;
-        const auto e_y = reproj(1) - keypt.pt.y;
-        const auto e_x_right =
-            x_right - keyfrm->frm_obs_.stereo_x_right_.at(idx);
-        const auto reproj_error_sq =
-            e_x * e_x + e_y * e_y + e_x_right * e_x_right;
-
-        // n=3
-        constexpr float chi_sq_3D = 7.81473;
-        if (chi_sq_3D <
-            reproj_error_sq *
-                keyfrm->orb_params_->inv_level_sigma_sq_.at(scale_level)) {
-          continue;
-        }
-      } else {
-        // Compute reprojection error with 2 degrees of freedom if a stereo
-        // match does not exist
-        const auto e_x = reproj(0) - keypt.pt.x;
-        const auto e_y = reproj(1) - keypt.pt.y;
-        const auto reproj_error_sq = e_x * e_x + e_y * e_y;
-
-        // n=2
-        constexpr float chi_sq_2D = 5.99146;
-        if (chi_sq_2D <
-            reproj_error_sq *
-                keyfrm->orb_params_->inv_level_sigma_sq_.at(scale_level)) {
-          continue;
-        }
-      }
-
-      const auto& desc = keyfrm->frm_obs_.descriptors_.row(idx);
-
-      const auto hamm_dist = compute_descriptor_distance_32(lm_desc, desc);
-
-      if (hamm_dist < best_dist) {
-        best_dist = hamm_dist;
-        best_idx = idx;
-      }
-    }
-
-    if (HAMMING_DIST_THR_LOW < best_dist) {
+    // The descriptor of the modified landmark might be updated after the
+    // detection
+    const auto& lm = proposal.lms_.at(i);
+    const auto best_idx =
+        modified_lms.count(lm)
+            ? find_matched_keypoint(keyfrm, cam_center, lm,
+                                    proposal.pos_ws_.at(i),
+                                    proposal.reprojs_.at(i),
+                                    proposal.x_rights_.at(i), margin)
+            : proposal.matched_idxs_.at(i);
+    if (best_idx < 0) {
       continue;
     }
 
@@ -280,6 +313,8 @@ unsigned int fuse::replace_duplication(
           // Replace lm_in_keyfrm with lm
           lm_in_keyfrm->replace(lm);
         }
+        modified_lms.insert(lm);
+        modified_lms.insert(lm_in_keyfrm);
       }
     } else {
       // There is no association between the 3D point and the keyframe
@@ -294,12 +329,107 @@ unsigned int fuse::replace_duplication(
   return num_fused;
 }
 
-template unsigned int fuse::replace_duplication(
-    const std::shared_ptr<data::keyframe>&,
-    const std::vector<std::shared_ptr<data::landmark>>&, const float);
-template unsigned int fuse::replace_duplication(
-    const std::shared_ptr<data::keyframe>&,
-    const std::unordered_set<std::shared_ptr<data::landmark>>&, const float);
+int fuse::find_matched_keypoint(const std::shared_ptr<data::keyframe>& keyfrm,
+                                const Vec3_t& cam_center,
+                                const std::shared_ptr<data::landmark>& lm,
+                                const Vec3_t& pos_w, const Vec2_t& reproj,
+                                const float x_right, const float margin) const {
+  // Check if it's within ORB scale levels
+  const Vec3_t cam_to_lm_vec = pos_w - cam_center;
+  const auto cam_to_lm_dist = cam_to_lm_vec.norm();
+  const auto max_cam_to_lm_dist = lm->get_max_valid_distance();
+  const auto min_cam_to_lm_dist = lm->get_min_valid_distance();
+
+  if (cam_to_lm_dist < min_cam_to_lm_dist ||
+      max_cam_to_lm_dist < cam_to_lm_dist) {
+    return -1;
+  }
+
+  // Compute the angle formed by the average vector of the 3D point
+  // observation, and discard it if it is wider than the threshold value (60
+  // degrees)
+  const Vec3_t obs_mean_normal = lm->get_obs_mean_normal();
+
+  if (cam_to_lm_vec.dot(obs_mean_normal) < 0.5 * cam_to_lm_dist) {
+    return -1;
+  }
+
+  // Acquire keypoints in the cell where the reprojected 3D points exist
+  const auto pred_scale_level = lm->predict_scale_level(
+      cam_to_lm_dist, keyfrm->orb_params_->num_levels_,
+      keyfrm->orb_params_->log_scale_factor_);
+  const auto indices = keyfrm->get_keypoints_in_cell(
+      reproj(0), reproj(1),
+      margin * keyfrm->orb_params_->scale_factors_.at(pred_scale_level));
+
+  if (indices.empty()) {
+    return -1;
+  }
+
+  // Find a keypoint with the closest descriptor
+  const auto lm_desc = lm->get_descriptor();
+
+  unsigned int best_dist = MAX_HAMMING_DIST;
+  int best_idx = -1;
+
+  for (const auto idx : indices) {
+    const auto& keypt = keyfrm->frm_obs_.undist_keypts_.at(idx);
+
+    const auto scale_level = static_cast<unsigned int>(keypt.octave);
+
+    // TODO: should determine the scale with 'keyfrm-> get_keypts_in_cell ()'
+    if (scale_level < pred_scale_level - 1 || pred_scale_level < scale_level) {
+      continue;
+    }
+
+    if (keyfrm->frm_obs_.stereo_x_right_.at(idx) >= 0) {
+      // Compute reprojection error with 3 degrees of freedom if a stereo
+      // match exists
+      const auto e_x = reproj(0) - keypt.pt.x;
+      const auto e_y = reproj(1) - keypt.pt.y;
+      const auto e_x_right = x_right - keyfrm->frm_obs_.stereo_x_right_.at(idx);
+      const auto reproj_error_sq =
+          e_x * e_x + e_y * e_y + e_x_right * e_x_right;
+
+      // n=3
+      constexpr float chi_sq_3D = 7.81473;
+      if (chi_sq_3D <
+          reproj_error_sq *
+              keyfrm->orb_params_->inv_level_sigma_sq_.at(scale_level)) {
+        continue;
+      }
+    } else {
+      // Compute reprojection error with 2 degrees of freedom if a stereo
+      // match does not exist
+      const auto e_x = reproj(0) - keypt.pt.x;
+      const auto e_y = reproj(1) - keypt.pt.y;
+      const auto reproj_error_sq = e_x * e_x + e_y * e_y;
+
+      // n=2
+      constexpr float chi_sq_2D = 5.99146;
+      if (chi_sq_2D <
+          reproj_error_sq *
+              keyfrm->orb_params_->inv_level_sigma_sq_.at(scale_level)) {
+        continue;
+      }
+    }
+
+    const auto& desc = keyfrm->frm_obs_.descriptors_.row(idx);
+
+    const auto hamm_dist = compute_descriptor_distance_32(lm_desc, desc);
+
+    if (hamm_dist < best_dist) {
+      best_dist = hamm_dist;
+      best_idx = idx;
+    }
+  }
+
+  if (HAMMING_DIST_THR_LOW < best_dist) {
+    return -1;
+  }
+
+  return best_idx;
+}
 
 }  // namespace match
 }  // namespace openvslam
@@ -2,6 +2,8 @@
 #define OPENVSLAM_MATCH_FUSE_H
 
 #include <memory>
+#include <unordered_set>
+#include <vector>
 
 #include "openvslam/match/base.h"
 #include "openvslam/type.h"
@@ -15,6 +17,33 @@ class landmark;
 
 namespace match {
 
+/**
+ * Matches between the landmarks and the keypoints of a keyframe, which are
+ * detected by fuse::detect_fusion() without modifying the map, and are applied
+ * to the map by fuse::apply_fusion()
+ */
+struct fusion_proposal {
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  //! Append the proposal for the same keyframe
+  void append(const fusion_proposal& proposal);
+
+  //! keyframe to fuse the landmarks into
+  std::shared_ptr<data::keyframe> keyfrm_ = nullptr;
+  //! landmarks which were valid and not observed in the keyframe at detection
+  std::vector<std::shared_ptr<data::landmark>> lms_;
+  //! positions of the landmarks in the world coordinates
+  eigen_alloc_vector<Vec3_t> pos_ws_;
+  //! reprojections of the landmarks
+  eigen_alloc_vector<Vec2_t> reprojs_;
+  //! x-coordinates of the reprojections in the right image
+  std::vector<float> x_rights_;
+  //! the landmarks are reprojected inside of the image or not
+  std::vector<unsigned char> in_image_;
+  //! indices of the matched keypoints (-1 if not matched)
+  std::vector<int> matched_idxs_;
+};
+
 class fuse final : public base {
  public:
   explicit fuse(const float lowe_ratio = 0.6) : base(lowe_ratio, true) {}
@@ -38,6 +67,43 @@ class fuse final : public base {
   unsigned int replace_duplication(
       const std::shared_ptr<data::keyframe>& keyfrm,
       const T& landmarks_to_check, const float margin = 3.0);
+
+  //! Fuse the landmarks into the keyframe in the same way as
+  //! replace_duplication(), while the matches are detected in parallel for
+  //! the chunks of chunk_size landmarks
+  //! (the result does not depend on the chunk size)
+  unsigned int replace_duplication_in_chunks(
+      const std::shared_ptr<data::keyframe>& keyfrm,
+      const std::vector<std::shared_ptr<data::landmark>>& landmarks_to_check,
+      const unsigned int chunk_size, const float margin = 3.0);
+
+  //! Reproject the landmarks to the keyframe and find the matched keypoints
+  //! without modifying the map
+  //! (it can be called concurrently for the different keyframes)
+  template <typename T>
+  fusion_proposal detect_fusion(const std::shared_ptr<data::keyframe>& keyfrm,
+                                const T& landmarks_to_check,
+                                const float margin = 3.0) const;
+
+  //! Add the matches in the proposal to the map, and select more reliable
+  //! landmarks if the matched keypoints have been associated with landmarks
+  //! (the landmarks in modified_lms, which have been replaced or have
+  //! absorbed the others after the detection, are matched again in the same
+  //! way as replace_duplication(), and the landmarks modified here are added
+  //! to modified_lms)
+  unsigned int apply_fusion(
+      const fusion_proposal& proposal,
+      std::unordered_set<std::shared_ptr<data::landmark>>& modified_lms,
+      const float margin = 3.0) const;
+
+ private:
+  //! Find the keypoint matched with the landmark reprojected to the keyframe
+  //! (-1 is returned if not found)
+  int find_matched_keypoint(const std::shared_ptr<data::keyframe>& keyfrm,
+                            const Vec3_t& cam_center,
+                            const std::shared_ptr<data::landmark>& lm,
+                            const Vec3_t& pos_w, const Vec2_t& reproj,
+                            const float x_right, const float margin) const;
 };
 
 }  // namespace match
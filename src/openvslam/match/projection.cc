@@ -4,6 +4,7 @@
 #include "openvslam/data/frame.h"
 #include "openvslam/data/keyframe.h"
 #include "openvslam/data/landmark.h"
+#include "openvslam/data/landmark_snapshot.h"
 #include "openvslam/match/angle_checker.h"
 
 namespace openvslam {
@@ -27,71 +28,102 @@ unsigned int projection::match_frame_and_landmarks(
       continue;
     }
 
-    const auto pred_scale_level = lm_to_scale.at(local_lm->id_);
+    if (match_frame_and_landmark(frm, local_lm, lm_to_reproj.at(local_lm->id_),
+                                 lm_to_x_right.at(local_lm->id_),
+                                 lm_to_scale.at(local_lm->id_), margin)) {
+      ++num_matches;
+    }
+  }
 
-    // Acquire keypoints in the cell where the reprojected 3D points exist
-    Vec2_t reproj = lm_to_reproj.at(local_lm->id_);
-    const auto indices_in_cell = frm.get_keypoints_in_cell(
-        reproj(0), reproj(1),
-        margin * frm.orb_params_->scale_factors_.at(pred_scale_level),
-        pred_scale_level - 1, pred_scale_level);
-    if (indices_in_cell.empty()) {
+  return num_matches;
+}
+
+unsigned int projection::match_frame_and_landmarks(
+    data::frame& frm, const data::landmark_snapshot& snapshot,
+    const float margin) const {
+  unsigned int num_matches = 0;
+
+  // Acquire the 2D-3D matches of the observable landmarks
+  for (unsigned int i = 0; i < snapshot.visible_indices_.size(); ++i) {
+    const auto& lm = snapshot.lms_.at(snapshot.visible_indices_.at(i));
+    if (lm->will_be_erased()) {
       continue;
     }
 
-    const cv::Mat lm_desc = local_lm->get_descriptor();
-
-    unsigned int best_hamm_dist = MAX_HAMMING_DIST;
-    int best_scale_level = -1;
-    unsigned int second_best_hamm_dist = MAX_HAMMING_DIST;
-    int second_best_scale_level = -1;
-    int best_idx = -1;
+    if (match_frame_and_landmark(frm, lm, snapshot.reprojs_.at(i),
+                                 snapshot.x_rights_.at(i),
+                                 snapshot.pred_scale_levels_.at(i), margin)) {
+      ++num_matches;
+    }
+  }
 
-    for (const auto idx : indices_in_cell) {
-      if (frm.landmarks_.at(idx) && frm.landmarks_.at(idx)->has_observation()) {
-        continue;
-      }
+  return num_matches;
+}
 
-      if (0 < frm.frm_obs_.stereo_x_right_.at(idx)) {
-        const auto reproj_error =
-            std::abs(lm_to_x_right.at(local_lm->id_) -
-                     frm.frm_obs_.stereo_x_right_.at(idx));
-        if (margin * frm.orb_params_->scale_factors_.at(pred_scale_level) <
-            reproj_error) {
-          continue;
-        }
-      }
+bool projection::match_frame_and_landmark(
+    data::frame& frm, const std::shared_ptr<data::landmark>& lm,
+    const Vec2_t& reproj, const float x_right,
+    const unsigned int pred_scale_level, const float margin) const {
+  // Acquire keypoints in the cell where the reprojected 3D points exist
+  const auto indices_in_cell = frm.get_keypoints_in_cell(
+      reproj(0), reproj(1),
+      margin * frm.orb_params_->scale_factors_.at(pred_scale_level),
+      static_cast<int>(pred_scale_level) - 1, pred_scale_level);
+  if (indices_in_cell.empty()) {
+    return false;
+  }
 
-      const cv::Mat& desc = frm.frm_obs_.descriptors_.row(idx);
+  const cv::Mat lm_desc = lm->get_descriptor();
 
-      const auto dist = compute_descriptor_distance_32(lm_desc, desc);
+  unsigned int best_hamm_dist = MAX_HAMMING_DIST;
+  int best_scale_level = -1;
+  unsigned int second_best_hamm_dist = MAX_HAMMING_DIST;
+  int second_best_scale_level = -1;
+  int best_idx = -1;
 
-      if (dist < best_hamm_dist) {
-        second_best_hamm_dist = best_hamm_dist;
-        best_hamm_dist = dist;
-        second_best_scale_level = best_scale_level;
-        best_scale_level = frm.frm_obs_.undist_keypts_.at(idx).octave;
-        best_idx = idx;
-      } else if (dist < second_best_hamm_dist) {
-        second_best_scale_level = frm.frm_obs_.undist_keypts_.at(idx).octave;
-        second_best_hamm_dist = dist;
-      }
+  for (const auto idx : indices_in_cell) {
+    if (frm.landmarks_.at(idx) && frm.landmarks_.at(idx)->has_observation()) {
+      continue;
     }
 
-    if (best_hamm_dist <= HAMMING_DIST_THR_HIGH) {
-      // Lowe's ratio test
-      if (best_scale_level == second_best_scale_level &&
-          best_hamm_dist > lowe_ratio_ * second_best_hamm_dist) {
+    if (0 < frm.frm_obs_.stereo_x_right_.at(idx)) {
+      const auto reproj_error =
+          std::abs(x_right - frm.frm_obs_.stereo_x_right_.at(idx));
+      if (margin * frm.orb_params_->scale_factors_.at(pred_scale_level) <
+          reproj_error) {
         continue;
       }
+    }
 
-      // Add the matching information
-      frm.landmarks_.at(best_idx) = local_lm;
-      ++num_matches;
+    const cv::Mat& desc = frm.frm_obs_.descriptors_.row(idx);
+
+    const auto dist = compute_descriptor_distance_32(lm_desc, desc);
+
+    if (dist < best_hamm_dist) {
+      second_best_hamm_dist = best_hamm_dist;
+      best_hamm_dist = dist;
+      second_best_scale_level = best_scale_level;
+      best_scale_level = frm.frm_obs_.undist_keypts_.at(idx).octave;
+      best_idx = idx;
+    } else if (dist < second_best_hamm_dist) {
+      second_best_scale_level = frm.frm_obs_.undist_keypts_.at(idx).octave;
+      second_best_hamm_dist = dist;
     }
   }
 
-  return num_matches;
+  if (best_hamm_dist <= HAMMING_DIST_THR_HIGH) {
+    // Lowe's ratio test
+    if (best_scale_level == second_best_scale_level &&
+        best_hamm_dist > lowe_ratio_ * second_best_hamm_dist) {
+      return false;
+    }
+
+    // Add the matching information
+    frm.landmarks_.at(best_idx) = lm;
+    return true;
+  }
+
+  return false;
 }
 
 unsigned int projection::match_current_and_last_frames(
@@ -124,11 +156,14 @@ unsigned int projection::match_current_and_last_frames(
           ? false
           : -trans_lc(2) > curr_frm.camera_->true_baseline_;
 
-  // Reproject the 3D points associated to the keypoints of the last frame,
-  // then acquire the 2D-3D matches
+  // Collect the 3D points associated to the keypoints of the last frame
+  std::vector<unsigned int> last_indices;
+  eigen_alloc_vector<Vec3_t> pos_ws;
+  last_indices.reserve(last_frm.frm_obs_.num_keypts_);
+  pos_ws.reserve(last_frm.frm_obs_.num_keypts_);
   for (unsigned int idx_last = 0; idx_last < last_frm.frm_obs_.num_keypts_;
        ++idx_last) {
-    auto& lm = last_frm.landmarks_.at(idx_last);
+    const auto& lm = last_frm.landmarks_.at(idx_last);
     if (!lm) {
       continue;
     }
@@ -137,21 +172,30 @@ unsigned int projection::match_current_and_last_frames(
     if (last_frm.outlier_flags_.at(idx_last)) {
       continue;
     }
-
+    last_indices.push_back(idx_last);
     // 3D point coordinates with the global reference
-    const Vec3_t pos_w = lm->get_pos_in_world();
+    pos_ws.push_back(lm->get_pos_in_world());
+  }
 
-    // Reproject and compute visibility
-    Vec2_t reproj;
-    float x_right;
-    const bool in_image = curr_frm.camera_->reproject_to_image(
-        rot_cw, trans_cw, pos_w, reproj, x_right);
+  // Reproject and compute visibility at once
+  eigen_alloc_vector<Vec2_t> reprojs;
+  std::vector<float> x_rights;
+  std::vector<unsigned char> in_image;
+  curr_frm.camera_->reproject_points_to_image(rot_cw, trans_cw, pos_ws, reprojs,
+                                              x_rights, in_image);
 
+  // Acquire the 2D-3D matches
+  for (unsigned int i = 0; i < last_indices.size(); ++i) {
     // Ignore if it is reprojected outside the image
-    if (!in_image) {
+    if (!in_image.at(i)) {
       continue;
     }
 
+    const auto idx_last = last_indices.at(i);
+    const auto& lm = last_frm.landmarks_.at(idx_last);
+    const Vec2_t& reproj = reprojs.at(i);
+    const float x_right = x_rights.at(i);
+
     // Acquire keypoints in the cell where the reprojected 3D points exist
     const auto last_scale_level = last_frm.frm_obs_.keypts_.at(idx_last).octave;
     int min_level;
@@ -245,10 +289,13 @@ unsigned int projection::match_frame_and_keyframe(
 
   const auto landmarks = keyfrm->get_landmarks();
 
-  // Reproject the 3D points associated to the keypoints of the keyframe,
-  // then acquire the 2D-3D matches
+  // Collect the 3D points associated to the keypoints of the keyframe
+  std::vector<unsigned int> lm_indices;
+  eigen_alloc_vector<Vec3_t> pos_ws;
+  lm_indices.reserve(landmarks.size());
+  pos_ws.reserve(landmarks.size());
   for (unsigned int idx = 0; idx < landmarks.size(); idx++) {
-    auto& lm = landmarks.at(idx);
+    const auto& lm = landmarks.at(idx);
     if (!lm) {
       continue;
     }
@@ -259,21 +306,30 @@ unsigned int projection::match_frame_and_keyframe(
     if (already_matched_lms.count(lm)) {
       continue;
     }
-
+    lm_indices.push_back(idx);
     // 3D point coordinates with the global reference
-    const Vec3_t pos_w = lm->get_pos_in_world();
+    pos_ws.push_back(lm->get_pos_in_world());
+  }
 
-    // Reproject and compute visibility
-    Vec2_t reproj;
-    float x_right;
-    const bool in_image = curr_frm.camera_->reproject_to_image(
-        rot_cw, trans_cw, pos_w, reproj, x_right);
+  // Reproject and compute visibility at once
+  eigen_alloc_vector<Vec2_t> reprojs;
+  std::vector<float> x_rights;
+  std::vector<unsigned char> in_image;
+  curr_frm.camera_->reproject_points_to_image(rot_cw, trans_cw, pos_ws, reprojs,
+                                              x_rights, in_image);
 
+  // Acquire the 2D-3D matches
+  for (unsigned int i = 0; i < lm_indices.size(); ++i) {
     // Ignore if it is reprojected outside the image
-    if (!in_image) {
+    if (!in_image.at(i)) {
       continue;
     }
 
+    const auto idx = lm_indices.at(i);
+    const auto& lm = landmarks.at(idx);
+    const Vec3_t& pos_w = pos_ws.at(i);
+    const Vec2_t& reproj = reprojs.at(i);
+
     // Check if it's within ORB scale levels
     const Vec3_t cam_to_lm_vec = pos_w - cam_center;
     const auto cam_to_lm_dist = cam_to_lm_vec.norm();
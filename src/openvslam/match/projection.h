@@ -13,6 +13,7 @@ namespace data {
 class frame;
 class keyframe;
 class landmark;
+class landmark_snapshot;
 }  // namespace data
 
 namespace match {
@@ -34,6 +35,12 @@ class projection final : public base {
       std::unordered_map<unsigned int, int>& lm_to_scale,
       const float margin = 5.0) const;
 
+  //! match the frame with the observable landmarks which are found by
+  //! landmark_snapshot::cull() (the reprojections are read from the arrays)
+  unsigned int match_frame_and_landmarks(
+      data::frame& frm, const data::landmark_snapshot& snapshot,
+      const float margin = 5.0) const;
+
   //! last frameで観測している3次元点をcurrent
   //! frameに再投影し，frame.landmarks_に対応情報を記録する
   unsigned int match_current_and_last_frames(data::frame& curr_frm,
@@ -65,6 +72,15 @@ class projection final : public base {
       std::vector<std::shared_ptr<data::landmark>>& matched_lms_in_keyfrm_1,
       const float& s_12, const Mat33_t& rot_12, const Vec3_t& trans_12,
       const float margin) const;
+
+ private:
+  //! find the best keypoint for the reprojected landmark and record the
+  //! association to frm.landmarks_ (return true if the match is found)
+  bool match_frame_and_landmark(data::frame& frm,
+                                const std::shared_ptr<data::landmark>& lm,
+                                const Vec2_t& reproj, const float x_right,
+                                const unsigned int pred_scale_level,
+                                const float margin) const;
 };
 
 }  // namespace match
@@ -37,6 +37,9 @@ unsigned int robust::match_for_triangulation(
   // Acquire the 3D point information of the keframes
   const auto assoc_lms_in_keyfrm_1 = keyfrm_1->get_landmarks();
   const auto assoc_lms_in_keyfrm_2 = keyfrm_2->get_landmarks();
+  // (the bearings of keyframe 2 are computed once because they are compared
+  // with every keypoint in keyframe 1)
+  const auto bearings_2 = keyfrm_2->get_bearings();
 
   // Save the matching information
   // Discard the already matched keypoints in keyframe 2
@@ -85,7 +88,7 @@ unsigned int robust::match_for_triangulation(
 
         // Acquire the keypoints and ORB feature vectors
         const auto& keypt_1 = keyfrm_1->frm_obs_.undist_keypts_.at(idx_1);
-        const Vec3_t& bearing_1 = keyfrm_1->frm_obs_.bearings_.at(idx_1);
+        const Vec3_t bearing_1 = keyfrm_1->get_bearing(idx_1);
         const auto& desc_1 = keyfrm_1->frm_obs_.descriptors_.row(idx_1);
 
         // Find a keypoint in keyframe 2 that has the minimum hamming distance
@@ -110,7 +113,7 @@ unsigned int robust::match_for_triangulation(
               0 <= keyfrm_2->frm_obs_.stereo_x_right_.at(idx_2);
 
           // Acquire the keypoints and ORB feature vectors
-          const Vec3_t& bearing_2 = keyfrm_2->frm_obs_.bearings_.at(idx_2);
+          const Vec3_t& bearing_2 = bearings_2.at(idx_2);
           const auto& desc_2 = keyfrm_2->frm_obs_.descriptors_.row(idx_2);
 
           // Compute the distance
@@ -212,8 +215,9 @@ unsigned int robust::match_frame_and_keyframe(
   brute_force_match(frm, keyfrm, matches);
 
   // Extract only inliers with eight-point RANSAC
-  solve::essential_solver solver(frm.frm_obs_.bearings_,
-                                 keyfrm->frm_obs_.bearings_, matches);
+  const auto keyfrm_bearings = keyfrm->get_bearings();
+  solve::essential_solver solver(frm.frm_obs_.bearings_, keyfrm_bearings,
+                                 matches);
   solver.find_via_ransac(50, false);
   if (!solver.solution_is_valid()) {
     return 0;
@@ -197,8 +197,10 @@ bool initializer::create_map_for_monocular(data::bow_vocabulary* bow_vocab,
   }
 
   // create initial keyframes
-  auto init_keyfrm = data::keyframe::make_keyframe(init_frm_);
-  auto curr_keyfrm = data::keyframe::make_keyframe(curr_frm);
+  auto init_keyfrm = data::keyframe::make_keyframe(
+      map_db_->next_keyframe_id_++, init_frm_, map_db_);
+  auto curr_keyfrm = data::keyframe::make_keyframe(
+      map_db_->next_keyframe_id_++, curr_frm, map_db_);
 
   // compute BoW representations
   init_keyfrm->compute_bow(bow_vocab);
@@ -307,7 +309,8 @@ bool initializer::create_map_for_stereo(data::bow_vocabulary* bow_vocab,
 
   // create an initial keyframe
   curr_frm.set_cam_pose(Mat44_t::Identity());
-  auto curr_keyfrm = data::keyframe::make_keyframe(curr_frm);
+  auto curr_keyfrm = data::keyframe::make_keyframe(
+      map_db_->next_keyframe_id_++, curr_frm, map_db_);
 
   // compute BoW representation
   curr_keyfrm->compute_bow(bow_vocab);
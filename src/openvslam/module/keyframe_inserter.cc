@@ -87,7 +87,8 @@ std::shared_ptr<data::keyframe> keyframe_inserter::insert_new_keyframe(
   }
 
   curr_frm.update_pose_params();
-  auto keyfrm = data::keyframe::make_keyframe(curr_frm);
+  auto keyfrm = data::keyframe::make_keyframe(map_db->next_keyframe_id_++,
+                                              curr_frm, map_db);
 
   // Queue up the keyframe to the mapping module
   if (!keyfrm->depth_is_avaliable()) {
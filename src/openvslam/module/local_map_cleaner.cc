@@ -109,77 +109,9 @@ unsigned int local_map_cleaner::remove_redundant_keyframes(
 void local_map_cleaner::count_redundant_observations(
     const std::shared_ptr<data::keyframe>& keyfrm, unsigned int& num_valid_obs,
     unsigned int& num_redundant_obs) const {
-  // if the number of keyframes that observes the landmark with more reliable
-  // scale than the specified keyframe does, it is considered as redundant
-  constexpr unsigned int num_better_obs_thr = 3;
-
-  num_valid_obs = 0;
-  num_redundant_obs = 0;
-
-  const auto landmarks = keyfrm->get_landmarks();
-  for (unsigned int idx = 0; idx < landmarks.size(); ++idx) {
-    const auto& lm = landmarks.at(idx);
-    if (!lm) {
-      continue;
-    }
-    if (lm->will_be_erased()) {
-      continue;
-    }
-
-    // if depth is within the valid range, it won't be considered
-    const auto depth = keyfrm->frm_obs_.depths_.at(idx);
-    if (keyfrm->depth_is_avaliable() &&
-        (depth < 0.0 || keyfrm->camera_->depth_thr_ < depth)) {
-      continue;
-    }
-
-    ++num_valid_obs;
-
-    // if the number of the obs is smaller than the threshold, cannot remote the
-    // observers
-    if (lm->num_observations() <= num_better_obs_thr) {
-      continue;
-    }
-
-    // `keyfrm` observes `lm` with the scale level `scale_level`
-    const auto scale_level = keyfrm->frm_obs_.undist_keypts_.at(idx).octave;
-    // get observers of `lm`
-    const auto observations = lm->get_observations();
-
-    bool obs_by_keyfrm_is_redundant = false;
-
-    // the number of the keyframes that observe `lm` with the more reliable
-    // (closer) scale
-    unsigned int num_better_obs = 0;
-
-    for (const auto& obs : observations) {
-      const auto ngh_keyfrm = obs.first.lock();
-      if (*ngh_keyfrm == *keyfrm) {
-        continue;
-      }
-
-      // `ngh_keyfrm` observes `lm` with the scale level `ngh_scale_level`
-      const auto ngh_scale_level =
-          ngh_keyfrm->frm_obs_.undist_keypts_.at(obs.second).octave;
-
-      // compare the scale levels
-      if (ngh_scale_level <= scale_level + 1) {
-        // the observation by `ngh_keyfrm` is more reliable than `keyfrm`
-        ++num_better_obs;
-        if (num_better_obs_thr <= num_better_obs) {
-          // if the number of the better observations is greater than the
-          // threshold, consider the observation of `lm` by `keyfrm` is
-          // redundant
-          obs_by_keyfrm_is_redundant = true;
-          break;
-        }
-      }
-    }
-
-    if (obs_by_keyfrm_is_redundant) {
-      ++num_redundant_obs;
-    }
-  }
+  // the counts are maintained incrementally by the landmarks whenever their
+  // observations are changed (see landmark::update_redundancy())
+  keyfrm->get_redundant_observation_counts(num_valid_obs, num_redundant_obs);
 }
 
 }  // namespace module
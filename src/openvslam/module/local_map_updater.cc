@@ -3,23 +3,21 @@
 #include "openvslam/data/frame.h"
 #include "openvslam/data/keyframe.h"
 #include "openvslam/data/landmark.h"
+#include "openvslam/data/map_database.h"
 
 namespace openvslam {
 namespace module {
 
-local_map_updater::local_map_updater(const data::frame& curr_frm,
+local_map_updater::local_map_updater(data::map_database* map_db,
                                      const unsigned int max_num_local_keyfrms)
-    : frm_id_(curr_frm.id_),
-      frm_lms_(curr_frm.landmarks_),
-      num_keypts_(curr_frm.frm_obs_.num_keypts_),
-      max_num_local_keyfrms_(max_num_local_keyfrms) {}
+    : map_db_(map_db), max_num_local_keyfrms_(max_num_local_keyfrms) {}
 
-std::vector<std::shared_ptr<data::keyframe>>
+const std::vector<std::shared_ptr<data::keyframe>>&
 local_map_updater::get_local_keyframes() const {
   return local_keyfrms_;
 }
 
-std::vector<std::shared_ptr<data::landmark>>
+const std::vector<std::shared_ptr<data::landmark>>&
 local_map_updater::get_local_landmarks() const {
   return local_lms_;
 }
@@ -29,58 +27,175 @@ std::shared_ptr<data::keyframe> local_map_updater::get_nearest_covisibility()
   return nearest_covisibility_;
 }
 
-bool local_map_updater::acquire_local_map(
-    std::unordered_set<unsigned int>& outlier_ids) {
-  const auto local_keyfrms_was_found = find_local_keyframes();
-  const auto local_lms_was_found = find_local_landmarks(outlier_ids);
-  return local_keyfrms_was_found && local_lms_was_found;
-}
+bool local_map_updater::acquire_local_map(const data::frame& curr_frm) {
+  local_map_is_rebuilt_ = false;
+
+  // the cached observations cannot be used if the map graph has been modified
+  const unsigned int graph_epoch = map_db_->graph_epoch_;
+  const bool graph_is_changed = !is_valid_ || graph_epoch != graph_epoch_;
 
-bool local_map_updater::find_local_keyframes() {
-  const auto keyfrm_weights = count_keyframe_weights();
-  if (keyfrm_weights.empty()) {
+  // 1. update the keyframe weights with the difference of the matches
+  const bool keyfrms_are_changed =
+      update_keyframe_weights(curr_frm, graph_is_changed);
+  if (keyfrm_weights_.empty()) {
+    is_valid_ = false;
     return false;
   }
-  std::unordered_set<unsigned int> already_found_ids;
-  const auto first_local_keyfrms =
-      find_first_local_keyframes(keyfrm_weights, already_found_ids);
-  const auto second_local_keyfrms =
-      find_second_local_keyframes(first_local_keyfrms, already_found_ids);
-  local_keyfrms_ = first_local_keyfrms;
-  std::copy(second_local_keyfrms.begin(), second_local_keyfrms.end(),
-            std::back_inserter(local_keyfrms_));
+
+  // 2. search the local map again only if the first-order keyframes, the
+  // nearest covisibility or the map graph have been changed
+  const auto nearest_covisibility = find_nearest_covisibility();
+  if (graph_is_changed || keyfrms_are_changed ||
+      nearest_covisibility != nearest_covisibility_) {
+    nearest_covisibility_ = nearest_covisibility;
+    find_local_keyframes();
+    find_local_landmarks();
+    local_map_is_rebuilt_ = true;
+  }
+
+  graph_epoch_ = graph_epoch;
+  is_valid_ = true;
   return true;
 }
 
-local_map_updater::keyframe_weights_t
-local_map_updater::count_keyframe_weights() const {
-  // count the number of sharing landmarks between the current frame and each of
-  // the neighbor keyframes key: keyframe, value: number of sharing landmarks
-  keyframe_weights_t keyfrm_weights;
-  for (unsigned int idx = 0; idx < num_keypts_; ++idx) {
-    auto& lm = frm_lms_.at(idx);
+bool local_map_updater::local_map_is_rebuilt() const {
+  return local_map_is_rebuilt_;
+}
+
+void local_map_updater::reset() {
+  is_valid_ = false;
+  local_map_is_rebuilt_ = false;
+  matched_lms_.clear();
+  keyfrm_weights_.clear();
+  local_keyfrms_.clear();
+  local_lms_.clear();
+  nearest_covisibility_ = nullptr;
+}
+
+bool local_map_updater::update_keyframe_weights(const data::frame& curr_frm,
+                                                const bool graph_is_changed) {
+  bool keyfrms_are_changed = graph_is_changed;
+  if (graph_is_changed) {
+    matched_lms_.clear();
+    keyfrm_weights_.clear();
+  }
+
+  // count the number of the keypoints associated to each of the landmarks
+  // key: landmark ID, value: landmark and number of the associations
+  std::unordered_map<unsigned int, std::pair<data::landmark*, unsigned int>>
+      curr_matches;
+  curr_matches.reserve(matched_lms_.size());
+  for (unsigned int idx = 0; idx < curr_frm.frm_obs_.num_keypts_; ++idx) {
+    const auto& lm = curr_frm.landmarks_.at(idx);
     if (!lm) {
       continue;
     }
-    const auto observations = lm->get_observations();
-    for (auto obs : observations) {
-      ++keyfrm_weights[obs.first.lock()];
+    auto& match = curr_matches[lm->id_];
+    match.first = lm.get();
+    ++match.second;
+  }
+
+  // apply the difference for the landmarks which were matched in the previous
+  // frame
+  for (auto iter = matched_lms_.begin(); iter != matched_lms_.end();) {
+    auto& matched_lm = iter->second;
+    const auto found = curr_matches.find(iter->first);
+    if (found == curr_matches.end()) {
+      keyfrms_are_changed |= remove_keyframe_weights(
+          matched_lm.observing_keyfrms_, matched_lm.num_matches_);
+      iter = matched_lms_.erase(iter);
+      continue;
     }
+
+    const auto num_matches = found->second.second;
+    if (matched_lm.num_matches_ < num_matches) {
+      keyfrms_are_changed |=
+          add_keyframe_weights(matched_lm.observing_keyfrms_,
+                               num_matches - matched_lm.num_matches_);
+    } else if (num_matches < matched_lm.num_matches_) {
+      keyfrms_are_changed |=
+          remove_keyframe_weights(matched_lm.observing_keyfrms_,
+                                  matched_lm.num_matches_ - num_matches);
+    }
+    matched_lm.num_matches_ = num_matches;
+    curr_matches.erase(found);
+    ++iter;
   }
-  return keyfrm_weights;
+
+  // add the contribution of the newly matched landmarks
+  for (const auto& id_and_match : curr_matches) {
+    auto& matched_lm = matched_lms_[id_and_match.first];
+    matched_lm.num_matches_ = id_and_match.second.second;
+
+    const auto observations = id_and_match.second.first->get_observations();
+    matched_lm.observing_keyfrms_.reserve(observations.size());
+    for (const auto& obs : observations) {
+      auto keyfrm = obs.first.lock();
+      if (!keyfrm) {
+        continue;
+      }
+      matched_lm.observing_keyfrms_.push_back(keyfrm);
+    }
+
+    keyfrms_are_changed |= add_keyframe_weights(matched_lm.observing_keyfrms_,
+                                                matched_lm.num_matches_);
+  }
+
+  return keyfrms_are_changed;
+}
+
+bool local_map_updater::add_keyframe_weights(
+    const std::vector<std::shared_ptr<data::keyframe>>& observing_keyfrms,
+    const unsigned int num_matches) {
+  bool keyfrms_are_changed = false;
+  for (const auto& keyfrm : observing_keyfrms) {
+    auto& weight = keyfrm_weights_[keyfrm];
+    if (weight == 0) {
+      keyfrms_are_changed = true;
+    }
+    weight += num_matches;
+  }
+  return keyfrms_are_changed;
+}
+
+bool local_map_updater::remove_keyframe_weights(
+    const std::vector<std::shared_ptr<data::keyframe>>& observing_keyfrms,
+    const unsigned int num_matches) {
+  bool keyfrms_are_changed = false;
+  for (const auto& keyfrm : observing_keyfrms) {
+    auto iter = keyfrm_weights_.find(keyfrm);
+    if (iter == keyfrm_weights_.end()) {
+      continue;
+    }
+    if (iter->second <= num_matches) {
+      keyfrm_weights_.erase(iter);
+      keyfrms_are_changed = true;
+    } else {
+      iter->second -= num_matches;
+    }
+  }
+  return keyfrms_are_changed;
+}
+
+void local_map_updater::find_local_keyframes() {
+  std::unordered_set<unsigned int> already_found_ids;
+  const auto first_local_keyfrms =
+      find_first_local_keyframes(already_found_ids);
+  const auto second_local_keyfrms =
+      find_second_local_keyframes(first_local_keyfrms, already_found_ids);
+  local_keyfrms_ = first_local_keyfrms;
+  std::copy(second_local_keyfrms.begin(), second_local_keyfrms.end(),
+            std::back_inserter(local_keyfrms_));
 }
 
 auto local_map_updater::find_first_local_keyframes(
-    const keyframe_weights_t& keyfrm_weights,
-    std::unordered_set<unsigned int>& already_found_ids)
+    std::unordered_set<unsigned int>& already_found_ids) const
     -> std::vector<std::shared_ptr<data::keyframe>> {
   std::vector<std::shared_ptr<data::keyframe>> first_local_keyfrms;
-  first_local_keyfrms.reserve(2 * keyfrm_weights.size());
+  first_local_keyfrms.reserve(2 * keyfrm_weights_.size());
 
-  unsigned int max_weight = 0;
-  for (auto& keyfrm_weight : keyfrm_weights) {
+  for (const auto& keyfrm_weight : keyfrm_weights_) {
     const auto& keyfrm = keyfrm_weight.first;
-    const auto weight = keyfrm_weight.second;
 
     if (keyfrm->will_be_erased()) {
       continue;
@@ -90,12 +205,6 @@ auto local_map_updater::find_first_local_keyframes(
 
     // avoid duplication
     already_found_ids.insert(keyfrm->id_);
-
-    // update the nearest keyframe
-    if (max_weight < weight) {
-      max_weight = weight;
-      nearest_covisibility_ = keyfrm;
-    }
   }
 
   return first_local_keyfrms;
@@ -159,8 +268,27 @@ auto local_map_updater::find_second_local_keyframes(
   return second_local_keyfrms;
 }
 
-bool local_map_updater::find_local_landmarks(
-    std::unordered_set<unsigned int>& outlier_ids) {
+std::shared_ptr<data::keyframe> local_map_updater::find_nearest_covisibility()
+    const {
+  std::shared_ptr<data::keyframe> nearest_covisibility = nullptr;
+  unsigned int max_weight = 0;
+  for (const auto& keyfrm_weight : keyfrm_weights_) {
+    const auto& keyfrm = keyfrm_weight.first;
+    const auto weight = keyfrm_weight.second;
+
+    if (keyfrm->will_be_erased()) {
+      continue;
+    }
+
+    if (max_weight < weight) {
+      max_weight = weight;
+      nearest_covisibility = keyfrm;
+    }
+  }
+  return nearest_covisibility;
+}
+
+void local_map_updater::find_local_landmarks() {
   local_lms_.clear();
   local_lms_.reserve(50 * local_keyfrms_.size());
 
@@ -176,9 +304,6 @@ bool local_map_updater::find_local_landmarks(
         continue;
       }
 
-      if (outlier_ids.count(lm->id_)) {
-        continue;
-      }
       // avoid duplication
       if (already_found_ids.count(lm->id_)) {
         continue;
@@ -188,8 +313,6 @@ bool local_map_updater::find_local_landmarks(
       local_lms_.push_back(lm);
     }
   }
-
-  return true;
 }
 
 }  // namespace module
@@ -12,45 +12,75 @@ namespace data {
 class frame;
 class keyframe;
 class landmark;
+class map_database;
 }  // namespace data
 
 namespace module {
 
+/**
+ * Local map updater, which keeps the local map of the previous frame and
+ * updates it incrementally
+ * (the keyframe weights are updated from the difference of the matched
+ * landmarks, and the second-order keyframes and the local landmarks are
+ * searched again only if the first-order keyframes, the nearest covisibility
+ * or the map graph have been changed)
+ */
 class local_map_updater {
  public:
   using keyframe_weights_t =
       std::unordered_map<std::shared_ptr<data::keyframe>, unsigned int>;
 
   //! Constructor
-  explicit local_map_updater(const data::frame& curr_frm,
-                             const unsigned int max_num_local_keyfrms);
+  local_map_updater(data::map_database* map_db,
+                    const unsigned int max_num_local_keyfrms);
 
   //! Destructor
   ~local_map_updater() = default;
 
   //! Get the local keyframes
-  std::vector<std::shared_ptr<data::keyframe>> get_local_keyframes() const;
+  const std::vector<std::shared_ptr<data::keyframe>>& get_local_keyframes()
+      const;
 
   //! Get the local landmarks
-  std::vector<std::shared_ptr<data::landmark>> get_local_landmarks() const;
+  //! (NOTE: the outliers of the current frame are not excluded)
+  const std::vector<std::shared_ptr<data::landmark>>& get_local_landmarks()
+      const;
 
   //! Get the nearest covisibility
   std::shared_ptr<data::keyframe> get_nearest_covisibility() const;
 
-  //! Acquire the new local map
-  bool acquire_local_map(std::unordered_set<unsigned int>& outlier_ids);
+  //! Acquire the local map of the current frame
+  bool acquire_local_map(const data::frame& curr_frm);
+
+  //! Return true if the local keyframes and landmarks were searched again in
+  //! the last acquire_local_map()
+  bool local_map_is_rebuilt() const;
+
+  //! Discard the cached local map
+  void reset();
 
  private:
-  //! Find the local keyframes
-  bool find_local_keyframes();
+  //! Update the keyframe weights from the landmarks observed in the frame
+  //! (returns true if the set of the weighted keyframes has been changed)
+  bool update_keyframe_weights(const data::frame& curr_frm,
+                               const bool graph_is_changed);
+
+  //! Add the contribution of the landmark to the keyframe weights
+  bool add_keyframe_weights(const std::vector<std::shared_ptr<data::keyframe>>&
+                                observing_keyfrms,
+                            const unsigned int num_matches);
+
+  //! Remove the contribution of the landmark from the keyframe weights
+  bool remove_keyframe_weights(
+      const std::vector<std::shared_ptr<data::keyframe>>& observing_keyfrms,
+      const unsigned int num_matches);
 
-  //! Compute keyframe weights
-  keyframe_weights_t count_keyframe_weights() const;
+  //! Find the local keyframes
+  void find_local_keyframes();
 
   //! Find the first-order local keyframes
   auto find_first_local_keyframes(
-      const keyframe_weights_t& keyfrm_weights,
-      std::unordered_set<unsigned int>& already_found_ids)
+      std::unordered_set<unsigned int>& already_found_ids) const
       -> std::vector<std::shared_ptr<data::keyframe>>;
 
   //! Find the second-order local keyframes
@@ -59,24 +89,42 @@ class local_map_updater {
       std::unordered_set<unsigned int>& already_found_ids) const
       -> std::vector<std::shared_ptr<data::keyframe>>;
 
+  //! Find the nearest keyframe in covisibility graph
+  std::shared_ptr<data::keyframe> find_nearest_covisibility() const;
+
   //! Find the local landmarks
-  bool find_local_landmarks(std::unordered_set<unsigned int>& outlier_ids);
-
-  // frame ID
-  const unsigned int frm_id_;
-  // landmark associations
-  const std::vector<std::shared_ptr<data::landmark>> frm_lms_;
-  // the number of keypoints
-  const unsigned int num_keypts_;
+  void find_local_landmarks();
+
+  //! matched landmark in the previous frame
+  struct matched_landmark {
+    //! number of the keypoints which are associated to the landmark
+    unsigned int num_matches_ = 0;
+    //! keyframes which observed the landmark
+    std::vector<std::shared_ptr<data::keyframe>> observing_keyfrms_;
+  };
+
+  // map database whose graph epoch is checked
+  data::map_database* const map_db_;
   // maximum number of the local keyframes
   const unsigned int max_num_local_keyfrms_;
 
+  // true if the cached local map is valid
+  bool is_valid_ = false;
+  // true if the local map was searched again in the last update
+  bool local_map_is_rebuilt_ = false;
+  // graph epoch of the map database when the local map was found
+  unsigned int graph_epoch_ = 0;
+
+  // matched landmarks in the previous frame (key: landmark ID)
+  std::unordered_map<unsigned int, matched_landmark> matched_lms_;
+  // number of the sharing landmarks between the frame and each of the keyframes
+  keyframe_weights_t keyfrm_weights_;
+
   // found local keyframes
   std::vector<std::shared_ptr<data::keyframe>> local_keyfrms_;
   // found local landmarks
   std::vector<std::shared_ptr<data::landmark>> local_lms_;
-  // the nearst keyframe in covisibility graph, which will be found in
-  // find_first_local_keyframes()
+  // the nearst keyframe in covisibility graph
   std::shared_ptr<data::keyframe> nearest_covisibility_;
 };
 
@@ -9,13 +9,28 @@
 #include "openvslam/data/map_database.h"
 #include "openvslam/mapping_module.h"
 #include "openvslam/optimize/global_bundle_adjuster.h"
+#include "openvslam/optimize/hierarchical_bundle_adjuster.h"
+#include "openvslam/optimize/job_scheduler.h"
+#include "openvslam/util/converter.h"
 
 namespace openvslam {
 namespace module {
 
+loop_bundle_adjuster::loop_bundle_adjuster(
+    data::map_database* map_db, const unsigned int num_iter,
+    const unsigned int num_keyfrms_per_submap,
+    const unsigned int min_num_keyfrms_to_split)
+    : map_db_(map_db),
+      num_iter_(num_iter),
+      num_keyfrms_per_submap_(num_keyfrms_per_submap),
+      min_num_keyfrms_to_split_(min_num_keyfrms_to_split) {}
+
 loop_bundle_adjuster::loop_bundle_adjuster(data::map_database* map_db,
-                                           const unsigned int num_iter)
-    : map_db_(map_db), num_iter_(num_iter) {}
+                                           const YAML::Node& yaml_node)
+    : loop_bundle_adjuster(
+          map_db, yaml_node["num_iter"].as<unsigned int>(10),
+          yaml_node["num_keyframes_per_submap"].as<unsigned int>(0),
+          yaml_node["min_num_keyframes_to_split"].as<unsigned int>(0)) {}
 
 void loop_bundle_adjuster::set_mapping_module(mapping_module* mapper) {
   mapper_ = mapper;
@@ -26,24 +41,12 @@ void loop_bundle_adjuster::count_loop_BA_execution() {
   ++num_exec_loop_BA_;
 }
 
-void loop_bundle_adjuster::abort() {
-  std::lock_guard<std::mutex> lock(mtx_thread_);
-  abort_loop_BA_ = true;
-}
-
-bool loop_bundle_adjuster::is_running() const {
-  std::lock_guard<std::mutex> lock(mtx_thread_);
-  return loop_BA_is_running_;
-}
-
-void loop_bundle_adjuster::optimize() {
+void loop_bundle_adjuster::optimize(const optimize::cancellation_token& token) {
   spdlog::info("start loop bundle adjustment");
 
   unsigned int num_exec_loop_BA = 0;
   {
     std::lock_guard<std::mutex> lock(mtx_thread_);
-    loop_BA_is_running_ = true;
-    abort_loop_BA_ = false;
     num_exec_loop_BA = num_exec_loop_BA_;
   }
 
@@ -52,40 +55,99 @@ void loop_bundle_adjuster::optimize() {
   eigen_alloc_unord_map<unsigned int, Vec3_t> lm_to_pos_w_after_global_BA;
   eigen_alloc_unord_map<unsigned int, Mat44_t>
       keyfrm_to_pose_cw_after_global_BA;
-  const auto global_BA =
-      optimize::global_bundle_adjuster(map_db_, num_iter_, false);
-  global_BA.optimize(optimized_keyfrm_ids, optimized_landmark_ids,
-                     lm_to_pos_w_after_global_BA,
-                     keyfrm_to_pose_cw_after_global_BA, &abort_loop_BA_);
+  // the map is updated by the commits of the submaps, not after the BA
+  bool is_committed_per_submap = false;
+  // IDs of the keyframes and the landmarks which have been committed
+  std::unordered_set<unsigned int> committed_keyfrm_ids;
+  std::unordered_set<unsigned int> committed_lm_ids;
+
+  if (0 < num_keyfrms_per_submap_ &&
+      min_num_keyfrms_to_split_ <= map_db_->get_num_keyframes()) {
+    is_committed_per_submap = true;
+    // commit the result of each submap as soon as it is optimized
+    const auto commit_callback =
+        [this, num_exec_loop_BA, &token, &committed_keyfrm_ids,
+         &committed_lm_ids](
+            const eigen_alloc_unord_map<unsigned int, Mat44_t>&
+                keyfrm_to_pose_cw,
+            const eigen_alloc_unord_map<unsigned int, Vec3_t>& lm_to_pos_w) {
+          std::lock_guard<std::mutex> lock(mtx_thread_);
+          if (num_exec_loop_BA != num_exec_loop_BA_) {
+            return;
+          }
+          // the cancellation during the commit is applied after it
+          if (!token.begin_commit()) {
+            return;
+          }
+          commit(keyfrm_to_pose_cw, lm_to_pos_w, committed_keyfrm_ids,
+                 committed_lm_ids);
+          token.end_commit();
+        };
+    const auto hierarchical_BA = optimize::hierarchical_bundle_adjuster(
+        map_db_, num_keyfrms_per_submap_, num_iter_, false);
+    hierarchical_BA.optimize(optimized_keyfrm_ids, optimized_landmark_ids,
+                             lm_to_pos_w_after_global_BA,
+                             keyfrm_to_pose_cw_after_global_BA, commit_callback,
+                             token.get_force_stop_flag());
+  } else {
+    const auto global_BA =
+        optimize::global_bundle_adjuster(map_db_, num_iter_, false);
+    global_BA.optimize(optimized_keyfrm_ids, optimized_landmark_ids,
+                       lm_to_pos_w_after_global_BA,
+                       keyfrm_to_pose_cw_after_global_BA,
+                       token.get_force_stop_flag());
+  }
 
   {
     std::lock_guard<std::mutex> lock1(mtx_thread_);
 
     // if count_loop_BA_execution() was called during the loop BA or the loop BA
     // was aborted, cannot update the map
-    if (num_exec_loop_BA != num_exec_loop_BA_ || abort_loop_BA_) {
+    if (num_exec_loop_BA != num_exec_loop_BA_ || token.is_cancelled()) {
       spdlog::info("abort loop bundle adjustment");
-      loop_BA_is_running_ = false;
-      abort_loop_BA_ = false;
       return;
     }
 
     spdlog::info("finish loop bundle adjustment");
+    if (is_committed_per_submap) {
+      // the corrections have been propagated by the commits
+      // (the job is not run again after all of the submaps are committed)
+      if (!token.begin_commit()) {
+        spdlog::info("abort loop bundle adjustment");
+        return;
+      }
+      spdlog::info("updated the map by {} keyframes and {} landmarks",
+                   committed_keyfrm_ids.size(), committed_lm_ids.size());
+      return;
+    }
     spdlog::info("updating the map with pose propagation");
 
     // stop mapping module
     auto future_pause = mapper_->async_pause();
     while (future_pause.wait_for(std::chrono::milliseconds(1)) ==
            std::future_status::timeout) {
+      // the local BA which is submitted after the pause request can be queued
+      // behind this job when the scheduler has only one worker
+      mapper_->abort_local_BA();
       while (mapper_->is_terminated()) {
         break;
       }
     }
 
-    std::lock_guard<std::mutex> lock2(data::map_database::mtx_database_);
+    // the job can be preempted while waiting for the mapping module
+    // (the result is not committed so that the job is run again)
+    if (!token.begin_commit()) {
+      mapper_->resume();
+      spdlog::info("abort loop bundle adjustment");
+      return;
+    }
 
+    std::lock_guard<std::mutex> lock2(map_db_->mtx_database_);
+
+    // camera poses BEFORE the correction (for the pose propagation)
     eigen_alloc_unord_map<unsigned int, Mat44_t>
         keyfrm_to_cam_pose_cw_before_BA;
+
     // update the camera pose along the spanning tree from the origin
     std::list<std::shared_ptr<data::keyframe>> keyfrms_to_check;
     keyfrms_to_check.push_back(map_db_->origin_keyfrm_);
@@ -161,12 +223,124 @@ void loop_bundle_adjuster::optimize() {
       }
     }
 
+    ++map_db_->correction_epoch_;
+
     mapper_->resume();
-    loop_BA_is_running_ = false;
 
     spdlog::info("updated the map");
   }
 }
 
+void loop_bundle_adjuster::commit(
+    const eigen_alloc_unord_map<unsigned int, Mat44_t>&
+        keyfrm_to_pose_cw_after_global_BA,
+    const eigen_alloc_unord_map<unsigned int, Vec3_t>&
+        lm_to_pos_w_after_global_BA,
+    std::unordered_set<unsigned int>& committed_keyfrm_ids,
+    std::unordered_set<unsigned int>& committed_lm_ids) const {
+  std::lock_guard<std::mutex> lock(map_db_->mtx_database_);
+
+  // camera poses BEFORE this commit of the keyframes which are moved by it
+  eigen_alloc_unord_map<unsigned int, Mat44_t> keyfrm_to_cam_pose_cw_before;
+  std::list<std::shared_ptr<data::keyframe>> keyfrms_to_check;
+
+  for (const auto& id_pose : keyfrm_to_pose_cw_after_global_BA) {
+    auto keyfrm = map_db_->get_keyframe(id_pose.first);
+    if (!keyfrm) {
+      continue;
+    }
+    if (keyfrm->will_be_erased()) {
+      continue;
+    }
+    keyfrm_to_cam_pose_cw_before[keyfrm->id_] = keyfrm->get_cam_pose();
+    keyfrm->set_cam_pose(id_pose.second);
+    committed_keyfrm_ids.insert(keyfrm->id_);
+    keyfrms_to_check.push_back(keyfrm);
+  }
+
+  // propagate the correction along the spanning tree to the keyframes which
+  // have not been committed
+  // (the keyframes created after the commit of their parent are consistent
+  // with the corrected parent, and the ones committed later are overwritten)
+  while (!keyfrms_to_check.empty()) {
+    auto parent = keyfrms_to_check.front();
+    keyfrms_to_check.pop_front();
+    const Mat44_t cam_pose_wp_before = util::converter::inverse_pose(
+        keyfrm_to_cam_pose_cw_before.at(parent->id_));
+    const Mat44_t cam_pose_pw = parent->get_cam_pose();
+
+    const auto children = parent->graph_node_->get_spanning_children();
+    for (const auto& child : children) {
+      if (committed_keyfrm_ids.count(child->id_)) {
+        continue;
+      }
+      if (keyfrm_to_cam_pose_cw_before.count(child->id_)) {
+        continue;
+      }
+      const Mat44_t cam_pose_cw_before = child->get_cam_pose();
+      keyfrm_to_cam_pose_cw_before[child->id_] = cam_pose_cw_before;
+      // world->child AFTER correction = parent->child * world->parent AFTER
+      // correction
+      const Mat44_t cam_pose_cp = cam_pose_cw_before * cam_pose_wp_before;
+      child->set_cam_pose(cam_pose_cp * cam_pose_pw);
+      keyfrms_to_check.push_back(child);
+    }
+  }
+
+  for (const auto& id_pos : lm_to_pos_w_after_global_BA) {
+    auto lm = map_db_->get_landmark(id_pos.first);
+    if (!lm) {
+      continue;
+    }
+    if (lm->will_be_erased()) {
+      continue;
+    }
+    lm->set_pos_in_world(id_pos.second);
+    committed_lm_ids.insert(lm->id_);
+  }
+
+  // the landmarks which have not been committed follow the reference
+  // keyframes
+  const auto landmarks = map_db_->get_all_landmarks();
+  for (const auto& lm : landmarks) {
+    if (!lm) {
+      continue;
+    }
+    if (lm->will_be_erased()) {
+      continue;
+    }
+    if (committed_lm_ids.count(lm->id_)) {
+      continue;
+    }
+    const auto ref_keyfrm = lm->get_ref_keyframe();
+    if (!ref_keyfrm) {
+      continue;
+    }
+    const auto cam_pose_cw_before =
+        keyfrm_to_cam_pose_cw_before.find(ref_keyfrm->id_);
+    if (cam_pose_cw_before == keyfrm_to_cam_pose_cw_before.end()) {
+      continue;
+    }
+
+    // convert the position to the camera-reference using the camera pose
+    // BEFORE the commit
+    const Mat33_t rot_cw_before = cam_pose_cw_before->second.block<3, 3>(0, 0);
+    const Vec3_t trans_cw_before = cam_pose_cw_before->second.block<3, 1>(0, 3);
+    const Vec3_t pos_c =
+        rot_cw_before * lm->get_pos_in_world() + trans_cw_before;
+
+    // convert the position to the world-reference using the camera pose
+    // AFTER the commit
+    const Mat44_t cam_pose_wc = ref_keyfrm->get_cam_pose_inv();
+    const Mat33_t rot_wc = cam_pose_wc.block<3, 3>(0, 0);
+    const Vec3_t trans_wc = cam_pose_wc.block<3, 1>(0, 3);
+    lm->set_pos_in_world(rot_wc * pos_c + trans_wc);
+  }
+
+  // the local BA which has started before this commit does not overwrite it
+  // (the mapping module is not paused for the commits of the submaps)
+  ++map_db_->correction_epoch_;
+}
+
 }  // namespace module
 }  // namespace openvslam
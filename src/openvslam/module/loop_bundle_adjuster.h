@@ -1,7 +1,12 @@
 #ifndef OPENVSLAM_MODULE_LOOP_BUNDLE_ADJUSTER_H
 #define OPENVSLAM_MODULE_LOOP_BUNDLE_ADJUSTER_H
 
+#include <yaml-cpp/node/node.h>
+
 #include <mutex>
+#include <unordered_set>
+
+#include "openvslam/type.h"
 
 namespace openvslam {
 
@@ -11,6 +16,10 @@ namespace data {
 class map_database;
 }  // namespace data
 
+namespace optimize {
+class cancellation_token;
+}  // namespace optimize
+
 namespace module {
 
 class loop_bundle_adjuster {
@@ -19,7 +28,16 @@ class loop_bundle_adjuster {
    * Constructor
    */
   explicit loop_bundle_adjuster(data::map_database* map_db,
-                                const unsigned int num_iter = 10);
+                                const unsigned int num_iter = 10,
+                                const unsigned int num_keyfrms_per_submap = 0,
+                                const unsigned int min_num_keyfrms_to_split =
+                                    0);
+
+  /**
+   * Constructor
+   */
+  loop_bundle_adjuster(data::map_database* map_db,
+                       const YAML::Node& yaml_node);
 
   /**
    * Destructor
@@ -37,21 +55,30 @@ class loop_bundle_adjuster {
   void count_loop_BA_execution();
 
   /**
-   * Abort loop BA externally
-   */
-  void abort();
-
-  /**
-   * Loop BA is running or not
+   * Run loop BA
+   * (the map is not updated after the token is cancelled, and the token is
+   * not cancelled any more once the whole result is committed)
    */
-  bool is_running() const;
+  void optimize(const optimize::cancellation_token& token);
 
+ private:
   /**
-   * Run loop BA
+   * Apply the optimized poses and positions of a submap to the map
+   * (NOTE: the correction is propagated at once to the keyframes and the
+   * landmarks which have not been committed, including the ones created
+   * after the partition, so that they are never corrected twice)
+   * @param keyfrm_to_pose_cw_after_global_BA
+   * @param lm_to_pos_w_after_global_BA
+   * @param committed_keyfrm_ids IDs of the keyframes which have been committed
+   * @param committed_lm_ids IDs of the landmarks which have been committed
    */
-  void optimize();
+  void commit(const eigen_alloc_unord_map<unsigned int, Mat44_t>&
+                  keyfrm_to_pose_cw_after_global_BA,
+              const eigen_alloc_unord_map<unsigned int, Vec3_t>&
+                  lm_to_pos_w_after_global_BA,
+              std::unordered_set<unsigned int>& committed_keyfrm_ids,
+              std::unordered_set<unsigned int>& committed_lm_ids) const;
 
- private:
   //! map database
   data::map_database* map_db_ = nullptr;
 
@@ -61,6 +88,13 @@ class loop_bundle_adjuster {
   //! number of iteration for optimization
   const unsigned int num_iter_ = 10;
 
+  //! maximum number of keyframes in a submap of the hierarchical BA
+  //! (0: always optimize the whole map as one problem)
+  const unsigned int num_keyfrms_per_submap_ = 0;
+
+  //! minimum number of keyframes to switch to the hierarchical BA
+  const unsigned int min_num_keyfrms_to_split_ = 0;
+
   //-----------------------------------------
   // thread management
 
@@ -69,12 +103,6 @@ class loop_bundle_adjuster {
 
   //! number of times loop BA is performed
   unsigned int num_exec_loop_BA_ = 0;
-
-  //! flag to abort loop BA
-  bool abort_loop_BA_ = false;
-
-  //! flag which indicates loop BA is running or not
-  bool loop_BA_is_running_ = false;
 };
 
 }  // namespace module
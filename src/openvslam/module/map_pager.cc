@@ -0,0 +1,291 @@
+#include "openvslam/module/map_pager.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <nlohmann/json.hpp>
+
+#include "openvslam/data/bow_database.h"
+#include "openvslam/data/keyframe.h"
+#include "openvslam/data/map_database.h"
+
+namespace openvslam {
+namespace module {
+
+map_pager::map_pager(data::camera_database* cam_db,
+                     data::orb_params_database* orb_params_db,
+                     data::map_database* map_db, data::bow_database* bow_db,
+                     data::bow_vocabulary* bow_vocab,
+                     const io::map_tile_index& index,
+                     const unsigned int tile_radius,
+                     const double memory_budget_mb,
+                     const unsigned int num_relocalization_tiles)
+    : cam_db_(cam_db),
+      orb_params_db_(orb_params_db),
+      map_db_(map_db),
+      bow_db_(bow_db),
+      bow_vocab_(bow_vocab),
+      index_(index),
+      tile_radius_(tile_radius),
+      memory_budget_(static_cast<std::size_t>(memory_budget_mb * 1024 * 1024)),
+      num_relocalization_tiles_(num_relocalization_tiles),
+      worker_(&map_pager::run, this) {
+  spdlog::debug("CONSTRUCT: module::map_pager");
+}
+
+map_pager::map_pager(const YAML::Node& yaml_node,
+                     data::camera_database* cam_db,
+                     data::orb_params_database* orb_params_db,
+                     data::map_database* map_db, data::bow_database* bow_db,
+                     data::bow_vocabulary* bow_vocab,
+                     const io::map_tile_index& index)
+    : map_pager(cam_db, orb_params_db, map_db, bow_db, bow_vocab, index,
+                yaml_node["tile_radius"].as<unsigned int>(1),
+                yaml_node["memory_budget_mb"].as<double>(512.0),
+                yaml_node["num_relocalization_tiles"].as<unsigned int>(3)) {}
+
+map_pager::~map_pager() {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    terminate_is_requested_ = true;
+  }
+  cv_.notify_all();
+  worker_.join();
+  spdlog::debug("DESTRUCT: module::map_pager");
+}
+
+void map_pager::request_tiles_around(const Vec3_t& cam_center) {
+  const auto center_key = index_.get_key(cam_center);
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    // the same tiles have been requested already
+    if (center_key_is_valid_ && center_key == last_center_key_) {
+      return;
+    }
+    last_center_key_ = center_key;
+    center_key_is_valid_ = true;
+  }
+
+  const int radius = static_cast<int>(tile_radius_);
+  std::vector<io::map_tile_key> keys;
+  for (int dx = -radius; dx <= radius; ++dx) {
+    for (int dy = -radius; dy <= radius; ++dy) {
+      for (int dz = -radius; dz <= radius; ++dz) {
+        io::map_tile_key key;
+        key.x_ = center_key.x_ + dx;
+        key.y_ = center_key.y_ + dy;
+        key.z_ = center_key.z_ + dz;
+        if (index_.keyfrm_ids_in_tiles_.count(key)) {
+          keys.push_back(key);
+        }
+      }
+    }
+  }
+  request_tiles(keys);
+}
+
+void map_pager::request_tiles_for_relocalization(
+    const data::bow_vector& bow_vec) {
+  // count the visual words shared with each of the tiles
+  std::unordered_map<io::map_tile_key, unsigned int, io::map_tile_key_hash>
+      num_common_words;
+  for (const auto& word_weight : bow_vec) {
+    const auto itr = index_.tiles_in_words_.find(word_weight.first);
+    if (itr == index_.tiles_in_words_.end()) {
+      continue;
+    }
+    for (const auto& key : itr->second) {
+      ++num_common_words[key];
+    }
+  }
+
+  // request the top-n tiles
+  std::vector<std::pair<unsigned int, io::map_tile_key>> scored_keys;
+  scored_keys.reserve(num_common_words.size());
+  for (const auto& key_num : num_common_words) {
+    scored_keys.emplace_back(key_num.second, key_num.first);
+  }
+  const auto num_keys =
+      std::min<std::size_t>(num_relocalization_tiles_, scored_keys.size());
+  std::partial_sort(scored_keys.begin(), scored_keys.begin() + num_keys,
+                    scored_keys.end(),
+                    [](const std::pair<unsigned int, io::map_tile_key>& a,
+                       const std::pair<unsigned int, io::map_tile_key>& b) {
+                      return a.first > b.first;
+                    });
+
+  std::vector<io::map_tile_key> keys;
+  keys.reserve(num_keys);
+  for (unsigned int i = 0; i < num_keys; ++i) {
+    keys.push_back(scored_keys.at(i).second);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    // the tiles around the pose should be requested again after relocalization
+    center_key_is_valid_ = false;
+  }
+  request_tiles(keys);
+}
+
+void map_pager::request_tiles(const std::vector<io::map_tile_key>& keys) {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    requested_keys_ = keys;
+    request_is_pending_ = true;
+  }
+  cv_.notify_all();
+}
+
+void map_pager::wait_until_idle() {
+  std::unique_lock<std::mutex> lock(mtx_);
+  cv_.wait(lock, [this] { return !request_is_pending_ && !is_busy_; });
+}
+
+unsigned int map_pager::get_num_resident_tiles() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return resident_tiles_.size();
+}
+
+std::size_t map_pager::get_resident_memory_footprint() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  std::size_t memory_footprint = 0;
+  for (const auto& key_tile : resident_tiles_) {
+    memory_footprint += key_tile.second.memory_footprint_;
+  }
+  return memory_footprint;
+}
+
+void map_pager::run() {
+  while (true) {
+    std::vector<io::map_tile_key> keys;
+    {
+      std::unique_lock<std::mutex> lock(mtx_);
+      cv_.wait(lock,
+               [this] { return terminate_is_requested_ || request_is_pending_; });
+      if (terminate_is_requested_) {
+        break;
+      }
+      // only the latest request is processed
+      keys = requested_keys_;
+      request_is_pending_ = false;
+      is_busy_ = true;
+    }
+
+    try {
+      load_tiles(keys);
+      evict_tiles(keys);
+    } catch (const std::exception& e) {
+      spdlog::error("failed to page the map tiles: {}", e.what());
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      is_busy_ = false;
+    }
+    cv_.notify_all();
+  }
+}
+
+void map_pager::load_tiles(const std::vector<io::map_tile_key>& keys) {
+  unsigned long stamp;
+  std::vector<io::map_tile_key> keys_to_load;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    stamp = ++request_stamp_;
+    for (const auto& key : keys) {
+      const auto itr = resident_tiles_.find(key);
+      if (itr != resident_tiles_.end()) {
+        itr->second.last_requested_ = stamp;
+      } else {
+        keys_to_load.push_back(key);
+      }
+    }
+  }
+
+  for (const auto& key : keys_to_load) {
+    // read and decode the tile without locking the map database
+    // (the decoded keyframes are not visible from the other modules yet)
+    const auto json_tile = io::map_tile_io::load_tile(index_.get_tile_path(key));
+    const auto& json_keyfrms = json_tile.at("keyframes");
+    const auto& json_landmarks = json_tile.at("landmarks");
+    const auto use_bow_cache =
+        data::map_database::bow_cache_is_valid(bow_vocab_, json_keyfrms);
+    std::vector<std::shared_ptr<data::keyframe>> keyfrms;
+    keyfrms.reserve(json_keyfrms.size());
+    for (const auto& json_id_keyfrm : json_keyfrms.items()) {
+      const auto id = std::stoi(json_id_keyfrm.key());
+      assert(0 <= id);
+      keyfrms.push_back(map_db_->decode_keyframe(cam_db_, orb_params_db_,
+                                                 bow_vocab_, id,
+                                                 json_id_keyfrm.value(),
+                                                 use_bow_cache));
+    }
+
+    // splice the tile into the map database
+    std::vector<std::shared_ptr<data::keyframe>> new_keyfrms;
+    {
+      std::lock_guard<std::mutex> lock(map_db_->mtx_database_);
+      new_keyfrms = map_db_->add_tile(keyfrms, json_keyfrms, json_landmarks);
+      for (const auto& keyfrm : new_keyfrms) {
+        bow_db_->add_keyframe(keyfrm);
+      }
+    }
+
+    resident_tile tile;
+    for (const auto& keyfrm : new_keyfrms) {
+      tile.memory_footprint_ += keyfrm->frm_obs_.get_memory_footprint();
+    }
+    tile.last_requested_ = stamp;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      resident_tiles_[key] = tile;
+    }
+    spdlog::debug("load the map tile ({}, {}, {}) with {} keyframes", key.x_,
+                  key.y_, key.z_, new_keyfrms.size());
+  }
+}
+
+void map_pager::evict_tiles(const std::vector<io::map_tile_key>& keys) {
+  while (get_resident_memory_footprint() > memory_budget_) {
+    // find the least recently used tile which is not requested now
+    io::map_tile_key lru_key;
+    bool lru_key_is_found = false;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      unsigned long min_stamp = request_stamp_ + 1;
+      for (const auto& key_tile : resident_tiles_) {
+        if (std::find(keys.begin(), keys.end(), key_tile.first) != keys.end()) {
+          continue;
+        }
+        if (key_tile.second.last_requested_ < min_stamp) {
+          min_stamp = key_tile.second.last_requested_;
+          lru_key = key_tile.first;
+          lru_key_is_found = true;
+        }
+      }
+    }
+    if (!lru_key_is_found) {
+      spdlog::warn("the requested map tiles exceed the memory budget");
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(map_db_->mtx_database_);
+      const auto erased_keyfrms =
+          map_db_->erase_tile(index_.keyfrm_ids_in_tiles_.at(lru_key));
+      for (const auto& keyfrm : erased_keyfrms) {
+        bow_db_->erase_keyframe(keyfrm);
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      resident_tiles_.erase(lru_key);
+    }
+    spdlog::debug("evict the map tile ({}, {}, {})", lru_key.x_, lru_key.y_,
+                  lru_key.z_);
+  }
+}
+
+}  // namespace module
+}  // namespace openvslam
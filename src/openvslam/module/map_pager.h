@@ -0,0 +1,143 @@
+#ifndef OPENVSLAM_MODULE_MAP_PAGER_H
+#define OPENVSLAM_MODULE_MAP_PAGER_H
+
+#include <yaml-cpp/node/node.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "openvslam/data/bow_vocabulary.h"
+#include "openvslam/io/map_tile_io.h"
+#include "openvslam/type.h"
+
+namespace openvslam {
+
+namespace data {
+class camera_database;
+class orb_params_database;
+class map_database;
+class bow_database;
+}  // namespace data
+
+namespace module {
+
+/**
+ * Pager of the tiled map database for localization mode
+ * (the tiles around the tracked pose and the tiles which are likely to contain
+ * the relocalization candidates are loaded on the worker thread, and the least
+ * recently used tiles are evicted to keep the memory budget)
+ */
+class map_pager {
+ public:
+  //! Constructor
+  map_pager(data::camera_database* cam_db,
+            data::orb_params_database* orb_params_db,
+            data::map_database* map_db, data::bow_database* bow_db,
+            data::bow_vocabulary* bow_vocab, const io::map_tile_index& index,
+            const unsigned int tile_radius = 1,
+            const double memory_budget_mb = 512.0,
+            const unsigned int num_relocalization_tiles = 3);
+
+  map_pager(const YAML::Node& yaml_node, data::camera_database* cam_db,
+            data::orb_params_database* orb_params_db,
+            data::map_database* map_db, data::bow_database* bow_db,
+            data::bow_vocabulary* bow_vocab, const io::map_tile_index& index);
+
+  //! Destructor (the worker thread is joined)
+  ~map_pager();
+
+  //! Request the tiles around the camera center
+  //! (returns immediately, the tiles are loaded asynchronously)
+  void request_tiles_around(const Vec3_t& cam_center);
+
+  //! Request the tiles which share the most visual words with the BoW vector
+  //! (returns immediately, the tiles are loaded asynchronously)
+  void request_tiles_for_relocalization(const data::bow_vector& bow_vec);
+
+  //! Block until the worker thread finishes the pending request
+  void wait_until_idle();
+
+  //! Get the number of the tiles loaded in the map database
+  unsigned int get_num_resident_tiles() const;
+
+  //! Get the number of bytes of the keyframe observations in the resident
+  //! tiles
+  std::size_t get_resident_memory_footprint() const;
+
+ private:
+  //! Tile loaded in the map database
+  struct resident_tile {
+    //! number of bytes of the keyframe observations
+    std::size_t memory_footprint_ = 0;
+    //! stamp of the last request which contains the tile
+    unsigned long last_requested_ = 0;
+  };
+
+  //! Replace the pending request with the keys
+  void request_tiles(const std::vector<io::map_tile_key>& keys);
+
+  //! Main loop of the worker thread
+  void run();
+
+  //! Load the requested tiles which are not resident
+  void load_tiles(const std::vector<io::map_tile_key>& keys);
+
+  //! Evict the least recently used tiles until the memory budget is satisfied
+  //! (the requested tiles are never evicted)
+  void evict_tiles(const std::vector<io::map_tile_key>& keys);
+
+  //! camera database
+  data::camera_database* const cam_db_;
+  //! orb_params database
+  data::orb_params_database* const orb_params_db_;
+  //! map database
+  data::map_database* const map_db_;
+  //! BoW database
+  data::bow_database* const bow_db_;
+  //! BoW vocabulary
+  data::bow_vocabulary* const bow_vocab_;
+
+  //! index of the tiled map database
+  const io::map_tile_index index_;
+
+  //! number of the neighboring tiles which are loaded along each axis
+  const unsigned int tile_radius_;
+  //! memory budget of the keyframe observations [byte]
+  const std::size_t memory_budget_;
+  //! number of the tiles which are loaded for relocalization
+  const unsigned int num_relocalization_tiles_;
+
+  //! mutex for the request and the resident tiles
+  mutable std::mutex mtx_;
+  //! condition variable to wake up the worker thread
+  std::condition_variable cv_;
+  //! tiles of the pending request
+  std::vector<io::map_tile_key> requested_keys_;
+  //! a request is pending or not
+  bool request_is_pending_ = false;
+  //! the worker thread is processing a request or not
+  bool is_busy_ = false;
+  //! the worker thread should be terminated or not
+  bool terminate_is_requested_ = false;
+  //! the center tile of the last request by request_tiles_around()
+  io::map_tile_key last_center_key_;
+  //! request_tiles_around() has been called or not
+  bool center_key_is_valid_ = false;
+
+  //! tiles loaded in the map database
+  std::unordered_map<io::map_tile_key, resident_tile, io::map_tile_key_hash>
+      resident_tiles_;
+  //! stamp of the request which is processed last
+  unsigned long request_stamp_ = 0;
+
+  //! worker thread
+  std::thread worker_;
+};
+
+}  // namespace module
+}  // namespace openvslam
+
+#endif  // OPENVSLAM_MODULE_MAP_PAGER_H
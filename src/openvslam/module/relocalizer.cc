@@ -15,9 +15,11 @@ relocalizer::relocalizer(const double bow_match_lowe_ratio,
                          const double proj_match_lowe_ratio,
                          const double robust_match_lowe_ratio,
                          const unsigned int min_num_bow_matches,
-                         const unsigned int min_num_valid_obs)
+                         const unsigned int min_num_valid_obs,
+                         const bool use_fixed_seed)
     : min_num_bow_matches_(min_num_bow_matches),
       min_num_valid_obs_(min_num_valid_obs),
+      use_fixed_seed_(use_fixed_seed),
       bow_matcher_(bow_match_lowe_ratio, true),
       proj_matcher_(proj_match_lowe_ratio, true),
       robust_matcher_(robust_match_lowe_ratio, false),
@@ -30,7 +32,8 @@ relocalizer::relocalizer(const YAML::Node& yaml_node)
                   yaml_node["proj_match_lowe_ratio"].as<double>(0.9),
                   yaml_node["robust_match_lowe_ratio"].as<double>(0.8),
                   yaml_node["min_num_bow_matches"].as<unsigned int>(20),
-                  yaml_node["min_num_valid_obs"].as<unsigned int>(50)) {}
+                  yaml_node["min_num_valid_obs"].as<unsigned int>(50),
+                  yaml_node["use_fixed_seed"].as<bool>(false)) {}
 
 relocalizer::~relocalizer() { spdlog::debug("DESTRUCT: module::relocalizer"); }
 
@@ -87,7 +90,8 @@ bool relocalizer::reloc_by_candidates(
     const auto valid_indices = extract_valid_indices(matched_landmarks.at(i));
     auto pnp_solver = setup_pnp_solver(
         valid_indices, curr_frm.frm_obs_.bearings_, curr_frm.frm_obs_.keypts_,
-        matched_landmarks.at(i), curr_frm.orb_params_->scale_factors_);
+        curr_frm.frm_obs_.descriptors_, matched_landmarks.at(i),
+        curr_frm.orb_params_->scale_factors_);
 
     // 1. Estimate the camera pose using EPnP (+ RANSAC)
 
@@ -233,7 +237,7 @@ std::vector<unsigned int> relocalizer::extract_valid_indices(
 std::unique_ptr<solve::pnp_solver> relocalizer::setup_pnp_solver(
     const std::vector<unsigned int>& valid_indices,
     const eigen_alloc_vector<Vec3_t>& bearings,
-    const std::vector<cv::KeyPoint>& keypts,
+    const std::vector<cv::KeyPoint>& keypts, const cv::Mat& descriptors,
     const std::vector<std::shared_ptr<data::landmark>>& matched_landmarks,
     const std::vector<float>& scale_factors) const {
   // Resample valid elements
@@ -243,12 +247,18 @@ std::unique_ptr<solve::pnp_solver> relocalizer::setup_pnp_solver(
   const auto valid_assoc_lms =
       util::resample_by_indices(matched_landmarks, valid_indices);
   eigen_alloc_vector<Vec3_t> valid_landmarks(valid_indices.size());
+  // Descriptor distances are used to draw the reliable matches first
+  std::vector<unsigned int> match_dists(valid_indices.size());
   for (unsigned int i = 0; i < valid_indices.size(); ++i) {
     valid_landmarks.at(i) = valid_assoc_lms.at(i)->get_pos_in_world();
+    match_dists.at(i) = match::compute_descriptor_distance_32(
+        descriptors.row(valid_indices.at(i)),
+        valid_assoc_lms.at(i)->get_descriptor());
   }
   // Setup PnP solver
   return std::unique_ptr<solve::pnp_solver>(new solve::pnp_solver(
-      valid_bearings, valid_keypts, valid_landmarks, scale_factors));
+      valid_bearings, valid_keypts, valid_landmarks, scale_factors, 10,
+      use_fixed_seed_, match_dists));
 }
 
 }  // namespace module
@@ -27,7 +27,8 @@ class relocalizer {
                        const double proj_match_lowe_ratio = 0.9,
                        const double robust_match_lowe_ratio = 0.8,
                        const unsigned int min_num_bow_matches = 20,
-                       const unsigned int min_num_valid_obs = 50);
+                       const unsigned int min_num_valid_obs = 50,
+                       const bool use_fixed_seed = false);
 
   explicit relocalizer(const YAML::Node& yaml_node);
 
@@ -53,7 +54,7 @@ class relocalizer {
   std::unique_ptr<solve::pnp_solver> setup_pnp_solver(
       const std::vector<unsigned int>& valid_indices,
       const eigen_alloc_vector<Vec3_t>& bearings,
-      const std::vector<cv::KeyPoint>& keypts,
+      const std::vector<cv::KeyPoint>& keypts, const cv::Mat& descriptors,
       const std::vector<std::shared_ptr<data::landmark>>& matched_landmarks,
       const std::vector<float>& scale_factors) const;
 
@@ -62,6 +63,8 @@ class relocalizer {
   //! minimum threshold of the number of valid (= inlier after pose
   //! optimization) matches
   const unsigned int min_num_valid_obs_;
+  //! use a fixed seed for RANSAC or not
+  const bool use_fixed_seed_;
 
   //! BoW matcher
   const match::bow_tree bow_matcher_;
@@ -33,28 +33,33 @@ void graph_optimizer::optimize(
                    std::set<std::shared_ptr<data::keyframe>>>& loop_connections,
     std::unordered_map<unsigned int, unsigned int>& found_lm_to_ref_keyfrm_id)
     const {
-  // 1. Construct an optimizer
+  const auto snapshot =
+      create_snapshot(loop_keyfrm, curr_keyfrm, non_corrected_Sim3s,
+                      pre_corrected_Sim3s, loop_connections);
+  commit(snapshot, solve(snapshot), found_lm_to_ref_keyfrm_id);
+}
 
-  auto linear_solver = std::make_unique<
-      g2o::LinearSolverCSparse<g2o::BlockSolver_7_3::PoseMatrixType>>();
-  auto block_solver =
-      std::make_unique<g2o::BlockSolver_7_3>(std::move(linear_solver));
-  auto algorithm =
-      new g2o::OptimizationAlgorithmLevenberg(std::move(block_solver));
+pose_graph_snapshot graph_optimizer::create_snapshot(
+    const std::shared_ptr<data::keyframe>& loop_keyfrm,
+    const std::shared_ptr<data::keyframe>& curr_keyfrm,
+    const module::keyframe_Sim3_pairs_t& non_corrected_Sim3s,
+    const module::keyframe_Sim3_pairs_t& pre_corrected_Sim3s,
+    const std::map<std::shared_ptr<data::keyframe>,
+                   std::set<std::shared_ptr<data::keyframe>>>& loop_connections)
+    const {
+  std::lock_guard<std::mutex> lock(map_db_->mtx_database_);
 
-  g2o::SparseOptimizer optimizer;
-  optimizer.setAlgorithm(algorithm);
+  pose_graph_snapshot snapshot;
+  snapshot.fixed_keyfrm_id_ = loop_keyfrm->id_;
+  snapshot.curr_keyfrm_id_ = curr_keyfrm->id_;
 
-  // 2. Add vertices
+  // 1. Save the vertices
 
   const auto all_keyfrms = map_db_->get_all_keyframes();
-  const auto all_lms = map_db_->get_all_landmarks();
 
   // Transform the pre-modified poses of all the keyframes to Sim3, and save
   // them
-  eigen_alloc_unord_map<unsigned int, g2o::Sim3> Sim3s_cw;
-  // Save the added vertices
-  std::unordered_map<unsigned int, internal::sim3::shot_vertex*> vertices;
+  auto& Sim3s_cw = snapshot.Sim3s_cw_;
 
   constexpr int min_weight = 100;
 
@@ -62,7 +67,6 @@ void graph_optimizer::optimize(
     if (keyfrm->will_be_erased()) {
       continue;
     }
-    auto keyfrm_vtx = new internal::sim3::shot_vertex();
 
     const auto id = keyfrm->id_;
 
@@ -71,7 +75,6 @@ void graph_optimizer::optimize(
     if (iter != pre_corrected_Sim3s.end()) {
       // BEFORE optimization, set the already-modified poses for verices
       Sim3s_cw[id] = iter->second;
-      keyfrm_vtx->setEstimate(iter->second);
     } else {
       // Transform an unmodified pose to Sim3, and set it for a vertex
       const Mat33_t rot_cw = keyfrm->get_rotation();
@@ -79,39 +82,28 @@ void graph_optimizer::optimize(
       const g2o::Sim3 Sim3_cw(rot_cw, trans_cw, 1.0);
 
       Sim3s_cw[id] = Sim3_cw;
-      keyfrm_vtx->setEstimate(Sim3_cw);
-    }
-
-    // Fix the loop keyframe
-    if (*keyfrm == *loop_keyfrm) {
-      keyfrm_vtx->setFixed(true);
     }
-
-    // Set the vertex to the optimizer
-    keyfrm_vtx->setId(id);
-    keyfrm_vtx->fix_scale_ = fix_scale_;
-
-    optimizer.addVertex(keyfrm_vtx);
-    vertices[id] = keyfrm_vtx;
   }
 
-  // 3. Add edges
+  // 2. Save the edges
 
   // Save keyframe pairs which the edge is inserted between
   std::set<std::pair<unsigned int, unsigned int>> inserted_edge_pairs;
 
   // Function to add a constraint edge
-  const auto insert_edge = [&optimizer, &vertices, &inserted_edge_pairs](
+  const auto insert_edge = [&snapshot, &inserted_edge_pairs](
                                unsigned int id1, unsigned int id2,
                                const g2o::Sim3& Sim3_21) {
-    auto edge = new internal::sim3::graph_opt_edge();
-    edge->setVertex(0, vertices.at(id1));
-    edge->setVertex(1, vertices.at(id2));
-    edge->setMeasurement(Sim3_21);
-
-    edge->information() = MatRC_t<7, 7>::Identity();
+    // the edge to the erased keyframe does not have the vertex
+    if (!snapshot.Sim3s_cw_.count(id1) || !snapshot.Sim3s_cw_.count(id2)) {
+      return;
+    }
 
-    optimizer.addEdge(edge);
+    pose_graph_snapshot::edge edge;
+    edge.id1_ = id1;
+    edge.id2_ = id2;
+    edge.Sim3_21_ = Sim3_21;
+    snapshot.edges_.push_back(edge);
     inserted_edge_pairs.insert(
         std::make_pair(std::min(id1, id2), std::max(id1, id2)));
   };
@@ -122,11 +114,17 @@ void graph_optimizer::optimize(
     const auto& connected_keyfrms = loop_connection.second;
 
     const auto id1 = keyfrm->id_;
+    if (!Sim3s_cw.count(id1)) {
+      continue;
+    }
     const g2o::Sim3& Sim3_1w = Sim3s_cw.at(id1);
     const g2o::Sim3 Sim3_w1 = Sim3_1w.inverse();
 
     for (auto connected_keyfrm : connected_keyfrms) {
       const auto id2 = connected_keyfrm->id_;
+      if (!Sim3s_cw.count(id2)) {
+        continue;
+      }
 
       // Except the current vs loop edges,
       // Add the loop edges only over the weight threshold
@@ -148,6 +146,9 @@ void graph_optimizer::optimize(
   for (auto keyfrm : all_keyfrms) {
     // Select one pose of the keyframe pair
     const auto id1 = keyfrm->id_;
+    if (!Sim3s_cw.count(id1)) {
+      continue;
+    }
 
     // Use only non-modified poses in the covisibility information
     // (Both camera poses should be non-modified in order to compute the
@@ -257,57 +258,144 @@ void graph_optimizer::optimize(
     }
   }
 
+  return snapshot;
+}
+
+eigen_alloc_unord_map<unsigned int, g2o::Sim3> graph_optimizer::solve(
+    const pose_graph_snapshot& snapshot) const {
+  // 1. Construct an optimizer
+
+  auto linear_solver = std::make_unique<
+      g2o::LinearSolverCSparse<g2o::BlockSolver_7_3::PoseMatrixType>>();
+  auto block_solver =
+      std::make_unique<g2o::BlockSolver_7_3>(std::move(linear_solver));
+  auto algorithm =
+      new g2o::OptimizationAlgorithmLevenberg(std::move(block_solver));
+
+  g2o::SparseOptimizer optimizer;
+  optimizer.setAlgorithm(algorithm);
+
+  // 2. Add vertices
+
+  // Save the added vertices
+  std::unordered_map<unsigned int, internal::sim3::shot_vertex*> vertices;
+
+  for (const auto& id_and_Sim3 : snapshot.Sim3s_cw_) {
+    const auto id = id_and_Sim3.first;
+    auto keyfrm_vtx = new internal::sim3::shot_vertex();
+    keyfrm_vtx->setEstimate(id_and_Sim3.second);
+
+    // Fix the loop keyframe
+    if (id == snapshot.fixed_keyfrm_id_) {
+      keyfrm_vtx->setFixed(true);
+    }
+
+    // Set the vertex to the optimizer
+    keyfrm_vtx->setId(id);
+    keyfrm_vtx->fix_scale_ = fix_scale_;
+
+    optimizer.addVertex(keyfrm_vtx);
+    vertices[id] = keyfrm_vtx;
+  }
+
+  // 3. Add edges
+
+  for (const auto& snapshot_edge : snapshot.edges_) {
+    auto edge = new internal::sim3::graph_opt_edge();
+    edge->setVertex(0, vertices.at(snapshot_edge.id1_));
+    edge->setVertex(1, vertices.at(snapshot_edge.id2_));
+    edge->setMeasurement(snapshot_edge.Sim3_21_);
+
+    edge->information() = MatRC_t<7, 7>::Identity();
+
+    optimizer.addEdge(edge);
+  }
+
   // 4. Perform a pose graph optimization
 
   optimizer.initializeOptimization();
   optimizer.optimize(50);
 
-  // 5. Update the camera poses and point-cloud
+  // 5. Get the corrected poses
 
-  {
-    std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+  eigen_alloc_unord_map<unsigned int, g2o::Sim3> corrected_Sim3s_cw;
+  for (const auto& id_and_vtx : vertices) {
+    corrected_Sim3s_cw[id_and_vtx.first] = id_and_vtx.second->estimate();
+  }
+  return corrected_Sim3s_cw;
+}
 
-    // For modification of a point-cloud, save the post-modified poses of all
-    // the keyframes
-    std::unordered_map<unsigned int, g2o::Sim3> corrected_Sim3s_wc;
+void graph_optimizer::commit(
+    const pose_graph_snapshot& snapshot,
+    const eigen_alloc_unord_map<unsigned int, g2o::Sim3>& corrected_Sim3s_cw,
+    const std::unordered_map<unsigned int, unsigned int>&
+        found_lm_to_ref_keyfrm_id) const {
+  std::lock_guard<std::mutex> lock(map_db_->mtx_database_);
 
-    for (auto keyfrm : all_keyfrms) {
-      const auto id = keyfrm->id_;
+  // 1. Compute the corrections from the world before the optimization to the
+  //    world after that, for each of the keyframes in the snapshot
 
-      auto keyfrm_vtx =
-          static_cast<internal::sim3::shot_vertex*>(optimizer.vertex(id));
+  eigen_alloc_unord_map<unsigned int, g2o::Sim3> corrections;
+  for (const auto& id_and_Sim3 : snapshot.Sim3s_cw_) {
+    const auto id = id_and_Sim3.first;
+    corrections[id] = corrected_Sim3s_cw.at(id).inverse() * id_and_Sim3.second;
+  }
+  const auto& default_correction = corrections.at(snapshot.curr_keyfrm_id_);
 
-      const g2o::Sim3& corrected_Sim3_cw = keyfrm_vtx->estimate();
-      const float s = corrected_Sim3_cw.scale();
-      const Mat33_t rot_cw = corrected_Sim3_cw.rotation().toRotationMatrix();
-      const Vec3_t trans_cw = corrected_Sim3_cw.translation() / s;
+  const auto all_keyfrms = map_db_->get_all_keyframes();
+  const auto all_lms = map_db_->get_all_landmarks();
+
+  // Function to find the correction of the keyframe
+  // (the keyframes inserted during the optimization are rebased onto their
+  // nearest ancestors in the snapshot)
+  const auto find_correction =
+      [&corrections, &default_correction, &all_keyfrms](
+          std::shared_ptr<data::keyframe> keyfrm) -> const g2o::Sim3& {
+    for (unsigned int i = 0; keyfrm && i <= all_keyfrms.size(); ++i) {
+      const auto iter = corrections.find(keyfrm->id_);
+      if (iter != corrections.end()) {
+        return iter->second;
+      }
+      keyfrm = keyfrm->graph_node_->get_spanning_parent();
+    }
+    return default_correction;
+  };
 
-      const Mat44_t cam_pose_cw =
-          util::converter::to_eigen_cam_pose(rot_cw, trans_cw);
-      keyfrm->set_cam_pose(cam_pose_cw);
+  // 2. Update the point-cloud
+  // (the corrections are applied to the current positions, so that the
+  // refinement by the other modules during the optimization is kept)
 
-      corrected_Sim3s_wc[id] = corrected_Sim3_cw.inverse();
+  for (const auto& lm : all_lms) {
+    if (lm->will_be_erased()) {
+      continue;
     }
 
-    // Update the point-cloud
-    for (const auto& lm : all_lms) {
-      if (lm->will_be_erased()) {
-        continue;
-      }
+    const auto iter = found_lm_to_ref_keyfrm_id.find(lm->id_);
+    const auto& correction = (iter != found_lm_to_ref_keyfrm_id.end() &&
+                              corrections.count(iter->second))
+                                 ? corrections.at(iter->second)
+                                 : find_correction(lm->get_ref_keyframe());
 
-      const auto id = (found_lm_to_ref_keyfrm_id.count(lm->id_))
-                          ? found_lm_to_ref_keyfrm_id.at(lm->id_)
-                          : lm->get_ref_keyframe()->id_;
+    const Vec3_t pos_w = lm->get_pos_in_world();
+    lm->set_pos_in_world(correction.map(pos_w));
+    lm->update_mean_normal_and_obs_scale_variance();
+  }
 
-      const g2o::Sim3& Sim3_cw = Sim3s_cw.at(id);
-      const g2o::Sim3& corrected_Sim3_wc = corrected_Sim3s_wc.at(id);
+  // 3. Update the camera poses
 
-      const Vec3_t pos_w = lm->get_pos_in_world();
-      const Vec3_t corrected_pos_w = corrected_Sim3_wc.map(Sim3_cw.map(pos_w));
+  for (const auto& keyfrm : all_keyfrms) {
+    const auto& correction = find_correction(keyfrm);
 
-      lm->set_pos_in_world(corrected_pos_w);
-      lm->update_mean_normal_and_obs_scale_variance();
-    }
+    const g2o::Sim3 Sim3_cw(keyfrm->get_rotation(), keyfrm->get_translation(),
+                            1.0);
+    const g2o::Sim3 corrected_Sim3_cw = Sim3_cw * correction.inverse();
+    const float s = corrected_Sim3_cw.scale();
+    const Mat33_t rot_cw = corrected_Sim3_cw.rotation().toRotationMatrix();
+    const Vec3_t trans_cw = corrected_Sim3_cw.translation() / s;
+
+    const Mat44_t cam_pose_cw =
+        util::converter::to_eigen_cam_pose(rot_cw, trans_cw);
+    keyfrm->set_cam_pose(cam_pose_cw);
   }
 }
 
@@ -6,6 +6,7 @@
 #include <set>
 
 #include "openvslam/module/type.h"
+#include "openvslam/type.h"
 
 namespace openvslam {
 
@@ -16,6 +17,35 @@ class map_database;
 
 namespace optimize {
 
+/**
+ * Pose graph copied from the map database
+ * (it is optimized without locking the map database, and the result is
+ * committed to the map database afterwards)
+ */
+struct pose_graph_snapshot {
+  //! Constraint between two keyframes
+  struct edge {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    //! keyframe ID of the first vertex
+    unsigned int id1_;
+    //! keyframe ID of the second vertex
+    unsigned int id2_;
+    //! relative Sim3 from the first keyframe to the second one
+    g2o::Sim3 Sim3_21_;
+  };
+
+  //! Sim3 camera poses of the keyframes before the optimization
+  eigen_alloc_unord_map<unsigned int, g2o::Sim3> Sim3s_cw_;
+  //! constraints between the keyframes
+  eigen_alloc_vector<edge> edges_;
+  //! ID of the keyframe which is fixed during the optimization
+  unsigned int fixed_keyfrm_id_ = 0;
+  //! ID of the keyframe whose correction is applied to the keyframes which
+  //! cannot be traced to the snapshot
+  unsigned int curr_keyfrm_id_ = 0;
+};
+
 class graph_optimizer {
  public:
   /**
@@ -48,6 +78,48 @@ class graph_optimizer {
                 std::unordered_map<unsigned int, unsigned int>&
                     found_lm_to_ref_keyfrm_id) const;
 
+  /**
+   * Copy the pose graph from the map database
+   * @param loop_keyfrm
+   * @param curr_keyfrm
+   * @param non_corrected_Sim3s
+   * @param pre_corrected_Sim3s
+   * @param loop_connections
+   * @return
+   */
+  pose_graph_snapshot create_snapshot(
+      const std::shared_ptr<data::keyframe>& loop_keyfrm,
+      const std::shared_ptr<data::keyframe>& curr_keyfrm,
+      const module::keyframe_Sim3_pairs_t& non_corrected_Sim3s,
+      const module::keyframe_Sim3_pairs_t& pre_corrected_Sim3s,
+      const std::map<std::shared_ptr<data::keyframe>,
+                     std::set<std::shared_ptr<data::keyframe>>>&
+          loop_connections) const;
+
+  /**
+   * Optimize the pose graph
+   * (the map database is not accessed, so the other modules can modify the
+   * map during the optimization)
+   * @param snapshot
+   * @return corrected Sim3 camera poses of the keyframes in the snapshot
+   */
+  eigen_alloc_unord_map<unsigned int, g2o::Sim3> solve(
+      const pose_graph_snapshot& snapshot) const;
+
+  /**
+   * Apply the correction to the camera poses and the point-cloud
+   * (the keyframes which are inserted after the snapshot is created are
+   * rebased onto their nearest ancestors in the spanning tree)
+   * @param snapshot
+   * @param corrected_Sim3s_cw
+   * @param found_lm_to_ref_keyfrm_id
+   */
+  void commit(const pose_graph_snapshot& snapshot,
+              const eigen_alloc_unord_map<unsigned int, g2o::Sim3>&
+                  corrected_Sim3s_cw,
+              const std::unordered_map<unsigned int, unsigned int>&
+                  found_lm_to_ref_keyfrm_id) const;
+
  private:
   //! map database
   const data::map_database* map_db_;
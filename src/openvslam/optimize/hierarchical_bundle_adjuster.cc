@@ -0,0 +1,499 @@
+#include "openvslam/optimize/hierarchical_bundle_adjuster.h"
+
+#include <g2o/core/block_solver.h>
+#include <g2o/core/optimization_algorithm_levenberg.h>
+#include <g2o/core/robust_kernel_impl.h>
+#include <g2o/core/solver.h>
+#include <g2o/core/sparse_optimizer.h>
+#include <g2o/solvers/csparse/linear_solver_csparse.h>
+#include <g2o/solvers/eigen/linear_solver_eigen.h>
+#include <g2o/types/sba/types_six_dof_expmap.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <mutex>
+
+#include "openvslam/data/keyframe.h"
+#include "openvslam/data/landmark.h"
+#include "openvslam/data/map_database.h"
+#include "openvslam/optimize/internal/landmark_vertex_container.h"
+#include "openvslam/optimize/internal/se3/reproj_edge_wrapper.h"
+#include "openvslam/optimize/internal/se3/shot_vertex_container.h"
+#include "openvslam/util/converter.h"
+
+namespace openvslam {
+namespace optimize {
+
+hierarchical_bundle_adjuster::hierarchical_bundle_adjuster(
+    data::map_database* map_db, const unsigned int num_keyfrms_per_submap,
+    const unsigned int num_iter, const bool use_huber_kernel)
+    : map_db_(map_db),
+      num_keyfrms_per_submap_(num_keyfrms_per_submap),
+      num_iter_(num_iter),
+      use_huber_kernel_(use_huber_kernel) {}
+
+std::vector<std::vector<std::shared_ptr<data::keyframe>>>
+hierarchical_bundle_adjuster::partition(
+    const std::vector<std::shared_ptr<data::keyframe>>& keyfrms) const {
+  // grow the submaps from the oldest unassigned keyframe in breadth-first order
+  // on the covisibility graph, so that each submap is a connected cluster
+  std::vector<std::shared_ptr<data::keyframe>> sorted_keyfrms;
+  sorted_keyfrms.reserve(keyfrms.size());
+  for (const auto& keyfrm : keyfrms) {
+    if (!keyfrm) {
+      continue;
+    }
+    if (keyfrm->will_be_erased()) {
+      continue;
+    }
+    sorted_keyfrms.push_back(keyfrm);
+  }
+  std::sort(sorted_keyfrms.begin(), sorted_keyfrms.end(),
+            [](const std::shared_ptr<data::keyframe>& keyfrm_1,
+               const std::shared_ptr<data::keyframe>& keyfrm_2) {
+              return keyfrm_1->id_ < keyfrm_2->id_;
+            });
+
+  std::unordered_set<unsigned int> keyfrm_ids;
+  keyfrm_ids.reserve(sorted_keyfrms.size());
+  for (const auto& keyfrm : sorted_keyfrms) {
+    keyfrm_ids.insert(keyfrm->id_);
+  }
+
+  std::vector<std::vector<std::shared_ptr<data::keyframe>>> submaps;
+  std::unordered_set<unsigned int> assigned_keyfrm_ids;
+  assigned_keyfrm_ids.reserve(sorted_keyfrms.size());
+
+  for (const auto& seed_keyfrm : sorted_keyfrms) {
+    if (assigned_keyfrm_ids.count(seed_keyfrm->id_)) {
+      continue;
+    }
+
+    std::vector<std::shared_ptr<data::keyframe>> submap;
+    submap.reserve(num_keyfrms_per_submap_);
+
+    std::list<std::shared_ptr<data::keyframe>> keyfrms_to_check;
+    keyfrms_to_check.push_back(seed_keyfrm);
+    while (!keyfrms_to_check.empty() &&
+           submap.size() < num_keyfrms_per_submap_) {
+      const auto keyfrm = keyfrms_to_check.front();
+      keyfrms_to_check.pop_front();
+      if (assigned_keyfrm_ids.count(keyfrm->id_)) {
+        continue;
+      }
+
+      assigned_keyfrm_ids.insert(keyfrm->id_);
+      submap.push_back(keyfrm);
+
+      // the covisibilities are sorted in descending order of weights
+      const auto covisibilities = keyfrm->graph_node_->get_covisibilities();
+      for (const auto& covisibility : covisibilities) {
+        if (!keyfrm_ids.count(covisibility->id_)) {
+          continue;
+        }
+        if (assigned_keyfrm_ids.count(covisibility->id_)) {
+          continue;
+        }
+        keyfrms_to_check.push_back(covisibility);
+      }
+    }
+
+    submaps.push_back(submap);
+  }
+
+  return submaps;
+}
+
+void hierarchical_bundle_adjuster::optimize(
+    std::unordered_set<unsigned int>& optimized_keyfrm_ids,
+    std::unordered_set<unsigned int>& optimized_landmark_ids,
+    eigen_alloc_unord_map<unsigned int, Vec3_t>& lm_to_pos_w_after_global_BA,
+    eigen_alloc_unord_map<unsigned int, Mat44_t>&
+        keyfrm_to_pose_cw_after_global_BA,
+    const commit_callback_t& commit_callback,
+    bool* const force_stop_flag) const {
+  // 1. Partition the covisibility graph into submaps
+
+  const auto submaps = partition(map_db_->get_all_keyframes());
+
+  std::unordered_map<unsigned int, unsigned int> keyfrm_id_to_submap_idx;
+  for (unsigned int submap_idx = 0; submap_idx < submaps.size(); ++submap_idx) {
+    for (const auto& keyfrm : submaps.at(submap_idx)) {
+      keyfrm_id_to_submap_idx[keyfrm->id_] = submap_idx;
+    }
+  }
+
+  spdlog::info("hierarchical bundle adjustment: {} keyframes in {} submaps",
+               keyfrm_id_to_submap_idx.size(), submaps.size());
+
+  // 2. Classify the landmarks into interior ones (observed in only one submap)
+  // and separator ones (observed across the submaps)
+
+  const auto lms = map_db_->get_all_landmarks();
+
+  std::vector<std::vector<std::shared_ptr<data::landmark>>> interior_lms(
+      submaps.size());
+  std::vector<std::shared_ptr<data::landmark>> separator_lms;
+  std::unordered_set<unsigned int> separator_lm_ids;
+  // boundary keyframes: keyframes which observe any of the separator landmarks
+  std::unordered_set<unsigned int> boundary_keyfrm_ids;
+
+  for (const auto& lm : lms) {
+    if (!lm) {
+      continue;
+    }
+    if (lm->will_be_erased()) {
+      continue;
+    }
+
+    const auto observations = lm->get_observations();
+    std::unordered_set<unsigned int> observer_submap_indices;
+    for (const auto& obs : observations) {
+      const auto keyfrm = obs.first.lock();
+      if (!keyfrm) {
+        continue;
+      }
+      if (!keyfrm_id_to_submap_idx.count(keyfrm->id_)) {
+        continue;
+      }
+      observer_submap_indices.insert(keyfrm_id_to_submap_idx.at(keyfrm->id_));
+    }
+
+    if (observer_submap_indices.empty()) {
+      continue;
+    }
+
+    if (observer_submap_indices.size() == 1) {
+      interior_lms.at(*observer_submap_indices.begin()).push_back(lm);
+      continue;
+    }
+
+    separator_lms.push_back(lm);
+    separator_lm_ids.insert(lm->id_);
+    for (const auto& obs : observations) {
+      const auto keyfrm = obs.first.lock();
+      if (!keyfrm) {
+        continue;
+      }
+      if (!keyfrm_id_to_submap_idx.count(keyfrm->id_)) {
+        continue;
+      }
+      boundary_keyfrm_ids.insert(keyfrm->id_);
+    }
+  }
+
+  // 3. Optimize each of the submaps with the separator landmarks fixed
+
+  std::mutex mtx_result;
+
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (unsigned int submap_idx = 0; submap_idx < submaps.size();
+       ++submap_idx) {
+    if (force_stop_flag && *force_stop_flag) {
+      continue;
+    }
+
+    const auto& submap = submaps.at(submap_idx);
+
+    // the separator landmarks observed in the submap are the boundary
+    // variables
+    std::vector<std::shared_ptr<data::landmark>> fixed_lms;
+    std::unordered_set<unsigned int> fixed_lm_ids;
+    for (const auto& keyfrm : submap) {
+      if (!boundary_keyfrm_ids.count(keyfrm->id_)) {
+        continue;
+      }
+      const auto keyfrm_lms = keyfrm->get_landmarks();
+      for (const auto& lm : keyfrm_lms) {
+        if (!lm) {
+          continue;
+        }
+        if (!separator_lm_ids.count(lm->id_)) {
+          continue;
+        }
+        if (fixed_lm_ids.count(lm->id_)) {
+          continue;
+        }
+        fixed_lm_ids.insert(lm->id_);
+        fixed_lms.push_back(lm);
+      }
+    }
+
+    eigen_alloc_unord_map<unsigned int, Mat44_t> keyfrm_to_pose_cw;
+    eigen_alloc_unord_map<unsigned int, Vec3_t> lm_to_pos_w;
+    optimize_subproblem(submap, interior_lms.at(submap_idx), fixed_lms, {}, {},
+                        keyfrm_to_pose_cw, lm_to_pos_w, force_stop_flag);
+
+    if (force_stop_flag && *force_stop_flag) {
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_result);
+    for (const auto& id_pose : keyfrm_to_pose_cw) {
+      keyfrm_to_pose_cw_after_global_BA[id_pose.first] = id_pose.second;
+      optimized_keyfrm_ids.insert(id_pose.first);
+    }
+    for (const auto& id_pos : lm_to_pos_w) {
+      lm_to_pos_w_after_global_BA[id_pos.first] = id_pos.second;
+      optimized_landmark_ids.insert(id_pos.first);
+    }
+    // commit the result of the submap so that tracking can benefit from it
+    // before the whole BA completes
+    if (commit_callback) {
+      commit_callback(keyfrm_to_pose_cw, lm_to_pos_w);
+    }
+  }
+
+  if (force_stop_flag && *force_stop_flag) {
+    return;
+  }
+
+  // 4. Optimize the separator landmarks and the boundary keyframes with the
+  // interior landmarks fixed
+
+  if (separator_lms.empty()) {
+    return;
+  }
+
+  std::vector<std::shared_ptr<data::keyframe>> boundary_keyfrms;
+  boundary_keyfrms.reserve(boundary_keyfrm_ids.size());
+  for (const auto& submap : submaps) {
+    for (const auto& keyfrm : submap) {
+      if (boundary_keyfrm_ids.count(keyfrm->id_)) {
+        boundary_keyfrms.push_back(keyfrm);
+      }
+    }
+  }
+
+  // the interior landmarks observed in the boundary keyframes anchor the
+  // reduced problem
+  // (the problem starts from the results of the submaps because they are not
+  // in the map if the callback is not given)
+  std::vector<std::shared_ptr<data::landmark>> anchor_lms;
+  std::unordered_set<unsigned int> anchor_lm_ids;
+  for (const auto& keyfrm : boundary_keyfrms) {
+    const auto keyfrm_lms = keyfrm->get_landmarks();
+    for (const auto& lm : keyfrm_lms) {
+      if (!lm) {
+        continue;
+      }
+      if (lm->will_be_erased()) {
+        continue;
+      }
+      if (separator_lm_ids.count(lm->id_)) {
+        continue;
+      }
+      if (anchor_lm_ids.count(lm->id_)) {
+        continue;
+      }
+      anchor_lm_ids.insert(lm->id_);
+      anchor_lms.push_back(lm);
+    }
+  }
+
+  eigen_alloc_unord_map<unsigned int, Mat44_t> keyfrm_to_pose_cw;
+  eigen_alloc_unord_map<unsigned int, Vec3_t> lm_to_pos_w;
+  optimize_subproblem(boundary_keyfrms, separator_lms, anchor_lms,
+                      keyfrm_to_pose_cw_after_global_BA,
+                      lm_to_pos_w_after_global_BA, keyfrm_to_pose_cw,
+                      lm_to_pos_w, force_stop_flag);
+
+  if (force_stop_flag && *force_stop_flag) {
+    return;
+  }
+
+  for (const auto& id_pose : keyfrm_to_pose_cw) {
+    keyfrm_to_pose_cw_after_global_BA[id_pose.first] = id_pose.second;
+    optimized_keyfrm_ids.insert(id_pose.first);
+  }
+  for (const auto& id_pos : lm_to_pos_w) {
+    lm_to_pos_w_after_global_BA[id_pos.first] = id_pos.second;
+    optimized_landmark_ids.insert(id_pos.first);
+  }
+  if (commit_callback) {
+    commit_callback(keyfrm_to_pose_cw, lm_to_pos_w);
+  }
+}
+
+void hierarchical_bundle_adjuster::optimize_subproblem(
+    const std::vector<std::shared_ptr<data::keyframe>>& keyfrms,
+    const std::vector<std::shared_ptr<data::landmark>>& lms,
+    const std::vector<std::shared_ptr<data::landmark>>& fixed_lms,
+    const eigen_alloc_unord_map<unsigned int, Mat44_t>&
+        initial_keyfrm_to_pose_cw,
+    const eigen_alloc_unord_map<unsigned int, Vec3_t>& initial_lm_to_pos_w,
+    eigen_alloc_unord_map<unsigned int, Mat44_t>& keyfrm_to_pose_cw,
+    eigen_alloc_unord_map<unsigned int, Vec3_t>& lm_to_pos_w,
+    bool* const force_stop_flag) const {
+  // 1. Construct an optimizer
+
+  auto linear_solver = std::make_unique<
+      g2o::LinearSolverCSparse<g2o::BlockSolver_6_3::PoseMatrixType>>();
+  auto block_solver =
+      std::make_unique<g2o::BlockSolver_6_3>(std::move(linear_solver));
+  auto algorithm =
+      new g2o::OptimizationAlgorithmLevenberg(std::move(block_solver));
+
+  g2o::SparseOptimizer optimizer;
+  optimizer.setAlgorithm(algorithm);
+
+  if (force_stop_flag) {
+    optimizer.setForceStopFlag(force_stop_flag);
+  }
+
+  // 2. Convert each of the keyframe to the g2o vertex, then set it to the
+  // optimizer
+
+  auto vtx_id_offset = std::make_shared<unsigned int>(0);
+  // Container of the shot vertices
+  internal::se3::shot_vertex_container keyfrm_vtx_container(vtx_id_offset,
+                                                            keyfrms.size());
+  // Container of the landmark vertices
+  internal::landmark_vertex_container lm_vtx_container(
+      vtx_id_offset, lms.size() + fixed_lms.size());
+
+  std::vector<std::shared_ptr<data::keyframe>> optimized_keyfrms;
+  optimized_keyfrms.reserve(keyfrms.size());
+  for (const auto& keyfrm : keyfrms) {
+    if (!keyfrm) {
+      continue;
+    }
+    if (keyfrm->will_be_erased()) {
+      continue;
+    }
+
+    const auto initial_pose_cw = initial_keyfrm_to_pose_cw.find(keyfrm->id_);
+    auto keyfrm_vtx =
+        (initial_pose_cw != initial_keyfrm_to_pose_cw.end())
+            ? keyfrm_vtx_container.create_vertex(
+                  keyfrm->id_, initial_pose_cw->second, keyfrm->id_ == 0)
+            : keyfrm_vtx_container.create_vertex(keyfrm, keyfrm->id_ == 0);
+    optimizer.addVertex(keyfrm_vtx);
+    optimized_keyfrms.push_back(keyfrm);
+  }
+
+  // 3. Connect the vertices of the keyframe and the landmark by using
+  // reprojection edge
+
+  // Container of the reprojection edges
+  using reproj_edge_wrapper =
+      internal::se3::reproj_edge_wrapper<data::keyframe>;
+  std::vector<reproj_edge_wrapper> reproj_edge_wraps;
+  reproj_edge_wraps.reserve(10 * (lms.size() + fixed_lms.size()));
+
+  // Chi-squared value with significance level of 5%
+  // Two degree-of-freedom (n=2)
+  constexpr float chi_sq_2D = 5.99146;
+  const float sqrt_chi_sq_2D = std::sqrt(chi_sq_2D);
+  // Three degree-of-freedom (n=3)
+  constexpr float chi_sq_3D = 7.81473;
+  const float sqrt_chi_sq_3D = std::sqrt(chi_sq_3D);
+
+  std::vector<std::shared_ptr<data::landmark>> optimized_lms;
+  optimized_lms.reserve(lms.size());
+
+  const auto add_landmark = [&](const std::shared_ptr<data::landmark>& lm,
+                                const bool is_constant) {
+    if (!lm) {
+      return;
+    }
+    if (lm->will_be_erased()) {
+      return;
+    }
+    if (lm_vtx_container.contain(lm)) {
+      return;
+    }
+
+    // Convert the landmark to the g2o vertex, then set it to the optimizer
+    const auto initial_pos_w = initial_lm_to_pos_w.find(lm->id_);
+    auto lm_vtx =
+        (initial_pos_w != initial_lm_to_pos_w.end())
+            ? lm_vtx_container.create_vertex(lm->id_, initial_pos_w->second,
+                                             is_constant)
+            : lm_vtx_container.create_vertex(lm, is_constant);
+    optimizer.addVertex(lm_vtx);
+
+    unsigned int num_edges = 0;
+    const auto observations = lm->get_observations();
+    for (const auto& obs : observations) {
+      auto keyfrm = obs.first.lock();
+      auto idx = obs.second;
+      if (!keyfrm) {
+        continue;
+      }
+      if (keyfrm->will_be_erased()) {
+        continue;
+      }
+      // the observers outside of the sub-problem are not considered
+      if (!keyfrm_vtx_container.contain(keyfrm)) {
+        continue;
+      }
+
+      const auto keyfrm_vtx = keyfrm_vtx_container.get_vertex(keyfrm);
+      const auto& undist_keypt = keyfrm->frm_obs_.undist_keypts_.at(idx);
+      const float x_right = keyfrm->frm_obs_.stereo_x_right_.at(idx);
+      const float inv_sigma_sq =
+          keyfrm->orb_params_->inv_level_sigma_sq_.at(undist_keypt.octave);
+      const auto sqrt_chi_sq =
+          (keyfrm->camera_->setup_type_ == camera::setup_type_t::Monocular)
+              ? sqrt_chi_sq_2D
+              : sqrt_chi_sq_3D;
+      auto reproj_edge_wrap = reproj_edge_wrapper(
+          keyfrm, keyfrm_vtx, lm, lm_vtx, idx, undist_keypt.pt.x,
+          undist_keypt.pt.y, x_right, inv_sigma_sq, sqrt_chi_sq,
+          use_huber_kernel_);
+      reproj_edge_wraps.push_back(reproj_edge_wrap);
+      optimizer.addEdge(reproj_edge_wrap.edge_);
+      ++num_edges;
+    }
+
+    if (num_edges == 0) {
+      optimizer.removeVertex(lm_vtx);
+      return;
+    }
+
+    if (!is_constant) {
+      optimized_lms.push_back(lm);
+    }
+  };
+
+  for (const auto& lm : fixed_lms) {
+    add_landmark(lm, true);
+  }
+  for (const auto& lm : lms) {
+    add_landmark(lm, false);
+  }
+
+  // 4. Perform optimization
+
+  if (force_stop_flag && *force_stop_flag) {
+    return;
+  }
+
+  optimizer.initializeOptimization();
+  optimizer.optimize(num_iter_);
+
+  if (force_stop_flag && *force_stop_flag) {
+    return;
+  }
+
+  // 5. Extract the result
+
+  for (const auto& keyfrm : optimized_keyfrms) {
+    auto keyfrm_vtx = keyfrm_vtx_container.get_vertex(keyfrm);
+    keyfrm_to_pose_cw[keyfrm->id_] =
+        util::converter::to_eigen_mat(keyfrm_vtx->estimate());
+  }
+
+  for (const auto& lm : optimized_lms) {
+    auto lm_vtx = lm_vtx_container.get_vertex(lm);
+    lm_to_pos_w[lm->id_] = lm_vtx->estimate();
+  }
+}
+
+}  // namespace optimize
+}  // namespace openvslam
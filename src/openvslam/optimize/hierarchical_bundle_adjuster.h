@@ -0,0 +1,118 @@
+#ifndef OPENVSLAM_OPTIMIZE_HIERARCHICAL_BUNDLE_ADJUSTER_H
+#define OPENVSLAM_OPTIMIZE_HIERARCHICAL_BUNDLE_ADJUSTER_H
+
+#include <functional>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "openvslam/type.h"
+
+namespace openvslam {
+
+namespace data {
+class keyframe;
+class landmark;
+class map_database;
+}  // namespace data
+
+namespace optimize {
+
+class hierarchical_bundle_adjuster {
+ public:
+  //! Callback which receives the result of each sub-problem as soon as it is
+  //! solved (keyframe ID -> camera pose, landmark ID -> position)
+  using commit_callback_t = std::function<void(
+      const eigen_alloc_unord_map<unsigned int, Mat44_t>& keyfrm_to_pose_cw,
+      const eigen_alloc_unord_map<unsigned int, Vec3_t>& lm_to_pos_w)>;
+
+  /**
+   * Constructor
+   * @param map_db
+   * @param num_keyfrms_per_submap
+   * @param num_iter
+   * @param use_huber_kernel
+   */
+  explicit hierarchical_bundle_adjuster(
+      data::map_database* map_db,
+      const unsigned int num_keyfrms_per_submap = 100,
+      const unsigned int num_iter = 10, const bool use_huber_kernel = true);
+
+  /**
+   * Destructor
+   */
+  virtual ~hierarchical_bundle_adjuster() = default;
+
+  /**
+   * Perform optimization
+   * (NOTE: the submaps are optimized with the separator landmarks fixed, then
+   * the separator landmarks and the boundary keyframes are optimized with the
+   * interior of the submaps fixed, starting from the results of the submaps
+   * whether or not they have been committed to the map)
+   * @param optimized_keyfrm_ids
+   * @param optimized_landmark_ids
+   * @param lm_to_pos_w_after_global_BA
+   * @param keyfrm_to_pose_cw_after_global_BA
+   * @param commit_callback
+   * @param force_stop_flag
+   */
+  void optimize(
+      std::unordered_set<unsigned int>& optimized_keyfrm_ids,
+      std::unordered_set<unsigned int>& optimized_landmark_ids,
+      eigen_alloc_unord_map<unsigned int, Vec3_t>& lm_to_pos_w_after_global_BA,
+      eigen_alloc_unord_map<unsigned int, Mat44_t>&
+          keyfrm_to_pose_cw_after_global_BA,
+      const commit_callback_t& commit_callback = nullptr,
+      bool* const force_stop_flag = nullptr) const;
+
+  /**
+   * Partition the keyframes into connected clusters on the covisibility graph
+   * @param keyfrms
+   * @return submaps (lists of keyframes)
+   */
+  std::vector<std::vector<std::shared_ptr<data::keyframe>>> partition(
+      const std::vector<std::shared_ptr<data::keyframe>>& keyfrms) const;
+
+ private:
+  /**
+   * Optimize a set of keyframes and landmarks with the other observers and
+   * landmarks treated as constants
+   * @param keyfrms
+   * @param lms
+   * @param fixed_lms
+   * @param initial_keyfrm_to_pose_cw initial camera poses which override the
+   * ones in the map (the results of the previous phase)
+   * @param initial_lm_to_pos_w initial positions which override the ones in
+   * the map (the results of the previous phase)
+   * @param keyfrm_to_pose_cw
+   * @param lm_to_pos_w
+   * @param force_stop_flag
+   */
+  void optimize_subproblem(
+      const std::vector<std::shared_ptr<data::keyframe>>& keyfrms,
+      const std::vector<std::shared_ptr<data::landmark>>& lms,
+      const std::vector<std::shared_ptr<data::landmark>>& fixed_lms,
+      const eigen_alloc_unord_map<unsigned int, Mat44_t>&
+          initial_keyfrm_to_pose_cw,
+      const eigen_alloc_unord_map<unsigned int, Vec3_t>& initial_lm_to_pos_w,
+      eigen_alloc_unord_map<unsigned int, Mat44_t>& keyfrm_to_pose_cw,
+      eigen_alloc_unord_map<unsigned int, Vec3_t>& lm_to_pos_w,
+      bool* const force_stop_flag) const;
+
+  //! map database
+  const data::map_database* map_db_;
+
+  //! maximum number of keyframes in a submap
+  const unsigned int num_keyfrms_per_submap_;
+
+  //! number of iterations of optimization
+  const unsigned int num_iter_;
+
+  //! use Huber loss or not
+  const bool use_huber_kernel_;
+};
+
+}  // namespace optimize
+}  // namespace openvslam
+
+#endif  // OPENVSLAM_OPTIMIZE_HIERARCHICAL_BUNDLE_ADJUSTER_H
@@ -0,0 +1,310 @@
+#include "openvslam/optimize/job_scheduler.h"
+
+#include <spdlog/spdlog.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+
+namespace openvslam {
+namespace optimize {
+
+namespace {
+
+double elapsed_ms(const std::chrono::steady_clock::time_point& from,
+                  const std::chrono::steady_clock::time_point& to) {
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+}  // unnamed namespace
+
+void cancellation_token::cancel() const {
+  auto status = state_->status_.load();
+  while (true) {
+    status_t desired;
+    if (status == status_t::Active) {
+      desired = status_t::Cancelled;
+    } else if (status == status_t::Committing) {
+      desired = status_t::CancelledWhileCommitting;
+    } else {
+      return;
+    }
+    if (state_->status_.compare_exchange_weak(status, desired)) {
+      break;
+    }
+  }
+  if (status == status_t::Active) {
+    state_->force_stop_flag_ = true;
+  }
+}
+
+bool cancellation_token::begin_commit() const {
+  auto status = status_t::Active;
+  return state_->status_.compare_exchange_strong(status, status_t::Committing);
+}
+
+void cancellation_token::end_commit() const {
+  auto status = status_t::Committing;
+  if (state_->status_.compare_exchange_strong(status, status_t::Active)) {
+    return;
+  }
+  if (status == status_t::CancelledWhileCommitting) {
+    state_->status_ = status_t::Cancelled;
+    state_->force_stop_flag_ = true;
+  }
+}
+
+void job_scheduler::job_handle::wait() const {
+  if (!job_) {
+    return;
+  }
+  scheduler_->wait(job_);
+}
+
+void job_scheduler::job_handle::cancel() const {
+  if (!job_) {
+    return;
+  }
+  scheduler_->cancel(job_);
+}
+
+bool job_scheduler::job_handle::is_finished() const {
+  if (!job_) {
+    return true;
+  }
+  std::lock_guard<std::mutex> lock(scheduler_->mtx_);
+  return job_->status_ == job_status_t::Finished;
+}
+
+bool job_scheduler::job_handle::was_cancelled() const {
+  if (!job_) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(scheduler_->mtx_);
+  return job_->status_ == job_status_t::Finished && job_->cancel_is_requested_;
+}
+
+job_scheduler::job_scheduler(const unsigned int num_workers,
+                             const unsigned int max_num_preemptions)
+    : max_num_preemptions_(max_num_preemptions) {
+  spdlog::debug("CONSTRUCT: optimize::job_scheduler");
+  const auto num_threads = std::max(1u, num_workers);
+  workers_.reserve(num_threads);
+  for (unsigned int i = 0; i < num_threads; ++i) {
+    workers_.emplace_back(&job_scheduler::run, this);
+  }
+}
+
+job_scheduler::job_scheduler(const YAML::Node& yaml_node)
+    : job_scheduler(yaml_node["num_workers"].as<unsigned int>(2),
+                    yaml_node["max_num_preemptions"].as<unsigned int>(3)) {}
+
+job_scheduler::~job_scheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    terminate_is_requested_ = true;
+    // the queued jobs are never started
+    for (const auto& job : queued_jobs_) {
+      job->cancel_is_requested_ = true;
+      job->token_.cancel();
+      job->status_ = job_status_t::Finished;
+      auto& metrics = metrics_of(job->priority_);
+      --metrics.num_queued_;
+      ++metrics.num_cancelled_;
+    }
+    queued_jobs_.clear();
+    for (const auto& job : running_jobs_) {
+      job->cancel_is_requested_ = true;
+      job->token_.cancel();
+    }
+  }
+  cv_queue_.notify_all();
+  cv_finished_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+  spdlog::debug("DESTRUCT: optimize::job_scheduler");
+}
+
+job_scheduler::job_handle job_scheduler::submit(const std::string& name,
+                                                const job_priority_t priority,
+                                                const job_t& job,
+                                                const bool is_preemptible) {
+  auto state = std::make_shared<job_state>();
+  state->name_ = name;
+  state->priority_ = priority;
+  state->job_ = job;
+  state->is_preemptible_ = is_preemptible;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    state->sequence_ = num_submissions_++;
+    state->queued_time_ = clock_type::now();
+    auto& metrics = metrics_of(priority);
+    ++metrics.num_submitted_;
+    if (terminate_is_requested_) {
+      state->cancel_is_requested_ = true;
+      state->token_.cancel();
+      state->status_ = job_status_t::Finished;
+      ++metrics.num_cancelled_;
+      return job_handle(this, state);
+    }
+    queued_jobs_.push_back(state);
+    ++metrics.num_queued_;
+    preempt_for(*state);
+  }
+  cv_queue_.notify_one();
+  return job_handle(this, state);
+}
+
+job_metrics job_scheduler::get_metrics(const job_priority_t priority) const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return metrics_.at(static_cast<unsigned int>(priority));
+}
+
+void job_scheduler::run() {
+  std::unique_lock<std::mutex> lock(mtx_);
+  while (true) {
+    cv_queue_.wait(lock, [this] {
+      return terminate_is_requested_ || !queued_jobs_.empty();
+    });
+    if (terminate_is_requested_) {
+      break;
+    }
+
+    const auto job = pop_next_job();
+    job->status_ = job_status_t::Running;
+    running_jobs_.push_back(job);
+    const auto start_time = clock_type::now();
+    auto& metrics = metrics_of(job->priority_);
+    --metrics.num_queued_;
+    ++metrics.num_running_;
+    metrics.total_wait_time_ms_ += elapsed_ms(job->queued_time_, start_time);
+    // copy the token because it is replaced when the job is preempted
+    const auto token = job->token_;
+
+    lock.unlock();
+    spdlog::debug("start optimization job: {}", job->name_);
+    job->job_(token);
+    lock.lock();
+
+    const auto end_time = clock_type::now();
+    running_jobs_.erase(
+        std::find(running_jobs_.begin(), running_jobs_.end(), job));
+    --metrics.num_running_;
+    metrics.total_run_time_ms_ += elapsed_ms(start_time, end_time);
+
+    // the job which has committed its result is not cancelled by the
+    // preemption or cancel(), and it is not run again
+    const bool is_cancelled = token.is_cancelled();
+    job->cancel_is_requested_ = job->cancel_is_requested_ && is_cancelled;
+    if (job->is_preempted_ && is_cancelled && !job->cancel_is_requested_ &&
+        !terminate_is_requested_) {
+      // run the job again from the beginning with a new token
+      spdlog::debug("preempted optimization job: {}", job->name_);
+      job->is_preempted_ = false;
+      job->token_ = cancellation_token();
+      job->status_ = job_status_t::Queued;
+      job->queued_time_ = end_time;
+      queued_jobs_.push_back(job);
+      ++metrics.num_queued_;
+      ++metrics.num_preempted_;
+      continue;
+    }
+
+    job->is_preempted_ = false;
+    job->status_ = job_status_t::Finished;
+    if (job->cancel_is_requested_) {
+      ++metrics.num_cancelled_;
+    } else {
+      ++metrics.num_completed_;
+    }
+    spdlog::debug("finish optimization job: {}", job->name_);
+    cv_finished_.notify_all();
+  }
+}
+
+std::shared_ptr<job_scheduler::job_state> job_scheduler::pop_next_job() {
+  const auto next = std::min_element(
+      queued_jobs_.begin(), queued_jobs_.end(),
+      [](const std::shared_ptr<job_state>& job_1,
+         const std::shared_ptr<job_state>& job_2) {
+        if (job_1->priority_ != job_2->priority_) {
+          return job_2->priority_ < job_1->priority_;
+        }
+        return job_1->sequence_ < job_2->sequence_;
+      });
+  const auto job = *next;
+  queued_jobs_.erase(next);
+  return job;
+}
+
+void job_scheduler::preempt_for(const job_state& job) {
+  // a worker is idle
+  if (running_jobs_.size() + queued_jobs_.size() <= workers_.size()) {
+    return;
+  }
+
+  std::shared_ptr<job_state> victim = nullptr;
+  for (const auto& running_job : running_jobs_) {
+    // a worker is going to be released by the previous preemption
+    if (running_job->is_preempted_) {
+      return;
+    }
+    if (!running_job->is_preemptible_ || running_job->cancel_is_requested_) {
+      continue;
+    }
+    if (job.priority_ <= running_job->priority_) {
+      continue;
+    }
+    if (max_num_preemptions_ <= running_job->num_preemptions_) {
+      continue;
+    }
+    // preempt the job with the lowest priority, then the newest one
+    if (!victim || running_job->priority_ < victim->priority_ ||
+        (running_job->priority_ == victim->priority_ &&
+         victim->sequence_ < running_job->sequence_)) {
+      victim = running_job;
+    }
+  }
+
+  if (!victim) {
+    return;
+  }
+  spdlog::debug("preempt optimization job {} for {}", victim->name_,
+                job.name_);
+  victim->is_preempted_ = true;
+  ++victim->num_preemptions_;
+  victim->token_.cancel();
+}
+
+void job_scheduler::wait(const std::shared_ptr<job_state>& job) {
+  std::unique_lock<std::mutex> lock(mtx_);
+  cv_finished_.wait(
+      lock, [&job] { return job->status_ == job_status_t::Finished; });
+}
+
+void job_scheduler::cancel(const std::shared_ptr<job_state>& job) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (job->status_ == job_status_t::Finished) {
+    return;
+  }
+  job->cancel_is_requested_ = true;
+  job->token_.cancel();
+  if (job->status_ != job_status_t::Queued) {
+    // the worker finishes the job when it returns
+    return;
+  }
+
+  queued_jobs_.erase(std::find(queued_jobs_.begin(), queued_jobs_.end(), job));
+  job->status_ = job_status_t::Finished;
+  auto& metrics = metrics_of(job->priority_);
+  --metrics.num_queued_;
+  ++metrics.num_cancelled_;
+  cv_finished_.notify_all();
+}
+
+job_metrics& job_scheduler::metrics_of(const job_priority_t priority) {
+  return metrics_.at(static_cast<unsigned int>(priority));
+}
+
+}  // namespace optimize
+}  // namespace openvslam
@@ -0,0 +1,255 @@
+#ifndef OPENVSLAM_OPTIMIZE_JOB_SCHEDULER_H
+#define OPENVSLAM_OPTIMIZE_JOB_SCHEDULER_H
+
+#include <yaml-cpp/node/node.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace openvslam {
+namespace optimize {
+
+/**
+ * Token to cancel an optimization job cooperatively
+ * (the copies share the same state, and the flag is passed to g2o as the
+ * force-stop flag. The job must apply its result to the map between
+ * begin_commit() and end_commit() so that a cancellation never follows the
+ * commit of the result.)
+ */
+class cancellation_token {
+ public:
+  //! Constructor
+  cancellation_token() : state_(std::make_shared<shared_state>()) {}
+
+  //! Request the cancellation
+  //! (it is deferred to end_commit() while the job is committing)
+  void cancel() const;
+
+  //! The job has been cancelled or not
+  bool is_cancelled() const {
+    return state_->status_ == status_t::Cancelled;
+  }
+
+  /**
+   * Begin committing the result of the job
+   * (returns false if the job has been cancelled. Unless end_commit() is
+   * called, the job is not cancelled any more.)
+   */
+  bool begin_commit() const;
+
+  //! End committing the result and apply the deferred cancellation
+  void end_commit() const;
+
+  //! Get the force-stop flag for g2o::SparseOptimizer
+  bool* get_force_stop_flag() const { return &state_->force_stop_flag_; }
+
+ private:
+  //! Status of the token
+  enum class status_t {
+    Active,
+    Cancelled,
+    Committing,
+    CancelledWhileCommitting
+  };
+
+  //! State shared by the copies
+  struct shared_state {
+    std::atomic<status_t> status_{status_t::Active};
+    //! force-stop flag for g2o (set when the job is cancelled)
+    bool force_stop_flag_ = false;
+  };
+
+  //! shared state
+  std::shared_ptr<shared_state> state_;
+};
+
+//! Priority of an optimization job
+enum class job_priority_t { Low = 0, Normal = 1, High = 2 };
+
+//! Metrics of the optimization jobs of a priority
+struct job_metrics {
+  //! number of the submitted jobs
+  unsigned int num_submitted_ = 0;
+  //! number of the jobs which ran to the end
+  unsigned int num_completed_ = 0;
+  //! number of the jobs which were cancelled
+  unsigned int num_cancelled_ = 0;
+  //! number of the times the jobs were preempted and queued again
+  unsigned int num_preempted_ = 0;
+  //! number of the jobs in the queue
+  unsigned int num_queued_ = 0;
+  //! number of the jobs which are running
+  unsigned int num_running_ = 0;
+  //! total time between the submission (or the preemption) and the start [ms]
+  double total_wait_time_ms_ = 0.0;
+  //! total time spent by the workers [ms]
+  double total_run_time_ms_ = 0.0;
+};
+
+/**
+ * Scheduler of the background optimization jobs
+ * (the jobs are run on a fixed number of worker threads in the order of the
+ * priorities, then the order of the submissions. When no worker is idle, a
+ * submitted job preempts the running preemptible job with the lowest priority
+ * below its own: the token of the running job is cancelled, and the job is
+ * queued again with a new token when it returns unless it has committed its
+ * result. A job is preempted at most max_num_preemptions times so that it
+ * finishes eventually.)
+ */
+class job_scheduler {
+ private:
+  struct job_state;
+
+ public:
+  //! Body of a job (the token must be checked cooperatively)
+  using job_t = std::function<void(const cancellation_token&)>;
+
+  /**
+   * Handle of a submitted job
+   * (an empty handle behaves as a finished job. The handle must not be used
+   * after the scheduler is destructed.)
+   */
+  class job_handle {
+   public:
+    //! Constructor of an empty handle
+    job_handle() = default;
+
+    //! Block until the job finishes or is cancelled
+    void wait() const;
+
+    //! Cancel the job (the queued job is never started)
+    void cancel() const;
+
+    //! The job has finished or has been cancelled
+    bool is_finished() const;
+
+    //! The job has been cancelled
+    //! (false if the job committed its result before the cancellation)
+    bool was_cancelled() const;
+
+   private:
+    friend class job_scheduler;
+
+    job_handle(job_scheduler* scheduler, const std::shared_ptr<job_state>& job)
+        : scheduler_(scheduler), job_(job) {}
+
+    //! scheduler which runs the job
+    job_scheduler* scheduler_ = nullptr;
+    //! state of the job
+    std::shared_ptr<job_state> job_ = nullptr;
+  };
+
+  //! Constructor
+  explicit job_scheduler(const unsigned int num_workers = 2,
+                         const unsigned int max_num_preemptions = 3);
+
+  //! Constructor
+  explicit job_scheduler(const YAML::Node& yaml_node);
+
+  //! Destructor (the running jobs are cancelled and the workers are joined)
+  ~job_scheduler();
+
+  /**
+   * Submit a job
+   * @param name
+   * @param priority
+   * @param job
+   * @param is_preemptible
+   * @return handle of the job
+   */
+  job_handle submit(const std::string& name, const job_priority_t priority,
+                    const job_t& job, const bool is_preemptible = false);
+
+  //! Get the metrics of the jobs of the priority
+  job_metrics get_metrics(const job_priority_t priority) const;
+
+  //! Get the number of the worker threads
+  unsigned int get_num_workers() const { return workers_.size(); }
+
+ private:
+  using clock_type = std::chrono::steady_clock;
+
+  //! Status of a job
+  enum class job_status_t { Queued, Running, Finished };
+
+  //! State of a submitted job (guarded by mtx_)
+  struct job_state {
+    //! name for logging
+    std::string name_;
+    //! priority
+    job_priority_t priority_ = job_priority_t::Normal;
+    //! body of the job
+    job_t job_;
+    //! the job can be preempted or not
+    bool is_preemptible_ = false;
+    //! order of the submission
+    unsigned long sequence_ = 0;
+    //! token of the current run
+    cancellation_token token_;
+    //! status
+    job_status_t status_ = job_status_t::Queued;
+    //! cancel() has been called or not
+    bool cancel_is_requested_ = false;
+    //! the current run is preempted or not
+    bool is_preempted_ = false;
+    //! number of the times the job has been preempted
+    unsigned int num_preemptions_ = 0;
+    //! time when the job is queued
+    clock_type::time_point queued_time_;
+  };
+
+  //! Main loop of the worker threads
+  void run();
+
+  //! Pop the queued job with the highest priority (mtx_ must be locked)
+  std::shared_ptr<job_state> pop_next_job();
+
+  //! Preempt a running job for the job if no worker is idle
+  //! (mtx_ must be locked)
+  void preempt_for(const job_state& job);
+
+  //! Block until the job finishes
+  void wait(const std::shared_ptr<job_state>& job);
+
+  //! Cancel the job
+  void cancel(const std::shared_ptr<job_state>& job);
+
+  //! Get the metrics of the priority (mtx_ must be locked)
+  job_metrics& metrics_of(const job_priority_t priority);
+
+  //! maximum number of the times a job is preempted
+  const unsigned int max_num_preemptions_;
+
+  //! mutex for the queue, the jobs and the metrics
+  mutable std::mutex mtx_;
+  //! condition variable to wake up the workers
+  std::condition_variable cv_queue_;
+  //! condition variable to notify the finished jobs
+  std::condition_variable cv_finished_;
+  //! queued jobs
+  std::vector<std::shared_ptr<job_state>> queued_jobs_;
+  //! running jobs
+  std::vector<std::shared_ptr<job_state>> running_jobs_;
+  //! counter of the submissions
+  unsigned long num_submissions_ = 0;
+  //! the workers should be terminated or not
+  bool terminate_is_requested_ = false;
+  //! metrics of each priority
+  std::array<job_metrics, 3> metrics_;
+
+  //! worker threads
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace optimize
+}  // namespace openvslam
+
+#endif  // OPENVSLAM_OPTIMIZE_JOB_SCHEDULER_H
@@ -9,6 +9,7 @@
 #include <g2o/solvers/dense/linear_solver_dense.h>
 #include <g2o/solvers/eigen/linear_solver_eigen.h>
 #include <g2o/types/sba/types_six_dof_expmap.h>
+#include <spdlog/spdlog.h>
 
 #include <Eigen/StdVector>
 #include <memory>
@@ -33,6 +34,10 @@ void local_bundle_adjuster::optimize(
     data::map_database* map_db,
     const std::shared_ptr<openvslam::data::keyframe>& curr_keyfrm,
     bool* const force_stop_flag) const {
+  // the result is discarded if the map is corrected by the loop BA after this
+  // point, otherwise the corrections of the local keyframes are overwritten
+  const unsigned int correction_epoch = map_db->correction_epoch_;
+
   // 1. Aggregate the local and fixed keyframes, and local landmarks
 
   // Correct the local keyframes of the current keyframe
@@ -280,7 +285,12 @@ void local_bundle_adjuster::optimize(
   // 8. Update the information
 
   {
-    std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+    std::lock_guard<std::mutex> lock(map_db->mtx_database_);
+
+    if (correction_epoch != map_db->correction_epoch_) {
+      spdlog::debug("discard the result of local BA after the loop BA");
+      return;
+    }
 
     for (const auto& outlier_obs : outlier_observations) {
       const auto& keyfrm = outlier_obs.first;
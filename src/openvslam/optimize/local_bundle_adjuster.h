@@ -29,6 +29,8 @@ class local_bundle_adjuster {
 
   /**
    * Perform optimization
+   * (the result is not written to the map if the loop BA corrects the map
+   * during the optimization)
    * @param map_db
    * @param curr_keyfrm
    * @param force_stop_flag
@@ -14,53 +14,44 @@ namespace publish {
 frame_publisher::frame_publisher(const std::shared_ptr<config>& cfg,
                                  data::map_database* map_db,
                                  const unsigned int img_width)
-    : cfg_(cfg),
-      map_db_(map_db),
-      img_width_(img_width),
-      img_(cv::Mat(480, img_width_, CV_8UC3, cv::Scalar(0, 0, 0))) {
+    : cfg_(cfg), map_db_(map_db), img_width_(img_width) {
   spdlog::debug("CONSTRUCT: publish::frame_publisher");
+  auto snapshot = std::make_shared<frame_snapshot>();
+  snapshot->img_ = cv::Mat(480, img_width_, CV_8UC3, cv::Scalar(0, 0, 0));
+  snapshot_ = snapshot;
 }
 
 frame_publisher::~frame_publisher() {
   spdlog::debug("DESTRUCT: publish::frame_publisher");
 }
 
-cv::Mat frame_publisher::draw_frame() {
-  cv::Mat img;
-  tracker_state_t tracking_state;
-  std::vector<cv::KeyPoint> init_keypts;
-  std::vector<int> init_matches;
-  std::vector<cv::KeyPoint> curr_keypts;
-  bool mapping_is_enabled;
-  std::vector<bool> is_tracked;
-
-  // copy to avoid memory access conflict
-  {
-    std::lock_guard<std::mutex> lock(mtx_);
-
-    img_.copyTo(img);
-
-    tracking_state = tracking_state_;
-
-    // copy tracking information
-    if (tracking_state == tracker_state_t::Initializing) {
-      init_keypts = init_keypts_;
-      init_matches = init_matches_;
-    }
+void frame_publisher::set_image_sharing(const bool img_is_shared) {
+  img_is_shared_ = img_is_shared;
+}
 
-    curr_keypts = curr_keypts_;
+cv::Mat frame_publisher::draw_frame() {
+  const auto snapshot = std::atomic_load(&snapshot_);
 
-    mapping_is_enabled = mapping_is_enabled_;
+  std::lock_guard<std::mutex> lock(mtx_rendered_);
 
-    is_tracked = is_tracked_;
+  // the snapshot has already been rendered
+  if (!rendered_img_.empty() && rendered_version_ == snapshot->version_) {
+    return rendered_img_;
   }
 
   // resize image
-  const float mag = (img_width_ < img_.cols)
-                        ? static_cast<float>(img_width_) / img.cols
+  // (the raw image is shared with the tracker, so it is drawn on a new buffer)
+  const auto& raw_img = snapshot->img_;
+  const float mag = (img_width_ < raw_img.cols)
+                        ? static_cast<float>(img_width_) / raw_img.cols
                         : 1.0;
+  cv::Mat img;
   if (mag != 1.0) {
-    cv::resize(img, img, cv::Size(), mag, mag, cv::INTER_NEAREST);
+    cv::resize(raw_img, img, cv::Size(), mag, mag, cv::INTER_NEAREST);
+  } else if (raw_img.channels() < 3) {
+    img = raw_img;
+  } else {
+    img = raw_img.clone();
   }
 
   // to draw COLOR information
@@ -70,15 +61,15 @@ cv::Mat frame_publisher::draw_frame() {
 
   // draw keypoints
   unsigned int num_tracked = 0;
-  switch (tracking_state) {
+  switch (snapshot->tracking_state_) {
     case tracker_state_t::Initializing: {
-      num_tracked =
-          draw_initial_points(img, init_keypts, init_matches, curr_keypts, mag);
+      num_tracked = draw_initial_points(img, snapshot->init_pts_,
+                                        snapshot->init_matched_pts_, mag);
       break;
     }
     case tracker_state_t::Tracking: {
-      num_tracked = draw_tracked_points(img, curr_keypts, is_tracked,
-                                        mapping_is_enabled, mag);
+      num_tracked = draw_tracked_points(img, snapshot->tracked_pts_,
+                                        snapshot->mapping_is_enabled_, mag);
       break;
     }
     default: {
@@ -88,85 +79,75 @@ cv::Mat frame_publisher::draw_frame() {
 
   spdlog::trace("num_tracked: {}", num_tracked);
 
+  rendered_img_ = img;
+  rendered_version_ = snapshot->version_;
   return img;
 }
 
-unsigned int frame_publisher::draw_initial_points(
-    cv::Mat& img, const std::vector<cv::KeyPoint>& init_keypts,
-    const std::vector<int>& init_matches,
-    const std::vector<cv::KeyPoint>& curr_keypts, const float mag) const {
-  unsigned int num_tracked = 0;
-
-  for (unsigned int i = 0; i < init_matches.size(); ++i) {
-    if (init_matches.at(i) < 0) {
-      continue;
-    }
-
-    cv::circle(img, init_keypts.at(i).pt * mag, 2, mapping_color_, -1);
-    cv::circle(img, curr_keypts.at(init_matches.at(i)).pt * mag, 2,
-               mapping_color_, -1);
-    cv::line(img, init_keypts.at(i).pt * mag,
-             curr_keypts.at(init_matches.at(i)).pt * mag, mapping_color_);
+unsigned int frame_publisher::get_version() {
+  return std::atomic_load(&snapshot_)->version_;
+}
 
-    ++num_tracked;
+unsigned int frame_publisher::draw_initial_points(
+    cv::Mat& img, const std::vector<cv::Point2f>& init_pts,
+    const std::vector<cv::Point2f>& init_matched_pts, const float mag) const {
+  for (unsigned int i = 0; i < init_pts.size(); ++i) {
+    cv::circle(img, init_pts.at(i) * mag, 2, mapping_color_, -1);
+    cv::circle(img, init_matched_pts.at(i) * mag, 2, mapping_color_, -1);
+    cv::line(img, init_pts.at(i) * mag, init_matched_pts.at(i) * mag,
+             mapping_color_);
   }
 
-  return num_tracked;
+  return init_pts.size();
 }
 
 unsigned int frame_publisher::draw_tracked_points(
-    cv::Mat& img, const std::vector<cv::KeyPoint>& curr_keypts,
-    const std::vector<bool>& is_tracked, const bool mapping_is_enabled,
-    const float mag) const {
+    cv::Mat& img, const std::vector<cv::Point2f>& tracked_pts,
+    const bool mapping_is_enabled, const float mag) const {
   constexpr float radius = 5;
 
-  unsigned int num_tracked = 0;
-
-  for (unsigned int i = 0; i < curr_keypts.size(); ++i) {
-    if (!is_tracked.at(i)) {
-      continue;
-    }
-
-    const cv::Point2f pt_begin{curr_keypts.at(i).pt.x * mag - radius,
-                               curr_keypts.at(i).pt.y * mag - radius};
-    const cv::Point2f pt_end{curr_keypts.at(i).pt.x * mag + radius,
-                             curr_keypts.at(i).pt.y * mag + radius};
-
-    if (mapping_is_enabled) {
-      cv::rectangle(img, pt_begin, pt_end, mapping_color_);
-      cv::circle(img, curr_keypts.at(i).pt * mag, 2, mapping_color_, -1);
-    } else {
-      cv::rectangle(img, pt_begin, pt_end, localization_color_);
-      cv::circle(img, curr_keypts.at(i).pt * mag, 2, localization_color_, -1);
-    }
+  const auto& color = mapping_is_enabled ? mapping_color_ : localization_color_;
+  for (const auto& pt : tracked_pts) {
+    const cv::Point2f pt_begin{pt.x * mag - radius, pt.y * mag - radius};
+    const cv::Point2f pt_end{pt.x * mag + radius, pt.y * mag + radius};
 
-    ++num_tracked;
+    cv::rectangle(img, pt_begin, pt_end, color);
+    cv::circle(img, pt * mag, 2, color, -1);
   }
 
-  return num_tracked;
+  return tracked_pts.size();
 }
 
 void frame_publisher::update(tracking_module* tracker, const cv::Mat& img,
                              double elapsed_ms) {
-  std::lock_guard<std::mutex> lock(mtx_);
-
-  img.copyTo(img_);
-
-  const auto num_curr_keypts = tracker->curr_frm_.frm_obs_.num_keypts_;
-  curr_keypts_ = tracker->curr_frm_.frm_obs_.keypts_;
-  elapsed_ms_ = elapsed_ms;
-  mapping_is_enabled_ = tracker->get_mapping_module_status();
-  tracking_state_ = tracker->tracking_state_;
-
-  is_tracked_ = std::vector<bool>(num_curr_keypts, false);
-
-  switch (tracking_state_) {
+  // the snapshot is built on this thread, then published atomically
+  auto snapshot = std::make_shared<frame_snapshot>();
+  snapshot->version_ = ++version_;
+  // the buffer of the caller can be overwritten unless the sharing is enabled
+  snapshot->img_ = img_is_shared_ ? img : img.clone();
+  snapshot->elapsed_ms_ = elapsed_ms;
+  snapshot->mapping_is_enabled_ = tracker->get_mapping_module_status();
+  snapshot->tracking_state_ = tracker->tracking_state_;
+
+  // only the keypoints to be drawn are copied
+  const auto& curr_keypts = tracker->curr_frm_.frm_obs_.keypts_;
+  switch (snapshot->tracking_state_) {
     case tracker_state_t::Initializing: {
-      init_keypts_ = tracker->get_initial_keypoints();
-      init_matches_ = tracker->get_initial_matches();
+      const auto init_keypts = tracker->get_initial_keypoints();
+      const auto init_matches = tracker->get_initial_matches();
+      for (unsigned int i = 0; i < init_matches.size(); ++i) {
+        if (init_matches.at(i) < 0) {
+          continue;
+        }
+        snapshot->init_pts_.push_back(init_keypts.at(i).pt);
+        snapshot->init_matched_pts_.push_back(
+            curr_keypts.at(init_matches.at(i)).pt);
+      }
       break;
     }
     case tracker_state_t::Tracking: {
+      const auto num_curr_keypts = tracker->curr_frm_.frm_obs_.num_keypts_;
+      snapshot->tracked_pts_.reserve(num_curr_keypts);
       for (unsigned int i = 0; i < num_curr_keypts; ++i) {
         const auto& lm = tracker->curr_frm_.landmarks_.at(i);
         if (!lm) {
@@ -177,7 +158,7 @@ void frame_publisher::update(tracking_module* tracker, const cv::Mat& img,
         }
 
         if (0 < lm->num_observations()) {
-          is_tracked_.at(i) = true;
+          snapshot->tracked_pts_.push_back(curr_keypts.at(i).pt);
         }
       }
       break;
@@ -186,6 +167,9 @@ void frame_publisher::update(tracking_module* tracker, const cv::Mat& img,
       break;
     }
   }
+
+  std::atomic_store(&snapshot_,
+                    std::shared_ptr<const frame_snapshot>(std::move(snapshot)));
 }
 
 }  // namespace publish
@@ -1,6 +1,7 @@
 #ifndef OPENVSLAM_PUBLISH_FRAME_PUBLISHER_H
 #define OPENVSLAM_PUBLISH_FRAME_PUBLISHER_H
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <opencv2/core/core.hpp>
@@ -19,6 +20,35 @@ class map_database;
 
 namespace publish {
 
+/**
+ * Tracking information of a frame to be drawn
+ * (immutable after it is published, so it is shared with the viewers without
+ * copying)
+ */
+struct frame_snapshot {
+  //! version (incremented by every update)
+  unsigned int version_ = 0;
+  //! raw img (shared with the caller of frame_publisher::update() if the image
+  //! sharing is enabled)
+  cv::Mat img_;
+  //! tracking state
+  tracker_state_t tracking_state_ = tracker_state_t::Initializing;
+
+  //! initial keypoints which are matched to the current keypoints
+  std::vector<cv::Point2f> init_pts_;
+  //! current keypoints which are matched to init_pts_
+  std::vector<cv::Point2f> init_matched_pts_;
+
+  //! current keypoints which are tracked
+  std::vector<cv::Point2f> tracked_pts_;
+
+  //! elapsed time for tracking
+  double elapsed_ms_ = 0.0;
+
+  //! mapping module status
+  bool mapping_is_enabled_ = true;
+};
+
 class frame_publisher {
  public:
   /**
@@ -35,26 +65,40 @@ class frame_publisher {
 
   /**
    * Update tracking information
+   * (the image is copied unless the image sharing is enabled)
    * NOTE: should be accessed from system thread
    */
   void update(tracking_module* tracker, const cv::Mat& img, double elapsed_ms);
 
+  /**
+   * Enable or disable the image sharing
+   * (if enabled, the image passed to update() is shared without copying, so
+   * the caller must not overwrite its buffer afterwards. Disabled by default)
+   */
+  void set_image_sharing(const bool img_is_shared);
+
   /**
    * Get the current image with tracking information
+   * (the image is rendered once for each version and shared with the other
+   * callers, so it must not be modified)
    * NOTE: should be accessed from viewer thread
    */
   cv::Mat draw_frame();
 
+  /**
+   * Get the version of the tracking information
+   * (the version is incremented by every update)
+   */
+  unsigned int get_version();
+
  protected:
-  unsigned int draw_initial_points(cv::Mat& img,
-                                   const std::vector<cv::KeyPoint>& init_keypts,
-                                   const std::vector<int>& init_matches,
-                                   const std::vector<cv::KeyPoint>& curr_keypts,
-                                   const float mag = 1.0) const;
+  unsigned int draw_initial_points(
+      cv::Mat& img, const std::vector<cv::Point2f>& init_pts,
+      const std::vector<cv::Point2f>& init_matched_pts,
+      const float mag = 1.0) const;
 
   unsigned int draw_tracked_points(cv::Mat& img,
-                                   const std::vector<cv::KeyPoint>& curr_keypts,
-                                   const std::vector<bool>& is_tracked,
+                                   const std::vector<cv::Point2f>& tracked_pts,
                                    const bool mapping_is_enabled,
                                    const float mag = 1.0) const;
 
@@ -69,31 +113,22 @@ class frame_publisher {
   //! maximum size of output images
   const int img_width_;
 
+  //! the latest snapshot
+  //! (accessed with std::atomic_load and std::atomic_store)
+  std::shared_ptr<const frame_snapshot> snapshot_;
+  //! version of the latest snapshot (accessed only from system thread)
+  unsigned int version_ = 0;
+  //! the image passed to update() is shared without copying or not
+  std::atomic<bool> img_is_shared_{false};
+
   // -------------------------------------------
   //! mutex to access variables below
-  std::mutex mtx_;
-
-  //! raw img
-  cv::Mat img_;
-  //! tracking state
-  tracker_state_t tracking_state_;
-
-  //! initial keypoints
-  std::vector<cv::KeyPoint> init_keypts_;
-  //! matching between initial frame and current frame
-  std::vector<int> init_matches_;
-
-  //! current keypoints
-  std::vector<cv::KeyPoint> curr_keypts_;
-
-  //! elapsed time for tracking
-  double elapsed_ms_ = 0.0;
-
-  //! mapping module status
-  bool mapping_is_enabled_;
+  std::mutex mtx_rendered_;
 
-  //! tracking flag for each current keypoint
-  std::vector<bool> is_tracked_;
+  //! image rendered from the snapshot of rendered_version_
+  cv::Mat rendered_img_;
+  //! version of rendered_img_
+  unsigned int rendered_version_ = 0;
 };
 
 }  // namespace publish
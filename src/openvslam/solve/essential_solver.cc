@@ -1,7 +1,150 @@
 #include "openvslam/solve/essential_solver.h"
 
+#include "openvslam/solve/ransac.h"
 #include "openvslam/util/converter.h"
-#include "openvslam/util/random_array.h"
+
+namespace {
+using namespace openvslam;
+
+using MatX3_t = Eigen::Matrix<double, Eigen::Dynamic, 3>;
+
+//! Estimation problem of an essential matrix for solve::ransac
+class essential_problem {
+ public:
+  using model_t = Mat33_t;
+  static constexpr unsigned int min_set_size = 8;
+
+  //! Buffers to compute and score an essential matrix
+  struct workspace_t {
+    //! minimum set of the bearing vectors of shot 1
+    eigen_alloc_vector<Vec3_t> min_set_bearings_1_ =
+        eigen_alloc_vector<Vec3_t>(min_set_size);
+    //! minimum set of the bearing vectors of shot 2
+    eigen_alloc_vector<Vec3_t> min_set_bearings_2_ =
+        eigen_alloc_vector<Vec3_t>(min_set_size);
+    //! normal vectors of the epipolar planes
+    MatX3_t epiplanes_;
+    //! residuals in shot 2
+    Eigen::ArrayXd residuals_in_2_;
+    //! residuals in shot 1
+    Eigen::ArrayXd residuals_in_1_;
+  };
+
+  essential_problem(const eigen_alloc_vector<Vec3_t>& bearings_1,
+                    const eigen_alloc_vector<Vec3_t>& bearings_2,
+                    const std::vector<std::pair<int, int>>& matches_12)
+      : bearings_1_(bearings_1),
+        bearings_2_(bearings_2),
+        matches_12_(matches_12) {
+    // arrange the matched bearing vectors as the rows
+    const auto num_matches = matches_12_.size();
+    matched_bearings_1_.resize(num_matches, 3);
+    matched_bearings_2_.resize(num_matches, 3);
+    for (unsigned int i = 0; i < num_matches; ++i) {
+      matched_bearings_1_.row(i) =
+          bearings_1_.at(matches_12_.at(i).first).transpose();
+      matched_bearings_2_.row(i) =
+          bearings_2_.at(matches_12_.at(i).second).transpose();
+    }
+  }
+
+  unsigned int get_num_data() const { return matches_12_.size(); }
+
+  bool compute_model(const std::array<unsigned int, min_set_size>& min_set,
+                     workspace_t& workspace, model_t& E_21) const {
+    for (unsigned int i = 0; i < min_set_size; ++i) {
+      const auto idx = min_set.at(i);
+      workspace.min_set_bearings_1_.at(i) =
+          bearings_1_.at(matches_12_.at(idx).first);
+      workspace.min_set_bearings_2_.at(i) =
+          bearings_2_.at(matches_12_.at(idx).second);
+    }
+    E_21 = solve::essential_solver::compute_E_21(workspace.min_set_bearings_1_,
+                                                 workspace.min_set_bearings_2_);
+    return true;
+  }
+
+  //! Check inliers of the epipolar constraint
+  //! (Note: inlier flags are set to `inlier_match` and a score is returned)
+  float score_model(const model_t& E_21, workspace_t& workspace,
+                    std::vector<bool>& is_inlier_match) const {
+    const auto num_points = matches_12_.size();
+
+    is_inlier_match.resize(num_points);
+
+    // outlier threshold as cosine value between a bearing vector and a normal
+    // vector of the epipolar plane
+    constexpr float residual_cos_thr = 0.01745240643;
+
+    // 1. Compute symmetric transfer errors of all the matches at once
+
+    // 1-1. Transform the bearings in shot 1 to the epipolar planes in shot 2,
+    //      then compute transfer errors (= dot product)
+    workspace.epiplanes_.noalias() = matched_bearings_1_ * E_21.transpose();
+    workspace.residuals_in_2_ =
+        workspace.epiplanes_.cwiseProduct(matched_bearings_2_)
+            .rowwise()
+            .sum()
+            .array()
+            .abs() /
+        workspace.epiplanes_.rowwise().norm().array();
+
+    // 1-2. Transform the bearings in shot 2 to the epipolar planes in shot 1,
+    //      then compute transfer errors (= dot product)
+    workspace.epiplanes_.noalias() = matched_bearings_2_ * E_21;
+    workspace.residuals_in_1_ =
+        workspace.epiplanes_.cwiseProduct(matched_bearings_1_)
+            .rowwise()
+            .sum()
+            .array()
+            .abs() /
+        workspace.epiplanes_.rowwise().norm().array();
+
+    // 2. Check inliers and accumulate the score
+
+    float score = 0;
+
+    for (unsigned int i = 0; i < num_points; ++i) {
+      const float residual_in_2 = workspace.residuals_in_2_(i);
+      // if a match is inlier, accumulate the score
+      if (residual_cos_thr < residual_in_2) {
+        is_inlier_match.at(i) = false;
+        continue;
+      } else {
+        is_inlier_match.at(i) = true;
+        score += residual_in_2;
+      }
+
+      const float residual_in_1 = workspace.residuals_in_1_(i);
+      // if a match is inlier, accumulate the score
+      if (residual_cos_thr < residual_in_1) {
+        is_inlier_match.at(i) = false;
+        continue;
+      } else {
+        is_inlier_match.at(i) = true;
+        score += residual_in_1;
+      }
+    }
+
+    return score;
+  }
+
+ private:
+  //! bearing vectors of shot 1
+  const eigen_alloc_vector<Vec3_t>& bearings_1_;
+  //! bearing vectors of shot 2
+  const eigen_alloc_vector<Vec3_t>& bearings_2_;
+  //! matched indices between shots 1 and 2
+  const std::vector<std::pair<int, int>>& matches_12_;
+  //! matched bearing vectors of shot 1
+  MatX3_t matched_bearings_1_;
+  //! matched bearing vectors of shot 2
+  MatX3_t matched_bearings_2_;
+};
+
+constexpr unsigned int essential_problem::min_set_size;
+
+}  // unnamed namespace
 
 namespace openvslam {
 namespace solve {
@@ -13,61 +156,39 @@ essential_solver::essential_solver(
     : bearings_1_(bearings_1),
       bearings_2_(bearings_2),
       matches_12_(matches_12),
-      random_engine_(util::create_random_engine(use_fixed_seed)) {}
+      use_fixed_seed_(use_fixed_seed) {}
 
 void essential_solver::find_via_ransac(const unsigned int max_num_iter,
-                                       const bool recompute) {
+                                       const bool recompute,
+                                       const double confidence,
+                                       const unsigned int num_threads) {
   const auto num_matches = static_cast<unsigned int>(matches_12_.size());
 
   // 1. Prepare for RANSAC
 
+  // RANSAC variables
+  best_score_ = 0.0;
+  is_inlier_match_ = std::vector<bool>(num_matches, false);
+  num_iter_ = 0;
+
   // minimum number of samples (= 8)
-  constexpr unsigned int min_set_size = 8;
+  constexpr unsigned int min_set_size = essential_problem::min_set_size;
   if (num_matches < min_set_size) {
     solution_is_valid_ = false;
     return;
   }
 
-  // RANSAC variables
-  best_score_ = 0.0;
-  is_inlier_match_ = std::vector<bool>(num_matches, false);
-
-  // minimum set of keypoint matches
-  eigen_alloc_vector<Vec3_t> min_set_bearings_1(min_set_size);
-  eigen_alloc_vector<Vec3_t> min_set_bearings_2(min_set_size);
-
-  // shared variables in RANSAC loop
-  // essential matrix from shot 1 to shot 2
-  Mat33_t E_21_in_sac;
-  // inlier/outlier flags
-  std::vector<bool> is_inlier_match_in_sac(num_matches, false);
-  // score of essential matrix
-  float score_in_sac;
+  const essential_problem problem(bearings_1_, bearings_2_, matches_12_);
 
   // 2. RANSAC loop
 
-  for (unsigned int iter = 0; iter < max_num_iter; iter++) {
-    // 2-1. Create a minimum set
-    const auto indices = util::create_random_array(
-        min_set_size, 0U, num_matches - 1, random_engine_);
-    for (unsigned int i = 0; i < min_set_size; ++i) {
-      const auto idx = indices.at(i);
-      min_set_bearings_1.at(i) = bearings_1_.at(matches_12_.at(idx).first);
-      min_set_bearings_2.at(i) = bearings_2_.at(matches_12_.at(idx).second);
-    }
-
-    // 2-2. Compute an essential matrix
-    E_21_in_sac = compute_E_21(min_set_bearings_1, min_set_bearings_2);
-
-    // 2-3. Check inliers and compute a score
-    score_in_sac = check_inliers(E_21_in_sac, is_inlier_match_in_sac);
-
-    // 2-4. Update the best model
-    if (best_score_ < score_in_sac) {
-      best_score_ = score_in_sac;
-      best_E_21_ = E_21_in_sac;
-      is_inlier_match_ = is_inlier_match_in_sac;
-    }
+  ransac<essential_problem> sac(problem, use_fixed_seed_);
+  const bool model_is_found = sac.run(max_num_iter, confidence, num_threads);
+  num_iter_ = sac.get_num_iterations();
+  if (model_is_found) {
+    best_score_ = sac.get_best_score();
+    best_E_21_ = sac.get_best_model();
+    is_inlier_match_ = sac.get_inlier_flags();
   }
 
   const auto num_inliers =
@@ -92,7 +213,8 @@ void essential_solver::find_via_ransac(const unsigned int max_num_iter,
   }
   best_E_21_ =
       solve::essential_solver::compute_E_21(inlier_bearing_1, inlier_bearing_2);
-  best_score_ = check_inliers(best_E_21_, is_inlier_match_);
+  essential_problem::workspace_t workspace;
+  best_score_ = problem.score_model(best_E_21_, workspace, is_inlier_match_);
 }
 
 Mat33_t essential_solver::compute_E_21(
@@ -175,60 +297,5 @@ Mat33_t essential_solver::create_E_21(const Mat33_t& rot_1w,
   return trans_21_x * rot_21;
 }
 
-float essential_solver::check_inliers(const Mat33_t& E_21,
-                                      std::vector<bool>& is_inlier_match) {
-  const auto num_points = matches_12_.size();
-
-  is_inlier_match.resize(num_points);
-
-  const Mat33_t E_12 = E_21.transpose();
-
-  float score = 0;
-
-  // outlier threshold as cosine value between a bearing vector and a normal
-  // vector of the epipolar plane
-  constexpr float residual_cos_thr = 0.01745240643;
-
-  for (unsigned int i = 0; i < num_points; ++i) {
-    const auto& bearing_1 = bearings_1_.at(matches_12_.at(i).first);
-    const auto& bearing_2 = bearings_2_.at(matches_12_.at(i).second);
-
-    // 1. Transform a point in shot 1 to the epipolar plane in shot 2,
-    //    then compute a transfer error (= dot product)
-
-    const Vec3_t epiplane_in_2 = E_21 * bearing_1;
-    const float residual_in_2 =
-        std::abs(epiplane_in_2.dot(bearing_2) / epiplane_in_2.norm());
-
-    // if a match is inlier, accumulate the score
-    if (residual_cos_thr < residual_in_2) {
-      is_inlier_match.at(i) = false;
-      continue;
-    } else {
-      is_inlier_match.at(i) = true;
-      score += residual_in_2;
-    }
-
-    // 2. Transform a point in shot 2 to the epipolar plane in shot 1,
-    //    then compute a transfer error (= dot product)
-
-    const Vec3_t epiplane_in_1 = E_12 * bearing_2;
-
-    const float residual_in_1 =
-        std::abs(epiplane_in_1.dot(bearing_1) / epiplane_in_1.norm());
-
-    // if a match is inlier, accumulate the score
-    if (residual_cos_thr < residual_in_1) {
-      is_inlier_match.at(i) = false;
-      continue;
-    } else {
-      is_inlier_match.at(i) = true;
-      score += residual_in_1;
-    }
-  }
-
-  return score;
-}
-
 }  // namespace solve
 }  // namespace openvslam
@@ -2,7 +2,6 @@
 #define OPENVSLAM_SOLVE_ESSENTIAL_SOLVER_H
 
 #include <opencv2/core.hpp>
-#include <random>
 #include <vector>
 
 #include "openvslam/type.h"
@@ -24,8 +23,12 @@ class essential_solver {
   virtual ~essential_solver() = default;
 
   //! Find the most reliable essential matrix via RANSAC
+  //! (the iterations are terminated when the confidence is reached, and the
+  //! hypotheses are evaluated with num_threads threads)
   void find_via_ransac(const unsigned int max_num_iter,
-                       const bool recompute = true);
+                       const bool recompute = true,
+                       const double confidence = 0.99,
+                       const unsigned int num_threads = 1);
 
   //! Check if the solution is valid or not
   bool solution_is_valid() const { return solution_is_valid_; }
@@ -39,6 +42,9 @@ class essential_solver {
   //! Get the inlier matches
   std::vector<bool> get_inlier_matches() const { return is_inlier_match_; }
 
+  //! Get the number of the RANSAC iterations in the last estimation
+  unsigned int get_num_iterations() const { return num_iter_; }
+
   //! Compute an essential matrix with 8-point algorithm
   static Mat33_t compute_E_21(const eigen_alloc_vector<Vec3_t>& bearings_1,
                               const eigen_alloc_vector<Vec3_t>& bearings_2);
@@ -53,10 +59,6 @@ class essential_solver {
                              const Mat33_t& rot_2w, const Vec3_t& trans_2w);
 
  private:
-  //! Check inliers of the epipolar constraint
-  //! (Note: inlier flags are set to `inlier_match` and a score is returned)
-  float check_inliers(const Mat33_t& E_21, std::vector<bool>& is_inlier_match);
-
   //! bearing vectors of shot 1
   const eigen_alloc_vector<Vec3_t>& bearings_1_;
   //! bearing vectors of shot 2
@@ -72,8 +74,10 @@ class essential_solver {
   Mat33_t best_E_21_;
   //! inlier matches computed via RANSAC
   std::vector<bool> is_inlier_match_;
-  //! random engine for RANSAC
-  std::mt19937 random_engine_;
+  //! number of the RANSAC iterations
+  unsigned int num_iter_ = 0;
+  //! use the fixed seed for RANSAC or not
+  const bool use_fixed_seed_;
 };
 
 }  // namespace solve
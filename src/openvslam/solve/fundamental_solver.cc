@@ -2,8 +2,171 @@
 
 #include "openvslam/solve/common.h"
 #include "openvslam/solve/essential_solver.h"
+#include "openvslam/solve/ransac.h"
 #include "openvslam/util/converter.h"
-#include "openvslam/util/random_array.h"
+
+namespace {
+using namespace openvslam;
+
+using MatX3_t = Eigen::Matrix<double, Eigen::Dynamic, 3>;
+
+//! Estimation problem of a fundamental matrix for solve::ransac
+class fundamental_problem {
+ public:
+  using model_t = Mat33_t;
+  static constexpr unsigned int min_set_size = 8;
+
+  //! Buffers to compute and score a fundamental matrix
+  struct workspace_t {
+    //! minimum set of the normalized keypoints of shot 1
+    std::vector<cv::Point2f> min_set_keypts_1_ =
+        std::vector<cv::Point2f>(min_set_size);
+    //! minimum set of the normalized keypoints of shot 2
+    std::vector<cv::Point2f> min_set_keypts_2_ =
+        std::vector<cv::Point2f>(min_set_size);
+    //! epipolar lines
+    MatX3_t epilines_;
+    //! standardized distances to the epipolar lines in shot 2
+    Eigen::ArrayXd chi_sqs_2_;
+    //! standardized distances to the epipolar lines in shot 1
+    Eigen::ArrayXd chi_sqs_1_;
+  };
+
+  fundamental_problem(const std::vector<cv::KeyPoint>& undist_keypts_1,
+                      const std::vector<cv::KeyPoint>& undist_keypts_2,
+                      const std::vector<std::pair<int, int>>& matches_12,
+                      const float sigma)
+      : matches_12_(matches_12), inv_sigma_sq_(1.0 / (sigma * sigma)) {
+    // apply normalization
+    Mat33_t transform_2;
+    solve::normalize(undist_keypts_1, normalized_keypts_1_, transform_1_);
+    solve::normalize(undist_keypts_2, normalized_keypts_2_, transform_2);
+    transform_2_t_ = transform_2.transpose();
+
+    // arrange the matched keypoints in homogeneous coordinates as the rows
+    const auto num_matches = matches_12_.size();
+    pts_1_.resize(num_matches, 3);
+    pts_2_.resize(num_matches, 3);
+    for (unsigned int i = 0; i < num_matches; ++i) {
+      pts_1_.row(i) = util::converter::to_homogeneous(
+                          undist_keypts_1.at(matches_12_.at(i).first).pt)
+                          .transpose();
+      pts_2_.row(i) = util::converter::to_homogeneous(
+                          undist_keypts_2.at(matches_12_.at(i).second).pt)
+                          .transpose();
+    }
+  }
+
+  unsigned int get_num_data() const { return matches_12_.size(); }
+
+  bool compute_model(const std::array<unsigned int, min_set_size>& min_set,
+                     workspace_t& workspace, model_t& F_21) const {
+    for (unsigned int i = 0; i < min_set_size; ++i) {
+      const auto idx = min_set.at(i);
+      workspace.min_set_keypts_1_.at(i) =
+          normalized_keypts_1_.at(matches_12_.at(idx).first);
+      workspace.min_set_keypts_2_.at(i) =
+          normalized_keypts_2_.at(matches_12_.at(idx).second);
+    }
+    F_21 = compute_F_21(workspace.min_set_keypts_1_,
+                        workspace.min_set_keypts_2_);
+    return true;
+  }
+
+  //! Compute a fundamental matrix from the normalized keypoints
+  Mat33_t compute_F_21(
+      const std::vector<cv::Point2f>& normalized_keypts_1,
+      const std::vector<cv::Point2f>& normalized_keypts_2) const {
+    const Mat33_t normalized_F_21 = solve::fundamental_solver::compute_F_21(
+        normalized_keypts_1, normalized_keypts_2);
+    return transform_2_t_ * normalized_F_21 * transform_1_;
+  }
+
+  //! Check inliers of the epipolar constraint
+  //! (Note: inlier flags are set to `inlier_match` and a score is returned)
+  float score_model(const model_t& F_21, workspace_t& workspace,
+                    std::vector<bool>& is_inlier_match) const {
+    const auto num_points = matches_12_.size();
+
+    // chi-squared value (p=0.05, n=1)
+    constexpr float chi_sq_thr = 3.841;
+    // chi-squared value (p=0.05, n=2)
+    constexpr float score_thr = 5.991;
+
+    is_inlier_match.resize(num_points);
+
+    // 1. Compute symmetric transfer errors of all the matches at once
+
+    // 1-1. Transform the points in shot 1 to the epipolar lines in shot 2,
+    //      then compute transfer errors (= dot product)
+    workspace.epilines_.noalias() = pts_1_ * F_21.transpose();
+    workspace.chi_sqs_2_ =
+        (workspace.epilines_.cwiseProduct(pts_2_).rowwise().sum().array())
+            .square() /
+        workspace.epilines_.leftCols<2>().rowwise().squaredNorm().array() *
+        inv_sigma_sq_;
+
+    // 1-2. Transform the points in shot 2 to the epipolar lines in shot 1,
+    //      then compute transfer errors (= dot product)
+    workspace.epilines_.noalias() = pts_2_ * F_21;
+    workspace.chi_sqs_1_ =
+        (workspace.epilines_.cwiseProduct(pts_1_).rowwise().sum().array())
+            .square() /
+        workspace.epilines_.leftCols<2>().rowwise().squaredNorm().array() *
+        inv_sigma_sq_;
+
+    // 2. Check inliers and accumulate the score
+
+    float score = 0;
+
+    for (unsigned int i = 0; i < num_points; ++i) {
+      const float chi_sq_2 = workspace.chi_sqs_2_(i);
+      // if a match is inlier, accumulate the score
+      if (chi_sq_thr < chi_sq_2) {
+        is_inlier_match.at(i) = false;
+        continue;
+      } else {
+        is_inlier_match.at(i) = true;
+        score += score_thr - chi_sq_2;
+      }
+
+      const float chi_sq_1 = workspace.chi_sqs_1_(i);
+      // if a match is inlier, accumulate the score
+      if (chi_sq_thr < chi_sq_1) {
+        is_inlier_match.at(i) = false;
+        continue;
+      } else {
+        is_inlier_match.at(i) = true;
+        score += score_thr - chi_sq_1;
+      }
+    }
+
+    return score;
+  }
+
+  //! normalized keypoints of shot 1
+  std::vector<cv::Point2f> normalized_keypts_1_;
+  //! normalized keypoints of shot 2
+  std::vector<cv::Point2f> normalized_keypts_2_;
+
+ private:
+  //! matched indices between shots 1 and 2
+  const std::vector<std::pair<int, int>>& matches_12_;
+  //! inverse of the variance of keypoint detection error
+  const double inv_sigma_sq_;
+  //! normalization transform of shot 1
+  Mat33_t transform_1_;
+  //! transpose of the normalization transform of shot 2
+  Mat33_t transform_2_t_;
+  //! matched undistorted keypoints of shot 1 in homogeneous coordinates
+  MatX3_t pts_1_;
+  //! matched undistorted keypoints of shot 2 in homogeneous coordinates
+  MatX3_t pts_2_;
+};
+
+constexpr unsigned int fundamental_problem::min_set_size;
+
+}  // unnamed namespace
 
 namespace openvslam {
 namespace solve {
@@ -17,75 +180,41 @@ fundamental_solver::fundamental_solver(
       undist_keypts_2_(undist_keypts_2),
       matches_12_(matches_12),
       sigma_(sigma),
-      random_engine_(util::create_random_engine(use_fixed_seed)) {}
+      use_fixed_seed_(use_fixed_seed) {}
 
 void fundamental_solver::find_via_ransac(const unsigned int max_num_iter,
-                                         const bool recompute) {
+                                         const bool recompute,
+                                         const double confidence,
+                                         const unsigned int num_threads) {
   const auto num_matches = static_cast<unsigned int>(matches_12_.size());
 
-  // 0. Normalize keypoint coordinates
-
-  // apply normalization
-  std::vector<cv::Point2f> normalized_keypts_1, normalized_keypts_2;
-  Mat33_t transform_1, transform_2;
-  normalize(undist_keypts_1_, normalized_keypts_1, transform_1);
-  normalize(undist_keypts_2_, normalized_keypts_2, transform_2);
-
-  const Mat33_t transform_2_t = transform_2.transpose();
-
   // 1. Prepare for RANSAC
 
+  // RANSAC variables
+  best_score_ = 0.0;
+  is_inlier_match_ = std::vector<bool>(num_matches, false);
+  num_iter_ = 0;
+
   // minimum number of samples (= 8)
-  constexpr unsigned int min_set_size = 8;
+  constexpr unsigned int min_set_size = fundamental_problem::min_set_size;
   if (num_matches < min_set_size) {
     solution_is_valid_ = false;
     return;
   }
 
-  // RANSAC variables
-  best_score_ = 0.0;
-  is_inlier_match_ = std::vector<bool>(num_matches, false);
-
-  // minimum set of keypoint matches
-  std::vector<cv::Point2f> min_set_keypts_1(min_set_size);
-  std::vector<cv::Point2f> min_set_keypts_2(min_set_size);
-
-  // shared variables in RANSAC loop
-  // fundamental matrix from shot 1 to shot 2
-  Mat33_t F_21_in_sac;
-  // inlier/outlier flags
-  std::vector<bool> is_inlier_match_in_sac(num_matches, false);
-  // score of fundamental matrix
-  float score_in_sac;
+  // normalize the keypoint coordinates
+  const fundamental_problem problem(undist_keypts_1_, undist_keypts_2_,
+                                    matches_12_, sigma_);
 
   // 2. RANSAC loop
 
-  for (unsigned int iter = 0; iter < max_num_iter; iter++) {
-    // 2-1. Create a minimum set
-    const auto indices = util::create_random_array(
-        min_set_size, 0U, num_matches - 1, random_engine_);
-    for (unsigned int i = 0; i < min_set_size; ++i) {
-      const auto idx = indices.at(i);
-      min_set_keypts_1.at(i) =
-          normalized_keypts_1.at(matches_12_.at(idx).first);
-      min_set_keypts_2.at(i) =
-          normalized_keypts_2.at(matches_12_.at(idx).second);
-    }
-
-    // 2-2. Compute a fundamental matrix
-    const Mat33_t normalized_F_21 =
-        compute_F_21(min_set_keypts_1, min_set_keypts_2);
-    F_21_in_sac = transform_2_t * normalized_F_21 * transform_1;
-
-    // 2-3. Check inliers and compute a score
-    score_in_sac = check_inliers(F_21_in_sac, is_inlier_match_in_sac);
-
-    // 2-4. Update the best model
-    if (best_score_ < score_in_sac) {
-      best_score_ = score_in_sac;
-      best_F_21_ = F_21_in_sac;
-      is_inlier_match_ = is_inlier_match_in_sac;
-    }
+  ransac<fundamental_problem> sac(problem, use_fixed_seed_);
+  const bool model_is_found = sac.run(max_num_iter, confidence, num_threads);
+  num_iter_ = sac.get_num_iterations();
+  if (model_is_found) {
+    best_score_ = sac.get_best_score();
+    best_F_21_ = sac.get_best_model();
+    is_inlier_match_ = sac.get_inlier_flags();
   }
 
   const auto num_inliers =
@@ -105,15 +234,15 @@ void fundamental_solver::find_via_ransac(const unsigned int max_num_iter,
   for (unsigned int i = 0; i < matches_12_.size(); ++i) {
     if (is_inlier_match_.at(i)) {
       inlier_normalized_keypts_1.push_back(
-          normalized_keypts_1.at(matches_12_.at(i).first));
+          problem.normalized_keypts_1_.at(matches_12_.at(i).first));
       inlier_normalized_keypts_2.push_back(
-          normalized_keypts_2.at(matches_12_.at(i).second));
+          problem.normalized_keypts_2_.at(matches_12_.at(i).second));
     }
   }
-  const Mat33_t normalized_F_21 = solve::fundamental_solver::compute_F_21(
-      inlier_normalized_keypts_1, inlier_normalized_keypts_2);
-  best_F_21_ = transform_2_t * normalized_F_21 * transform_1;
-  best_score_ = check_inliers(best_F_21_, is_inlier_match_);
+  best_F_21_ = problem.compute_F_21(inlier_normalized_keypts_1,
+                                    inlier_normalized_keypts_2);
+  fundamental_problem::workspace_t workspace;
+  best_score_ = problem.score_model(best_F_21_, workspace, is_inlier_match_);
 }
 
 Mat33_t fundamental_solver::compute_F_21(
@@ -177,79 +306,5 @@ Mat33_t fundamental_solver::create_F_21(const Mat33_t& rot_1w,
   return cam_matrix_2.transpose().inverse() * E_21 * cam_matrix_1.inverse();
 }
 
-float fundamental_solver::check_inliers(const Mat33_t& F_21,
-                                        std::vector<bool>& is_inlier_match) {
-  const auto num_points = matches_12_.size();
-
-  // chi-squared value (p=0.05, n=1)
-  constexpr float chi_sq_thr = 3.841;
-  // chi-squared value (p=0.05, n=2)
-  constexpr float score_thr = 5.991;
-
-  is_inlier_match.resize(num_points);
-
-  const Mat33_t F_12 = F_21.transpose();
-
-  float score = 0;
-
-  const float inv_sigma_sq = 1.0 / (sigma_ * sigma_);
-
-  for (unsigned int i = 0; i < num_points; ++i) {
-    const auto& keypt_1 = undist_keypts_1_.at(matches_12_.at(i).first);
-    const auto& keypt_2 = undist_keypts_2_.at(matches_12_.at(i).second);
-
-    // 1. Transform to homogeneous coordinates
-
-    const Vec3_t pt_1 = util::converter::to_homogeneous(keypt_1.pt);
-    const Vec3_t pt_2 = util::converter::to_homogeneous(keypt_2.pt);
-
-    // 2. Compute symmetric transfer error
-
-    // 2-1. Transform a point in shot 1 to the epipolar line in shot 2,
-    //      then compute a transfer error (= dot product)
-
-    const Vec3_t epiline_in_2 = F_21 * pt_1;
-
-    const float residual_in_2 = epiline_in_2.dot(pt_2);
-    const float dist_sq_2 = residual_in_2 * residual_in_2 /
-                            epiline_in_2.block<2, 1>(0, 0).squaredNorm();
-
-    // standardization
-    const float chi_sq_2 = dist_sq_2 * inv_sigma_sq;
-
-    // if a match is inlier, accumulate the score
-    if (chi_sq_thr < chi_sq_2) {
-      is_inlier_match.at(i) = false;
-      continue;
-    } else {
-      is_inlier_match.at(i) = true;
-      score += score_thr - chi_sq_2;
-    }
-
-    // 2. Transform a point in shot 2 to the epipolar line in shot 1,
-    //    then compute a transfer error (= dot product)
-
-    const Vec3_t epiline_in_1 = F_12 * pt_2;
-
-    const float residual_in_1 = epiline_in_1.dot(pt_1);
-    const float dist_sq_1 = residual_in_1 * residual_in_1 /
-                            epiline_in_1.block<2, 1>(0, 0).squaredNorm();
-
-    // standardization
-    const float chi_sq_1 = dist_sq_1 * inv_sigma_sq;
-
-    // if a match is inlier, accumulate the score
-    if (chi_sq_thr < chi_sq_1) {
-      is_inlier_match.at(i) = false;
-      continue;
-    } else {
-      is_inlier_match.at(i) = true;
-      score += score_thr - chi_sq_1;
-    }
-  }
-
-  return score;
-}
-
 }  // namespace solve
 }  // namespace openvslam
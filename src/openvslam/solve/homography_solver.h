@@ -2,7 +2,6 @@
 #define OPENVSLAM_SOLVE_HOMOGRAPHY_SOLVER_H
 
 #include <opencv2/core.hpp>
-#include <random>
 #include <vector>
 
 #include "openvslam/camera/base.h"
@@ -24,8 +23,12 @@ class homography_solver {
   virtual ~homography_solver() = default;
 
   //! Find the most reliable homography matrix via RASNAC
+  //! (the iterations are terminated when the confidence is reached, and the
+  //! hypotheses are evaluated with num_threads threads)
   void find_via_ransac(const unsigned int max_num_iter,
-                       const bool recompute = true);
+                       const bool recompute = true,
+                       const double confidence = 0.99,
+                       const unsigned int num_threads = 1);
 
   //! Check if the solution is valid or not
   bool solution_is_valid() const { return solution_is_valid_; }
@@ -39,6 +42,9 @@ class homography_solver {
   //! Get the inlier matches
   std::vector<bool> get_inlier_matches() const { return is_inlier_match_; }
 
+  //! Get the number of the RANSAC iterations in the last estimation
+  unsigned int get_num_iterations() const { return num_iter_; }
+
   //! Compute a homography matrix with 4-point algorithm
   static Mat33_t compute_H_21(const std::vector<cv::Point2f>& keypts_1,
                               const std::vector<cv::Point2f>& keypts_2);
@@ -51,10 +57,6 @@ class homography_solver {
                         eigen_alloc_vector<Vec3_t>& init_normals);
 
  private:
-  //! Check inliers of homography transformation
-  //! (Note: inlier flags are set to_inlier_match and a score is returned)
-  float check_inliers(const Mat33_t& H_21, std::vector<bool>& is_inlier_match);
-
   //! undistorted keypoints of shot 1
   const std::vector<cv::KeyPoint> undist_keypts_1_;
   //! undistorted keypoints of shot 2
@@ -72,8 +74,10 @@ class homography_solver {
   Mat33_t best_H_21_;
   //! inlier matches computed via RANSAC
   std::vector<bool> is_inlier_match_;
-  //! random engine for RANSAC
-  std::mt19937 random_engine_;
+  //! number of the RANSAC iterations
+  unsigned int num_iter_ = 0;
+  //! use the fixed seed for RANSAC or not
+  const bool use_fixed_seed_;
 };
 
 }  // namespace solve
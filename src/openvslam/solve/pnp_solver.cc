@@ -2,6 +2,10 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
 #include "openvslam/util/fancy_index.h"
 #include "openvslam/util/random_array.h"
 #include "openvslam/util/trigonometric.h"
@@ -9,80 +13,126 @@
 namespace openvslam {
 namespace solve {
 
+constexpr unsigned int pnp_solver::min_set_size_;
+
 pnp_solver::pnp_solver(const eigen_alloc_vector<Vec3_t>& valid_bearings,
                        const std::vector<cv::KeyPoint>& valid_keypts,
                        const eigen_alloc_vector<Vec3_t>& valid_landmarks,
                        const std::vector<float>& scale_factors,
-                       const unsigned int min_num_inliers, bool use_fixed_seed)
+                       const unsigned int min_num_inliers, bool use_fixed_seed,
+                       const std::vector<unsigned int>& match_dists)
     : num_matches_(valid_bearings.size()),
-      valid_bearings_(valid_bearings),
-      valid_landmarks_(valid_landmarks),
       min_num_inliers_(min_num_inliers),
+      use_prosac_(!match_dists.empty()),
       random_engine_(util::create_random_engine(use_fixed_seed)) {
   spdlog::debug("CONSTRUCT: solve::pnp_solver");
 
-  max_cos_errors_.clear();
+  assert(num_matches_ == valid_bearings.size());
+  assert(num_matches_ == valid_keypts.size());
+  assert(num_matches_ == valid_landmarks.size());
+  assert(!use_prosac_ || num_matches_ == match_dists.size());
+
+  // Sort the matches in ascending order of the descriptor distances
+  match_order_.resize(num_matches_);
+  std::iota(match_order_.begin(), match_order_.end(), 0);
+  if (use_prosac_) {
+    std::stable_sort(match_order_.begin(), match_order_.end(),
+                     [&match_dists](const unsigned int i, const unsigned int j) {
+                       return match_dists.at(i) < match_dists.at(j);
+                     });
+  }
+
+  valid_bearings_.resize(num_matches_, 3);
+  valid_landmarks_.resize(num_matches_, 3);
   max_cos_errors_.resize(num_matches_);
 
   constexpr double max_rad_error = 1.0 * M_PI / 180.0;
   for (unsigned int i = 0; i < num_matches_; ++i) {
+    const auto idx = match_order_.at(i);
+    valid_bearings_.row(i) = valid_bearings.at(idx).transpose();
+    valid_landmarks_.row(i) = valid_landmarks.at(idx).transpose();
     // Calculate radial error threshold from each scale factor
     const auto max_rad_error_with_scale =
-        scale_factors.at(valid_keypts.at(i).octave) * max_rad_error;
-    max_cos_errors_.at(i) = util::cos(max_rad_error_with_scale);
+        scale_factors.at(valid_keypts.at(idx).octave) * max_rad_error;
+    max_cos_errors_(i) = util::cos(max_rad_error_with_scale);
   }
 
-  assert(num_matches_ == valid_bearings_.size());
-  assert(num_matches_ == valid_keypts.size());
-  assert(num_matches_ == valid_landmarks_.size());
-  assert(num_matches_ == max_cos_errors_.size());
+  pos_cs_.resize(num_matches_, 3);
+  dots_.resize(num_matches_);
+  norms_.resize(num_matches_);
+  inlier_flags_in_sac_.resize(num_matches_);
+  best_inlier_flags_.resize(num_matches_);
 }
 
 pnp_solver::~pnp_solver() { spdlog::debug("DESTRUCT: solve::pnp_solver"); }
 
 void pnp_solver::find_via_ransac(const unsigned int max_num_iter,
-                                 const bool recompute) {
+                                 const bool recompute,
+                                 const double confidence) {
   // 1. Prepare for RANSAC
 
-  // minimum number of samples (= 4)
-  static constexpr unsigned int min_set_size = 4;
-  if (num_matches_ < min_set_size || num_matches_ < min_num_inliers_) {
-    solution_is_valid_ = false;
+  num_iter_ = 0;
+  solution_is_valid_ = false;
+  if (num_matches_ < min_set_size_ || num_matches_ < min_num_inliers_) {
     return;
   }
 
   // RANSAC variables
   unsigned int max_num_inliers = 0;
-  is_inlier_match = std::vector<bool>(num_matches_, false);
+  best_inlier_flags_.setConstant(false);
+  // the number of iterations required to reach the confidence, which is
+  // updated from the inlier ratio of the best model
+  unsigned int num_required_iter = max_num_iter;
+  const double log_outlier_prob = std::log(1.0 - confidence);
+
+  // PROSAC variables
+  // (see "Matching with PROSAC - Progressive Sample Consensus" (Chum and Matas,
+  // CVPR 2005))
+  // the number of the matches from which the minimum sets are drawn
+  unsigned int num_sampled = use_prosac_ ? min_set_size_ : num_matches_;
+  // the average number of the minimum sets drawn from the first num_sampled
+  // matches in the max_num_iter uniform draws
+  double num_expected_sets = max_num_iter;
+  for (unsigned int i = 0; i < min_set_size_; ++i) {
+    num_expected_sets *= static_cast<double>(num_sampled - i) /
+                         static_cast<double>(num_matches_ - i);
+  }
+  // the iteration at which num_sampled is increased
+  unsigned int growth_iter = 1;
 
   // shared variables in RANSAC loop
   // rotation from world to camera
   Mat33_t rot_cw_in_sac;
   // translation from world to camera
   Vec3_t trans_cw_in_sac;
-  // inlier/outlier flags
-  std::vector<bool> is_inlier_match_in_sac;
+  // indices of the minimum set
+  std::array<unsigned int, min_set_size_> min_set;
 
-  eigen_alloc_vector<Vec3_t> min_set_bearings;
-  eigen_alloc_vector<Vec3_t> min_set_pos_ws;
+  eigen_alloc_vector<Vec3_t> min_set_bearings(min_set_size_);
+  eigen_alloc_vector<Vec3_t> min_set_pos_ws(min_set_size_);
 
   // 2. RANSAC loop
 
-  for (unsigned int iter = 0; iter < max_num_iter; ++iter) {
+  for (unsigned int iter = 1; iter <= num_required_iter; ++iter) {
     // 2-1. Create a minimum set
-    const auto random_indices = util::create_random_array(
-        min_set_size, 0U, num_matches_ - 1, random_engine_);
-    assert(random_indices.size() == min_set_size);
-
-    min_set_bearings.clear();
-    min_set_pos_ws.clear();
-
-    for (const auto i : random_indices) {
-      const Vec3_t& bearing = valid_bearings_.at(i);
-      const Vec3_t& pos_w = valid_landmarks_.at(i);
+    bool include_last = false;
+    if (num_sampled < num_matches_) {
+      if (iter == growth_iter) {
+        const double next_num_expected_sets =
+            num_expected_sets * (num_sampled + 1) /
+            (num_sampled + 1 - min_set_size_);
+        growth_iter += static_cast<unsigned int>(
+            std::ceil(next_num_expected_sets - num_expected_sets));
+        num_expected_sets = next_num_expected_sets;
+        ++num_sampled;
+      }
+      include_last = iter <= growth_iter;
+    }
+    draw_min_set(num_sampled, include_last, min_set);
 
-      min_set_bearings.push_back(bearing);
-      min_set_pos_ws.push_back(pos_w);
+    for (unsigned int k = 0; k < min_set_size_; ++k) {
+      min_set_bearings.at(k) = valid_bearings_.row(min_set.at(k)).transpose();
+      min_set_pos_ws.at(k) = valid_landmarks_.row(min_set.at(k)).transpose();
     }
 
     // 2-2. Compute a camera pose
@@ -90,18 +140,38 @@ void pnp_solver::find_via_ransac(const unsigned int max_num_iter,
                  trans_cw_in_sac);
 
     // 2-3. Check inliers and compute a score
-    const auto num_inliers =
-        check_inliers(rot_cw_in_sac, trans_cw_in_sac, is_inlier_match_in_sac);
+    const auto num_inliers = check_inliers(rot_cw_in_sac, trans_cw_in_sac);
+    num_iter_ = iter;
 
     // 2-4. Update the best model
     if (max_num_inliers < num_inliers) {
       max_num_inliers = num_inliers;
       best_rot_cw_ = rot_cw_in_sac;
       best_trans_cw_ = trans_cw_in_sac;
-      is_inlier_match = is_inlier_match_in_sac;
+      best_inlier_flags_.swap(inlier_flags_in_sac_);
+
+      // 2-5. Update the number of the required iterations
+      const double inlier_ratio =
+          static_cast<double>(num_inliers) / num_matches_;
+      const double min_set_prob = std::pow(inlier_ratio, min_set_size_);
+      if (1.0 - 1e-12 < min_set_prob) {
+        num_required_iter = iter;
+      } else if (0.0 < min_set_prob) {
+        const double num_iter =
+            std::ceil(log_outlier_prob / std::log(1.0 - min_set_prob));
+        if (num_iter < num_required_iter) {
+          num_required_iter = std::max(iter, static_cast<unsigned int>(num_iter));
+        }
+      }
     }
   }
 
+  // Restore the order of the inlier flags
+  is_inlier_match = std::vector<bool>(num_matches_, false);
+  for (unsigned int i = 0; i < num_matches_; ++i) {
+    is_inlier_match.at(match_order_.at(i)) = best_inlier_flags_(i);
+  }
+
   if (max_num_inliers > min_num_inliers_) {
     solution_is_valid_ = true;
   }
@@ -114,46 +184,61 @@ void pnp_solver::find_via_ransac(const unsigned int max_num_iter,
 
   eigen_alloc_vector<Vec3_t> inlier_bearings;
   eigen_alloc_vector<Vec3_t> inlier_pos_ws;
+  inlier_bearings.reserve(max_num_inliers);
+  inlier_pos_ws.reserve(max_num_inliers);
   for (unsigned int i = 0; i < num_matches_; ++i) {
-    if (!is_inlier_match.at(i)) {
+    if (!best_inlier_flags_(i)) {
       continue;
     }
-    const Vec3_t& bearing = valid_bearings_.at(i);
-    const Vec3_t& pos_w = valid_landmarks_.at(i);
-    inlier_bearings.push_back(bearing);
-    inlier_pos_ws.push_back(pos_w);
+    inlier_bearings.push_back(valid_bearings_.row(i).transpose());
+    inlier_pos_ws.push_back(valid_landmarks_.row(i).transpose());
   }
 
   compute_pose(inlier_bearings, inlier_pos_ws, best_rot_cw_, best_trans_cw_);
 }
 
-unsigned int pnp_solver::check_inliers(const Mat33_t& rot_cw,
-                                       const Vec3_t& trans_cw,
-                                       std::vector<bool>& is_inlier) {
-  unsigned int num_inliers = 0;
-
-  is_inlier.resize(num_matches_);
-  for (unsigned int i = 0; i < num_matches_; ++i) {
-    const Vec3_t& pos_w = valid_landmarks_.at(i);
-    const Vec3_t& bearing = valid_bearings_.at(i);
-
-    const Vec3_t pos_c = rot_cw * pos_w + trans_cw;
-
-    // Compute cosine similarity between the bearing vector and the position of
-    // the 3D point
-    const auto cos = pos_c.dot(bearing) / pos_c.norm();
-
-    // The match is inlier if the cosine similarity is less than or equal to the
-    // threshold
-    if (max_cos_errors_.at(i) < cos) {
-      is_inlier.at(i) = true;
-      ++num_inliers;
-    } else {
-      is_inlier.at(i) = false;
+void pnp_solver::draw_min_set(
+    const unsigned int num_sampled, const bool include_last,
+    std::array<unsigned int, min_set_size_>& min_set) {
+  assert(min_set_size_ <= num_sampled && num_sampled <= num_matches_);
+
+  // Draw the distinct indices by rejection, which does not allocate any memory
+  // and is fast enough because num_sampled is much larger than the set size
+  unsigned int num_drawn = 0;
+  unsigned int rand_max = num_sampled - 1;
+  if (include_last) {
+    min_set.at(num_drawn++) = num_sampled - 1;
+    rand_max = num_sampled - 2;
+  }
+  std::uniform_int_distribution<unsigned int> uniform_int_distribution(
+      0, rand_max);
+  while (num_drawn < min_set_size_) {
+    const auto idx = uniform_int_distribution(random_engine_);
+    if (std::find(min_set.begin(), min_set.begin() + num_drawn, idx) ==
+        min_set.begin() + num_drawn) {
+      min_set.at(num_drawn++) = idx;
     }
   }
+}
 
-  return num_inliers;
+unsigned int pnp_solver::check_inliers(const Mat33_t& rot_cw,
+                                       const Vec3_t& trans_cw) {
+  // Transform all of the 3D points at once (each column of the arrays is
+  // contiguous, so the operations below are vectorized by Eigen)
+  pos_cs_.noalias() = valid_landmarks_ * rot_cw.transpose();
+  pos_cs_.rowwise() += trans_cw.transpose();
+
+  // Compute cosine similarity between the bearing vector and the position of
+  // the 3D point
+  // (Note: the comparison is done without the division by the norms)
+  dots_ = (pos_cs_.array() * valid_bearings_.array()).rowwise().sum();
+  norms_ = pos_cs_.rowwise().norm();
+
+  // The match is inlier if the cosine similarity is greater than the threshold
+  inlier_flags_in_sac_ =
+      max_cos_errors_.array() * norms_.array() < dots_.array();
+
+  return inlier_flags_in_sac_.count();
 }
 
 double pnp_solver::compute_pose(
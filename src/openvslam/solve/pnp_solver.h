@@ -1,6 +1,7 @@
 #ifndef OPENVSLAM_SOLVE_PNP_SOLVER_H
 #define OPENVSLAM_SOLVE_PNP_SOLVER_H
 
+#include <array>
 #include <random>
 #include <vector>
 
@@ -15,19 +16,27 @@ class pnp_solver {
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
   //! Constructor
+  //! (if the descriptor distances of the matches are given, the minimum sets
+  //! are drawn from the matches with the smaller distances first (PROSAC),
+  //! otherwise they are drawn uniformly)
   pnp_solver(const eigen_alloc_vector<Vec3_t>& valid_bearings,
              const std::vector<cv::KeyPoint>& valid_keypts,
              const eigen_alloc_vector<Vec3_t>& valid_landmarks,
              const std::vector<float>& scale_factors,
              const unsigned int min_num_inliers = 10,
-             bool use_fixed_seed = false);
+             bool use_fixed_seed = false,
+             const std::vector<unsigned int>& match_dists =
+                 std::vector<unsigned int>());
 
   //! Destructor
   virtual ~pnp_solver();
 
   //! Find the most reliable camera pose via RANSAC
+  //! (the loop is terminated before max_num_iter when the probability that a
+  //! better model exists falls below 1 - confidence)
   void find_via_ransac(const unsigned int max_num_iter,
-                       const bool recompute = true);
+                       const bool recompute = true,
+                       const double confidence = 0.99);
 
   //! Check if the solution is valid or not
   bool solution_is_valid() const { return solution_is_valid_; }
@@ -46,28 +55,61 @@ class pnp_solver {
   //! Get the inlier flags estimated via RANSAC
   std::vector<bool> get_inlier_flags() const { return is_inlier_match; }
 
+  //! Get the number of the RANSAC iterations in the last find_via_ransac()
+  unsigned int get_num_iterations() const { return num_iter_; }
+
  private:
+  //! N x 3 matrix whose columns are stored contiguously
+  using MatX3_t = Eigen::Matrix<double, Eigen::Dynamic, 3>;
+  //! boolean array
+  using ArrayXb_t = Eigen::Array<bool, Eigen::Dynamic, 1>;
+
+  //! minimum number of samples (= 4)
+  static constexpr unsigned int min_set_size_ = 4;
+
+  //! Draw a minimum set from the first num_sampled matches
+  //! (if include_last is true, the last one of them is always included)
+  void draw_min_set(const unsigned int num_sampled, const bool include_last,
+                    std::array<unsigned int, min_set_size_>& min_set);
+
   //! Check inliers of 2D-3D matches
-  //! (Note: inlier flags are set to_inlier_match and the number of inliers is
-  //! returned)
-  unsigned int check_inliers(const Mat33_t& rot_cw, const Vec3_t& trans_cw,
-                             std::vector<bool>& is_inlier);
+  //! (Note: inlier flags are set to inlier_flags_in_sac_ and the number of
+  //! inliers is returned)
+  unsigned int check_inliers(const Mat33_t& rot_cw, const Vec3_t& trans_cw);
 
   //! the number of 2D-3D matches
   const unsigned int num_matches_;
-  // the following vectors are corresponded as element-wise
-  //! bearing vector
-  eigen_alloc_vector<Vec3_t> valid_bearings_;
-  //! 3D point
-  eigen_alloc_vector<Vec3_t> valid_landmarks_;
+  // the following arrays are sorted by the quality of the matches and
+  // corresponded as row-wise
+  //! bearing vectors
+  MatX3_t valid_bearings_;
+  //! 3D points
+  MatX3_t valid_landmarks_;
   //! acceptable maximum error
-  std::vector<float> max_cos_errors_;
+  VecX_t max_cos_errors_;
+  //! original index of each of the sorted matches
+  std::vector<unsigned int> match_order_;
+
+  // buffers of the inlier check, which are reused in the RANSAC loop
+  //! 3D points in the camera coordinates
+  MatX3_t pos_cs_;
+  //! inner products of the bearings and the 3D points
+  VecX_t dots_;
+  //! norms of the 3D points in the camera coordinates
+  VecX_t norms_;
+  //! inlier flags of the current hypothesis
+  ArrayXb_t inlier_flags_in_sac_;
+  //! inlier flags of the best hypothesis
+  ArrayXb_t best_inlier_flags_;
 
   //! minimum number of inliers
   //! (Note: if the number of inliers is less than this, the solution is
   //! regarded as invalid)
   const unsigned int min_num_inliers_;
 
+  //! the matches are sorted by their quality or not
+  const bool use_prosac_;
+
   //! the solution is valid or not
   bool solution_is_valid_ = false;
   //! most reliable rotation
@@ -76,6 +118,8 @@ class pnp_solver {
   Vec3_t best_trans_cw_;
   //! inlier matches computed via RANSAC
   std::vector<bool> is_inlier_match;
+  //! number of the RANSAC iterations
+  unsigned int num_iter_ = 0;
   //! random engine for RANSAC
   std::mt19937 random_engine_;
 
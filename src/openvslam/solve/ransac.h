@@ -0,0 +1,297 @@
+#ifndef OPENVSLAM_SOLVE_RANSAC_H
+#define OPENVSLAM_SOLVE_RANSAC_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "openvslam/type.h"
+#include "openvslam/util/random_array.h"
+
+namespace openvslam {
+namespace solve {
+
+/**
+ * RANSAC engine shared by the solvers
+ *
+ * The estimation problem is given as the template parameter which has
+ * - model_t: type of the model
+ * - workspace_t: buffers to compute and score a model (created per thread)
+ * - min_set_size: number of the data in a minimum set
+ * - unsigned int get_num_data() const
+ * - bool compute_model(const std::array<unsigned int, min_set_size>& min_set,
+ *                      workspace_t& workspace, model_t& model) const
+ *   (false is returned if the minimum set is degenerate)
+ * - float score_model(const model_t& model, workspace_t& workspace,
+ *                     std::vector<bool>& is_inlier) const
+ *   (the inlier flags are set and the score, higher is better, is returned)
+ * compute_model() and score_model() are called from the multiple threads.
+ *
+ * The minimum sets are drawn on the calling thread and the hypotheses are
+ * evaluated in parallel, then the results are reduced in the order of the
+ * iterations, so that the estimate does not depend on the number of the
+ * threads.
+ */
+template <typename Problem>
+class ransac {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  using model_t = typename Problem::model_t;
+  using workspace_t = typename Problem::workspace_t;
+  using min_set_t = std::array<unsigned int, Problem::min_set_size>;
+
+  //! Constructor
+  explicit ransac(const Problem& problem, const bool use_fixed_seed = false)
+      : problem_(problem),
+        random_engine_(util::create_random_engine(use_fixed_seed)) {}
+
+  //! Destructor
+  virtual ~ransac() = default;
+
+  /**
+   * Find the model with the best score
+   * (the number of iterations is bounded by max_num_iter, and is reduced
+   * adaptively when the inlier ratio of the hypotheses is large enough to
+   * reach the confidence)
+   * @param max_num_iter
+   * @param confidence
+   * @param num_threads
+   * @return true if a non-degenerate model is found
+   */
+  bool run(const unsigned int max_num_iter, const double confidence = 0.99,
+           const unsigned int num_threads = 1);
+
+  //! Get the best model
+  const model_t& get_best_model() const { return best_model_; }
+
+  //! Get the score of the best model
+  float get_best_score() const { return best_score_; }
+
+  //! Get the inlier flags of the best model
+  const std::vector<bool>& get_inlier_flags() const { return is_inlier_; }
+
+  //! Get the number of the inliers of the best model
+  unsigned int get_num_inliers() const { return num_inliers_; }
+
+  //! Get the number of the iterations in the last run
+  unsigned int get_num_iterations() const { return num_iter_; }
+
+ private:
+  //! Evaluate the hypotheses until the shared bound of the iterations
+  void evaluate_hypotheses(const double confidence,
+                           std::atomic<unsigned int>& next_iter,
+                           std::atomic<unsigned int>& iter_bound);
+
+  //! Compute the number of the iterations which is required to draw an
+  //! outlier-free minimum set with the confidence
+  unsigned int compute_num_required_iters(
+      const unsigned int num_inliers, const double confidence,
+      const unsigned int max_num_iter) const;
+
+  //! Draw the distinct indices of a minimum set
+  void draw_min_set(const unsigned int num_data, min_set_t& min_set);
+
+  //! estimation problem
+  const Problem& problem_;
+  //! random engine for RANSAC
+  std::mt19937 random_engine_;
+
+  //! minimum sets of all of the iterations
+  std::vector<min_set_t> min_sets_;
+  //! hypotheses of all of the iterations
+  eigen_alloc_vector<model_t> models_;
+  //! the hypotheses are valid or not
+  std::vector<unsigned char> model_is_valid_;
+  //! scores of the hypotheses
+  std::vector<float> scores_;
+  //! numbers of the inliers of the hypotheses
+  std::vector<unsigned int> nums_inliers_;
+
+  //! best model
+  model_t best_model_;
+  //! score of the best model
+  float best_score_ = 0.0;
+  //! inlier flags of the best model
+  std::vector<bool> is_inlier_;
+  //! number of the inliers of the best model
+  unsigned int num_inliers_ = 0;
+  //! number of the iterations in the last run
+  unsigned int num_iter_ = 0;
+};
+
+template <typename Problem>
+bool ransac<Problem>::run(const unsigned int max_num_iter,
+                          const double confidence,
+                          const unsigned int num_threads) {
+  const auto num_data = problem_.get_num_data();
+
+  best_score_ = 0.0;
+  is_inlier_ = std::vector<bool>(num_data, false);
+  num_inliers_ = 0;
+  num_iter_ = 0;
+
+  if (num_data < Problem::min_set_size || max_num_iter == 0) {
+    return false;
+  }
+
+  // 1. Draw all of the minimum sets in advance
+  //    (the sequence of the minimum sets depends only on the random engine)
+
+  min_sets_.resize(max_num_iter);
+  for (auto& min_set : min_sets_) {
+    draw_min_set(num_data, min_set);
+  }
+  models_.resize(max_num_iter);
+  model_is_valid_.assign(max_num_iter, 0);
+  scores_.assign(max_num_iter, 0.0);
+  nums_inliers_.assign(max_num_iter, 0);
+
+  // 2. Evaluate the hypotheses in parallel
+
+  std::atomic<unsigned int> next_iter(0);
+  std::atomic<unsigned int> iter_bound(max_num_iter);
+  if (num_threads <= 1) {
+    evaluate_hypotheses(confidence, next_iter, iter_bound);
+  } else {
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (unsigned int i = 1; i < num_threads; ++i) {
+      threads.emplace_back(&ransac::evaluate_hypotheses, this, confidence,
+                           std::ref(next_iter), std::ref(iter_bound));
+    }
+    evaluate_hypotheses(confidence, next_iter, iter_bound);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  // 3. Reduce the results in the order of the iterations
+  //    (the hypotheses beyond the shared bound are not required here)
+
+  unsigned int num_required_iter = max_num_iter;
+  unsigned int max_num_inliers = 0;
+  bool model_is_found = false;
+  unsigned int best_iter = 0;
+  for (num_iter_ = 0; num_iter_ < num_required_iter; ++num_iter_) {
+    const auto iter = num_iter_;
+    if (!model_is_valid_.at(iter)) {
+      continue;
+    }
+    if (!model_is_found || best_score_ < scores_.at(iter)) {
+      model_is_found = true;
+      best_score_ = scores_.at(iter);
+      best_iter = iter;
+    }
+    if (max_num_inliers < nums_inliers_.at(iter)) {
+      max_num_inliers = nums_inliers_.at(iter);
+      num_required_iter = std::max(
+          iter + 1, std::min(num_required_iter,
+                             compute_num_required_iters(
+                                 max_num_inliers, confidence, max_num_iter)));
+    }
+  }
+
+  if (!model_is_found) {
+    return false;
+  }
+
+  // 4. Score the best model again to get its inlier flags
+
+  workspace_t workspace;
+  best_model_ = models_.at(best_iter);
+  best_score_ = problem_.score_model(best_model_, workspace, is_inlier_);
+  num_inliers_ = std::count(is_inlier_.begin(), is_inlier_.end(), true);
+  return true;
+}
+
+template <typename Problem>
+void ransac<Problem>::evaluate_hypotheses(
+    const double confidence, std::atomic<unsigned int>& next_iter,
+    std::atomic<unsigned int>& iter_bound) {
+  const auto max_num_iter = static_cast<unsigned int>(min_sets_.size());
+  workspace_t workspace;
+  std::vector<bool> is_inlier;
+  while (true) {
+    const unsigned int iter = next_iter++;
+    if (iter_bound.load() <= iter) {
+      break;
+    }
+
+    // 1. Compute a hypothesis from the minimum set
+    if (!problem_.compute_model(min_sets_.at(iter), workspace,
+                                models_.at(iter))) {
+      continue;
+    }
+
+    // 2. Check inliers and compute a score
+    model_is_valid_.at(iter) = 1;
+    scores_.at(iter) =
+        problem_.score_model(models_.at(iter), workspace, is_inlier);
+    nums_inliers_.at(iter) =
+        std::count(is_inlier.begin(), is_inlier.end(), true);
+
+    // 3. Tighten the shared bound
+    //    (the reduction has seen this iteration before any iteration beyond
+    //    the bound, so the iterations skipped by the bound are never required)
+    const auto bound = std::max(
+        iter + 1, compute_num_required_iters(nums_inliers_.at(iter), confidence,
+                                             max_num_iter));
+    auto current_bound = iter_bound.load();
+    while (bound < current_bound &&
+           !iter_bound.compare_exchange_weak(current_bound, bound)) {
+    }
+  }
+}
+
+template <typename Problem>
+unsigned int ransac<Problem>::compute_num_required_iters(
+    const unsigned int num_inliers, const double confidence,
+    const unsigned int max_num_iter) const {
+  if (num_inliers == 0 || 1.0 <= confidence) {
+    return max_num_iter;
+  }
+  const double inlier_ratio =
+      static_cast<double>(num_inliers) / problem_.get_num_data();
+  const double min_set_prob =
+      std::pow(inlier_ratio, static_cast<double>(Problem::min_set_size));
+  if (1.0 - 1e-12 < min_set_prob) {
+    return 1;
+  }
+  const double num_iter =
+      std::ceil(std::log(1.0 - confidence) / std::log1p(-min_set_prob));
+  if (!(num_iter < max_num_iter)) {
+    return max_num_iter;
+  }
+  return std::max(1u, static_cast<unsigned int>(num_iter));
+}
+
+template <typename Problem>
+void ransac<Problem>::draw_min_set(const unsigned int num_data,
+                                   min_set_t& min_set) {
+  assert(Problem::min_set_size <= num_data);
+
+  // Draw the distinct indices by rejection, which does not allocate any memory
+  std::uniform_int_distribution<unsigned int> dist(0, num_data - 1);
+  for (unsigned int i = 0; i < Problem::min_set_size; ++i) {
+    while (true) {
+      const auto idx = dist(random_engine_);
+      if (std::find(min_set.begin(), min_set.begin() + i, idx) ==
+          min_set.begin() + i) {
+        min_set.at(i) = idx;
+        break;
+      }
+    }
+  }
+}
+
+}  // namespace solve
+}  // namespace openvslam
+
+#endif  // OPENVSLAM_SOLVE_RANSAC_H
@@ -7,11 +7,114 @@
 #include "openvslam/camera/base.h"
 #include "openvslam/data/keyframe.h"
 #include "openvslam/data/landmark.h"
-#include "openvslam/util/random_array.h"
+#include "openvslam/solve/ransac.h"
 
 namespace openvslam {
 namespace solve {
 
+class sim3_solver::ransac_problem {
+ public:
+  //! similarity transformations in both directions
+  struct model_t {
+    Mat33_t rot_12_;
+    Vec3_t trans_12_;
+    float scale_12_;
+    Mat33_t rot_21_;
+    Vec3_t trans_21_;
+    float scale_21_;
+  };
+  static constexpr unsigned int min_set_size = 3;
+
+  //! Buffers to reproject the common points
+  struct workspace_t {
+    //! common points in keyframe 1 reprojected to keyframe 2
+    eigen_alloc_vector<Vec2_t> reprojected_1_in_cam_2_;
+    //! common points in keyframe 2 reprojected to keyframe 1
+    eigen_alloc_vector<Vec2_t> reprojected_2_in_cam_1_;
+    //! (unused) x-coordinates in the right images
+    std::vector<float> x_rights_;
+    //! (unused) the reprojections are inside of the images or not
+    std::vector<unsigned char> is_valid_;
+  };
+
+  explicit ransac_problem(const sim3_solver& solver) : solver_(solver) {}
+
+  unsigned int get_num_data() const { return solver_.num_common_pts_; }
+
+  bool compute_model(const std::array<unsigned int, min_set_size>& min_set,
+                     workspace_t&, model_t& model) const {
+    // Sample three 3D points into a matrix
+    Mat33_t pts_1, pts_2;
+    for (unsigned int i = 0; i < min_set_size; ++i) {
+      pts_1.block(0, i, 3, 1) =
+          solver_.common_pts_in_keyfrm_1_.at(min_set.at(i));
+      pts_2.block(0, i, 3, 1) =
+          solver_.common_pts_in_keyfrm_2_.at(min_set.at(i));
+    }
+
+    // Compute the similarity transformation matrix (R, t, s)
+    solver_.compute_Sim3(pts_1, pts_2, model.rot_12_, model.trans_12_,
+                         model.scale_12_, model.rot_21_, model.trans_21_,
+                         model.scale_21_);
+    return true;
+  }
+
+  //! Count up inliers
+  //! (the number of the inliers is returned as the score)
+  float score_model(const model_t& model, workspace_t& workspace,
+                    std::vector<bool>& inliers) const {
+    const auto num_common_pts = solver_.num_common_pts_;
+    inliers.resize(num_common_pts);
+    if (num_common_pts == 0) {
+      return 0.0;
+    }
+
+    // Reproject the 3D points seen in one image onto the other image using the
+    // estimated similarity transformation matrix at once
+    solver_.keyfrm_2_->camera_->reproject_points_to_image(
+        model.scale_21_ * model.rot_21_, model.trans_21_,
+        solver_.common_pts_in_keyfrm_1_, workspace.reprojected_1_in_cam_2_,
+        workspace.x_rights_, workspace.is_valid_);
+    solver_.keyfrm_1_->camera_->reproject_points_to_image(
+        model.scale_12_ * model.rot_12_, model.trans_12_,
+        solver_.common_pts_in_keyfrm_2_, workspace.reprojected_2_in_cam_1_,
+        workspace.x_rights_, workspace.is_valid_);
+
+    // Compute the squared errors
+    // (Vec2_t is not padded, so the points can be viewed as a 2 x N matrix)
+    using Mat2X_t = Eigen::Matrix<double, 2, Eigen::Dynamic>;
+    const Eigen::Map<const Mat2X_t> reprojected_1_in_cam_2(
+        workspace.reprojected_1_in_cam_2_.front().data(), 2, num_common_pts);
+    const Eigen::Map<const Mat2X_t> reprojected_2_in_cam_1(
+        workspace.reprojected_2_in_cam_1_.front().data(), 2, num_common_pts);
+    const Eigen::Map<const Mat2X_t> reprojected_1(
+        solver_.reprojected_1_.front().data(), 2, num_common_pts);
+    const Eigen::Map<const Mat2X_t> reprojected_2(
+        solver_.reprojected_2_.front().data(), 2, num_common_pts);
+    const Eigen::ArrayXd errors_in_2 =
+        (reprojected_1_in_cam_2 - reprojected_2).colwise().squaredNorm();
+    const Eigen::ArrayXd errors_in_1 =
+        (reprojected_2_in_cam_1 - reprojected_1).colwise().squaredNorm();
+
+    // Inlier check
+    unsigned int num_inliers = 0;
+    for (unsigned int i = 0; i < num_common_pts; ++i) {
+      inliers.at(i) = errors_in_2(i) < solver_.chi_sq_x_sigma_sq_2_.at(i) &&
+                      errors_in_1(i) < solver_.chi_sq_x_sigma_sq_1_.at(i);
+      if (inliers.at(i)) {
+        ++num_inliers;
+      }
+    }
+
+    return num_inliers;
+  }
+
+ private:
+  const sim3_solver& solver_;
+};
+
+constexpr unsigned int sim3_solver::ransac_problem::min_set_size;
+
 sim3_solver::sim3_solver(
     const std::shared_ptr<data::keyframe>& keyfrm_1,
     const std::shared_ptr<data::keyframe>& keyfrm_2,
@@ -22,7 +125,7 @@ sim3_solver::sim3_solver(
       keyfrm_2_(keyfrm_2),
       fix_scale_(fix_scale),
       min_num_inliers_(min_num_inliers),
-      random_engine_(util::create_random_engine(use_fixed_seed)) {
+      use_fixed_seed_(use_fixed_seed) {
   // 3D points seen in the current keyframe (keyframe 1)
   const auto keyfrm_1_lms = keyfrm_1_->get_landmarks();
 
@@ -97,77 +200,45 @@ sim3_solver::sim3_solver(
   reproject_to_same_image(common_pts_in_keyfrm_2_, reprojected_2_, keyfrm_2_);
 }
 
-void sim3_solver::find_via_ransac(const unsigned int max_num_iter) {
+void sim3_solver::find_via_ransac(const unsigned int max_num_iter,
+                                  const double confidence,
+                                  const unsigned int num_threads) {
   // Initialize the best model
-  unsigned int max_num_inliers = 0;
   solution_is_valid_ = false;
   best_rot_12_ = Mat33_t::Zero();
   best_trans_12_ = Vec3_t::Zero();
   best_scale_12_ = 0.0;
+  num_iter_ = 0;
 
   if (num_common_pts_ < 3 || num_common_pts_ < min_num_inliers_) {
     solution_is_valid_ = false;
     return;
   }
 
-  // Variables used in the RANSAC loop
-  Mat33_t rot_12_in_sac;
-  Vec3_t trans_12_in_sac;
-  float scale_12_in_sac;
-  Mat33_t rot_21_in_sac;
-  Vec3_t trans_21_in_sac;
-  float scale_21_in_sac;
-
   // RANSAC loop
-  for (unsigned int iter = 0; iter < max_num_iter; ++iter) {
-    // Randomly sample three 3D points into a matrix
-    Mat33_t pts_1, pts_2;
-    const auto random_indices = util::create_random_array(
-        3, 0, static_cast<int>(num_common_pts_ - 1), random_engine_);
-    for (unsigned int i = 0; i < 3; ++i) {
-      pts_1.block(0, i, 3, 1) =
-          common_pts_in_keyfrm_1_.at(random_indices.at(i));
-      pts_2.block(0, i, 3, 1) =
-          common_pts_in_keyfrm_2_.at(random_indices.at(i));
-    }
+  const ransac_problem problem(*this);
+  ransac<ransac_problem> sac(problem, use_fixed_seed_);
+  const bool model_is_found = sac.run(max_num_iter, confidence, num_threads);
+  num_iter_ = sac.get_num_iterations();
 
-    // Compute the similarity transformation matrix (R, t, s)
-    compute_Sim3(pts_1, pts_2, rot_12_in_sac, trans_12_in_sac, scale_12_in_sac,
-                 rot_21_in_sac, trans_21_in_sac, scale_21_in_sac);
-
-    // Count the inliers
-    std::vector<bool> inliers;
-    const auto num_inliers =
-        count_inliers(rot_12_in_sac, trans_12_in_sac, scale_12_in_sac,
-                      rot_21_in_sac, trans_21_in_sac, scale_21_in_sac, inliers);
-
-    // Update the best model
-    if (max_num_inliers < num_inliers) {
-      max_num_inliers = num_inliers;
-      best_rot_12_ = rot_12_in_sac;
-      best_trans_12_ = trans_12_in_sac;
-      best_scale_12_ = scale_12_in_sac;
-    }
-  }
-
-  if (max_num_inliers < min_num_inliers_) {
+  if (!model_is_found || sac.get_num_inliers() < min_num_inliers_) {
     // Estimation fails if the number of the inliers is insufficient for the
     // minimal condition
     solution_is_valid_ = false;
-    best_rot_12_ = Mat33_t::Zero();
-    best_trans_12_ = Vec3_t::Zero();
-    best_scale_12_ = 0.0;
-    return;
-  } else {
-    solution_is_valid_ = true;
     return;
   }
+
+  const auto& best_model = sac.get_best_model();
+  best_rot_12_ = best_model.rot_12_;
+  best_trans_12_ = best_model.trans_12_;
+  best_scale_12_ = best_model.scale_12_;
+  solution_is_valid_ = true;
 }
 
 void sim3_solver::compute_Sim3(const Mat33_t& pts_1, const Mat33_t& pts_2,
                                Mat33_t& rot_12, Vec3_t& trans_12,
                                float& scale_12, Mat33_t& rot_21,
-                               Vec3_t& trans_21, float& scale_21) {
+                               Vec3_t& trans_21, float& scale_21) const {
   // Based on "Closed-form solution of absolute orientation using unit
   // quaternions"
   // http://people.csail.mit.edu/bkph/papers/Absolute_Orientation.pdf
@@ -262,69 +333,6 @@ void sim3_solver::compute_Sim3(const Mat33_t& pts_1, const Mat33_t& pts_2,
   trans_12 = -scale_12 * rot_12 * trans_21;
 }
 
-unsigned int sim3_solver::count_inliers(
-    const Mat33_t& rot_12, const Vec3_t& trans_12, const float scale_12,
-    const Mat33_t& rot_21, const Vec3_t& trans_21, const float scale_21,
-    std::vector<bool>& inliers) {
-  // Reproject the 3D points seen in one image onto the other image using the
-  // estimated similarity transformation matrix and then compute the distance
-  unsigned int num_inliers = 0;
-  inliers.resize(num_common_pts_, false);
-
-  // Reroject the 3D points of coordinate system 1 onto the image of coordinate
-  // system 2
-  std::vector<Vec2_t, Eigen::aligned_allocator<Vec2_t>> reprojected_1_in_cam_2;
-  reproject_to_other_image(common_pts_in_keyfrm_1_, reprojected_1_in_cam_2,
-                           rot_21, trans_21, scale_21, keyfrm_2_);
-
-  // Reroject the 3D points of coordinate system 2 onto the image of coordinate
-  // system 1
-  std::vector<Vec2_t, Eigen::aligned_allocator<Vec2_t>> reprojected_2_in_cam_1;
-  reproject_to_other_image(common_pts_in_keyfrm_2_, reprojected_2_in_cam_1,
-                           rot_12, trans_12, scale_12, keyfrm_1_);
-
-  for (unsigned int i = 0; i < num_common_pts_; ++i) {
-    // Compute the residual vector
-    const Vec2_t dist_in_2 =
-        (reprojected_1_in_cam_2.at(i) - reprojected_2_.at(i));
-    const Vec2_t dist_in_1 =
-        (reprojected_2_in_cam_1.at(i) - reprojected_1_.at(i));
-
-    // Compute squared error
-    const double error_in_2 = dist_in_2.dot(dist_in_2);
-    const double error_in_1 = dist_in_1.dot(dist_in_1);
-
-    // Inlier check
-    if (error_in_2 < chi_sq_x_sigma_sq_2_.at(i) &&
-        error_in_1 < chi_sq_x_sigma_sq_1_.at(i)) {
-      inliers.at(i) = true;
-      ++num_inliers;
-    }
-  }
-
-  return num_inliers;
-}
-
-void sim3_solver::reproject_to_other_image(
-    const std::vector<Vec3_t, Eigen::aligned_allocator<Vec3_t>>&
-        lm_coords_in_cam_1,
-    std::vector<Vec2_t, Eigen::aligned_allocator<Vec2_t>>& reprojected_in_cam_2,
-    const Mat33_t& rot_21, const Vec3_t& trans_21, const float scale_21,
-    const std::shared_ptr<data::keyframe>& keyfrm) {
-  reprojected_in_cam_2.clear();
-  reprojected_in_cam_2.reserve(lm_coords_in_cam_1.size());
-
-  for (const auto& lm_coord_in_cam_1 : lm_coords_in_cam_1) {
-    Vec2_t reproj_in_cam_2;
-    float x_right;
-    keyfrm->camera_->reproject_to_image(scale_21 * rot_21, trans_21,
-                                        lm_coord_in_cam_1, reproj_in_cam_2,
-                                        x_right);
-
-    reprojected_in_cam_2.push_back(reproj_in_cam_2);
-  }
-}
-
 void sim3_solver::reproject_to_same_image(
     const std::vector<Vec3_t, Eigen::aligned_allocator<Vec3_t>>&
         lm_coords_in_cam,
@@ -3,7 +3,6 @@
 
 #include <memory>
 #include <opencv2/core.hpp>
-#include <random>
 #include <vector>
 
 #include "openvslam/data/keyframe.h"
@@ -28,7 +27,11 @@ class sim3_solver {
   virtual ~sim3_solver() = default;
 
   //! Find the most reliable Sim3 matrix via RANSAC
-  void find_via_ransac(const unsigned int max_num_iter);
+  //! (the iterations are terminated when the confidence is reached, and the
+  //! hypotheses are evaluated with num_threads threads)
+  void find_via_ransac(const unsigned int max_num_iter,
+                       const double confidence = 0.99,
+                       const unsigned int num_threads = 1);
 
   //! Check if the solution is valid or not
   bool solution_is_valid() const { return solution_is_valid_; }
@@ -42,29 +45,19 @@ class sim3_solver {
   //! Get the most reliable scale from keyframe 2 to keyframe 1
   float get_best_scale_12() { return best_scale_12_; }
 
+  //! Get the number of the RANSAC iterations in the last estimation
+  unsigned int get_num_iterations() const { return num_iter_; }
+
  protected:
+  //! estimation problem of Sim3 for solve::ransac
+  class ransac_problem;
+
   //! compute Sim3 from three common points
   //! points1(3点)の座標系をpoints2(3点)に変換する相似変換行列を推定する
   //! (入力行列は，各列が [x_i, y_i, z_i].T であり，計3列が行方向に並んでいる)
   void compute_Sim3(const Mat33_t& pts_1, const Mat33_t& pts_2, Mat33_t& rot_12,
                     Vec3_t& trans_12, float& scale_12, Mat33_t& rot_21,
-                    Vec3_t& trans_21, float& scale_21);
-
-  //! count up inliers
-  unsigned int count_inliers(const Mat33_t& rot_12, const Vec3_t& trans_12,
-                             const float scale_12, const Mat33_t& rot_21,
-                             const Vec3_t& trans_21, const float scale_21,
-                             std::vector<bool>& inliers);
-
-  //! reproject points in camera (local) coordinates to the other image (as
-  //! undistorted keypoints)
-  void reproject_to_other_image(
-      const std::vector<Vec3_t, Eigen::aligned_allocator<Vec3_t>>&
-          lm_coords_in_cam_1,
-      std::vector<Vec2_t, Eigen::aligned_allocator<Vec2_t>>&
-          reprojected_in_cam_2,
-      const Mat33_t& rot_21, const Vec3_t& trans_21, const float scale_21,
-      const std::shared_ptr<data::keyframe>& keyfrm);
+                    Vec3_t& trans_21, float& scale_21) const;
 
   //! reproject points in camera (local) coordinates to the same image (as
   //! undistorted keypoints)
@@ -113,8 +106,10 @@ class sim3_solver {
   //! RANSACのパラメータ
   unsigned int min_num_inliers_;
 
-  //! random engine for RANSAC
-  std::mt19937 random_engine_;
+  //! use the fixed seed for RANSAC or not
+  bool use_fixed_seed_;
+  //! number of the RANSAC iterations
+  unsigned int num_iter_ = 0;
 };
 
 }  // namespace solve
@@ -15,12 +15,17 @@
 #include "openvslam/data/frame_observation.h"
 #include "openvslam/data/map_database.h"
 #include "openvslam/data/orb_params_database.h"
+#include "openvslam/data/speculative_bow.h"
 #include "openvslam/feature/orb_extractor.h"
 #include "openvslam/global_optimization_module.h"
+#include "openvslam/io/feature_stream.h"
 #include "openvslam/io/map_database_io.h"
+#include "openvslam/io/map_tile_io.h"
 #include "openvslam/io/trajectory_io.h"
 #include "openvslam/mapping_module.h"
 #include "openvslam/match/stereo.h"
+#include "openvslam/module/map_pager.h"
+#include "openvslam/optimize/job_scheduler.h"
 #include "openvslam/publish/frame_publisher.h"
 #include "openvslam/publish/map_publisher.h"
 #include "openvslam/tracking_module.h"
@@ -49,13 +54,45 @@ double get_depthmap_factor(const camera::base* camera,
   }
   return depthmap_factor;
 }
+
+std::future<bool> start_loading_bow_vocabulary(
+    const std::shared_ptr<data::bow_vocabulary>& bow_vocab,
+    const std::string& vocab_file_path) {
+  if (vocab_file_path.empty()) {
+    return std::future<bool>();
+  }
+  // the vocabulary is shared with the loader so that it outlives the loading
+  return std::async(std::launch::async, [bow_vocab, vocab_file_path] {
+    spdlog::info("loading ORB vocabulary: {}", vocab_file_path);
+    const auto is_loaded = data::bow_vocabulary_util::load_vocabulary(
+        bow_vocab.get(), vocab_file_path);
+    if (is_loaded) {
+      spdlog::info("loaded ORB vocabulary: {}", vocab_file_path);
+    }
+    return is_loaded;
+  });
+}
 }  // namespace
 
 namespace openvslam {
 
 system::system(const std::shared_ptr<config>& cfg,
                const std::string& vocab_file_path)
-    : cfg_(cfg), camera_(cfg->camera_), orb_params_(cfg->orb_params_) {
+    : system(cfg, std::make_shared<data::bow_vocabulary>(), vocab_file_path) {}
+
+system::system(const std::shared_ptr<config>& cfg,
+               const std::shared_ptr<data::bow_vocabulary>& bow_vocab)
+    : system(cfg, bow_vocab, "") {}
+
+system::system(const std::shared_ptr<config>& cfg,
+               const std::shared_ptr<data::bow_vocabulary>& bow_vocab,
+               const std::string& vocab_file_path)
+    : cfg_(cfg),
+      camera_(cfg->camera_),
+      orb_params_(cfg->orb_params_),
+      bow_vocab_(bow_vocab),
+      bow_vocab_loader_(
+          start_loading_bow_vocabulary(bow_vocab, vocab_file_path)) {
   spdlog::debug("CONSTRUCT: system");
 
   std::ostringstream message_stream;
@@ -90,40 +127,25 @@ system::system(const std::shared_ptr<config>& cfg,
 
   spdlog::info(message_stream.str());
 
-  // load ORB vocabulary
-  spdlog::info("loading ORB vocabulary: {}", vocab_file_path);
-#ifdef USE_DBOW2
-  bow_vocab_ = new data::bow_vocabulary();
-  try {
-    bow_vocab_->loadFromBinaryFile(vocab_file_path);
-  } catch (const std::exception&) {
-    spdlog::critical("wrong path to vocabulary");
-    delete bow_vocab_;
-    bow_vocab_ = nullptr;
-    exit(EXIT_FAILURE);
+  if (!bow_vocab_) {
+    throw std::runtime_error("the vocabulary is not loaded");
   }
-#else
-  bow_vocab_ = new fbow::Vocabulary();
-  bow_vocab_->readFromFile(vocab_file_path);
-  if (!bow_vocab_->isValid()) {
-    spdlog::critical("wrong path to vocabulary");
-    delete bow_vocab_;
-    bow_vocab_ = nullptr;
-    exit(EXIT_FAILURE);
-  }
-#endif
 
   // database
   cam_db_ = new data::camera_database(camera_);
   map_db_ = new data::map_database();
+  const auto map_database_yaml_node =
+      util::yaml_optional_ref(cfg->yaml_node_, "MapDatabase");
+  map_bow_is_stored_ = map_database_yaml_node["store_bow"].as<bool>(true);
   auto bow_database_yaml_node =
       util::yaml_optional_ref(cfg->yaml_node_, "BowDatabase");
   int reject_by_graph_distance =
       bow_database_yaml_node["reject_by_graph_distance"].as<bool>(false);
   int loop_min_distance_on_graph =
       bow_database_yaml_node["loop_min_distance_on_graph"].as<int>(30);
-  bow_db_ = new data::bow_database(bow_vocab_, reject_by_graph_distance,
-                                   loop_min_distance_on_graph);
+  bow_db_ =
+      new data::bow_database(bow_vocab_.get(), reject_by_graph_distance,
+                             loop_min_distance_on_graph);
 
   // frame and map publisher
   frame_publisher_ = std::shared_ptr<publish::frame_publisher>(
@@ -132,19 +154,24 @@ system::system(const std::shared_ptr<config>& cfg,
       new publish::map_publisher(cfg_, map_db_));
 
   // tracking module
-  tracker_ = new tracking_module(cfg_, map_db_, bow_vocab_, bow_db_);
+  tracker_ = new tracking_module(cfg_, map_db_, bow_vocab_.get(), bow_db_);
+  // scheduler of the optimization jobs
+  optimization_scheduler_.reset(new optimize::job_scheduler(
+      util::yaml_optional_ref(cfg->yaml_node_, "OptimizationScheduler")));
   // mapping module
   mapper_ = new mapping_module(cfg_->yaml_node_["Mapping"], map_db_, bow_db_,
-                               bow_vocab_);
+                               bow_vocab_.get());
   // global optimization module
   global_optimizer_ = new global_optimization_module(
-      map_db_, bow_db_, bow_vocab_, cfg_->yaml_node_,
+      map_db_, bow_db_, bow_vocab_.get(), cfg_->yaml_node_,
       camera_->setup_type_ != camera::setup_type_t::Monocular);
 
   // preprocessing modules
   const auto preprocessing_params =
       util::yaml_optional_ref(cfg->yaml_node_, "Preprocessing");
   depthmap_factor_ = get_depthmap_factor(camera_, preprocessing_params);
+  speculative_bow_is_enabled_ =
+      preprocessing_params["speculative_bow"].as<bool>(true);
   auto mask_rectangles = preprocessing_params["mask_rectangles"]
                              .as<std::vector<std::vector<float>>>(
                                  std::vector<std::vector<float>>());
@@ -185,9 +212,18 @@ system::system(const std::shared_ptr<config>& cfg,
   mapper_->set_global_optimization_module(global_optimizer_);
   global_optimizer_->set_tracking_module(tracker_);
   global_optimizer_->set_mapping_module(mapper_);
+  mapper_->set_job_scheduler(optimization_scheduler_.get());
+  global_optimizer_->set_job_scheduler(optimization_scheduler_.get());
 }
 
 system::~system() {
+  // the worker refers to the vocabulary
+  speculative_bow_worker_.reset();
+
+  // the pager modifies the databases on its worker thread
+  tracker_->set_map_pager(nullptr);
+  map_pager_.reset();
+
   global_optimization_thread_.reset(nullptr);
   delete global_optimizer_;
   global_optimizer_ = nullptr;
@@ -196,6 +232,9 @@ system::~system() {
   delete mapper_;
   mapper_ = nullptr;
 
+  // the modules wait for their jobs before the workers are joined
+  optimization_scheduler_.reset();
+
   delete tracker_;
   tracker_ = nullptr;
 
@@ -205,8 +244,7 @@ system::~system() {
   map_db_ = nullptr;
   delete cam_db_;
   cam_db_ = nullptr;
-  delete bow_vocab_;
-  bow_vocab_ = nullptr;
+  bow_vocab_.reset();
 
   delete extractor_left_;
   extractor_left_ = nullptr;
@@ -222,6 +260,11 @@ system::~system() {
 }
 
 void system::startup(const bool need_initialize) {
+  wait_for_bow_vocabulary();
+  if (speculative_bow_is_enabled_ && !speculative_bow_worker_) {
+    speculative_bow_worker_.reset(
+        new data::speculative_bow_worker(bow_vocab_.get()));
+  }
   spdlog::info("startup SLAM system");
   system_is_running_ = true;
 
@@ -246,6 +289,24 @@ void system::shutdown() {
   mapping_thread_->join();
   global_optimization_thread_->join();
 
+  // report the optimization jobs
+  const std::pair<optimize::job_priority_t, const char*> priorities[] = {
+      {optimize::job_priority_t::High, "high"},
+      {optimize::job_priority_t::Normal, "normal"},
+      {optimize::job_priority_t::Low, "low"}};
+  for (const auto& priority : priorities) {
+    const auto metrics = optimization_scheduler_->get_metrics(priority.first);
+    if (metrics.num_submitted_ == 0) {
+      continue;
+    }
+    spdlog::info(
+        "optimization jobs ({} priority): {} completed, {} cancelled, {} "
+        "preempted, {:.1f} ms waiting, {:.1f} ms running",
+        priority.second, metrics.num_completed_, metrics.num_cancelled_,
+        metrics.num_preempted_, metrics.total_wait_time_ms_,
+        metrics.total_run_time_ms_);
+  }
+
   spdlog::info("shutdown SLAM system");
   system_is_running_ = false;
 }
@@ -269,19 +330,53 @@ void system::save_keyframe_trajectory(const std::string& path,
 void system::load_map_database(const std::string& path) const {
   pause_other_threads();
   io::map_database_io map_db_io(cam_db_, orb_params_db_, map_db_, bow_db_,
-                                bow_vocab_);
-  map_db_io.load_message_pack(path);
+                                bow_vocab_.get());
+  // the vocabulary is loaded while the map is decoded
+  map_db_io.load_message_pack(path, [this] { wait_for_bow_vocabulary(); });
   resume_other_threads();
 }
 
 void system::save_map_database(const std::string& path) const {
   pause_other_threads();
   io::map_database_io map_db_io(cam_db_, orb_params_db_, map_db_, bow_db_,
-                                bow_vocab_);
+                                bow_vocab_.get(), map_bow_is_stored_);
   map_db_io.save_message_pack(path);
   resume_other_threads();
 }
 
+void system::load_tiled_map_database(const std::string& dir) {
+  // the vocabulary is not waited for because the tiles are decoded after
+  // startup()
+  pause_other_threads();
+  tracker_->set_map_pager(nullptr);
+  map_pager_.reset();
+  io::map_tile_io map_tile_io(cam_db_, orb_params_db_, map_db_, bow_db_,
+                              bow_vocab_.get());
+  const auto index = map_tile_io.load_index(dir);
+  map_pager_.reset(new module::map_pager(
+      util::yaml_optional_ref(cfg_->yaml_node_, "MapPager"), cam_db_,
+      orb_params_db_, map_db_, bow_db_, bow_vocab_.get(), index));
+  tracker_->set_map_pager(map_pager_.get());
+  resume_other_threads();
+}
+
+void system::save_tiled_map_database(const std::string& dir,
+                                     const double tile_size) const {
+  pause_other_threads();
+  io::map_tile_io map_tile_io(cam_db_, orb_params_db_, map_db_, bow_db_,
+                              bow_vocab_.get(), map_bow_is_stored_);
+  map_tile_io.save_tiles(dir, tile_size);
+  resume_other_threads();
+}
+
+void system::start_feature_stream_recording(const std::string& path) {
+  feature_stream_writer_.reset(new io::feature_stream_writer(path));
+}
+
+void system::stop_feature_stream_recording() {
+  feature_stream_writer_.reset();
+}
+
 const std::shared_ptr<publish::map_publisher> system::get_map_publisher()
     const {
   return map_publisher_;
@@ -340,6 +435,14 @@ bool system::loop_BA_is_running() const {
 
 void system::abort_loop_BA() { global_optimizer_->abort_loop_BA(); }
 
+void system::enable_image_sharing() {
+  frame_publisher_->set_image_sharing(true);
+}
+
+void system::disable_image_sharing() {
+  frame_publisher_->set_image_sharing(false);
+}
+
 data::frame system::create_monocular_frame(const cv::Mat& img,
                                            const double timestamp,
                                            const cv::Mat& mask) {
@@ -374,7 +477,7 @@ data::frame system::create_monocular_frame(const cv::Mat& img,
   data::assign_keypoints_to_grid(camera_, frm_obs.undist_keypts_,
                                  frm_obs.keypt_indices_in_cells_);
 
-  return data::frame(timestamp, camera_, orb_params_, frm_obs);
+  return create_frame(timestamp, frm_obs);
 }
 
 data::frame system::create_stereo_frame(const cv::Mat& left_img,
@@ -446,7 +549,7 @@ data::frame system::create_stereo_frame(const cv::Mat& left_img,
   TP_COMPUTE_CPU(nullptr, std::chrono::nanoseconds(end - start),
                  "slam:keypoints_to_grid_assignment");
 
-  return data::frame(timestamp, camera_, orb_params_, frm_obs);
+  return create_frame(timestamp, frm_obs);
 }
 
 data::frame system::create_stereo_disparity_frame(const cv::Mat& left_img,
@@ -525,7 +628,7 @@ data::frame system::create_stereo_disparity_frame(const cv::Mat& left_img,
   TP_COMPUTE_CPU(nullptr, std::chrono::nanoseconds(end - start),
                  "slam:keypoints_to_grid_assignment");
 
-  return data::frame(timestamp, camera_, orb_params_, frm_obs);
+  return create_frame(timestamp, frm_obs);
 }
 
 data::frame system::create_RGBD_frame(const cv::Mat& rgb_img,
@@ -581,7 +684,29 @@ data::frame system::create_RGBD_frame(const cv::Mat& rgb_img,
   // Assign all the keypoints into grid
   data::assign_keypoints_to_grid(camera_, frm_obs.undist_keypts_,
                                  frm_obs.keypt_indices_in_cells_);
-  return data::frame(timestamp, camera_, orb_params_, frm_obs);
+  return create_frame(timestamp, frm_obs);
+}
+
+data::frame system::create_recorded_frame(
+    const data::frame_observation& frm_obs, const double timestamp) {
+  data::frame_observation recorded_frm_obs = frm_obs;
+  if (recorded_frm_obs.keypts_.empty()) {
+    spdlog::warn("preprocess: cannot extract any keypoints");
+  }
+
+  // Undistort keypoints
+  camera_->undistort_keypoints(recorded_frm_obs.keypts_,
+                               recorded_frm_obs.undist_keypts_);
+
+  // Convert to bearing vector
+  camera_->convert_keypoints_to_bearings(recorded_frm_obs.undist_keypts_,
+                                         recorded_frm_obs.bearings_);
+
+  // Assign all the keypoints into grid
+  data::assign_keypoints_to_grid(camera_, recorded_frm_obs.undist_keypts_,
+                                 recorded_frm_obs.keypt_indices_in_cells_);
+
+  return create_frame(timestamp, recorded_frm_obs);
 }
 
 std::shared_ptr<Mat44_t> system::feed_monocular_frame(const cv::Mat& img,
@@ -618,10 +743,24 @@ std::shared_ptr<Mat44_t> system::feed_RGBD_frame(const cv::Mat& rgb_img,
                     rgb_img);
 }
 
+std::shared_ptr<Mat44_t> system::feed_recorded_frame(
+    const data::frame_observation& frm_obs, const double timestamp) {
+  // the images are not recorded, so the keypoints are drawn on a blank image
+  if (blank_img_.empty()) {
+    blank_img_ = cv::Mat(camera_->rows_, camera_->cols_, CV_8UC1,
+                         cv::Scalar(0));
+  }
+  return feed_frame(create_recorded_frame(frm_obs, timestamp), blank_img_);
+}
+
 std::shared_ptr<Mat44_t> system::feed_frame(const data::frame& frm,
                                             const cv::Mat& img) {
   check_reset_request();
 
+  if (feature_stream_writer_) {
+    feature_stream_writer_->write(frm.timestamp_, frm.frm_obs_);
+  }
+
   const auto start = std::chrono::steady_clock::now();
 
   const auto cam_pose_wc = tracker_->feed_frame(frm);
@@ -696,6 +835,30 @@ bool system::terminate_is_requested() const {
   return terminate_is_requested_;
 }
 
+void system::wait_for_bow_vocabulary() const {
+  std::lock_guard<std::mutex> lock(mtx_bow_vocab_loader_);
+  if (!bow_vocab_loader_.valid()) {
+    return;
+  }
+  if (!bow_vocab_loader_.get()) {
+    spdlog::critical("wrong path to vocabulary");
+    exit(EXIT_FAILURE);
+  }
+}
+
+data::frame system::create_frame(const double timestamp,
+                                 const data::frame_observation& frm_obs) {
+  data::frame frm(map_db_->next_frame_id_++, timestamp, camera_, orb_params_,
+                  frm_obs);
+  // the BoW representation is computed while the frame is tracked,
+  // and it is used if relocalization or the keyframe needs it
+  if (speculative_bow_worker_) {
+    frm.speculative_bow_ =
+        speculative_bow_worker_->request(frm.frm_obs_.descriptors_);
+  }
+  return frm;
+}
+
 void system::check_reset_request() {
   std::lock_guard<std::mutex> lock(mtx_reset_);
   if (reset_is_requested_) {
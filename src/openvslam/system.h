@@ -2,6 +2,7 @@
 #define OPENVSLAM_SYSTEM_H
 
 #include <atomic>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <opencv2/core/core.hpp>
@@ -24,6 +25,8 @@ class base;
 
 namespace data {
 class frame;
+struct frame_observation;
+class speculative_bow_worker;
 class camera_database;
 class orb_params_database;
 class map_database;
@@ -35,6 +38,18 @@ class orb_extractor;
 class orb_params;
 }  // namespace feature
 
+namespace io {
+class feature_stream_writer;
+}  // namespace io
+
+namespace module {
+class map_pager;
+}  // namespace module
+
+namespace optimize {
+class job_scheduler;
+}  // namespace optimize
+
 namespace publish {
 class map_publisher;
 class frame_publisher;
@@ -43,9 +58,17 @@ class frame_publisher;
 class system {
  public:
   //! Constructor
+  //! (the vocabulary is loaded in the background while the system is set up
+  //! and a map is decoded, and is waited for before it is used for the first
+  //! time)
   system(const std::shared_ptr<config>& cfg,
          const std::string& vocab_file_path);
 
+  //! Constructor with the vocabulary which is shared with the other systems
+  //! (see data::bow_vocabulary_util::load_vocabulary())
+  system(const std::shared_ptr<config>& cfg,
+         const std::shared_ptr<data::bow_vocabulary>& bow_vocab);
+
   //! Destructor
   ~system();
 
@@ -75,6 +98,21 @@ class system {
   //! Save the map database to the MessagePack file
   void save_map_database(const std::string& path) const;
 
+  //! Load the index of the tiled map database from the directory and page in
+  //! the tiles on demand (for localization mode)
+  void load_tiled_map_database(const std::string& dir);
+
+  //! Save the map database to the existing directory as the tiles of the
+  //! specified size [m]
+  void save_tiled_map_database(const std::string& dir,
+                               const double tile_size) const;
+
+  //! Start recording the observations of the fed frames to the feature stream
+  void start_feature_stream_recording(const std::string& path);
+
+  //! Stop recording the feature stream
+  void stop_feature_stream_recording();
+
   //! Get the map publisher
   const std::shared_ptr<publish::map_publisher> get_map_publisher() const;
 
@@ -111,6 +149,14 @@ class system {
   //-----------------------------------------
   // data feeding methods
 
+  //! Share the fed images with the frame publisher without copying them
+  //! (NOTE: the caller must not overwrite the buffer of an image after
+  //! feeding it, e.g. by reading the next frame into the same cv::Mat)
+  void enable_image_sharing();
+
+  //! Copy the fed images for the frame publisher (default)
+  void disable_image_sharing();
+
   std::shared_ptr<Mat44_t> feed_frame(const data::frame& frm,
                                       const cv::Mat& img);
 
@@ -153,6 +199,13 @@ class system {
                                            const double timestamp,
                                            const cv::Mat& mask = cv::Mat{});
 
+  //! Feed a frame which is recorded in the feature stream
+  //! (ORB extraction and stereo matching are skipped)
+  data::frame create_recorded_frame(const data::frame_observation& frm_obs,
+                                    const double timestamp);
+  std::shared_ptr<Mat44_t> feed_recorded_frame(
+      const data::frame_observation& frm_obs, const double timestamp);
+
   //-----------------------------------------
   // pose initializing/updating
 
@@ -199,6 +252,21 @@ class system {
   double depthmap_factor_ = 1.0;
 
  private:
+  //! Constructor which starts loading the vocabulary from the file
+  //! (the vocabulary is not loaded if the path is empty)
+  system(const std::shared_ptr<config>& cfg,
+         const std::shared_ptr<data::bow_vocabulary>& bow_vocab,
+         const std::string& vocab_file_path);
+
+  //! Block until the vocabulary is loaded
+  //! (the process exits if the vocabulary cannot be loaded)
+  void wait_for_bow_vocabulary() const;
+
+  //! Create a frame from the observations
+  //! (the BoW representation is requested to the speculative worker)
+  data::frame create_frame(const double timestamp,
+                           const data::frame_observation& frm_obs);
+
   //! Check reset request of the system
   void check_reset_request();
 
@@ -224,9 +292,22 @@ class system {
 
   //! map database
   data::map_database* map_db_ = nullptr;
-
-  //! BoW vocabulary
-  data::bow_vocabulary* bow_vocab_ = nullptr;
+  //! save the BoW representations of the keyframes into the map files or not
+  bool map_bow_is_stored_ = true;
+
+  //! BoW vocabulary (shared with the other systems)
+  std::shared_ptr<data::bow_vocabulary> bow_vocab_ = nullptr;
+  //! mutex for bow_vocab_loader_
+  mutable std::mutex mtx_bow_vocab_loader_;
+  //! result of the background loading of the vocabulary
+  //! (invalid after the result is taken)
+  mutable std::future<bool> bow_vocab_loader_;
+
+  //! compute the BoW representations of the frames ahead or not
+  bool speculative_bow_is_enabled_ = true;
+  //! worker which computes the BoW representations in parallel with tracking
+  //! (launched at startup)
+  std::unique_ptr<data::speculative_bow_worker> speculative_bow_worker_;
 
   //! BoW database
   data::bow_database* bow_db_ = nullptr;
@@ -234,6 +315,10 @@ class system {
   //! tracker
   tracking_module* tracker_ = nullptr;
 
+  //! scheduler of the optimization jobs of the mapping and the global
+  //! optimization modules
+  std::unique_ptr<optimize::job_scheduler> optimization_scheduler_;
+
   //! mapping module
   mapping_module* mapper_ = nullptr;
   //! mapping thread
@@ -252,6 +337,14 @@ class system {
   //! ORB extractor only when used in initializing
   feature::orb_extractor* ini_extractor_left_ = nullptr;
 
+  //! feature stream writer (nullptr if the recording is disabled)
+  std::unique_ptr<io::feature_stream_writer> feature_stream_writer_;
+  //! blank image which is published instead of the recorded frames
+  cv::Mat blank_img_;
+
+  //! pager of the tiled map database (nullptr if the whole map is loaded)
+  std::unique_ptr<module::map_pager> map_pager_;
+
   //! frame publisher
   std::shared_ptr<publish::frame_publisher> frame_publisher_ = nullptr;
   //! map publisher
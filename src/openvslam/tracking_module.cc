@@ -13,7 +13,7 @@
 #include "openvslam/global_optimization_module.h"
 #include "openvslam/mapping_module.h"
 #include "openvslam/match/projection.h"
-#include "openvslam/module/local_map_updater.h"
+#include "openvslam/module/map_pager.h"
 #include "openvslam/system.h"
 #include "openvslam/util/yaml.h"
 
@@ -42,6 +42,10 @@ double get_use_robust_matcher_for_relocalization_request(
       false);
 }
 
+unsigned int get_max_num_local_keyfrms(const YAML::Node& yaml_node) {
+  return yaml_node["max_num_local_keyframes"].as<unsigned int>(60);
+}
+
 }  // unnamed namespace
 
 namespace openvslam {
@@ -69,7 +73,10 @@ tracking_module::tracking_module(const std::shared_ptr<config>& cfg,
       relocalizer_(util::yaml_optional_ref(cfg->yaml_node_, "Relocalizer")),
       pose_optimizer_(),
       keyfrm_inserter_(
-          util::yaml_optional_ref(cfg->yaml_node_, "KeyframeInserter")) {
+          util::yaml_optional_ref(cfg->yaml_node_, "KeyframeInserter")),
+      local_map_updater_(map_db,
+                         get_max_num_local_keyfrms(util::yaml_optional_ref(
+                             cfg->yaml_node_, "Tracking"))) {
   spdlog::debug("CONSTRUCT: tracking_module");
 }
 
@@ -87,6 +94,10 @@ void tracking_module::set_global_optimization_module(
   global_optimizer_ = global_optimizer;
 }
 
+void tracking_module::set_map_pager(module::map_pager* map_pager) {
+  map_pager_ = map_pager;
+}
+
 void tracking_module::set_mapping_module_status(const bool mapping_is_enabled) {
   std::lock_guard<std::mutex> lock(mtx_mapping_);
   mapping_is_enabled_ = mapping_is_enabled;
@@ -155,6 +166,7 @@ void tracking_module::reset() {
 
   initializer_.reset();
   keyfrm_inserter_.reset();
+  local_map_updater_.reset();
 
   auto future_mapper_reset = mapper_->async_reset();
   auto future_global_optimizer_reset = global_optimizer_->async_reset();
@@ -164,9 +176,9 @@ void tracking_module::reset() {
   bow_db_->clear();
   map_db_->clear();
 
-  data::frame::next_id_ = 0;
-  data::keyframe::next_id_ = 0;
-  data::landmark::next_id_ = 0;
+  map_db_->next_frame_id_ = 0;
+  map_db_->next_keyframe_id_ = 0;
+  map_db_->next_landmark_id_ = 0;
 
   last_reloc_frm_id_ = 0;
   last_reloc_frm_timestamp_ = 0.0;
@@ -228,7 +240,7 @@ std::shared_ptr<Mat44_t> tracking_module::feed_frame(data::frame curr_frm) {
 
 bool tracking_module::track(bool relocalization_is_needed) {
   // LOCK the map database
-  std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+  std::lock_guard<std::mutex> lock(map_db_->mtx_database_);
 
   // apply replace of landmarks observed in the last frame
   apply_landmark_replace();
@@ -252,6 +264,12 @@ bool tracking_module::track(bool relocalization_is_needed) {
     if (!curr_frm_.bow_is_available()) {
       curr_frm_.compute_bow(bow_vocab_);
     }
+    // page in the map tiles which are likely to contain the candidates
+    // (they are used from the next frame because the tiles are loaded
+    // asynchronously)
+    if (map_pager_) {
+      map_pager_->request_tiles_for_relocalization(curr_frm_.bow_vec_);
+    }
     // try to relocalize
     succeeded = relocalizer_.relocalize(bow_db_, curr_frm_);
     if (succeeded) {
@@ -263,7 +281,7 @@ bool tracking_module::track(bool relocalization_is_needed) {
   // update the local map and optimize the camera pose of the current frame
   unsigned int num_tracked_lms = 0;
   if (succeeded) {
-    update_local_map(outlier_ids);
+    update_local_map();
     succeeded =
         optimize_current_frame_with_local_map(num_tracked_lms, outlier_ids);
   }
@@ -273,6 +291,11 @@ bool tracking_module::track(bool relocalization_is_needed) {
     update_motion_model();
   }
 
+  // page in the map tiles around the current pose
+  if (succeeded && map_pager_) {
+    map_pager_->request_tiles_around(curr_frm_.get_cam_center());
+  }
+
   // check to insert the new keyframe derived from the current frame
   if (succeeded && new_keyframe_is_needed(num_tracked_lms)) {
     insert_new_keyframe();
@@ -293,7 +316,7 @@ bool tracking_module::track(bool relocalization_is_needed) {
 
 bool tracking_module::initialize() {
   // LOCK the map database
-  std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+  std::lock_guard<std::mutex> lock(map_db_->mtx_database_);
 
   // try to initialize with the current frame
   initializer_.initialize(camera_->setup_type_, bow_vocab_, curr_frm_);
@@ -468,8 +491,7 @@ bool tracking_module::optimize_current_frame_with_local_map(
   return true;
 }
 
-void tracking_module::update_local_map(
-    std::unordered_set<unsigned int>& outlier_ids) {
+void tracking_module::update_local_map() {
   // clean landmark associations
   for (unsigned int idx = 0; idx < curr_frm_.frm_obs_.num_keypts_; ++idx) {
     const auto& lm = curr_frm_.landmarks_.at(idx);
@@ -483,30 +505,31 @@ void tracking_module::update_local_map(
   }
 
   // acquire the current local map
-  constexpr unsigned int max_num_local_keyfrms = 60;
-  auto local_map_updater =
-      module::local_map_updater(curr_frm_, max_num_local_keyfrms);
-  if (!local_map_updater.acquire_local_map(outlier_ids)) {
+  // (the outliers are excluded in search_local_landmarks())
+  if (!local_map_updater_.acquire_local_map(curr_frm_)) {
     return;
   }
-  // update the variables
-  local_keyfrms_ = local_map_updater.get_local_keyframes();
-  local_landmarks_ = local_map_updater.get_local_landmarks();
-  auto nearest_covisibility = local_map_updater.get_nearest_covisibility();
+  // update the variables only if the local map has been searched again
+  if (local_map_updater_.local_map_is_rebuilt()) {
+    local_keyfrms_ = local_map_updater_.get_local_keyframes();
+    local_landmarks_ = local_map_updater_.get_local_landmarks();
+    map_db_->set_local_landmarks(local_landmarks_);
+  }
+  // the snapshot is taken every frame because the positions can be optimized
+  local_landmark_snapshot_.build(local_landmarks_);
+  auto nearest_covisibility = local_map_updater_.get_nearest_covisibility();
 
   // update the reference keyframe for the current frame
   if (nearest_covisibility) {
     curr_frm_.ref_keyfrm_ = nearest_covisibility;
   }
-
-  map_db_->set_local_landmarks(local_landmarks_);
 }
 
 void tracking_module::search_local_landmarks(
     std::unordered_set<unsigned int>& outlier_ids) {
   // select the landmarks which can be reprojected from the ones observed in the
-  // current frame
-  std::unordered_set<unsigned int> curr_landmark_ids;
+  // current frame (the outliers are not reprojected either)
+  std::unordered_set<unsigned int> excluded_ids = outlier_ids;
   for (const auto& lm : curr_frm_.landmarks_) {
     if (!lm) {
       continue;
@@ -517,47 +540,20 @@ void tracking_module::search_local_landmarks(
 
     // this landmark cannot be reprojected
     // because already observed in the current frame
-    curr_landmark_ids.insert(lm->id_);
+    excluded_ids.insert(lm->id_);
 
     // this landmark is observable from the current frame
     lm->increase_num_observable();
   }
 
-  bool found_proj_candidate = false;
-  // temporary variables
-  Vec2_t reproj;
-  float x_right;
-  unsigned int pred_scale_level;
-  eigen_alloc_unord_map<unsigned int, Vec2_t> lm_to_reproj;
-  std::unordered_map<unsigned int, float> lm_to_x_right;
-  std::unordered_map<unsigned int, int> lm_to_scale;
-  for (const auto& lm : local_landmarks_) {
-    if (curr_landmark_ids.count(curr_frm_.id_)) {
-      continue;
-    }
-    if (outlier_ids.count(curr_frm_.id_)) {
-      continue;
-    }
-    if (lm->will_be_erased()) {
-      continue;
-    }
-
-    // check the observability
-    if (curr_frm_.can_observe(lm, 0.5, reproj, x_right, pred_scale_level)) {
-      lm_to_reproj[lm->id_] = reproj;
-      lm_to_x_right[lm->id_] = x_right;
-      lm_to_scale[lm->id_] = pred_scale_level;
-
-      // this landmark is observable from the current frame
-      lm->increase_num_observable();
-
-      found_proj_candidate = true;
-    }
-  }
-
-  if (!found_proj_candidate) {
+  // check the observability of the local landmarks over the snapshot
+  if (!local_landmark_snapshot_.cull(curr_frm_, 0.5, excluded_ids)) {
     return;
   }
+  for (const auto idx : local_landmark_snapshot_.visible_indices_) {
+    // this landmark is observable from the current frame
+    local_landmark_snapshot_.lms_.at(idx)->increase_num_observable();
+  }
 
   // acquire more 2D-3D matches by projecting the local landmarks to the current
   // frame
@@ -566,9 +562,8 @@ void tracking_module::search_local_landmarks(
       (curr_frm_.id_ < last_reloc_frm_id_ + 2)
           ? 20.0
           : ((camera_->setup_type_ == camera::setup_type_t::RGBD) ? 10.0 : 5.0);
-  projection_matcher.match_frame_and_landmarks(curr_frm_, local_landmarks_,
-                                               lm_to_reproj, lm_to_x_right,
-                                               lm_to_scale, margin);
+  projection_matcher.match_frame_and_landmarks(
+      curr_frm_, local_landmark_snapshot_, margin);
 }
 
 bool tracking_module::new_keyframe_is_needed(
@@ -8,9 +8,11 @@
 #include <opencv2/features2d/features2d.hpp>
 
 #include "openvslam/data/frame.h"
+#include "openvslam/data/landmark_snapshot.h"
 #include "openvslam/module/frame_tracker.h"
 #include "openvslam/module/initializer.h"
 #include "openvslam/module/keyframe_inserter.h"
+#include "openvslam/module/local_map_updater.h"
 #include "openvslam/module/relocalizer.h"
 #include "openvslam/type.h"
 
@@ -25,6 +27,10 @@ class map_database;
 class bow_database;
 }  // namespace data
 
+namespace module {
+class map_pager;
+}  // namespace module
+
 // tracker state
 enum class tracker_state_t { Initializing, Tracking, Lost };
 
@@ -55,6 +61,9 @@ class tracking_module {
   void set_global_optimization_module(
       global_optimization_module* global_optimizer);
 
+  //! Set the pager of the tiled map database (nullptr to disable paging)
+  void set_map_pager(module::map_pager* map_pager);
+
   //-----------------------------------------
   // interfaces
 
@@ -161,7 +170,7 @@ class tracking_module {
       std::unordered_set<unsigned int>& outlier_ids);
 
   //! Update the local map
-  void update_local_map(std::unordered_set<unsigned int>& outlier_ids);
+  void update_local_map();
 
   //! Acquire more 2D-3D matches using initial camera pose estimation
   void search_local_landmarks(std::unordered_set<unsigned int>& outlier_ids);
@@ -176,6 +185,8 @@ class tracking_module {
   mapping_module* mapper_ = nullptr;
   //! global optimization module
   global_optimization_module* global_optimizer_ = nullptr;
+  //! pager of the tiled map database (nullptr if the whole map is loaded)
+  module::map_pager* map_pager_ = nullptr;
 
   //! map_database
   data::map_database* map_db_ = nullptr;
@@ -201,10 +212,15 @@ class tracking_module {
   //! keyframe inserter
   module::keyframe_inserter keyfrm_inserter_;
 
+  //! local map updater, which keeps the local map of the previous frame
+  module::local_map_updater local_map_updater_;
+
   //! local keyframes
   std::vector<std::shared_ptr<data::keyframe>> local_keyfrms_;
   //! local landmarks
   std::vector<std::shared_ptr<data::landmark>> local_landmarks_;
+  //! snapshot of the local landmarks, which is used for the visibility check
+  data::landmark_snapshot local_landmark_snapshot_;
 
   //! last frame
   data::frame last_frm_;
@@ -1,6 +1,7 @@
 #include "socket_publisher/data_serializer.h"
 
-#include <forward_list>
+#include <cmath>
+#include <cstdlib>
 #include <opencv2/imgcodecs.hpp>
 
 #include "openvslam/data/keyframe.h"
@@ -18,18 +19,40 @@ std::string data_serializer::serialized_reset_signal_{};
 data_serializer::data_serializer(
     const std::shared_ptr<openvslam::publish::frame_publisher>& frame_publisher,
     const std::shared_ptr<openvslam::publish::map_publisher>& map_publisher,
-    bool publish_points)
+    bool publish_points, const bool binary_transport,
+    const coordinate_format_t coordinate_format, const double quantization_step,
+    const bool wait_for_ack)
     : frame_publisher_(frame_publisher),
       map_publisher_(map_publisher),
       publish_points_(publish_points),
-      keyframe_hash_map_(new std::unordered_map<unsigned int, double>),
-      point_hash_map_(new std::unordered_map<unsigned int, double>) {
+      binary_transport_(binary_transport),
+      coordinate_format_(coordinate_format),
+      quantization_step_(quantization_step),
+      wait_for_ack_(wait_for_ack) {
+  if (coordinate_format_ == coordinate_format_t::Int16 &&
+      quantization_step_ <= 0.0) {
+    throw std::runtime_error("quantization_step must be greater than 0");
+  }
   const auto tags = std::vector<std::string>{"RESET_ALL"};
   const auto messages = std::vector<std::string>{"reset all data"};
   data_serializer::serialized_reset_signal_ =
       serialize_messages(tags, messages);
 }
 
+coordinate_format_t data_serializer::load_coordinate_format(
+    const std::string& coordinate_format_str) {
+  if (coordinate_format_str == "double") {
+    return coordinate_format_t::Double;
+  } else if (coordinate_format_str == "float32") {
+    return coordinate_format_t::Float32;
+  } else if (coordinate_format_str == "int16") {
+    return coordinate_format_t::Int16;
+  }
+
+  throw std::runtime_error("Invalid coordinate format: " +
+                           coordinate_format_str);
+}
+
 std::string data_serializer::serialize_messages(
     const std::vector<std::string>& tags,
     const std::vector<std::string>& messages) {
@@ -46,8 +69,7 @@ std::string data_serializer::serialize_messages(
   std::string buffer;
   map.SerializeToString(&buffer);
 
-  const auto* cstr = reinterpret_cast<const unsigned char*>(buffer.c_str());
-  return base64_encode(cstr, buffer.length());
+  return encode(buffer);
 }
 
 std::string data_serializer::serialize_map_diff() {
@@ -75,16 +97,87 @@ std::string data_serializer::serialize_map_diff() {
 
 std::string data_serializer::serialize_latest_frame(
     const unsigned int image_quality) {
+  // the drawing and the encoding are skipped if the frame is not updated
+  const auto version = frame_publisher_->get_version();
+  if (frame_is_serialized_ && version == frame_version_) {
+    return "";
+  }
+  frame_version_ = version;
+  frame_is_serialized_ = true;
+
   const auto image = frame_publisher_->draw_frame();
   std::vector<uchar> buf;
   const std::vector<int> params{static_cast<int>(cv::IMWRITE_JPEG_QUALITY),
                                 static_cast<int>(image_quality)};
   cv::imencode(".jpg", image, buf, params);
+  if (binary_transport_) {
+    return std::string(buf.begin(), buf.end());
+  }
   const auto char_buf = reinterpret_cast<const unsigned char*>(buf.data());
   const std::string base64_serial = base64_encode(char_buf, buf.size());
   return base64_serial;
 }
 
+void data_serializer::acknowledge(const unsigned int sequence) {
+  std::lock_guard<std::mutex> lock(mtx_states_);
+  if (sequence_ < sequence) {
+    return;
+  }
+  // the client applies the messages in order, so it has also applied the
+  // newest pending state at or below the sequence (the state of the sequence
+  // itself may have been evicted)
+  auto itr = pending_states_.upper_bound(sequence);
+  if (itr == pending_states_.begin()) {
+    return;
+  }
+  --itr;
+  // the older states are never used as the base
+  base_state_ = std::move(itr->second);
+  base_sequence_ = itr->first;
+  pending_states_.erase(pending_states_.begin(), std::next(itr));
+}
+
+std::array<double, 3> data_serializer::encode_position(
+    const coordinate_format_t coordinate_format,
+    const double quantization_step, const openvslam::Vec3_t& pos,
+    const std::array<double, 3>* sent_pos, std::array<long, 3>& deltas,
+    bool& is_quantized) {
+  constexpr long max_quantized_delta = 32767;
+
+  // position which the client decodes
+  std::array<double, 3> decoded_pos;
+  is_quantized = false;
+  deltas = {{0, 0, 0}};
+  switch (coordinate_format) {
+    case coordinate_format_t::Double: {
+      decoded_pos = {{pos(0), pos(1), pos(2)}};
+      break;
+    }
+    case coordinate_format_t::Float32: {
+      for (int i = 0; i < 3; i++) {
+        decoded_pos[i] = static_cast<float>(pos(i));
+      }
+      break;
+    }
+    case coordinate_format_t::Int16: {
+      // the differences from the sent position are quantized if they fit
+      // in int16, otherwise the position is sent as float32
+      is_quantized = sent_pos != nullptr;
+      for (int i = 0; is_quantized && i < 3; i++) {
+        deltas[i] = std::lround((pos(i) - (*sent_pos)[i]) / quantization_step);
+        is_quantized = std::abs(deltas[i]) <= max_quantized_delta;
+      }
+      for (int i = 0; i < 3; i++) {
+        decoded_pos[i] = is_quantized
+                             ? (*sent_pos)[i] + deltas[i] * quantization_step
+                             : static_cast<float>(pos(i));
+      }
+      break;
+    }
+  }
+  return decoded_pos;
+}
+
 std::string data_serializer::serialize_as_protobuf(
     const std::vector<std::shared_ptr<openvslam::data::keyframe>>& keyfrms,
     const std::vector<std::shared_ptr<openvslam::data::landmark>>&
@@ -96,53 +189,52 @@ std::string data_serializer::serialize_as_protobuf(
   message->set_tag("0");
   message->set_txt("only map data");
 
-  std::forward_list<map_segment::map_keyframe*> allocated_keyframes;
+  std::lock_guard<std::mutex> lock(mtx_states_);
+
+  // the client applies the differences to the state of base_sequence
+  map.set_sequence(++sequence_);
+  map.set_base_sequence(base_sequence_);
+  if (coordinate_format_ == coordinate_format_t::Int16) {
+    map.set_quantization_step(quantization_step_);
+  }
+
+  // state which the client holds after applying this message
+  map_state next_state;
 
   // 1. keyframe registration
 
-  std::unordered_map<unsigned int, double> next_keyframe_hash_map;
   for (const auto keyfrm : keyfrms) {
     if (!keyfrm || keyfrm->will_be_erased()) {
       continue;
     }
 
     const auto id = keyfrm->id_;
-    const auto pose = keyfrm->get_cam_pose();
-    const auto pose_hash = get_mat_hash(pose);  // get zipped code (likely hash)
 
-    next_keyframe_hash_map[id] = pose_hash;
+    map_segment::map_Mat44 pose_obj;
+    const auto pose = set_pose(keyfrm->get_cam_pose(), &pose_obj);
+    next_state.keyfrm_poses_[id] = pose;
 
-    // check whether the "point" has already been send.
-    // and remove it from "keyframe_zip".
-    if (keyframe_hash_map_->count(id) != 0) {
-      if (keyframe_hash_map_->at(id) == pose_hash) {
-        keyframe_hash_map_->erase(id);
-        continue;
-      }
-      keyframe_hash_map_->erase(id);
+    // check whether the pose has already been sent
+    const auto itr = base_state_.keyfrm_poses_.find(id);
+    if (itr != base_state_.keyfrm_poses_.end() && itr->second == pose) {
+      continue;
     }
 
     auto keyfrm_obj = map.add_keyframes();
-    keyfrm_obj->set_id(keyfrm->id_);
-    map_segment::map_Mat44* pose_obj = new map_segment::map_Mat44();
-    for (int i = 0; i < 16; i++) {
-      int ir = i / 4;
-      int il = i % 4;
-      pose_obj->add_pose(pose(ir, il));
-    }
-    keyfrm_obj->set_allocated_pose(pose_obj);
-    allocated_keyframes.push_front(keyfrm_obj);
+    keyfrm_obj->set_id(id);
+    keyfrm_obj->mutable_pose()->Swap(&pose_obj);
   }
   // add removed keyframes.
-  for (const auto& itr : *keyframe_hash_map_) {
+  for (const auto& itr : base_state_.keyfrm_poses_) {
     const auto id = itr.first;
+    if (next_state.keyfrm_poses_.count(id)) {
+      continue;
+    }
 
     auto keyfrm_obj = map.add_keyframes();
     keyfrm_obj->set_id(id);
   }
 
-  *keyframe_hash_map_ = next_keyframe_hash_map;
-
   // 2. graph registration
   for (const auto keyfrm : keyfrms) {
     if (!keyfrm || keyfrm->will_be_erased()) {
@@ -193,47 +285,58 @@ std::string data_serializer::serialize_as_protobuf(
 
   // 3. landmark registration
 
-  std::unordered_map<unsigned int, double> next_point_hash_map;
   for (const auto& landmark : all_landmarks) {
     if (!landmark || landmark->will_be_erased()) {
       continue;
     }
 
     const auto id = landmark->id_;
-    const auto pos = landmark->get_pos_in_world();
-    const auto zip = get_vec_hash(pos);
-
-    // point exists on next_point_zip.
-    next_point_hash_map[id] = zip;
-
-    // remove point from point_zip.
-    if (point_hash_map_->count(id) != 0) {
-      if (point_hash_map_->at(id) == zip) {
-        point_hash_map_->erase(id);
-        continue;
-      }
-      point_hash_map_->erase(id);
+    const openvslam::Vec3_t pos = landmark->get_pos_in_world();
+    const auto itr = base_state_.lm_positions_.find(id);
+    const bool is_sent = itr != base_state_.lm_positions_.end();
+
+    // position which the client decodes
+    bool is_quantized = false;
+    std::array<long, 3> deltas;
+    const auto decoded_pos = encode_position(
+        coordinate_format_, quantization_step_, pos,
+        is_sent ? &itr->second : nullptr, deltas, is_quantized);
+
+    // check whether the position has already been sent
+    if (is_sent && itr->second == decoded_pos) {
+      next_state.lm_positions_[id] = itr->second;
+      continue;
     }
+    next_state.lm_positions_[id] = decoded_pos;
+
     const unsigned int rgb[] = {0, 0, 0};
 
     // add to protocol buffers
     auto landmark_obj = map.add_landmarks();
     landmark_obj->set_id(id);
     for (int i = 0; i < 3; i++) {
-      landmark_obj->add_coords(pos[i]);
+      if (is_quantized) {
+        landmark_obj->add_coords_delta(deltas[i]);
+      } else if (coordinate_format_ == coordinate_format_t::Double) {
+        landmark_obj->add_coords(decoded_pos[i]);
+      } else {
+        landmark_obj->add_coords_f32(decoded_pos[i]);
+      }
     }
     for (int i = 0; i < 3; i++) {
       landmark_obj->add_color(rgb[i]);
     }
   }
-  // removed points are remaining in "point_zips".
-  for (const auto& itr : *point_hash_map_) {
+  // add removed landmarks.
+  for (const auto& itr : base_state_.lm_positions_) {
     const auto id = itr.first;
+    if (next_state.lm_positions_.count(id)) {
+      continue;
+    }
 
     auto landmark_obj = map.add_landmarks();
     landmark_obj->set_id(id);
   }
-  *point_hash_map_ = next_point_hash_map;
 
   // 4. local landmark registration
 
@@ -242,61 +345,81 @@ std::string data_serializer::serialize_as_protobuf(
   }
 
   // 5. current camera pose registration
-  map_segment::map_Mat44 pose_obj{};
-  for (int i = 0; i < 16; i++) {
-    int ir = i / 4;
-    int il = i % 4;
-    pose_obj.add_pose(current_camera_pose(ir, il));
+  set_pose(current_camera_pose, map.mutable_current_frame());
+
+  if (wait_for_ack_) {
+    // the client acknowledges the state
+    pending_states_[sequence_] = std::move(next_state);
+    // the oldest state is kept so that the base can be advanced by an ack
+    // for any of the evicted states
+    if (max_num_pending_states_ < pending_states_.size()) {
+      pending_states_.erase(std::next(pending_states_.begin()));
+    }
+  } else {
+    base_state_ = std::move(next_state);
+    base_sequence_ = sequence_;
   }
-  map.set_allocated_current_frame(&pose_obj);
 
   std::string buffer;
   map.SerializeToString(&buffer);
 
-  for (const auto keyfrm_obj : allocated_keyframes) {
-    keyfrm_obj->clear_pose();
+  return encode(buffer);
+}
+
+std::array<double, 16> data_serializer::set_pose(
+    const openvslam::Mat44_t& pose, map_segment::map_Mat44* pose_obj) const {
+  std::array<double, 16> decoded_pose;
+  for (int i = 0; i < 16; i++) {
+    int ir = i / 4;
+    int il = i % 4;
+    if (coordinate_format_ == coordinate_format_t::Double) {
+      decoded_pose[i] = pose(ir, il);
+      pose_obj->add_pose(decoded_pose[i]);
+    } else {
+      // the rotations are not quantized
+      decoded_pose[i] = static_cast<float>(pose(ir, il));
+      pose_obj->add_pose_f32(decoded_pose[i]);
+    }
   }
-  map.release_current_frame();
+  return decoded_pose;
+}
 
+std::string data_serializer::encode(const std::string& buffer) {
+  if (binary_transport_) {
+    return buffer;
+  }
   const auto* cstr = reinterpret_cast<const unsigned char*>(buffer.c_str());
   return base64_encode(cstr, buffer.length());
 }
 
 std::string data_serializer::base64_encode(unsigned char const* bytes_to_encode,
                                            unsigned int in_len) {
-  static const std::string base64_chars =
+  static const char base64_chars[] =
       "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-  std::stringstream ss;
-  int i = 0, j = 0;
-  unsigned char char_array_3[3];
-  unsigned char char_array_4[4];
-
-  while (in_len--) {
-    char_array_3[i++] = *(bytes_to_encode++);
-    if (i == 3) {
-      char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-      char_array_4[1] =
-          ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-      char_array_4[2] =
-          ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-      char_array_4[3] = char_array_3[2] & 0x3f;
-      for (i = 0; (i < 4); i++) ss << base64_chars[char_array_4[i]];
-      i = 0;
-    }
+  // every 3 bytes are encoded into 4 characters
+  std::string encoded(4 * ((in_len + 2) / 3), '=');
+  auto out = &encoded[0];
+  for (; 3 <= in_len; in_len -= 3, bytes_to_encode += 3) {
+    const unsigned int triple = (bytes_to_encode[0] << 16) |
+                                (bytes_to_encode[1] << 8) | bytes_to_encode[2];
+    *(out++) = base64_chars[(triple >> 18) & 0x3f];
+    *(out++) = base64_chars[(triple >> 12) & 0x3f];
+    *(out++) = base64_chars[(triple >> 6) & 0x3f];
+    *(out++) = base64_chars[triple & 0x3f];
   }
 
-  if (i > 0) {
-    for (j = i; j < 3; j++) char_array_3[j] = '\0';
-    char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-    char_array_4[1] =
-        ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-    char_array_4[2] =
-        ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-    for (j = 0; (j < i + 1); j++) ss << base64_chars[char_array_4[j]];
-    while ((i++ < 3)) ss << '=';
+  // the remaining bytes are padded with '='
+  if (0 < in_len) {
+    const unsigned int triple =
+        (bytes_to_encode[0] << 16) | (1 < in_len ? bytes_to_encode[1] << 8 : 0);
+    *(out++) = base64_chars[(triple >> 18) & 0x3f];
+    *(out++) = base64_chars[(triple >> 12) & 0x3f];
+    if (1 < in_len) {
+      *(out++) = base64_chars[(triple >> 6) & 0x3f];
+    }
   }
-  return ss.str();
+  return encoded;
 }
 
 }  // namespace socket_publisher
@@ -4,8 +4,12 @@
 #include <sioclient/sio_client.h>
 
 #include <Eigen/Core>
+#include <array>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <opencv2/core.hpp>
+#include <unordered_map>
 
 #include "openvslam/type.h"
 
@@ -25,38 +29,120 @@ class map_publisher;
 
 }  // namespace openvslam
 
+namespace map_segment {
+class map_Mat44;
+}  // namespace map_segment
+
 namespace socket_publisher {
 
+//! Format of the coordinates of the keyframes and the landmarks
+enum class coordinate_format_t { Double = 0, Float32 = 1, Int16 = 2 };
+
 class data_serializer {
  public:
+  /**
+   * Constructor
+   * @param frame_publisher
+   * @param map_publisher
+   * @param publish_points
+   * @param binary_transport if true, the messages are raw bytes, otherwise
+   * they are base64 strings
+   * @param coordinate_format
+   * @param quantization_step step of the quantized differences of the
+   * landmark coordinates (used if the format is int16) [m]
+   * @param wait_for_ack if true, the differences are encoded against the
+   * state acknowledged by the client, otherwise against the state sent last
+   */
   data_serializer(
       const std::shared_ptr<openvslam::publish::frame_publisher>&
           frame_publisher,
       const std::shared_ptr<openvslam::publish::map_publisher>& map_publisher,
-      bool publish_points);
+      bool publish_points, const bool binary_transport = false,
+      const coordinate_format_t coordinate_format = coordinate_format_t::Double,
+      const double quantization_step = 0.001, const bool wait_for_ack = false);
+
+  //! Load the coordinate format from the string
+  static coordinate_format_t load_coordinate_format(
+      const std::string& coordinate_format_str);
 
   std::string serialize_messages(const std::vector<std::string>& tags,
                                  const std::vector<std::string>& messages);
 
   std::string serialize_map_diff();
 
+  //! Serialize the latest frame
+  //! (an empty string is returned if the frame has not been updated)
   std::string serialize_latest_frame(const unsigned int image_quality_);
 
+  //! Notify that the client has applied the map message of the sequence
+  //! number (called from the thread of the socket client)
+  void acknowledge(const unsigned int sequence);
+
+  /**
+   * Encode the landmark position for the client
+   * @param coordinate_format
+   * @param quantization_step
+   * @param pos
+   * @param sent_pos position which the client holds, or nullptr if the
+   * landmark has not been sent
+   * @param deltas quantized differences from sent_pos (valid if is_quantized
+   * is true)
+   * @param is_quantized the differences are quantized or not
+   * @return position which the client decodes
+   */
+  static std::array<double, 3> encode_position(
+      const coordinate_format_t coordinate_format,
+      const double quantization_step, const openvslam::Vec3_t& pos,
+      const std::array<double, 3>* sent_pos, std::array<long, 3>& deltas,
+      bool& is_quantized);
+
+  //! Encode the bytes as a base64 string with the padding
+  static std::string base64_encode(unsigned char const* bytes_to_encode,
+                                   unsigned int in_len);
+
   static std::string serialized_reset_signal_;
 
  private:
+  //! Map which the client holds after applying a message
+  struct map_state {
+    //! poses of the keyframes as the client decodes them
+    std::unordered_map<unsigned int, std::array<double, 16>> keyfrm_poses_;
+    //! positions of the landmarks as the client decodes them
+    std::unordered_map<unsigned int, std::array<double, 3>> lm_positions_;
+  };
+
+  //! maximum number of the unacknowledged states
+  //! (the states after the oldest one are evicted if it is exceeded)
+  static constexpr unsigned int max_num_pending_states_ = 64;
+
   const std::shared_ptr<openvslam::publish::frame_publisher> frame_publisher_;
   const std::shared_ptr<openvslam::publish::map_publisher> map_publisher_;
   bool publish_points_ = true;
-  std::unique_ptr<std::unordered_map<unsigned int, double>> keyframe_hash_map_;
-  std::unique_ptr<std::unordered_map<unsigned int, double>> point_hash_map_;
+  //! the messages are raw bytes or not
+  const bool binary_transport_;
+  //! format of the coordinates
+  const coordinate_format_t coordinate_format_;
+  //! step of the quantized differences of the landmark coordinates [m]
+  const double quantization_step_;
+  //! the differences are encoded against the acknowledged state or not
+  const bool wait_for_ack_;
+
+  //! mutex to access the states below
+  std::mutex mtx_states_;
+  //! state which the differences are encoded against
+  map_state base_state_;
+  //! sequence number of base_state_ (0 is the empty map)
+  unsigned int base_sequence_ = 0;
+  //! states sent but not acknowledged yet
+  std::map<unsigned int, map_state> pending_states_;
+  //! sequence number of the last map message
+  unsigned int sequence_ = 0;
 
   double current_pose_hash_ = 0;
-  int frame_hash_ = 0;
-
-  inline double get_vec_hash(const openvslam::Vec3_t& point) {
-    return point[0] + point[1] + point[2];
-  }
+  //! version of the frame which is serialized last
+  unsigned int frame_version_ = 0;
+  //! a frame has been serialized or not
+  bool frame_is_serialized_ = false;
 
   inline double get_mat_hash(const openvslam::Mat44_t& pose) {
     return pose(0, 3) + pose(1, 3) + pose(2, 3);
@@ -70,8 +156,12 @@ class data_serializer {
           local_landmarks,
       const openvslam::Mat44_t& current_camera_pose);
 
-  std::string base64_encode(unsigned char const* bytes_to_encode,
-                            unsigned int in_len);
+  //! Set the pose to the message and return the pose decoded by the client
+  std::array<double, 16> set_pose(const openvslam::Mat44_t& pose,
+                                  map_segment::map_Mat44* pose_obj) const;
+
+  //! Encode the buffer for the transport
+  std::string encode(const std::string& buffer);
 };
 
 }  // namespace socket_publisher
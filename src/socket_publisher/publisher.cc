@@ -14,14 +14,24 @@ publisher::publisher(
       emitting_interval_(
           yaml_node["emitting_interval"].as<unsigned int>(15000)),
       image_quality_(yaml_node["image_quality"].as<unsigned int>(20)),
+      binary_transport_(yaml_node["binary_transport"].as<bool>(false)),
       client_(new socket_client(
           yaml_node["server_uri"].as<std::string>("http://127.0.0.1:3000"))) {
-  data_serializer_ = std::unique_ptr<data_serializer>(
-      new data_serializer(frame_publisher, map_publisher,
-                          yaml_node["publish_points"].as<bool>(true)));
+  const auto wait_for_ack = yaml_node["wait_for_ack"].as<bool>(false);
+  data_serializer_ = std::unique_ptr<data_serializer>(new data_serializer(
+      frame_publisher, map_publisher,
+      yaml_node["publish_points"].as<bool>(true), binary_transport_,
+      data_serializer::load_coordinate_format(
+          yaml_node["coordinate_format"].as<std::string>("double")),
+      yaml_node["quantization_step"].as<double>(0.001), wait_for_ack));
 
   client_->set_signal_callback(
       std::bind(&publisher::callback, this, std::placeholders::_1));
+  if (wait_for_ack) {
+    client_->set_ack_callback(std::bind(&data_serializer::acknowledge,
+                                        data_serializer_.get(),
+                                        std::placeholders::_1));
+  }
 }
 
 void publisher::run() {
@@ -30,20 +40,20 @@ void publisher::run() {
 
   const auto serialized_reset_signal =
       data_serializer::serialized_reset_signal_;
-  client_->emit("map_publish", serialized_reset_signal);
+  emit("map_publish", serialized_reset_signal);
 
   while (true) {
     const auto t0 = std::chrono::system_clock::now();
 
     const auto serialized_map_data = data_serializer_->serialize_map_diff();
     if (!serialized_map_data.empty()) {
-      client_->emit("map_publish", serialized_map_data);
+      emit("map_publish", serialized_map_data);
     }
 
     const auto serialized_frame_data =
         data_serializer_->serialize_latest_frame(image_quality_);
     if (!serialized_frame_data.empty()) {
-      client_->emit("frame_publish", serialized_frame_data);
+      emit("frame_publish", serialized_frame_data);
     }
 
     // sleep until emitting interval time is past
@@ -70,6 +80,14 @@ void publisher::run() {
   terminate();
 }
 
+void publisher::emit(const std::string& tag, const std::string& buffer) {
+  if (binary_transport_) {
+    client_->emit_binary(tag, buffer);
+  } else {
+    client_->emit(tag, buffer);
+  }
+}
+
 void publisher::callback(const std::string& message) {
   if (message == "disable_mapping_mode") {
     system_->disable_mapping_module();
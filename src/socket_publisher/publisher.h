@@ -42,10 +42,14 @@ class publisher {
   openvslam::system* system_;
   const unsigned int emitting_interval_;
   const unsigned int image_quality_;
+  //! the messages are emitted as raw bytes or not
+  const bool binary_transport_;
 
   std::unique_ptr<socket_client> client_;
   std::unique_ptr<data_serializer> data_serializer_;
 
+  void emit(const std::string& tag, const std::string& buffer);
+
   void callback(const std::string& message);
 
   /* thread controls */
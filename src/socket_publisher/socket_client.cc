@@ -5,7 +5,7 @@
 namespace socket_publisher {
 
 socket_client::socket_client(const std::string& server_uri)
-    : client_(), callback_() {
+    : client_(), callback_(), ack_callback_() {
   // register socket callbacks
   client_.set_open_listener(std::bind(&socket_client::on_open, this));
   client_.set_close_listener(std::bind(&socket_client::on_close, this));
@@ -18,6 +18,8 @@ socket_client::socket_client(const std::string& server_uri)
 
   socket_->on("signal", std::bind(&socket_client::on_receive, this,
                                   std::placeholders::_1));
+  socket_->on("ack", std::bind(&socket_client::on_ack, this,
+                               std::placeholders::_1));
 }
 
 void socket_client::on_close() { spdlog::info("connection closed correctly"); }
@@ -37,4 +39,16 @@ void socket_client::on_receive(const sio::event& event) {
   }
 }
 
+void socket_client::on_ack(const sio::event& event) {
+  try {
+    const auto sequence =
+        static_cast<unsigned int>(event.get_message()->get_int());
+    if (ack_callback_) {
+      ack_callback_(sequence);
+    }
+  } catch (std::exception& ex) {
+    spdlog::error(ex.what());
+  }
+}
+
 }  // namespace socket_publisher
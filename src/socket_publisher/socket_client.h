@@ -19,20 +19,33 @@ class socket_client {
     socket_->emit(tag, buffer);
   }
 
+  //! Emit the buffer as raw bytes
+  void emit_binary(const std::string tag, const std::string buffer) {
+    socket_->emit(tag, sio::binary_message::create(
+                           std::make_shared<const std::string>(buffer)));
+  }
+
   void set_signal_callback(std::function<void(std::string)> callback) {
     callback_ = callback;
   }
 
+  //! Set the callback of the sequence numbers acknowledged by the server
+  void set_ack_callback(std::function<void(unsigned int)> callback) {
+    ack_callback_ = callback;
+  }
+
  private:
   void on_close();
   void on_fail();
   void on_open();
   void on_receive(const sio::event& event);
+  void on_ack(const sio::event& event);
 
   sio::client client_;
   sio::socket::ptr socket_;
 
   std::function<void(std::string)> callback_;
+  std::function<void(unsigned int)> ack_callback_;
 };
 
 }  // namespace socket_publisher
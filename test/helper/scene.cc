@@ -0,0 +1,200 @@
+#include "helper/scene.h"
+
+#include "openvslam/data/common.h"
+#include "openvslam/data/graph_node.h"
+
+synthetic_scene::synthetic_scene(const unsigned int num_keyfrms,
+                                 const unsigned int num_landmarks,
+                                 const double noise_stddev,
+                                 const unsigned int seed)
+    : camera_(new camera::perspective(
+          "synthetic camera", camera::setup_type_t::Monocular,
+          camera::color_order_t::Gray, 640, 480, 30.0, 500.0, 500.0, 320.0,
+          240.0, 0.0, 0.0, 0.0, 0.0, 0.0)),
+      orb_params_(new feature::orb_params("synthetic ORB setting", 1.2, 8, 20,
+                                          7)),
+      map_db_(new data::map_database()),
+      noise_stddev_(noise_stddev),
+      mt_(seed) {
+  // 1. create the landmarks in front of the trajectory
+  std::uniform_real_distribution<> rand_x(-12.0, 12.0);
+  std::uniform_real_distribution<> rand_y(-8.0, 8.0);
+  std::uniform_real_distribution<> rand_z(10.0, 30.0);
+  std::uniform_real_distribution<float> rand_angle(0.0, 360.0);
+  std::uniform_int_distribution<int> rand_byte(0, 255);
+
+  lm_positions_.resize(num_landmarks);
+  lm_descriptors_ = cv::Mat(num_landmarks, 32, CV_8U);
+  lm_angles_.resize(num_landmarks);
+  for (unsigned int i = 0; i < num_landmarks; ++i) {
+    lm_positions_.at(i) = Vec3_t{rand_x(mt_), rand_y(mt_), rand_z(mt_)};
+    for (unsigned int j = 0; j < 32; ++j) {
+      lm_descriptors_.at<uchar>(i, j) = static_cast<uchar>(rand_byte(mt_));
+    }
+    lm_angles_.at(i) = rand_angle(mt_);
+  }
+
+  // 2. create the keyframes along the x-axis
+  std::vector<std::vector<unsigned int>> lm_indices_in_keyfrms(num_keyfrms);
+  keyfrms_.reserve(num_keyfrms);
+  keyfrm_xs_.reserve(num_keyfrms);
+  for (unsigned int i = 0; i < num_keyfrms; ++i) {
+    const double x = 0.2 * i;
+    const auto frm = create_frame(get_cam_pose(x), lm_indices_in_keyfrms.at(i));
+    auto keyfrm = data::keyframe::make_keyframe(map_db_->next_keyframe_id_++,
+                                                frm, map_db_.get());
+    map_db_->add_keyframe(keyfrm);
+    keyfrms_.push_back(keyfrm);
+    keyfrm_xs_.push_back(x);
+  }
+  if (!keyfrms_.empty()) {
+    map_db_->origin_keyfrm_ = keyfrms_.front();
+  }
+
+  // 3. create the landmarks which are observed by two or more keyframes
+  std::vector<std::vector<std::pair<unsigned int, unsigned int>>> observations(
+      num_landmarks);
+  for (unsigned int i = 0; i < num_keyfrms; ++i) {
+    const auto& lm_indices = lm_indices_in_keyfrms.at(i);
+    for (unsigned int idx = 0; idx < lm_indices.size(); ++idx) {
+      observations.at(lm_indices.at(idx)).emplace_back(i, idx);
+    }
+  }
+
+  lms_.resize(num_landmarks, nullptr);
+  for (unsigned int i = 0; i < num_landmarks; ++i) {
+    if (observations.at(i).size() < 2) {
+      continue;
+    }
+    const auto& ref_keyfrm = keyfrms_.at(observations.at(i).front().first);
+    auto lm = std::make_shared<data::landmark>(lm_positions_.at(i), ref_keyfrm,
+                                               map_db_.get());
+    for (const auto& obs : observations.at(i)) {
+      const auto& keyfrm = keyfrms_.at(obs.first);
+      lm->add_observation(keyfrm, obs.second);
+      keyfrm->add_landmark(lm, obs.second);
+    }
+    lm->compute_descriptor();
+    lm->update_mean_normal_and_obs_scale_variance();
+    map_db_->add_landmark(lm);
+    lms_.at(i) = lm;
+  }
+
+  // 4. build the covisibility graph
+  for (const auto& keyfrm : keyfrms_) {
+    keyfrm->graph_node_->update_connections();
+  }
+}
+
+synthetic_scene::~synthetic_scene() {
+  // release the map before the camera and the ORB parameters
+  keyfrms_.clear();
+  lms_.clear();
+  map_db_.reset();
+}
+
+Mat44_t synthetic_scene::get_cam_pose(const double x) const {
+  // the camera looks at +z, and the position is (x, 0, 0)
+  Mat44_t cam_pose_cw = Mat44_t::Identity();
+  cam_pose_cw(0, 3) = -x;
+  return cam_pose_cw;
+}
+
+data::frame synthetic_scene::create_frame(
+    const Mat44_t& cam_pose_cw, std::vector<unsigned int>& lm_indices) {
+  const Mat33_t rot_cw = cam_pose_cw.block<3, 3>(0, 0);
+  const Vec3_t trans_cw = cam_pose_cw.block<3, 1>(0, 3);
+
+  std::normal_distribution<> rand_noise(0.0, noise_stddev_);
+  std::uniform_int_distribution<int> rand_bit(0, 255);
+
+  data::frame_observation frm_obs;
+  lm_indices.clear();
+  for (unsigned int i = 0; i < lm_positions_.size(); ++i) {
+    const Vec3_t pos_c = rot_cw * lm_positions_.at(i) + trans_cw;
+    if (pos_c(2) <= 0.0) {
+      continue;
+    }
+    Vec2_t reproj;
+    float x_right;
+    camera_->reproject_to_image(rot_cw, trans_cw, lm_positions_.at(i), reproj,
+                                x_right);
+    if (0.0 < noise_stddev_) {
+      reproj += Vec2_t{rand_noise(mt_), rand_noise(mt_)};
+    }
+    if (reproj(0) < camera_->img_bounds_.min_x_ ||
+        camera_->img_bounds_.max_x_ <= reproj(0) ||
+        reproj(1) < camera_->img_bounds_.min_y_ ||
+        camera_->img_bounds_.max_y_ <= reproj(1)) {
+      continue;
+    }
+
+    frm_obs.keypts_.emplace_back(cv::Point2f(reproj(0), reproj(1)), 31.0,
+                                 lm_angles_.at(i), 1.0, 0);
+    lm_indices.push_back(i);
+
+    // flip a few bits of the ground-truth descriptor
+    cv::Mat desc = lm_descriptors_.row(i).clone();
+    desc.at<uchar>(0, rand_bit(mt_) % 32) ^= 1 << (rand_bit(mt_) % 8);
+    desc.at<uchar>(0, rand_bit(mt_) % 32) ^= 1 << (rand_bit(mt_) % 8);
+    frm_obs.descriptors_.push_back(desc);
+  }
+  frm_obs.num_keypts_ = frm_obs.keypts_.size();
+
+  // the camera has no distortion
+  frm_obs.undist_keypts_ = frm_obs.keypts_;
+  frm_obs.stereo_x_right_ = std::vector<float>(frm_obs.num_keypts_, -1);
+  frm_obs.depths_ = std::vector<float>(frm_obs.num_keypts_, -1);
+  camera_->convert_keypoints_to_bearings(frm_obs.undist_keypts_,
+                                         frm_obs.bearings_);
+  data::assign_keypoints_to_grid(camera_.get(), frm_obs.undist_keypts_,
+                                 frm_obs.keypt_indices_in_cells_);
+
+  data::frame frm(map_db_->next_frame_id_++, 0.0, camera_.get(),
+                  orb_params_.get(), frm_obs);
+  frm.set_cam_pose(cam_pose_cw);
+
+  // use the landmark index as the visual word (64 words in total)
+  for (unsigned int idx = 0; idx < lm_indices.size(); ++idx) {
+    const auto word_id = lm_indices.at(idx) % 64;
+    frm.bow_vec_[word_id] += 1.0;
+    frm.bow_feat_vec_[word_id].push_back(idx);
+  }
+
+  return frm;
+}
+
+void synthetic_scene::erase_observations(
+    const std::shared_ptr<data::keyframe>& keyfrm,
+    const unsigned int num_obs) {
+  unsigned int num_erased = 0;
+  for (const auto& lm : keyfrm->get_landmarks()) {
+    if (lm && num_erased < num_obs) {
+      keyfrm->erase_landmark(lm);
+      lm->erase_observation(map_db_.get(), keyfrm);
+      ++num_erased;
+    }
+  }
+}
+
+bool synthetic_scene::erase_and_replace_landmarks(
+    const unsigned int num_erased, const unsigned int num_replaced) {
+  std::vector<std::shared_ptr<data::landmark>> lms;
+  for (const auto& lm : lms_) {
+    if (lm && !lm->will_be_erased()) {
+      lms.push_back(lm);
+    }
+  }
+  // each of the replaced landmarks is replaced with a landmark after them
+  const unsigned int num_changed = num_erased + num_replaced;
+  if (lms.size() <= 2 * num_changed) {
+    return false;
+  }
+  for (unsigned int i = 0; i < num_erased; ++i) {
+    lms.at(i)->prepare_for_erasing(map_db_.get());
+  }
+  for (unsigned int i = num_erased; i < num_changed; ++i) {
+    lms.at(i)->replace(lms.at(i + num_changed));
+  }
+  return true;
+}
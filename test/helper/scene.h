@@ -0,0 +1,106 @@
+#ifndef OPENVSLAM_TEST_HELPER_SCENE_H
+#define OPENVSLAM_TEST_HELPER_SCENE_H
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "openvslam/camera/perspective.h"
+#include "openvslam/data/frame.h"
+#include "openvslam/data/keyframe.h"
+#include "openvslam/data/landmark.h"
+#include "openvslam/data/map_database.h"
+#include "openvslam/feature/orb_params.h"
+#include "openvslam/type.h"
+
+using namespace openvslam;
+
+/**
+ * Synthetic map observed by a perspective camera which moves along the x-axis
+ * (every random number is generated from a fixed seed, so the scene is
+ * reproducible)
+ */
+class synthetic_scene {
+ public:
+  /**
+   * Constructor
+   * @param num_keyfrms number of keyframes on the trajectory
+   * @param num_landmarks number of landmarks in the space
+   * @param noise_stddev standard deviation of the keypoint noise [px]
+   * @param seed
+   */
+  synthetic_scene(const unsigned int num_keyfrms,
+                  const unsigned int num_landmarks,
+                  const double noise_stddev = 0.5,
+                  const unsigned int seed = 0);
+
+  /**
+   * Destructor
+   */
+  ~synthetic_scene();
+
+  /**
+   * Get the camera pose at the specified position on the trajectory
+   * @param x
+   * @return
+   */
+  Mat44_t get_cam_pose(const double x) const;
+
+  /**
+   * Create a frame which observes the landmarks from the specified pose
+   * (the landmark associations are not set to the frame)
+   * @param cam_pose_cw
+   * @param lm_indices indices of the observed landmarks of each keypoint
+   * @return
+   */
+  data::frame create_frame(const Mat44_t& cam_pose_cw,
+                           std::vector<unsigned int>& lm_indices);
+
+  /**
+   * Erase the first observations of the keyframe
+   * (the landmarks which lose too many observations are erased)
+   * @param keyfrm
+   * @param num_obs number of the observations to be erased
+   */
+  void erase_observations(const std::shared_ptr<data::keyframe>& keyfrm,
+                          const unsigned int num_obs);
+
+  /**
+   * Erase the first valid landmarks, then replace the next ones with the
+   * landmarks after them
+   * @param num_erased number of the landmarks to be erased
+   * @param num_replaced number of the landmarks to be replaced
+   * @return false if the scene does not have enough valid landmarks
+   */
+  bool erase_and_replace_landmarks(const unsigned int num_erased,
+                                   const unsigned int num_replaced);
+
+  //! camera model
+  std::unique_ptr<camera::perspective> camera_;
+  //! ORB parameters
+  std::unique_ptr<feature::orb_params> orb_params_;
+  //! map database which contains the keyframes and the landmarks
+  std::unique_ptr<data::map_database> map_db_;
+
+  //! keyframes (sorted by the position on the trajectory)
+  std::vector<std::shared_ptr<data::keyframe>> keyfrms_;
+  //! landmarks (nullptr if the landmark is observed by less than two
+  //! keyframes)
+  std::vector<std::shared_ptr<data::landmark>> lms_;
+
+  //! ground-truth positions of the landmarks
+  eigen_alloc_vector<Vec3_t> lm_positions_;
+  //! ground-truth descriptors of the landmarks
+  cv::Mat lm_descriptors_;
+  //! ground-truth keypoint orientations of the landmarks
+  std::vector<float> lm_angles_;
+
+  //! positions of the keyframes on the trajectory
+  std::vector<double> keyfrm_xs_;
+
+ private:
+  const double noise_stddev_;
+  std::mt19937 mt_;
+};
+
+#endif  // OPENVSLAM_TEST_HELPER_SCENE_H
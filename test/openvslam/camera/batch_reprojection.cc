@@ -0,0 +1,120 @@
+#include "openvslam/camera/equirectangular.h"
+#include "openvslam/camera/fisheye.h"
+#include "openvslam/camera/perspective.h"
+#include "openvslam/camera/radial_division.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+
+using namespace openvslam;
+
+namespace {
+
+eigen_alloc_vector<Vec3_t> create_points(const unsigned int num_pts) {
+  std::mt19937 mt(0);
+  std::uniform_real_distribution<> rand(-10.0, 10.0);
+  eigen_alloc_vector<Vec3_t> pos_ws(num_pts);
+  for (auto& pos_w : pos_ws) {
+    pos_w = Vec3_t{rand(mt), rand(mt), rand(mt)};
+  }
+  return pos_ws;
+}
+
+void check_batch_reprojection(const camera::base& camera) {
+  const auto pos_ws = create_points(1000);
+  const Mat33_t rot_cw =
+      Eigen::AngleAxisd(0.3, Vec3_t{0.1, 1.0, 0.2}.normalized())
+          .toRotationMatrix();
+  const Vec3_t trans_cw{0.5, -0.2, 3.0};
+
+  eigen_alloc_vector<Vec2_t> reprojs;
+  std::vector<float> x_rights;
+  std::vector<unsigned char> in_image;
+  camera.reproject_points_to_image(rot_cw, trans_cw, pos_ws, reprojs, x_rights,
+                                   in_image);
+  ASSERT_EQ(reprojs.size(), pos_ws.size());
+  ASSERT_EQ(x_rights.size(), pos_ws.size());
+  ASSERT_EQ(in_image.size(), pos_ws.size());
+
+  eigen_alloc_vector<Vec3_t> bearings;
+  std::vector<unsigned char> bearing_is_valid;
+  camera.reproject_points_to_bearings(rot_cw, trans_cw, pos_ws, bearings,
+                                      bearing_is_valid);
+  ASSERT_EQ(bearings.size(), pos_ws.size());
+  ASSERT_EQ(bearing_is_valid.size(), pos_ws.size());
+
+  unsigned int num_valid = 0;
+  for (unsigned int i = 0; i < pos_ws.size(); ++i) {
+    Vec2_t reproj;
+    float x_right;
+    const bool is_valid = camera.reproject_to_image(rot_cw, trans_cw,
+                                                    pos_ws.at(i), reproj,
+                                                    x_right);
+    EXPECT_EQ(static_cast<bool>(in_image.at(i)), is_valid);
+    if (is_valid) {
+      EXPECT_LT((reprojs.at(i) - reproj).norm(), 1e-6);
+      EXPECT_NEAR(x_rights.at(i), x_right, 1e-3);
+      ++num_valid;
+    }
+
+    Vec3_t bearing;
+    const bool bearing_valid =
+        camera.reproject_to_bearing(rot_cw, trans_cw, pos_ws.at(i), bearing);
+    EXPECT_EQ(static_cast<bool>(bearing_is_valid.at(i)), bearing_valid);
+    if (bearing_valid) {
+      EXPECT_LT((bearings.at(i) - bearing).norm(), 1e-9);
+    }
+  }
+  EXPECT_GT(num_valid, 0);
+}
+
+}  // unnamed namespace
+
+TEST(batch_reprojection, perspective) {
+  const camera::perspective camera(
+      "perspective", camera::setup_type_t::Stereo, camera::color_order_t::Gray,
+      640, 480, 30.0, 500.0, 500.0, 320.0, 240.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+      50.0, 40.0);
+  check_batch_reprojection(camera);
+}
+
+TEST(batch_reprojection, fisheye) {
+  const camera::fisheye camera("fisheye", camera::setup_type_t::Monocular,
+                               camera::color_order_t::Gray, 640, 480, 30.0,
+                               300.0, 300.0, 320.0, 240.0, 0.0, 0.0, 0.0, 0.0);
+  check_batch_reprojection(camera);
+}
+
+TEST(batch_reprojection, equirectangular) {
+  const camera::equirectangular camera(
+      "equirectangular", camera::color_order_t::RGB, 1920, 960, 30.0);
+  check_batch_reprojection(camera);
+}
+
+TEST(batch_reprojection, radial_division) {
+  const camera::radial_division camera(
+      "radial_division", camera::setup_type_t::Monocular,
+      camera::color_order_t::Gray, 640, 480, 30.0, 500.0, 500.0, 320.0, 240.0,
+      -1e-7);
+  check_batch_reprojection(camera);
+}
+
+TEST(batch_reprojection, convert_keypoints_to_bearings) {
+  const camera::perspective camera(
+      "perspective", camera::setup_type_t::Monocular,
+      camera::color_order_t::Gray, 640, 480, 30.0, 500.0, 500.0, 320.0, 240.0,
+      0.0, 0.0, 0.0, 0.0, 0.0);
+  std::vector<cv::KeyPoint> keypts;
+  for (unsigned int i = 0; i < 100; ++i) {
+    keypts.emplace_back(cv::Point2f(6.0 * i, 4.5 * i), 31.0);
+  }
+
+  eigen_alloc_vector<Vec3_t> bearings;
+  camera.convert_keypoints_to_bearings(keypts, bearings);
+  ASSERT_EQ(bearings.size(), keypts.size());
+  for (unsigned int i = 0; i < keypts.size(); ++i) {
+    EXPECT_EQ(bearings.at(i), camera.convert_point_to_bearing(keypts.at(i).pt));
+  }
+}
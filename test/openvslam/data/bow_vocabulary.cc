@@ -62,31 +62,18 @@ TEST(bow_vocabulary, match_near_scene) {
     return;
   }
 
-#ifdef USE_DBOW2
-  auto bow_vocab = new data::bow_vocabulary();
-  try {
-    bow_vocab->loadFromBinaryFile(vocab_file_path);
-  } catch (const std::exception&) {
-    std::cerr << "wrong path to vocabulary" << std::endl;
-    delete bow_vocab;
-    bow_vocab = nullptr;
-    exit(EXIT_FAILURE);
-  }
-#else
-  auto bow_vocab = new fbow::Vocabulary();
-  bow_vocab->readFromFile(vocab_file_path);
-  if (!bow_vocab->isValid()) {
-    std::cerr << "wrong path to vocabulary" << std::endl;
-    delete bow_vocab;
-    bow_vocab = nullptr;
-    exit(EXIT_FAILURE);
-  }
-#endif
+  const auto bow_vocab =
+      data::bow_vocabulary_util::load_vocabulary(vocab_file_path);
+  ASSERT_TRUE(bow_vocab);
 
   auto score = get_score(
-      bow_vocab, std::string(TEST_DATA_DIR) + "./equirectangular_image_001.jpg",
+      bow_vocab.get(),
+      std::string(TEST_DATA_DIR) + "./equirectangular_image_001.jpg",
       std::string(TEST_DATA_DIR) + "./equirectangular_image_002.jpg");
   EXPECT_LT(score, 1.0);
+}
 
-  delete bow_vocab;
+TEST(bow_vocabulary, load_wrong_path) {
+  EXPECT_FALSE(data::bow_vocabulary_util::load_vocabulary(
+      std::string(TEST_DATA_DIR) + "./no_such_vocabulary.fbow"));
 }
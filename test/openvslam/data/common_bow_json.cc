@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <nlohmann/json.hpp>
+
+#include "openvslam/data/bow_vocabulary.h"
+#include "openvslam/data/common.h"
+
+#ifdef USE_DBOW2
+#include <DBoW2/BowVector.h>
+#include <DBoW2/FeatureVector.h>
+#else
+#include <fbow/bow_feat_vector.h>
+#include <fbow/bow_vector.h>
+#endif
+
+using namespace openvslam;
+
+namespace {
+
+void create_bow(data::bow_vector& bow_vec,
+                data::bow_feature_vector& bow_feat_vec) {
+  bow_vec.clear();
+  bow_feat_vec.clear();
+  for (unsigned int word = 0; word < 100; ++word) {
+    // weights which are not exactly representable in decimal
+    float weight = 1.0f / (3.0f + word);
+    bow_vec[7 * word + 1] = weight;
+  }
+  for (unsigned int node = 0; node < 20; ++node) {
+    auto& idxs = bow_feat_vec[11 * node];
+    for (unsigned int idx = node; idx < 50; idx += 3) {
+      idxs.push_back(idx);
+    }
+  }
+}
+
+}  // unnamed namespace
+
+TEST(common, bow_json_roundtrip) {
+  data::bow_vector bow_vec;
+  data::bow_feature_vector bow_feat_vec;
+  create_bow(bow_vec, bow_feat_vec);
+
+  // the weights are not changed through MessagePack
+  const auto json_bow = data::convert_bow_to_json(bow_vec, bow_feat_vec);
+  const auto msgpack = nlohmann::json::to_msgpack(json_bow);
+  const auto decoded_json_bow = nlohmann::json::from_msgpack(msgpack);
+
+  data::bow_vector decoded_bow_vec;
+  data::bow_feature_vector decoded_bow_feat_vec;
+  data::convert_json_to_bow(decoded_json_bow, decoded_bow_vec,
+                            decoded_bow_feat_vec);
+  EXPECT_EQ(decoded_bow_vec.size(), bow_vec.size());
+  EXPECT_EQ(decoded_bow_feat_vec.size(), bow_feat_vec.size());
+  EXPECT_TRUE(data::bow_is_equal(bow_vec, bow_feat_vec, decoded_bow_vec,
+                                 decoded_bow_feat_vec));
+}
+
+TEST(common, bow_is_equal) {
+  data::bow_vector bow_vec_1, bow_vec_2;
+  data::bow_feature_vector bow_feat_vec_1, bow_feat_vec_2;
+  create_bow(bow_vec_1, bow_feat_vec_1);
+  create_bow(bow_vec_2, bow_feat_vec_2);
+  EXPECT_TRUE(
+      data::bow_is_equal(bow_vec_1, bow_feat_vec_1, bow_vec_2, bow_feat_vec_2));
+
+  // different weight
+  float weight = 0.5f;
+  bow_vec_2[1] = weight;
+  EXPECT_FALSE(
+      data::bow_is_equal(bow_vec_1, bow_feat_vec_1, bow_vec_2, bow_feat_vec_2));
+
+  // different feature indices
+  create_bow(bow_vec_2, bow_feat_vec_2);
+  bow_feat_vec_2[0].push_back(100);
+  EXPECT_FALSE(
+      data::bow_is_equal(bow_vec_1, bow_feat_vec_1, bow_vec_2, bow_feat_vec_2));
+}
@@ -0,0 +1,94 @@
+#include "openvslam/data/graph_node.h"
+
+#include <gtest/gtest.h>
+
+#include "helper/scene.h"
+
+using namespace openvslam;
+
+namespace {
+
+// count the landmarks shared between the two keyframes from scratch
+unsigned int count_shared_landmarks(
+    const std::shared_ptr<data::keyframe>& keyfrm_1,
+    const std::shared_ptr<data::keyframe>& keyfrm_2) {
+  unsigned int num_shared_lms = 0;
+  for (const auto& lm : keyfrm_1->get_landmarks()) {
+    if (!lm || lm->will_be_erased()) {
+      continue;
+    }
+    if (lm->is_observed_in_keyframe(keyfrm_2)) {
+      ++num_shared_lms;
+    }
+  }
+  return num_shared_lms;
+}
+
+void check_shared_landmarks(const synthetic_scene& scene) {
+  for (const auto& keyfrm_1 : scene.keyfrms_) {
+    for (const auto& keyfrm_2 : scene.keyfrms_) {
+      if (keyfrm_1 == keyfrm_2) {
+        continue;
+      }
+      EXPECT_EQ(keyfrm_1->graph_node_->get_num_shared_landmarks(keyfrm_2),
+                count_shared_landmarks(keyfrm_1, keyfrm_2));
+    }
+  }
+}
+
+void check_covisibility_orders(const std::shared_ptr<data::keyframe>& keyfrm) {
+  const auto covisibilities = keyfrm->graph_node_->get_covisibilities();
+  for (unsigned int i = 1; i < covisibilities.size(); ++i) {
+    EXPECT_GE(keyfrm->graph_node_->get_weight(covisibilities.at(i - 1)),
+              keyfrm->graph_node_->get_weight(covisibilities.at(i)));
+  }
+}
+
+}  // unnamed namespace
+
+TEST(graph_node, incremental_shared_landmarks) {
+  synthetic_scene scene(10, 2000);
+  check_shared_landmarks(scene);
+
+  // erase a part of the observations
+  scene.erase_observations(scene.keyfrms_.at(4), 100);
+  check_shared_landmarks(scene);
+
+  // erase and replace a part of the landmarks
+  ASSERT_TRUE(scene.erase_and_replace_landmarks(50, 50));
+  check_shared_landmarks(scene);
+}
+
+TEST(graph_node, update_connections) {
+  synthetic_scene scene(10, 2000);
+
+  for (const auto& keyfrm : scene.keyfrms_) {
+    // the weights are the numbers of the shared landmarks
+    const auto covisibilities = keyfrm->graph_node_->get_covisibilities();
+    ASSERT_FALSE(covisibilities.empty());
+    for (const auto& covisibility : covisibilities) {
+      EXPECT_EQ(keyfrm->graph_node_->get_weight(covisibility),
+                count_shared_landmarks(keyfrm, covisibility));
+    }
+    check_covisibility_orders(keyfrm);
+
+    // the parent of the spanning tree is the nearest covisibility
+    if (keyfrm->id_ != 0) {
+      EXPECT_EQ(keyfrm->graph_node_->get_spanning_parent(),
+                covisibilities.front());
+    }
+  }
+
+  // the weights are updated after the observations are erased
+  const auto& keyfrm = scene.keyfrms_.at(4);
+  scene.erase_observations(keyfrm, 100);
+  keyfrm->graph_node_->update_connections();
+  for (const auto& covisibility : keyfrm->graph_node_->get_covisibilities()) {
+    const auto weight = count_shared_landmarks(keyfrm, covisibility);
+    EXPECT_EQ(keyfrm->graph_node_->get_weight(covisibility), weight);
+    EXPECT_EQ(covisibility->graph_node_->get_weight(keyfrm), weight);
+    // the covisibilities of the neighbor are sorted again lazily
+    check_covisibility_orders(covisibility);
+  }
+  check_covisibility_orders(keyfrm);
+}
@@ -0,0 +1,144 @@
+#include "openvslam/data/keyframe_observation.h"
+
+#include <gtest/gtest.h>
+
+#include "helper/scene.h"
+#include "openvslam/data/common.h"
+#include "openvslam/match/projection.h"
+
+using namespace openvslam;
+
+namespace {
+
+data::frame create_frame_with_levels(synthetic_scene& scene,
+                                     std::vector<unsigned int>& lm_indices) {
+  const auto src_frm = scene.create_frame(scene.get_cam_pose(0.5), lm_indices);
+
+  // spread the keypoints over the scale levels
+  auto frm_obs = src_frm.frm_obs_;
+  for (unsigned int idx = 0; idx < frm_obs.num_keypts_; ++idx) {
+    frm_obs.keypts_.at(idx).octave = idx % scene.orb_params_->num_levels_;
+    frm_obs.undist_keypts_.at(idx).octave = frm_obs.keypts_.at(idx).octave;
+  }
+
+  data::frame frm(scene.map_db_->next_frame_id_++, 0.0, scene.camera_.get(),
+                  scene.orb_params_.get(), frm_obs);
+  frm.set_cam_pose(src_frm.get_cam_pose());
+  return frm;
+}
+
+}  // unnamed namespace
+
+TEST(keyframe_observation, same_as_frame_observation) {
+  synthetic_scene scene(3, 2000);
+  std::vector<unsigned int> lm_indices;
+  const auto frm = create_frame_with_levels(scene, lm_indices);
+  const auto keyfrm = data::keyframe::make_keyframe(
+      scene.map_db_->next_keyframe_id_++, frm, scene.map_db_.get());
+
+  const auto& frm_obs = frm.frm_obs_;
+  const auto& keyfrm_obs = keyfrm->frm_obs_;
+  ASSERT_EQ(keyfrm_obs.num_keypts_, frm_obs.num_keypts_);
+  ASSERT_EQ(keyfrm_obs.keypts_.size(), frm_obs.keypts_.size());
+  ASSERT_EQ(keyfrm_obs.undist_keypts_.size(), frm_obs.undist_keypts_.size());
+  for (unsigned int idx = 0; idx < frm_obs.num_keypts_; ++idx) {
+    const auto keypt = keyfrm_obs.keypts_.at(idx);
+    EXPECT_EQ(keypt.pt, frm_obs.keypts_.at(idx).pt);
+    EXPECT_EQ(keypt.angle, frm_obs.keypts_.at(idx).angle);
+    EXPECT_EQ(keypt.octave, frm_obs.keypts_.at(idx).octave);
+
+    const auto undist_keypt = keyfrm_obs.undist_keypts_.at(idx);
+    EXPECT_EQ(undist_keypt.pt, frm_obs.undist_keypts_.at(idx).pt);
+    EXPECT_EQ(undist_keypt.angle, frm_obs.undist_keypts_.at(idx).angle);
+    EXPECT_EQ(undist_keypt.octave, frm_obs.undist_keypts_.at(idx).octave);
+
+    // the bearings are computed on demand with the same result
+    EXPECT_EQ(keyfrm->get_bearing(idx), frm_obs.bearings_.at(idx));
+  }
+  EXPECT_EQ(keyfrm->get_bearings(), frm_obs.bearings_);
+  EXPECT_EQ(cv::norm(keyfrm_obs.descriptors_, frm_obs.descriptors_,
+                     cv::NORM_HAMMING),
+            0);
+  EXPECT_EQ(keyfrm_obs.stereo_x_right_, frm_obs.stereo_x_right_);
+  EXPECT_EQ(keyfrm_obs.depths_, frm_obs.depths_);
+}
+
+TEST(keyframe_observation, same_keypoints_in_cell) {
+  synthetic_scene scene(3, 2000);
+  std::vector<unsigned int> lm_indices;
+  const auto frm = create_frame_with_levels(scene, lm_indices);
+  const auto keyfrm = data::keyframe::make_keyframe(
+      scene.map_db_->next_keyframe_id_++, frm, scene.map_db_.get());
+
+  // the candidates of the projection matching are the same including the order
+  const auto& camera = scene.camera_;
+  for (float ref_y = camera->img_bounds_.min_y_ - 20.0;
+       ref_y < camera->img_bounds_.max_y_ + 20.0; ref_y += 13.0) {
+    for (float ref_x = camera->img_bounds_.min_x_ - 20.0;
+         ref_x < camera->img_bounds_.max_x_ + 20.0; ref_x += 13.0) {
+      for (const float margin : {5.0f, 15.0f, 60.0f}) {
+        EXPECT_EQ(keyfrm->get_keypoints_in_cell(ref_x, ref_y, margin),
+                  frm.get_keypoints_in_cell(ref_x, ref_y, margin));
+        EXPECT_EQ(data::get_keypoints_in_cell(
+                      camera.get(), keyfrm->frm_obs_.undist_keypts_,
+                      keyfrm->frm_obs_.keypt_indices_in_cells_, ref_x, ref_y,
+                      margin, 2, 5),
+                  frm.get_keypoints_in_cell(ref_x, ref_y, margin, 2, 5));
+      }
+    }
+  }
+}
+
+TEST(keyframe_observation, projection_matching) {
+  synthetic_scene scene(5, 2000, 0.0);
+  const auto& keyfrm = scene.keyfrms_.at(2);
+
+  // project all of the landmarks to the keyframe with its own pose
+  std::vector<std::shared_ptr<data::landmark>> lms;
+  for (const auto& lm : scene.lms_) {
+    if (lm) {
+      lms.push_back(lm);
+    }
+  }
+  std::vector<std::shared_ptr<data::landmark>> matched_lms(
+      keyfrm->frm_obs_.num_keypts_, nullptr);
+  match::projection matcher(0.9, true);
+  const auto num_matches = matcher.match_by_Sim3_transform(
+      keyfrm, keyfrm->get_cam_pose(), lms, matched_lms, 5.0);
+  ASSERT_GT(num_matches, 0);
+
+  // the landmarks are matched to the keypoints which observe them
+  const auto keyfrm_lms = keyfrm->get_landmarks();
+  unsigned int num_correct_matches = 0;
+  for (unsigned int idx = 0; idx < matched_lms.size(); ++idx) {
+    if (matched_lms.at(idx) && matched_lms.at(idx) == keyfrm_lms.at(idx)) {
+      ++num_correct_matches;
+    }
+  }
+  EXPECT_GT(num_correct_matches, 0.9 * num_matches);
+}
+
+TEST(keyframe_observation, memory_footprint) {
+  synthetic_scene scene(3, 2000);
+  std::vector<unsigned int> lm_indices;
+  const auto frm = create_frame_with_levels(scene, lm_indices);
+  const data::keyframe_observation keyfrm_obs(frm.frm_obs_);
+
+  const auto num_keypts = frm.frm_obs_.num_keypts_;
+  ASSERT_GT(num_keypts, 0);
+  const auto num_cells =
+      scene.camera_->num_grid_cols_ * scene.camera_->num_grid_rows_;
+
+  // the footprint of the same fields in frame_observation
+  const auto full_footprint =
+      2 * num_keypts * sizeof(cv::KeyPoint) + num_keypts * sizeof(Vec3_t) +
+      32 * num_keypts + 2 * num_keypts * sizeof(float) +
+      num_cells * sizeof(std::vector<unsigned int>) +
+      num_keypts * sizeof(unsigned int);
+
+  // the keypoints are packed into 13 bytes, the bearings are not stored, and
+  // the cells share one array
+  const auto footprint = keyfrm_obs.get_memory_footprint();
+  EXPECT_GE(footprint, (2 * 13 + 32) * num_keypts);
+  EXPECT_LT(footprint, full_footprint / 2);
+}
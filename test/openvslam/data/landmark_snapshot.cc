@@ -0,0 +1,75 @@
+#include "openvslam/data/landmark_snapshot.h"
+
+#include <gtest/gtest.h>
+
+#include "helper/scene.h"
+
+using namespace openvslam;
+
+TEST(landmark_snapshot, cull_is_equivalent_to_can_observe) {
+  synthetic_scene scene(10, 2000);
+
+  std::vector<std::shared_ptr<data::landmark>> lms;
+  for (const auto& lm : scene.lms_) {
+    if (lm) {
+      lms.push_back(lm);
+    }
+  }
+  data::landmark_snapshot snapshot;
+  snapshot.build(lms);
+  EXPECT_EQ(snapshot.size(), lms.size());
+
+  // exclude a part of the landmarks
+  std::unordered_set<unsigned int> excluded_ids;
+  for (unsigned int i = 0; i < lms.size(); i += 7) {
+    excluded_ids.insert(lms.at(i)->id_);
+  }
+
+  std::vector<unsigned int> lm_indices;
+  const auto frm = scene.create_frame(
+      scene.get_cam_pose(scene.keyfrm_xs_.back() + 0.3), lm_indices);
+  const auto num_visible = snapshot.cull(frm, 0.5, excluded_ids);
+  EXPECT_GT(num_visible, 0);
+  ASSERT_EQ(snapshot.reprojs_.size(), num_visible);
+  ASSERT_EQ(snapshot.x_rights_.size(), num_visible);
+  ASSERT_EQ(snapshot.pred_scale_levels_.size(), num_visible);
+
+  unsigned int num_visible_gt = 0;
+  Vec2_t reproj;
+  float x_right;
+  unsigned int pred_scale_level;
+  for (unsigned int i = 0; i < lms.size(); ++i) {
+    const auto& lm = lms.at(i);
+    if (excluded_ids.count(lm->id_)) {
+      continue;
+    }
+    if (!frm.can_observe(lm, 0.5, reproj, x_right, pred_scale_level)) {
+      continue;
+    }
+    ASSERT_LT(num_visible_gt, num_visible);
+    EXPECT_EQ(snapshot.visible_indices_.at(num_visible_gt), i);
+    EXPECT_LT((snapshot.reprojs_.at(num_visible_gt) - reproj).norm(), 1e-6);
+    EXPECT_NEAR(snapshot.x_rights_.at(num_visible_gt), x_right, 1e-3);
+    EXPECT_EQ(snapshot.pred_scale_levels_.at(num_visible_gt), pred_scale_level);
+    ++num_visible_gt;
+  }
+  EXPECT_EQ(num_visible, num_visible_gt);
+}
+
+TEST(landmark_snapshot, erased_landmarks_are_excluded) {
+  synthetic_scene scene(5, 500);
+
+  std::vector<std::shared_ptr<data::landmark>> lms;
+  for (const auto& lm : scene.lms_) {
+    if (lm) {
+      lms.push_back(lm);
+    }
+  }
+  ASSERT_GT(lms.size(), 1);
+  lms.front()->prepare_for_erasing(scene.map_db_.get());
+
+  data::landmark_snapshot snapshot;
+  snapshot.build(lms);
+  EXPECT_EQ(snapshot.size(), lms.size() - 1);
+  EXPECT_NE(snapshot.ids_.front(), lms.front()->id_);
+}
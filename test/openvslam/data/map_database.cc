@@ -0,0 +1,32 @@
+#include "openvslam/data/map_database.h"
+
+#include <gtest/gtest.h>
+
+#include "helper/scene.h"
+
+using namespace openvslam;
+
+TEST(map_database, independent_id_counters) {
+  // the IDs are issued per map database
+  synthetic_scene scene_1(5, 500);
+  synthetic_scene scene_2(8, 800);
+  for (const auto scene : {&scene_1, &scene_2}) {
+    for (unsigned int i = 0; i < scene->keyfrms_.size(); ++i) {
+      EXPECT_EQ(scene->keyfrms_.at(i)->id_, i);
+    }
+    unsigned int num_lms = 0;
+    for (const auto& lm : scene->lms_) {
+      if (lm) {
+        EXPECT_EQ(lm->id_, num_lms++);
+      }
+    }
+    EXPECT_EQ(scene->map_db_->next_keyframe_id_, scene->keyfrms_.size());
+    EXPECT_EQ(scene->map_db_->next_landmark_id_, num_lms);
+  }
+
+  // the databases are locked independently
+  std::lock_guard<std::mutex> lock_1(scene_1.map_db_->mtx_database_);
+  std::unique_lock<std::mutex> lock_2(scene_2.map_db_->mtx_database_,
+                                      std::try_to_lock);
+  EXPECT_TRUE(lock_2.owns_lock());
+}
@@ -0,0 +1,183 @@
+#include "openvslam/data/speculative_bow.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace openvslam;
+
+namespace {
+
+// function which records the order of the computations
+// (the computation of the first descriptors is blocked until it is released)
+class recorder {
+ public:
+  data::speculative_bow::compute_bow_t get_function() {
+    return [this](const cv::Mat& descriptors, data::bow_vector&,
+                  data::bow_feature_vector&) {
+      const int id = descriptors.at<uchar>(0, 0);
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        started_ids_.push_back(id);
+      }
+      while (id == blocked_id_ && !is_released_) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+      std::lock_guard<std::mutex> lock(mtx_);
+      finished_ids_.push_back(id);
+    };
+  }
+
+  // block until the computation of the ID is started
+  void wait_until_started(const int id) const {
+    while (true) {
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (const auto started_id : started_ids_) {
+          if (started_id == id) {
+            return;
+          }
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+  std::vector<int> get_finished_ids() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return finished_ids_;
+  }
+
+  unsigned int num_started() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return started_ids_.size();
+  }
+
+  const int blocked_id_ = 0;
+  std::atomic<bool> is_released_{false};
+
+ private:
+  mutable std::mutex mtx_;
+  std::vector<int> started_ids_;
+  std::vector<int> finished_ids_;
+};
+
+// descriptors whose first byte is the ID
+cv::Mat create_descriptors(const int id) {
+  cv::Mat descriptors(1, 32, CV_8U, cv::Scalar(0));
+  descriptors.at<uchar>(0, 0) = static_cast<uchar>(id);
+  return descriptors;
+}
+
+// block until the worker finishes the number of the computations
+void wait_until_finished(const recorder& rec, const unsigned int num_finished) {
+  while (rec.get_finished_ids().size() < num_finished) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+}  // unnamed namespace
+
+TEST(speculative_bow, newest_first_and_eviction) {
+  recorder rec;
+  data::speculative_bow_worker worker(rec.get_function(), 3);
+
+  // occupy the worker until the requests are queued
+  const auto blocked = worker.request(create_descriptors(0));
+  rec.wait_until_started(0);
+  std::vector<std::shared_ptr<data::speculative_bow>> requests;
+  for (int id = 1; id <= 5; ++id) {
+    requests.push_back(worker.request(create_descriptors(id)));
+  }
+  rec.is_released_ = true;
+
+  // the oldest requests are evicted, and the rest are computed from the newest
+  wait_until_finished(rec, 4);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(rec.get_finished_ids(), (std::vector<int>{0, 5, 4, 3}));
+  EXPECT_TRUE(blocked->is_ready());
+  EXPECT_FALSE(requests.at(0)->is_ready());
+  EXPECT_FALSE(requests.at(1)->is_ready());
+  EXPECT_TRUE(requests.at(2)->is_ready());
+
+  // the evicted request is computed on demand
+  data::bow_vector bow_vec;
+  data::bow_feature_vector bow_feat_vec;
+  requests.at(0)->get(rec.get_function(), bow_vec, bow_feat_vec);
+  EXPECT_TRUE(requests.at(0)->is_ready());
+  EXPECT_EQ(rec.get_finished_ids(), (std::vector<int>{0, 5, 4, 3, 1}));
+}
+
+TEST(speculative_bow, skip_dropped_frames) {
+  recorder rec;
+  data::speculative_bow_worker worker(rec.get_function());
+
+  const auto blocked = worker.request(create_descriptors(0));
+  rec.wait_until_started(0);
+  const auto kept = worker.request(create_descriptors(1));
+  // the frame is dropped before the worker starts it
+  auto dropped = worker.request(create_descriptors(2));
+  dropped.reset();
+  rec.is_released_ = true;
+
+  wait_until_finished(rec, 2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(rec.get_finished_ids(), (std::vector<int>{0, 1}));
+  EXPECT_TRUE(kept->is_ready());
+}
+
+TEST(speculative_bow, get_while_computing) {
+  recorder rec;
+  data::speculative_bow_worker worker(rec.get_function());
+
+  // get() waits for the computation by the worker instead of computing again
+  const auto request = worker.request(create_descriptors(0));
+  rec.wait_until_started(0);
+  std::atomic<bool> get_is_returned(false);
+  std::thread getter([&] {
+    data::bow_vector bow_vec;
+    data::bow_feature_vector bow_feat_vec;
+    request->get(rec.get_function(), bow_vec, bow_feat_vec);
+    get_is_returned = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_FALSE(get_is_returned);
+  rec.is_released_ = true;
+  getter.join();
+
+  EXPECT_TRUE(request->is_ready());
+  EXPECT_EQ(rec.num_started(), 1u);
+  EXPECT_EQ(rec.get_finished_ids(), (std::vector<int>{0}));
+}
+
+TEST(speculative_bow, destruct_with_queued_requests) {
+  recorder rec;
+  std::shared_ptr<data::speculative_bow> running, queued;
+  std::thread releaser;
+  {
+    data::speculative_bow_worker worker(rec.get_function());
+    running = worker.request(create_descriptors(0));
+    rec.wait_until_started(0);
+    queued = worker.request(create_descriptors(1));
+
+    // the destructor waits for the running computation
+    releaser = std::thread([&rec] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      rec.is_released_ = true;
+    });
+  }
+  releaser.join();
+  EXPECT_TRUE(running->is_ready());
+
+  // the queued request is not computed by the worker, but on demand
+  EXPECT_FALSE(queued->is_ready());
+  data::bow_vector bow_vec;
+  data::bow_feature_vector bow_feat_vec;
+  queued->get(rec.get_function(), bow_vec, bow_feat_vec);
+  EXPECT_TRUE(queued->is_ready());
+  EXPECT_EQ(rec.get_finished_ids(), (std::vector<int>{0, 1}));
+}
@@ -2,11 +2,16 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <map>
 #include <opencv2/core.hpp>
 #include <opencv2/features2d.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
+#include <set>
+#include <utility>
 
 cv::Mat draw_lines(const cv::Mat& img, const unsigned int num_segments = 4) {
   auto lined_img = img.clone();
@@ -445,3 +450,123 @@ TEST(orb_extractor, extract_without_mask_4) {
   EXPECT_EQ(keypts.size(), desc.rows);
   EXPECT_EQ(desc.type(), CV_8U);
 }
+
+namespace {
+
+// FAST keypoints detected on the pyramid level independently of the extractor
+// key: position in the level without the border, value: FAST score
+std::map<std::pair<int, int>, float> detect_reference_fast_keypoints(
+    const cv::Mat& image_at_level, const int border,
+    const unsigned int fast_thr) {
+  std::vector<cv::KeyPoint> keypts;
+  cv::FAST(image_at_level.rowRange(border, image_at_level.rows - border)
+               .colRange(border, image_at_level.cols - border),
+           keypts, fast_thr, true);
+  std::map<std::pair<int, int>, float> responses;
+  for (const auto& keypt : keypts) {
+    responses[{static_cast<int>(keypt.pt.x), static_cast<int>(keypt.pt.y)}] =
+        keypt.response;
+  }
+  return responses;
+}
+
+}  // unnamed namespace
+
+TEST(orb_extractor, keypoints_are_consistent_with_reference_fast) {
+  const auto params = feature::orb_params("ORB setting for test");
+  auto extractor = feature::orb_extractor(&params, 2000);
+
+  // image
+  const auto img =
+      cv::imread(std::string(TEST_DATA_DIR) + "./equirectangular_image_001.jpg",
+                 cv::IMREAD_GRAYSCALE);
+
+  std::vector<cv::KeyPoint> keypts;
+  cv::Mat desc;
+  extractor.extract(img, cv::Mat(), keypts, desc);
+  ASSERT_GT(keypts.size(), 0);
+
+  // the keypoints are detected inside the border of the ORB patch radius
+  constexpr int border = 19;
+  // the cells where the keypoints with the initial threshold are preferred
+  constexpr int cell_size = 64;
+
+  for (unsigned int level = 0; level < params.num_levels_; ++level) {
+    const auto ref_responses = detect_reference_fast_keypoints(
+        extractor.image_pyramid_.at(level), border, params.min_fast_thr_);
+
+    // the cells which have keypoints passing the initial threshold
+    std::set<std::pair<int, int>> strong_cells;
+    float max_response = 0.0;
+    for (const auto& pos_and_response : ref_responses) {
+      const auto& pos = pos_and_response.first;
+      if (params.ini_fast_thr_ <= pos_and_response.second) {
+        strong_cells.emplace(pos.first / cell_size, pos.second / cell_size);
+      }
+      max_response = std::max(max_response, pos_and_response.second);
+    }
+
+    std::set<std::pair<int, int>> positions;
+    bool max_response_is_kept = false;
+    for (const auto& keypt : keypts) {
+      if (keypt.octave != static_cast<int>(level)) {
+        continue;
+      }
+      // position in the level without the border
+      const float scale_factor = params.scale_factors_.at(level);
+      const std::pair<int, int> pos{
+          std::lround(keypt.pt.x / scale_factor) - border,
+          std::lround(keypt.pt.y / scale_factor) - border};
+
+      // every keypoint is a FAST keypoint of the level with the same score
+      const auto ref_response = ref_responses.find(pos);
+      ASSERT_NE(ref_response, ref_responses.end());
+      EXPECT_FLOAT_EQ(keypt.response, ref_response->second);
+      // each keypoint is picked once
+      EXPECT_TRUE(positions.insert(pos).second);
+      // the keypoints below the initial threshold are picked only in the cells
+      // which have no keypoints passing it
+      if (keypt.response < params.ini_fast_thr_) {
+        EXPECT_FALSE(strong_cells.count(
+            {pos.first / cell_size, pos.second / cell_size}));
+      }
+      max_response_is_kept |= keypt.response == max_response;
+    }
+
+    // the node which has the strongest keypoint always keeps it
+    if (!positions.empty()) {
+      EXPECT_TRUE(max_response_is_kept);
+    }
+  }
+}
+
+TEST(orb_extractor, extract_is_repeatable) {
+  const auto params = feature::orb_params("ORB setting for test");
+  auto extractor = feature::orb_extractor(&params, 2000);
+
+  // image
+  const auto img_1 =
+      cv::imread(std::string(TEST_DATA_DIR) + "./equirectangular_image_001.jpg",
+                 cv::IMREAD_GRAYSCALE);
+  const auto img_2 =
+      cv::imread(std::string(TEST_DATA_DIR) + "./equirectangular_image_002.jpg",
+                 cv::IMREAD_GRAYSCALE);
+
+  // the buffers reused across the extractions don't change the results
+  std::vector<cv::KeyPoint> keypts_1, keypts_2, keypts_3;
+  cv::Mat desc_1, desc_2, desc_3;
+  extractor.extract(img_1, cv::Mat(), keypts_1, desc_1);
+  extractor.extract(img_2, cv::Mat(), keypts_2, desc_2);
+  extractor.extract(img_1, cv::Mat(), keypts_3, desc_3);
+  ASSERT_GT(keypts_1.size(), 0);
+
+  ASSERT_EQ(keypts_1.size(), keypts_3.size());
+  for (unsigned int idx = 0; idx < keypts_1.size(); ++idx) {
+    EXPECT_EQ(keypts_1.at(idx).pt, keypts_3.at(idx).pt);
+    EXPECT_EQ(keypts_1.at(idx).octave, keypts_3.at(idx).octave);
+    EXPECT_FLOAT_EQ(keypts_1.at(idx).angle, keypts_3.at(idx).angle);
+    EXPECT_FLOAT_EQ(keypts_1.at(idx).response, keypts_3.at(idx).response);
+  }
+  ASSERT_EQ(desc_1.rows, desc_3.rows);
+  EXPECT_EQ(cv::norm(desc_1, desc_3, cv::NORM_HAMMING), 0);
+}
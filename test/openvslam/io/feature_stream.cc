@@ -0,0 +1,91 @@
+#include "openvslam/io/feature_stream.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <random>
+
+#include "openvslam/data/frame_observation.h"
+
+using namespace openvslam;
+
+data::frame_observation create_random_observation(
+    const unsigned int num_keypts, std::mt19937& mt) {
+  std::uniform_real_distribution<float> rand_coord(0.0, 640.0);
+  std::uniform_int_distribution<int> rand_byte(0, 255);
+
+  data::frame_observation frm_obs;
+  frm_obs.num_keypts_ = num_keypts;
+  frm_obs.descriptors_ = cv::Mat(num_keypts, 32, CV_8U);
+  for (unsigned int idx = 0; idx < num_keypts; ++idx) {
+    frm_obs.keypts_.emplace_back(rand_coord(mt), rand_coord(mt), 31.0,
+                                 rand_coord(mt) / 640.0 * 360.0, 0.1 * idx,
+                                 idx % 8);
+    for (unsigned int j = 0; j < 32; ++j) {
+      frm_obs.descriptors_.at<uchar>(idx, j) =
+          static_cast<uchar>(rand_byte(mt));
+    }
+    // the half of the keypoints have no depth
+    frm_obs.stereo_x_right_.push_back(idx % 2 ? -1.0 : rand_coord(mt));
+    frm_obs.depths_.push_back(idx % 2 ? -1.0 : 0.01 * idx);
+  }
+  return frm_obs;
+}
+
+TEST(feature_stream, write_and_read) {
+  const std::string path = "feature_stream_test.bin";
+  std::mt19937 mt(0);
+
+  // 0 keypoints are also acceptable
+  const std::vector<unsigned int> nums_keypts{100, 0, 2000};
+  std::vector<data::frame_observation> frm_obses;
+  {
+    io::feature_stream_writer writer(path);
+    for (unsigned int i = 0; i < nums_keypts.size(); ++i) {
+      frm_obses.push_back(create_random_observation(nums_keypts.at(i), mt));
+      writer.write(0.05 * i, frm_obses.back());
+    }
+    EXPECT_EQ(writer.get_num_frames(), nums_keypts.size());
+  }
+
+  io::feature_stream_reader reader(path);
+  double timestamp;
+  data::frame_observation frm_obs;
+  for (unsigned int i = 0; i < nums_keypts.size(); ++i) {
+    ASSERT_TRUE(reader.read(timestamp, frm_obs));
+    const auto& frm_obs_gt = frm_obses.at(i);
+
+    EXPECT_DOUBLE_EQ(timestamp, 0.05 * i);
+    ASSERT_EQ(frm_obs.num_keypts_, frm_obs_gt.num_keypts_);
+    ASSERT_EQ(frm_obs.keypts_.size(), frm_obs_gt.keypts_.size());
+    for (unsigned int idx = 0; idx < frm_obs.num_keypts_; ++idx) {
+      const auto& keypt = frm_obs.keypts_.at(idx);
+      const auto& keypt_gt = frm_obs_gt.keypts_.at(idx);
+      EXPECT_EQ(keypt.pt, keypt_gt.pt);
+      EXPECT_EQ(keypt.size, keypt_gt.size);
+      EXPECT_EQ(keypt.angle, keypt_gt.angle);
+      EXPECT_EQ(keypt.response, keypt_gt.response);
+      EXPECT_EQ(keypt.octave, keypt_gt.octave);
+    }
+    if (0 < frm_obs.num_keypts_) {
+      EXPECT_EQ(cv::norm(frm_obs.descriptors_, frm_obs_gt.descriptors_,
+                         cv::NORM_HAMMING),
+                0);
+    }
+    EXPECT_EQ(frm_obs.stereo_x_right_, frm_obs_gt.stereo_x_right_);
+    EXPECT_EQ(frm_obs.depths_, frm_obs_gt.depths_);
+  }
+  EXPECT_FALSE(reader.read(timestamp, frm_obs));
+
+  std::remove(path.c_str());
+}
+
+TEST(feature_stream, invalid_file) {
+  const std::string path = "feature_stream_test_invalid.bin";
+  {
+    std::ofstream ofs(path, std::ios::out | std::ios::binary);
+    ofs << "not a feature stream";
+  }
+  EXPECT_THROW(io::feature_stream_reader reader(path), std::runtime_error);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,64 @@
+#include "openvslam/io/map_database_io.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "helper/scene.h"
+#include "openvslam/data/bow_database.h"
+#include "openvslam/data/camera_database.h"
+#include "openvslam/data/orb_params_database.h"
+
+using namespace openvslam;
+
+TEST(map_database_io, load_vocabulary_while_decoding) {
+  const auto vocab_file_path_env = std::getenv("BOW_VOCAB");
+  if (vocab_file_path_env == nullptr) {
+    return;
+  }
+  const std::string vocab_file_path(vocab_file_path_env);
+  const auto src_bow_vocab =
+      data::bow_vocabulary_util::load_vocabulary(vocab_file_path);
+  ASSERT_TRUE(src_bow_vocab);
+
+  synthetic_scene scene(10, 2000);
+  for (const auto& keyfrm : scene.keyfrms_) {
+    keyfrm->compute_bow(src_bow_vocab.get());
+  }
+  data::camera_database cam_db(scene.camera_.get());
+  data::orb_params_database orb_params_db(scene.orb_params_.get());
+  const auto path = testing::TempDir() + "/map_database_io.msgpack";
+
+  for (const bool store_bow : {true, false}) {
+    io::map_database_io src_io(&cam_db, &orb_params_db, scene.map_db_.get(),
+                               nullptr, src_bow_vocab.get(), store_bow);
+    src_io.save_message_pack(path);
+
+    // the vocabulary is loaded by the callback, so that the keyframes must
+    // be decoded without it
+    data::bow_vocabulary bow_vocab;
+    data::map_database map_db;
+    data::bow_database bow_db(&bow_vocab);
+    io::map_database_io dst_io(&cam_db, &orb_params_db, &map_db, &bow_db,
+                               &bow_vocab);
+    unsigned int num_waits = 0;
+    dst_io.load_message_pack(path, [&] {
+      ++num_waits;
+      ASSERT_TRUE(data::bow_vocabulary_util::load_vocabulary(
+          &bow_vocab, vocab_file_path));
+    });
+    EXPECT_EQ(num_waits, 1u);
+
+    // the stored or computed BoW representations are the same
+    ASSERT_EQ(map_db.get_num_keyframes(), scene.keyfrms_.size());
+    for (const auto& keyfrm : scene.keyfrms_) {
+      const auto loaded_keyfrm = map_db.get_keyframe(keyfrm->id_);
+      ASSERT_TRUE(loaded_keyfrm);
+      EXPECT_TRUE(loaded_keyfrm->bow_vec_ == keyfrm->bow_vec_);
+      EXPECT_TRUE(loaded_keyfrm->bow_feat_vec_ == keyfrm->bow_feat_vec_);
+    }
+  }
+  std::remove(path.c_str());
+}
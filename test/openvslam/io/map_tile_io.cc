@@ -0,0 +1,157 @@
+#include "openvslam/io/map_tile_io.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+
+#include "helper/scene.h"
+#include "openvslam/data/bow_database.h"
+#include "openvslam/data/camera_database.h"
+#include "openvslam/data/orb_params_database.h"
+#include "openvslam/module/map_pager.h"
+
+using namespace openvslam;
+
+namespace {
+
+std::unique_ptr<data::bow_vocabulary> load_bow_vocabulary() {
+  const auto vocab_file_path_env = std::getenv("BOW_VOCAB");
+  if (vocab_file_path_env == nullptr) {
+    return nullptr;
+  }
+  std::unique_ptr<data::bow_vocabulary> bow_vocab(new data::bow_vocabulary());
+#ifdef USE_DBOW2
+  bow_vocab->loadFromBinaryFile(vocab_file_path_env);
+#else
+  bow_vocab->readFromFile(vocab_file_path_env);
+#endif
+  return bow_vocab;
+}
+
+void remove_tiles(const io::map_tile_index& index) {
+  for (const auto& key_keyfrm_ids : index.keyfrm_ids_in_tiles_) {
+    std::remove(index.get_tile_path(key_keyfrm_ids.first).c_str());
+  }
+  std::remove((index.dir_ + "/index.msgpack").c_str());
+}
+
+// the resident keyframes and landmarks must not refer to the evicted ones
+void check_consistency(data::map_database* map_db) {
+  std::set<unsigned int> keyfrm_ids;
+  for (const auto& keyfrm : map_db->get_all_keyframes()) {
+    keyfrm_ids.insert(keyfrm->id_);
+  }
+  for (const auto& lm : map_db->get_all_landmarks()) {
+    EXPECT_TRUE(lm->has_observation());
+    EXPECT_TRUE(keyfrm_ids.count(lm->get_ref_keyframe()->id_));
+    for (const auto& obs : lm->get_observations()) {
+      EXPECT_TRUE(keyfrm_ids.count(obs.first.lock()->id_));
+    }
+  }
+  for (const auto& keyfrm : map_db->get_all_keyframes()) {
+    for (const auto& covisibility :
+         keyfrm->graph_node_->get_covisibilities()) {
+      EXPECT_TRUE(keyfrm_ids.count(covisibility->id_));
+    }
+  }
+}
+
+}  // unnamed namespace
+
+TEST(map_tile_io, save_and_page_tiles) {
+  // the keyframes of the tiles are decoded with the vocabulary
+  const auto bow_vocab = load_bow_vocabulary();
+  if (!bow_vocab) {
+    return;
+  }
+
+  // the keyframes are placed at x = 0.0, 0.2, ..., 5.8
+  synthetic_scene scene(30, 3000);
+  data::camera_database cam_db(scene.camera_.get());
+  data::orb_params_database orb_params_db(scene.orb_params_.get());
+  io::map_tile_io src_io(&cam_db, &orb_params_db, scene.map_db_.get(), nullptr,
+                         bow_vocab.get());
+  const auto dir = testing::TempDir();
+  src_io.save_tiles(dir, 1.0);
+
+  data::map_database map_db;
+  data::bow_database bow_db(bow_vocab.get());
+  io::map_tile_io dst_io(&cam_db, &orb_params_db, &map_db, &bow_db,
+                         bow_vocab.get());
+  const auto index = dst_io.load_index(dir);
+  EXPECT_EQ(index.keyfrm_ids_in_tiles_.size(), 6);
+  EXPECT_EQ(map_db.get_num_keyframes(), 0);
+
+  {
+    // load the tiles around x = 2.5 without eviction
+    module::map_pager pager(&cam_db, &orb_params_db, &map_db, &bow_db,
+                            bow_vocab.get(), index, 1, 1e6, 3);
+    pager.request_tiles_around(Vec3_t{2.5, 0.0, 0.0});
+    pager.wait_until_idle();
+    EXPECT_EQ(pager.get_num_resident_tiles(), 3);
+
+    unsigned int num_keyfrms = 0;
+    for (const int x : {1, 2, 3}) {
+      const auto key = index.get_key(Vec3_t{x + 0.5, 0.0, 0.0});
+      num_keyfrms += index.keyfrm_ids_in_tiles_.at(key).size();
+    }
+    EXPECT_EQ(map_db.get_num_keyframes(), num_keyfrms);
+    check_consistency(&map_db);
+
+    // the landmarks shared between the tiles are not duplicated
+    std::set<unsigned int> lm_ids;
+    for (const auto& keyfrm : map_db.get_all_keyframes()) {
+      for (const auto& lm : scene.map_db_->get_keyframe(keyfrm->id_)
+                                ->get_landmarks()) {
+        if (lm) {
+          lm_ids.insert(lm->id_);
+        }
+      }
+    }
+    EXPECT_EQ(map_db.get_num_landmarks(), lm_ids.size());
+  }
+
+  map_db.clear();
+  bow_db.clear();
+
+  {
+    // only the requested tile stays in the map database with a tiny budget
+    module::map_pager pager(&cam_db, &orb_params_db, &map_db, &bow_db,
+                            bow_vocab.get(), index, 0, 1e-6, 2);
+    pager.request_tiles_around(Vec3_t{0.5, 0.0, 0.0});
+    pager.wait_until_idle();
+    EXPECT_EQ(pager.get_num_resident_tiles(), 1);
+    ASSERT_NE(map_db.origin_keyfrm_, nullptr);
+    const auto evicted_keyfrm = map_db.get_keyframe(1);
+    ASSERT_NE(evicted_keyfrm, nullptr);
+
+    pager.request_tiles_around(Vec3_t{4.5, 0.0, 0.0});
+    pager.wait_until_idle();
+    EXPECT_EQ(pager.get_num_resident_tiles(), 1);
+    const auto& keyfrm_ids = index.keyfrm_ids_in_tiles_.at(
+        index.get_key(Vec3_t{4.5, 0.0, 0.0}));
+    // the origin stays resident when its tile is evicted
+    EXPECT_EQ(map_db.get_num_keyframes(), keyfrm_ids.size() + 1);
+    for (const auto id : keyfrm_ids) {
+      EXPECT_TRUE(map_db.get_keyframe(id));
+    }
+    ASSERT_NE(map_db.origin_keyfrm_, nullptr);
+    EXPECT_EQ(map_db.origin_keyfrm_->id_, 0);
+    EXPECT_EQ(map_db.get_keyframe(0), map_db.origin_keyfrm_);
+    EXPECT_FALSE(map_db.origin_keyfrm_->will_be_erased());
+    // the evicted keyframes are marked for the modules which still hold them
+    EXPECT_TRUE(evicted_keyfrm->will_be_erased());
+    EXPECT_EQ(map_db.get_keyframe(1), nullptr);
+    check_consistency(&map_db);
+
+    // the tiles for relocalization are loaded in the same way
+    pager.request_tiles_for_relocalization(scene.keyfrms_.at(10)->bow_vec_);
+    pager.wait_until_idle();
+    EXPECT_EQ(pager.get_num_resident_tiles(), 2);
+    check_consistency(&map_db);
+  }
+
+  remove_tiles(index);
+}
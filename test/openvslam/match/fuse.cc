@@ -0,0 +1,110 @@
+#include "openvslam/match/fuse.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "helper/scene.h"
+
+using namespace openvslam;
+
+namespace {
+
+// erase the observations of the keyframe, and add the landmarks which
+// duplicate the half of the erased ones to the keyframe
+void make_duplication(synthetic_scene& scene,
+                      const std::shared_ptr<data::keyframe>& keyfrm,
+                      const unsigned int num_obs) {
+  std::vector<std::pair<unsigned int, Vec3_t>> erased_obs;
+  const auto lms = keyfrm->get_landmarks();
+  for (unsigned int idx = 0; idx < lms.size(); ++idx) {
+    if (lms.at(idx) && erased_obs.size() < num_obs) {
+      erased_obs.emplace_back(idx, lms.at(idx)->get_pos_in_world());
+    }
+  }
+  scene.erase_observations(keyfrm, num_obs);
+
+  for (unsigned int i = 0; i < erased_obs.size(); i += 2) {
+    const auto idx = erased_obs.at(i).first;
+    auto lm = std::make_shared<data::landmark>(erased_obs.at(i).second, keyfrm,
+                                               scene.map_db_.get());
+    lm->add_observation(keyfrm, idx);
+    keyfrm->add_landmark(lm, idx);
+    lm->compute_descriptor();
+    lm->update_mean_normal_and_obs_scale_variance();
+    scene.map_db_->add_landmark(lm);
+  }
+}
+
+// IDs of the landmarks associated to the keypoints (-1 if not associated)
+std::vector<int> get_landmark_ids(
+    const std::shared_ptr<data::keyframe>& keyfrm) {
+  std::vector<int> lm_ids;
+  for (const auto& lm : keyfrm->get_landmarks()) {
+    lm_ids.push_back(lm && !lm->will_be_erased() ? static_cast<int>(lm->id_)
+                                                 : -1);
+  }
+  return lm_ids;
+}
+
+// keyframe IDs and keypoint indices of the observations
+std::map<unsigned int, unsigned int> get_observations(
+    const std::shared_ptr<data::landmark>& lm) {
+  std::map<unsigned int, unsigned int> observations;
+  for (const auto& obs : lm->get_observations()) {
+    observations[obs.first.lock()->id_] = obs.second;
+  }
+  return observations;
+}
+
+void expect_same_map(const synthetic_scene& scene_1,
+                     const synthetic_scene& scene_2) {
+  ASSERT_EQ(scene_1.keyfrms_.size(), scene_2.keyfrms_.size());
+  for (unsigned int i = 0; i < scene_1.keyfrms_.size(); ++i) {
+    EXPECT_EQ(get_landmark_ids(scene_1.keyfrms_.at(i)),
+              get_landmark_ids(scene_2.keyfrms_.at(i)));
+  }
+
+  const auto lms_1 = scene_1.map_db_->get_all_landmarks();
+  const auto lms_2 = scene_2.map_db_->get_all_landmarks();
+  ASSERT_EQ(lms_1.size(), lms_2.size());
+  for (const auto& lm_1 : lms_1) {
+    const auto lm_2 = scene_2.map_db_->get_landmark(lm_1->id_);
+    ASSERT_NE(lm_2, nullptr);
+    EXPECT_EQ(lm_1->will_be_erased(), lm_2->will_be_erased());
+    EXPECT_EQ(get_observations(lm_1), get_observations(lm_2));
+  }
+}
+
+}  // unnamed namespace
+
+TEST(fuse, replace_duplication_in_chunks) {
+  // the scenes are the same because they are generated from the same seed
+  synthetic_scene serial_scene(10, 2000);
+  synthetic_scene chunked_scene(10, 2000);
+  const unsigned int keyfrm_idx = 4;
+  make_duplication(serial_scene, serial_scene.keyfrms_.at(keyfrm_idx), 200);
+  make_duplication(chunked_scene, chunked_scene.keyfrms_.at(keyfrm_idx), 200);
+  expect_same_map(serial_scene, chunked_scene);
+
+  // fuse the landmarks in the same order
+  std::vector<std::shared_ptr<data::landmark>> serial_lms, chunked_lms;
+  for (unsigned int i = 0; i < serial_scene.lms_.size(); ++i) {
+    serial_lms.push_back(serial_scene.lms_.at(i));
+    chunked_lms.push_back(chunked_scene.lms_.at(i));
+  }
+
+  match::fuse matcher;
+  const auto num_serial_fused = matcher.replace_duplication(
+      serial_scene.keyfrms_.at(keyfrm_idx), serial_lms);
+  // the chunks are smaller than the number of the fused landmarks
+  const auto num_chunked_fused = matcher.replace_duplication_in_chunks(
+      chunked_scene.keyfrms_.at(keyfrm_idx), chunked_lms, 7);
+
+  // both of the observations are added and the duplication is replaced
+  EXPECT_LT(50, num_serial_fused);
+  EXPECT_EQ(num_chunked_fused, num_serial_fused);
+  expect_same_map(serial_scene, chunked_scene);
+}
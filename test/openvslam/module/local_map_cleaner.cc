@@ -0,0 +1,93 @@
+#include "openvslam/module/local_map_cleaner.h"
+
+#include <gtest/gtest.h>
+
+#include "helper/scene.h"
+
+using namespace openvslam;
+
+namespace {
+
+// count the valid and the redundant observations from scratch
+void count_redundant_observations(const std::shared_ptr<data::keyframe>& keyfrm,
+                                  unsigned int& num_valid_obs,
+                                  unsigned int& num_redundant_obs) {
+  constexpr unsigned int num_better_obs_thr = 3;
+
+  num_valid_obs = 0;
+  num_redundant_obs = 0;
+
+  const auto landmarks = keyfrm->get_landmarks();
+  for (unsigned int idx = 0; idx < landmarks.size(); ++idx) {
+    const auto& lm = landmarks.at(idx);
+    if (!lm || lm->will_be_erased()) {
+      continue;
+    }
+    if (!keyfrm->observation_is_checked_for_redundancy(idx)) {
+      continue;
+    }
+
+    ++num_valid_obs;
+
+    if (lm->num_observations() <= num_better_obs_thr) {
+      continue;
+    }
+
+    const auto scale_level = keyfrm->frm_obs_.undist_keypts_.at(idx).octave;
+    unsigned int num_better_obs = 0;
+    for (const auto& obs : lm->get_observations()) {
+      const auto ngh_keyfrm = obs.first.lock();
+      if (*ngh_keyfrm == *keyfrm) {
+        continue;
+      }
+      const auto ngh_scale_level =
+          ngh_keyfrm->frm_obs_.undist_keypts_.at(obs.second).octave;
+      if (ngh_scale_level <= scale_level + 1) {
+        ++num_better_obs;
+      }
+    }
+
+    if (num_better_obs_thr <= num_better_obs) {
+      ++num_redundant_obs;
+    }
+  }
+}
+
+void check_redundant_observations(const module::local_map_cleaner& cleaner,
+                                  const synthetic_scene& scene) {
+  for (const auto& keyfrm : scene.keyfrms_) {
+    unsigned int num_valid_obs, num_redundant_obs;
+    cleaner.count_redundant_observations(keyfrm, num_valid_obs,
+                                         num_redundant_obs);
+    unsigned int expected_num_valid_obs, expected_num_redundant_obs;
+    count_redundant_observations(keyfrm, expected_num_valid_obs,
+                                 expected_num_redundant_obs);
+    EXPECT_EQ(num_valid_obs, expected_num_valid_obs);
+    EXPECT_EQ(num_redundant_obs, expected_num_redundant_obs);
+  }
+}
+
+}  // unnamed namespace
+
+TEST(local_map_cleaner, incremental_redundancy_counts) {
+  synthetic_scene scene(10, 2000);
+  module::local_map_cleaner cleaner(scene.map_db_.get(), nullptr);
+  check_redundant_observations(cleaner, scene);
+
+  unsigned int num_redundant_obs_before = 0;
+  for (const auto& keyfrm : scene.keyfrms_) {
+    unsigned int num_valid_obs, num_redundant_obs;
+    cleaner.count_redundant_observations(keyfrm, num_valid_obs,
+                                         num_redundant_obs);
+    num_redundant_obs_before += num_redundant_obs;
+  }
+  ASSERT_LT(0, num_redundant_obs_before);
+
+  // erase a part of the observations
+  scene.erase_observations(scene.keyfrms_.at(4), 100);
+  check_redundant_observations(cleaner, scene);
+
+  // erase and replace a part of the landmarks
+  ASSERT_TRUE(scene.erase_and_replace_landmarks(50, 50));
+  check_redundant_observations(cleaner, scene);
+}
@@ -0,0 +1,140 @@
+#include "openvslam/module/local_map_updater.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "helper/scene.h"
+
+using namespace openvslam;
+
+namespace {
+
+data::frame create_matched_frame(synthetic_scene& scene, const double x) {
+  std::vector<unsigned int> lm_indices;
+  auto frm = scene.create_frame(scene.get_cam_pose(x), lm_indices);
+  for (unsigned int idx = 0; idx < lm_indices.size(); ++idx) {
+    frm.landmarks_.at(idx) = scene.lms_.at(lm_indices.at(idx));
+  }
+  return frm;
+}
+
+void check_local_map(const module::local_map_updater& updater,
+                     const data::frame& frm) {
+  // count the keyframe weights from scratch
+  std::unordered_map<unsigned int, unsigned int> keyfrm_weights;
+  for (const auto& lm : frm.landmarks_) {
+    if (!lm) {
+      continue;
+    }
+    for (const auto& obs : lm->get_observations()) {
+      ++keyfrm_weights[obs.first.lock()->id_];
+    }
+  }
+  ASSERT_FALSE(keyfrm_weights.empty());
+
+  // the first-order keyframes are contained in the local keyframes
+  std::unordered_set<unsigned int> local_keyfrm_ids;
+  for (const auto& keyfrm : updater.get_local_keyframes()) {
+    EXPECT_TRUE(local_keyfrm_ids.insert(keyfrm->id_).second);
+  }
+  unsigned int max_weight = 0;
+  for (const auto& id_and_weight : keyfrm_weights) {
+    EXPECT_TRUE(local_keyfrm_ids.count(id_and_weight.first));
+    max_weight = std::max(max_weight, id_and_weight.second);
+  }
+
+  // the nearest covisibility has the maximum weight
+  const auto nearest_covisibility = updater.get_nearest_covisibility();
+  ASSERT_NE(nearest_covisibility, nullptr);
+  EXPECT_EQ(keyfrm_weights.at(nearest_covisibility->id_), max_weight);
+
+  // the local landmarks are the ones observed in the local keyframes
+  std::unordered_set<unsigned int> local_lm_ids;
+  for (const auto& keyfrm : updater.get_local_keyframes()) {
+    for (const auto& lm : keyfrm->get_landmarks()) {
+      if (lm && !lm->will_be_erased()) {
+        local_lm_ids.insert(lm->id_);
+      }
+    }
+  }
+  EXPECT_EQ(updater.get_local_landmarks().size(), local_lm_ids.size());
+  for (const auto& lm : updater.get_local_landmarks()) {
+    EXPECT_TRUE(local_lm_ids.count(lm->id_));
+  }
+}
+
+}  // unnamed namespace
+
+TEST(local_map_updater, incremental_update) {
+  synthetic_scene scene(10, 2000);
+  module::local_map_updater updater(scene.map_db_.get(), 60);
+
+  // track the frames between the keyframes
+  for (double x = 0.1; x < scene.keyfrm_xs_.back(); x += 0.15) {
+    const auto frm = create_matched_frame(scene, x);
+    ASSERT_TRUE(updater.acquire_local_map(frm));
+    check_local_map(updater, frm);
+  }
+}
+
+TEST(local_map_updater, local_map_is_reused) {
+  synthetic_scene scene(10, 2000);
+  module::local_map_updater updater(scene.map_db_.get(), 60);
+
+  auto frm = create_matched_frame(scene, 0.9);
+  ASSERT_TRUE(updater.acquire_local_map(frm));
+  EXPECT_TRUE(updater.local_map_is_rebuilt());
+  const auto local_lms = updater.get_local_landmarks();
+
+  // the local map is not searched again if the matches are unchanged
+  ASSERT_TRUE(updater.acquire_local_map(frm));
+  EXPECT_FALSE(updater.local_map_is_rebuilt());
+  EXPECT_EQ(updater.get_local_landmarks(), local_lms);
+
+  // the local map is consistent after a part of the matches are dropped
+  unsigned int num_dropped = 0;
+  for (unsigned int idx = 0; idx < frm.landmarks_.size(); ++idx) {
+    const auto& lm = frm.landmarks_.at(idx);
+    if (lm && 5 <= lm->num_observations() && num_dropped < 10) {
+      frm.landmarks_.at(idx) = nullptr;
+      ++num_dropped;
+    }
+  }
+  ASSERT_TRUE(updater.acquire_local_map(frm));
+  check_local_map(updater, frm);
+
+  // the local map is not searched again if the graph of another map is
+  // modified
+  synthetic_scene another_scene(3, 500);
+  another_scene.keyfrms_.front()->graph_node_->update_connections();
+  ASSERT_TRUE(updater.acquire_local_map(frm));
+  EXPECT_FALSE(updater.local_map_is_rebuilt());
+
+  // the local map is not searched again if the connections are updated but
+  // unchanged
+  scene.keyfrms_.front()->graph_node_->update_connections();
+  ASSERT_TRUE(updater.acquire_local_map(frm));
+  EXPECT_FALSE(updater.local_map_is_rebuilt());
+
+  // the local map is searched again if the map graph is modified
+  scene.erase_observations(scene.keyfrms_.front(), 100);
+  scene.keyfrms_.front()->graph_node_->update_connections();
+  ASSERT_TRUE(updater.acquire_local_map(frm));
+  EXPECT_TRUE(updater.local_map_is_rebuilt());
+  check_local_map(updater, frm);
+
+  // the local map is discarded by reset()
+  updater.reset();
+  EXPECT_TRUE(updater.get_local_landmarks().empty());
+  EXPECT_EQ(updater.get_nearest_covisibility(), nullptr);
+}
+
+TEST(local_map_updater, no_matches) {
+  synthetic_scene scene(5, 500);
+  module::local_map_updater updater(scene.map_db_.get(), 60);
+
+  std::vector<unsigned int> lm_indices;
+  const auto frm = scene.create_frame(scene.get_cam_pose(0.3), lm_indices);
+  EXPECT_FALSE(updater.acquire_local_map(frm));
+}
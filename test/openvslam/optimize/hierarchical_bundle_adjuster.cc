@@ -0,0 +1,168 @@
+#include "openvslam/optimize/hierarchical_bundle_adjuster.h"
+
+#include <gtest/gtest.h>
+
+#include <list>
+#include <random>
+#include <unordered_set>
+
+#include "helper/scene.h"
+#include "openvslam/data/graph_node.h"
+#include "openvslam/optimize/global_bundle_adjuster.h"
+
+using namespace openvslam;
+
+namespace {
+
+// mean reprojection error of all the observations
+// (the poses and the positions which are not in the results are read from the
+// map)
+double get_mean_reproj_error(
+    const synthetic_scene& scene,
+    const eigen_alloc_unord_map<unsigned int, Mat44_t>& keyfrm_to_pose_cw,
+    const eigen_alloc_unord_map<unsigned int, Vec3_t>& lm_to_pos_w) {
+  double sum_error = 0.0;
+  unsigned int num_obs = 0;
+  for (const auto& lm : scene.lms_) {
+    if (!lm) {
+      continue;
+    }
+    const Vec3_t pos_w = lm_to_pos_w.count(lm->id_)
+                             ? lm_to_pos_w.at(lm->id_)
+                             : lm->get_pos_in_world();
+    for (const auto& obs : lm->get_observations()) {
+      const auto keyfrm = obs.first.lock();
+      const Mat44_t cam_pose_cw = keyfrm_to_pose_cw.count(keyfrm->id_)
+                                      ? keyfrm_to_pose_cw.at(keyfrm->id_)
+                                      : keyfrm->get_cam_pose();
+      Vec2_t reproj;
+      float x_right;
+      scene.camera_->reproject_to_image(cam_pose_cw.block<3, 3>(0, 0),
+                                        cam_pose_cw.block<3, 1>(0, 3), pos_w,
+                                        reproj, x_right);
+      const auto& keypt = keyfrm->frm_obs_.undist_keypts_.at(obs.second);
+      sum_error += (reproj - Vec2_t{keypt.pt.x, keypt.pt.y}).norm();
+      ++num_obs;
+    }
+  }
+  return sum_error / num_obs;
+}
+
+// perturb the camera poses except the origin and the landmark positions
+void perturb_map(synthetic_scene& scene) {
+  std::mt19937 mt(1);
+  std::normal_distribution<> rand_trans(0.0, 0.02);
+  std::normal_distribution<> rand_pos(0.0, 0.05);
+  for (const auto& keyfrm : scene.keyfrms_) {
+    if (keyfrm->id_ == 0) {
+      continue;
+    }
+    Mat44_t cam_pose_cw = keyfrm->get_cam_pose();
+    cam_pose_cw.block<3, 1>(0, 3) +=
+        Vec3_t{rand_trans(mt), rand_trans(mt), rand_trans(mt)};
+    keyfrm->set_cam_pose(cam_pose_cw);
+  }
+  for (const auto& lm : scene.lms_) {
+    if (!lm) {
+      continue;
+    }
+    lm->set_pos_in_world(lm->get_pos_in_world() +
+                         Vec3_t{rand_pos(mt), rand_pos(mt), rand_pos(mt)});
+  }
+}
+
+}  // unnamed namespace
+
+TEST(hierarchical_bundle_adjuster, partition_into_connected_submaps) {
+  synthetic_scene scene(30, 3000);
+  constexpr unsigned int num_keyfrms_per_submap = 8;
+  const optimize::hierarchical_bundle_adjuster hierarchical_BA(
+      scene.map_db_.get(), num_keyfrms_per_submap);
+
+  auto keyfrms = scene.map_db_->get_all_keyframes();
+  // nullptr is skipped
+  keyfrms.push_back(nullptr);
+  const auto submaps = hierarchical_BA.partition(keyfrms);
+  EXPECT_LE((scene.keyfrms_.size() + num_keyfrms_per_submap - 1) /
+                num_keyfrms_per_submap,
+            submaps.size());
+  // the first submap is grown from the oldest keyframe
+  ASSERT_FALSE(submaps.empty());
+  ASSERT_FALSE(submaps.front().empty());
+  EXPECT_EQ(submaps.front().front()->id_, 0u);
+
+  std::unordered_set<unsigned int> assigned_keyfrm_ids;
+  for (const auto& submap : submaps) {
+    ASSERT_FALSE(submap.empty());
+    EXPECT_LE(submap.size(), num_keyfrms_per_submap);
+
+    // every keyframe belongs to exactly one submap
+    std::unordered_set<unsigned int> keyfrm_ids;
+    for (const auto& keyfrm : submap) {
+      keyfrm_ids.insert(keyfrm->id_);
+      EXPECT_TRUE(assigned_keyfrm_ids.insert(keyfrm->id_).second);
+    }
+
+    // every keyframe in the submap is reachable from the seed on the
+    // covisibility graph without leaving the submap
+    std::unordered_set<unsigned int> reached_keyfrm_ids{submap.front()->id_};
+    std::list<std::shared_ptr<data::keyframe>> keyfrms_to_check{
+        submap.front()};
+    while (!keyfrms_to_check.empty()) {
+      const auto keyfrm = keyfrms_to_check.front();
+      keyfrms_to_check.pop_front();
+      for (const auto& covisibility :
+           keyfrm->graph_node_->get_covisibilities()) {
+        if (!keyfrm_ids.count(covisibility->id_)) {
+          continue;
+        }
+        if (reached_keyfrm_ids.insert(covisibility->id_).second) {
+          keyfrms_to_check.push_back(covisibility);
+        }
+      }
+    }
+    EXPECT_EQ(reached_keyfrm_ids.size(), submap.size());
+  }
+  EXPECT_EQ(assigned_keyfrm_ids.size(), scene.keyfrms_.size());
+}
+
+TEST(hierarchical_bundle_adjuster, close_to_global_bundle_adjuster) {
+  synthetic_scene scene(30, 3000);
+  perturb_map(scene);
+  const auto initial_error = get_mean_reproj_error(scene, {}, {});
+
+  // neither of the bundle adjusters writes the results to the map
+  std::unordered_set<unsigned int> global_keyfrm_ids, global_lm_ids;
+  eigen_alloc_unord_map<unsigned int, Vec3_t> global_lm_to_pos_w;
+  eigen_alloc_unord_map<unsigned int, Mat44_t> global_keyfrm_to_pose_cw;
+  const optimize::global_bundle_adjuster global_BA(scene.map_db_.get(), 10,
+                                                   false);
+  global_BA.optimize(global_keyfrm_ids, global_lm_ids, global_lm_to_pos_w,
+                     global_keyfrm_to_pose_cw);
+
+  std::unordered_set<unsigned int> hierarchical_keyfrm_ids,
+      hierarchical_lm_ids;
+  eigen_alloc_unord_map<unsigned int, Vec3_t> hierarchical_lm_to_pos_w;
+  eigen_alloc_unord_map<unsigned int, Mat44_t> hierarchical_keyfrm_to_pose_cw;
+  // the phase of the separators starts from the results of the submaps even
+  // though they are not committed to the map
+  const optimize::hierarchical_bundle_adjuster hierarchical_BA(
+      scene.map_db_.get(), 8, 10, false);
+  hierarchical_BA.optimize(hierarchical_keyfrm_ids, hierarchical_lm_ids,
+                           hierarchical_lm_to_pos_w,
+                           hierarchical_keyfrm_to_pose_cw);
+
+  // the same variables are optimized
+  EXPECT_EQ(hierarchical_keyfrm_ids, global_keyfrm_ids);
+  EXPECT_EQ(hierarchical_lm_ids, global_lm_ids);
+
+  // the reprojection error is compared because it does not depend on the
+  // gauge of the monocular map
+  const auto global_error = get_mean_reproj_error(
+      scene, global_keyfrm_to_pose_cw, global_lm_to_pos_w);
+  const auto hierarchical_error = get_mean_reproj_error(
+      scene, hierarchical_keyfrm_to_pose_cw, hierarchical_lm_to_pos_w);
+  EXPECT_LT(global_error, initial_error);
+  EXPECT_LT(hierarchical_error, initial_error);
+  EXPECT_LT(hierarchical_error, 2.0 * global_error);
+}
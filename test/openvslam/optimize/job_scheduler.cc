@@ -0,0 +1,285 @@
+#include "openvslam/optimize/job_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace openvslam;
+
+namespace {
+
+// job which spins until it is cancelled or released
+void spin_until_released(const optimize::cancellation_token& token,
+                         const std::atomic<bool>& is_released) {
+  while (!token.is_cancelled() && !is_released) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+// block until the job is started by a worker
+void wait_until_started(const std::atomic<unsigned int>& num_starts,
+                        const unsigned int num_expected) {
+  while (num_starts < num_expected) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+}  // unnamed namespace
+
+TEST(job_scheduler, run_in_order_of_priorities) {
+  optimize::job_scheduler scheduler(1);
+
+  // occupy the only worker until all of the jobs are queued
+  std::atomic<bool> is_released(false);
+  std::atomic<unsigned int> num_starts(0);
+  auto blocker = scheduler.submit(
+      "blocker", optimize::job_priority_t::High,
+      [&](const optimize::cancellation_token& token) {
+        ++num_starts;
+        spin_until_released(token, is_released);
+      });
+  wait_until_started(num_starts, 1);
+
+  std::mutex mtx;
+  std::vector<std::string> order;
+  const auto record = [&](const std::string& name) {
+    return [&mtx, &order, name](const optimize::cancellation_token&) {
+      std::lock_guard<std::mutex> lock(mtx);
+      order.push_back(name);
+    };
+  };
+  std::vector<optimize::job_scheduler::job_handle> jobs;
+  jobs.push_back(scheduler.submit("low", optimize::job_priority_t::Low,
+                                  record("low")));
+  jobs.push_back(scheduler.submit("normal_1", optimize::job_priority_t::Normal,
+                                  record("normal_1")));
+  jobs.push_back(scheduler.submit("high", optimize::job_priority_t::High,
+                                  record("high")));
+  jobs.push_back(scheduler.submit("normal_2", optimize::job_priority_t::Normal,
+                                  record("normal_2")));
+
+  is_released = true;
+  for (const auto& job : jobs) {
+    job.wait();
+    EXPECT_TRUE(job.is_finished());
+    EXPECT_FALSE(job.was_cancelled());
+  }
+  blocker.wait();
+
+  const std::vector<std::string> expected{"high", "normal_1", "normal_2",
+                                          "low"};
+  EXPECT_EQ(order, expected);
+
+  const auto metrics = scheduler.get_metrics(optimize::job_priority_t::Normal);
+  EXPECT_EQ(metrics.num_submitted_, 2);
+  EXPECT_EQ(metrics.num_completed_, 2);
+  EXPECT_EQ(metrics.num_queued_, 0);
+  EXPECT_EQ(metrics.num_running_, 0);
+}
+
+TEST(job_scheduler, cancel_jobs) {
+  optimize::job_scheduler scheduler(1);
+
+  std::atomic<bool> is_released(false);
+  std::atomic<unsigned int> num_starts(0);
+  auto running = scheduler.submit(
+      "running", optimize::job_priority_t::Normal,
+      [&](const optimize::cancellation_token& token) {
+        ++num_starts;
+        spin_until_released(token, is_released);
+      });
+  wait_until_started(num_starts, 1);
+
+  // the queued job is never started
+  std::atomic<bool> queued_job_is_started(false);
+  auto queued = scheduler.submit(
+      "queued", optimize::job_priority_t::Normal,
+      [&](const optimize::cancellation_token&) {
+        queued_job_is_started = true;
+      });
+  queued.cancel();
+  EXPECT_TRUE(queued.is_finished());
+  EXPECT_TRUE(queued.was_cancelled());
+
+  // the running job returns cooperatively
+  EXPECT_FALSE(running.is_finished());
+  running.cancel();
+  running.wait();
+  EXPECT_TRUE(running.was_cancelled());
+  EXPECT_FALSE(queued_job_is_started);
+
+  // an empty handle behaves as a finished job
+  optimize::job_scheduler::job_handle empty;
+  empty.cancel();
+  empty.wait();
+  EXPECT_TRUE(empty.is_finished());
+
+  const auto metrics = scheduler.get_metrics(optimize::job_priority_t::Normal);
+  EXPECT_EQ(metrics.num_submitted_, 2);
+  EXPECT_EQ(metrics.num_completed_, 0);
+  EXPECT_EQ(metrics.num_cancelled_, 2);
+}
+
+TEST(job_scheduler, preempt_low_priority_job) {
+  optimize::job_scheduler scheduler(1, 2);
+
+  // the low priority job runs until it is released
+  std::atomic<bool> is_released(false);
+  std::atomic<unsigned int> num_starts(0);
+  auto low = scheduler.submit(
+      "low", optimize::job_priority_t::Low,
+      [&](const optimize::cancellation_token& token) {
+        ++num_starts;
+        spin_until_released(token, is_released);
+      },
+      true);
+  wait_until_started(num_starts, 1);
+
+  // the high priority jobs preempt it, then it is run again
+  for (unsigned int i = 0; i < 2; ++i) {
+    auto high = scheduler.submit("high", optimize::job_priority_t::High,
+                                 [](const optimize::cancellation_token&) {});
+    high.wait();
+    wait_until_started(num_starts, i + 2);
+  }
+
+  // the job is not preempted more than the limit
+  auto high = scheduler.submit("high", optimize::job_priority_t::High,
+                               [](const optimize::cancellation_token&) {});
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_FALSE(high.is_finished());
+  EXPECT_FALSE(low.is_finished());
+  is_released = true;
+  low.wait();
+  high.wait();
+  EXPECT_FALSE(low.was_cancelled());
+  EXPECT_EQ(num_starts, 3);
+
+  const auto low_metrics = scheduler.get_metrics(optimize::job_priority_t::Low);
+  EXPECT_EQ(low_metrics.num_submitted_, 1);
+  EXPECT_EQ(low_metrics.num_completed_, 1);
+  EXPECT_EQ(low_metrics.num_preempted_, 2);
+  const auto high_metrics =
+      scheduler.get_metrics(optimize::job_priority_t::High);
+  EXPECT_EQ(high_metrics.num_completed_, 3);
+}
+
+TEST(job_scheduler, cancel_jobs_on_destruction) {
+  std::atomic<unsigned int> num_starts(0);
+  std::atomic<bool> is_released(false);
+  std::atomic<bool> running_job_is_cancelled(false);
+  std::atomic<bool> queued_job_is_started(false);
+  {
+    optimize::job_scheduler scheduler(1);
+    scheduler.submit("running", optimize::job_priority_t::Normal,
+                     [&](const optimize::cancellation_token& token) {
+                       ++num_starts;
+                       spin_until_released(token, is_released);
+                       running_job_is_cancelled = token.is_cancelled();
+                     });
+    wait_until_started(num_starts, 1);
+    scheduler.submit("queued", optimize::job_priority_t::High,
+                     [&](const optimize::cancellation_token&) {
+                       queued_job_is_started = true;
+                     });
+  }
+  EXPECT_TRUE(running_job_is_cancelled);
+  EXPECT_FALSE(queued_job_is_started);
+}
+
+TEST(job_scheduler, cancellation_is_deferred_during_commit) {
+  const optimize::cancellation_token token;
+  ASSERT_TRUE(token.begin_commit());
+  token.cancel();
+  EXPECT_FALSE(token.is_cancelled());
+  EXPECT_FALSE(*token.get_force_stop_flag());
+
+  // the deferred cancellation is applied after the commit
+  token.end_commit();
+  EXPECT_TRUE(token.is_cancelled());
+  EXPECT_TRUE(*token.get_force_stop_flag());
+
+  // the result cannot be committed after the cancellation
+  EXPECT_FALSE(token.begin_commit());
+}
+
+TEST(job_scheduler, committed_job_is_not_run_again) {
+  optimize::job_scheduler scheduler(1);
+
+  // the low priority job is preempted while it is committing the result
+  std::atomic<bool> is_released(false);
+  std::atomic<unsigned int> num_starts(0);
+  std::atomic<bool> is_committed(false);
+  auto low = scheduler.submit(
+      "low", optimize::job_priority_t::Low,
+      [&](const optimize::cancellation_token& token) {
+        ++num_starts;
+        if (!token.begin_commit()) {
+          return;
+        }
+        is_committed = true;
+        while (!is_released) {
+          std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+      },
+      true);
+  while (!is_committed) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  auto high = scheduler.submit("high", optimize::job_priority_t::High,
+                               [](const optimize::cancellation_token&) {});
+  is_released = true;
+  low.wait();
+  high.wait();
+
+  // the job has finished without being queued again
+  EXPECT_FALSE(low.was_cancelled());
+  EXPECT_EQ(num_starts, 1);
+  const auto low_metrics = scheduler.get_metrics(optimize::job_priority_t::Low);
+  EXPECT_EQ(low_metrics.num_completed_, 1);
+  EXPECT_EQ(low_metrics.num_preempted_, 0);
+  EXPECT_EQ(low_metrics.num_cancelled_, 0);
+}
+
+TEST(job_scheduler, preempt_job_after_partial_commit) {
+  optimize::job_scheduler scheduler(1);
+
+  // the preemption during the commit is applied when the commit ends
+  std::atomic<bool> is_released(false);
+  std::atomic<unsigned int> num_starts(0);
+  std::atomic<bool> is_committing(false);
+  auto low = scheduler.submit(
+      "low", optimize::job_priority_t::Low,
+      [&](const optimize::cancellation_token& token) {
+        if (0 < num_starts++) {
+          return;
+        }
+        ASSERT_TRUE(token.begin_commit());
+        is_committing = true;
+        while (!is_released) {
+          std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        token.end_commit();
+        spin_until_released(token, is_released);
+      },
+      true);
+  while (!is_committing) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  auto high = scheduler.submit("high", optimize::job_priority_t::High,
+                               [](const optimize::cancellation_token&) {});
+  is_released = true;
+  low.wait();
+  high.wait();
+
+  EXPECT_FALSE(low.was_cancelled());
+  EXPECT_EQ(num_starts, 2);
+  const auto low_metrics = scheduler.get_metrics(optimize::job_priority_t::Low);
+  EXPECT_EQ(low_metrics.num_completed_, 1);
+  EXPECT_EQ(low_metrics.num_preempted_, 1);
+}
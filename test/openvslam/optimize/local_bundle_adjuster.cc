@@ -0,0 +1,99 @@
+#include "openvslam/optimize/local_bundle_adjuster.h"
+
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "helper/scene.h"
+
+using namespace openvslam;
+
+namespace {
+
+// perturb the camera poses except the origin and the landmark positions
+void perturb_map(synthetic_scene& scene) {
+  std::mt19937 mt(1);
+  std::normal_distribution<> rand_trans(0.0, 0.02);
+  std::normal_distribution<> rand_pos(0.0, 0.05);
+  for (const auto& keyfrm : scene.keyfrms_) {
+    if (keyfrm->id_ == 0) {
+      continue;
+    }
+    Mat44_t cam_pose_cw = keyfrm->get_cam_pose();
+    cam_pose_cw.block<3, 1>(0, 3) +=
+        Vec3_t{rand_trans(mt), rand_trans(mt), rand_trans(mt)};
+    keyfrm->set_cam_pose(cam_pose_cw);
+  }
+  for (const auto& lm : scene.lms_) {
+    if (!lm) {
+      continue;
+    }
+    lm->set_pos_in_world(lm->get_pos_in_world() +
+                         Vec3_t{rand_pos(mt), rand_pos(mt), rand_pos(mt)});
+  }
+}
+
+// apply a correction to the whole map as the commit of the loop BA does
+void correct_map(synthetic_scene& scene, const Vec3_t& trans_w) {
+  std::lock_guard<std::mutex> lock(scene.map_db_->mtx_database_);
+  for (const auto& keyfrm : scene.keyfrms_) {
+    Mat44_t cam_pose_cw = keyfrm->get_cam_pose();
+    cam_pose_cw.block<3, 1>(0, 3) -= cam_pose_cw.block<3, 3>(0, 0) * trans_w;
+    keyfrm->set_cam_pose(cam_pose_cw);
+  }
+  for (const auto& lm : scene.lms_) {
+    if (!lm) {
+      continue;
+    }
+    lm->set_pos_in_world(lm->get_pos_in_world() + trans_w);
+  }
+  ++scene.map_db_->correction_epoch_;
+}
+
+}  // unnamed namespace
+
+TEST(local_bundle_adjuster, write_back_result) {
+  synthetic_scene scene(10, 2000);
+  perturb_map(scene);
+  const auto& curr_keyfrm = scene.keyfrms_.at(5);
+  const Mat44_t cam_pose_cw_before = curr_keyfrm->get_cam_pose();
+
+  bool force_stop_flag = false;
+  const optimize::local_bundle_adjuster local_BA;
+  local_BA.optimize(scene.map_db_.get(), curr_keyfrm, &force_stop_flag);
+
+  EXPECT_NE(curr_keyfrm->get_cam_pose(), cam_pose_cw_before);
+}
+
+TEST(local_bundle_adjuster, correction_during_optimization) {
+  synthetic_scene scene(10, 2000);
+  const Vec3_t trans_w{0.0, 1.0, 0.0};
+
+  // the correction is applied before, during or after the local BA, and it is
+  // kept in any case
+  for (unsigned int iter = 0; iter < 5; iter++) {
+    perturb_map(scene);
+    eigen_alloc_vector<Vec3_t> corrected_centers;
+    for (const auto& keyfrm : scene.keyfrms_) {
+      corrected_centers.push_back(keyfrm->get_cam_center() + trans_w);
+    }
+
+    std::thread local_BA_thread([&scene] {
+      bool force_stop_flag = false;
+      const optimize::local_bundle_adjuster local_BA;
+      local_BA.optimize(scene.map_db_.get(), scene.keyfrms_.at(5),
+                        &force_stop_flag);
+    });
+    correct_map(scene, trans_w);
+    local_BA_thread.join();
+
+    // the local BA moves the keyframes by far less than the correction
+    for (unsigned int i = 0; i < scene.keyfrms_.size(); i++) {
+      const Vec3_t cam_center = scene.keyfrms_.at(i)->get_cam_center();
+      EXPECT_LT((cam_center - corrected_centers.at(i)).norm(),
+                0.5 * trans_w.norm());
+    }
+  }
+}
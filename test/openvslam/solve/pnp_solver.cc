@@ -142,3 +142,78 @@ TEST(pnp_solver, with_noise) {
   EXPECT_LT(rot_err, 1e-2);
   EXPECT_LT(trans_err, 1);
 }
+
+TEST(pnp_solver, with_outliers) {
+  // Create landmarks
+  const unsigned int num_landmarks = 200;
+  const auto landmarks = create_random_landmarks_in_space(num_landmarks, 100);
+
+  // Create single-view pose
+  const Mat33_t rot_gt = util::converter::to_rot_mat(
+      97.37 * M_PI / 180 * Vec3_t{9.0, -8.5, 1.1}.normalized());
+  const Vec3_t trans_gt = Vec3_t(-67.5, 84.6, -68.0);
+
+  // Create bearing vectors and replace 40% of them with random directions
+  eigen_alloc_vector<Vec3_t> bearings;
+  create_bearing_vectors(rot_gt, trans_gt, landmarks, bearings);
+  std::mt19937 random_engine(0);
+  std::uniform_real_distribution<double> rand_coord(-1.0, 1.0);
+  std::uniform_int_distribution<unsigned int> rand_inlier_dist(0, 40);
+  std::uniform_int_distribution<unsigned int> rand_outlier_dist(30, 90);
+  std::vector<bool> is_outlier(num_landmarks, false);
+  std::vector<unsigned int> match_dists(num_landmarks);
+  for (unsigned int i = 0; i < num_landmarks; ++i) {
+    is_outlier.at(i) = (i % 5 < 2);
+    if (is_outlier.at(i)) {
+      bearings.at(i) = Vec3_t{rand_coord(random_engine),
+                              rand_coord(random_engine),
+                              rand_coord(random_engine)}
+                           .normalized();
+      match_dists.at(i) = rand_outlier_dist(random_engine);
+    } else {
+      match_dists.at(i) = rand_inlier_dist(random_engine);
+    }
+  }
+
+  // keypts and scale_factor are required of solver
+  // In this test, octave is 0 and scale factor is 1 for each keypoint
+  std::vector<cv::KeyPoint> keypts(num_landmarks, cv::KeyPoint{});
+  const std::vector<float> scale_factor{1};
+
+  // Compute the camera pose twice with the fixed seed
+  const unsigned int max_num_iter = 500;
+  solve::pnp_solver solver_1(bearings, keypts, landmarks, scale_factor, 10,
+                             true, match_dists);
+  solver_1.find_via_ransac(max_num_iter);
+  solve::pnp_solver solver_2(bearings, keypts, landmarks, scale_factor, 10,
+                             true, match_dists);
+  solver_2.find_via_ransac(max_num_iter);
+
+  ASSERT_TRUE(solver_1.solution_is_valid());
+  // the result is reproducible
+  EXPECT_EQ(solver_1.get_num_iterations(), solver_2.get_num_iterations());
+  EXPECT_EQ(solver_1.get_inlier_flags(), solver_2.get_inlier_flags());
+  EXPECT_EQ(solver_1.get_best_cam_pose(), solver_2.get_best_cam_pose());
+  // the loop is terminated after enough inliers are found
+  EXPECT_LT(solver_1.get_num_iterations(), max_num_iter);
+
+  // the inlier flags are in the order of the input matches
+  const auto inlier_flags = solver_1.get_inlier_flags();
+  ASSERT_EQ(inlier_flags.size(), num_landmarks);
+  unsigned int num_wrong_flags = 0;
+  for (unsigned int i = 0; i < num_landmarks; ++i) {
+    if (inlier_flags.at(i) == is_outlier.at(i)) {
+      ++num_wrong_flags;
+    }
+  }
+  EXPECT_LT(num_wrong_flags, 5);
+
+  const auto estimated_pose = solver_1.get_best_cam_pose();
+  const auto rot = estimated_pose.block<3, 3>(0, 0);
+  const auto trans = estimated_pose.block<3, 1>(0, 3);
+  const auto rot_err =
+      util::converter::to_angle_axis(rot_gt * rot.transpose()).norm();
+  const auto trans_err = (trans_gt - trans).norm();
+  EXPECT_LT(rot_err, 1e-4);
+  EXPECT_LT(trans_err, 1e-4);
+}
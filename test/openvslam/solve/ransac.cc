@@ -0,0 +1,165 @@
+#include "openvslam/solve/ransac.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "openvslam/type.h"
+
+using namespace openvslam;
+
+namespace {
+
+// fitting of a 2D line a * x + b * y + c = 0 with the unit normal (a, b)
+class line_problem {
+ public:
+  using model_t = Vec3_t;
+  static constexpr unsigned int min_set_size = 2;
+  struct workspace_t {};
+
+  line_problem(const eigen_alloc_vector<Vec2_t>& pts, const double thr)
+      : pts_(pts), thr_(thr) {}
+
+  unsigned int get_num_data() const { return pts_.size(); }
+
+  bool compute_model(const std::array<unsigned int, min_set_size>& min_set,
+                     workspace_t&, model_t& line) const {
+    const Vec2_t& pt_1 = pts_.at(min_set.at(0));
+    const Vec2_t& pt_2 = pts_.at(min_set.at(1));
+    const Vec2_t dir = pt_2 - pt_1;
+    if (dir.norm() < 1e-12) {
+      return false;
+    }
+    const Vec2_t normal = Vec2_t{-dir(1), dir(0)}.normalized();
+    line << normal, -normal.dot(pt_1);
+    return true;
+  }
+
+  float score_model(const model_t& line, workspace_t&,
+                    std::vector<bool>& is_inlier) const {
+    is_inlier.resize(pts_.size());
+    float score = 0.0;
+    for (unsigned int i = 0; i < pts_.size(); ++i) {
+      const double dist = std::abs(line.head<2>().dot(pts_.at(i)) + line(2));
+      is_inlier.at(i) = dist < thr_;
+      if (is_inlier.at(i)) {
+        score += thr_ - dist;
+      }
+    }
+    return score;
+  }
+
+ private:
+  const eigen_alloc_vector<Vec2_t>& pts_;
+  const double thr_;
+};
+
+constexpr unsigned int line_problem::min_set_size;
+
+// points on the line y = 0.5 * x + 1 with the outliers
+eigen_alloc_vector<Vec2_t> create_points(const unsigned int num_pts,
+                                         const double outlier_ratio,
+                                         std::vector<bool>& is_outlier) {
+  std::mt19937 random_engine(12345);
+  std::uniform_real_distribution<double> dist(-10.0, 10.0);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  eigen_alloc_vector<Vec2_t> pts;
+  is_outlier.clear();
+  for (unsigned int i = 0; i < num_pts; ++i) {
+    const double x = dist(random_engine);
+    if (uniform(random_engine) < outlier_ratio) {
+      pts.emplace_back(Vec2_t{x, dist(random_engine)});
+      is_outlier.push_back(true);
+    } else {
+      pts.emplace_back(Vec2_t{x, 0.5 * x + 1.0});
+      is_outlier.push_back(false);
+    }
+  }
+  return pts;
+}
+
+}  // unnamed namespace
+
+TEST(ransac, fit_line_with_outliers) {
+  std::vector<bool> is_outlier;
+  const auto pts = create_points(300, 0.5, is_outlier);
+  const line_problem problem(pts, 1e-6);
+
+  solve::ransac<line_problem> sac(problem, true);
+  EXPECT_TRUE(sac.run(1000));
+
+  // the line is recovered
+  const Vec3_t line = sac.get_best_model();
+  const Vec3_t expected = Vec3_t{0.5, -1.0, 1.0} / std::sqrt(1.25);
+  EXPECT_LT(std::min((line - expected).norm(), (line + expected).norm()),
+            1e-6);
+
+  // the outliers which lie off the line are rejected
+  const auto& is_inlier = sac.get_inlier_flags();
+  unsigned int num_inliers = 0;
+  for (unsigned int i = 0; i < pts.size(); ++i) {
+    const double residual = std::abs(pts.at(i)(1) - 0.5 * pts.at(i)(0) - 1.0);
+    if (1e-3 < residual) {
+      EXPECT_FALSE(is_inlier.at(i));
+    }
+    if (!is_outlier.at(i)) {
+      EXPECT_TRUE(is_inlier.at(i));
+    }
+    num_inliers += is_inlier.at(i);
+  }
+  EXPECT_EQ(sac.get_num_inliers(), num_inliers);
+
+  // the iterations are terminated adaptively
+  // (about 17 iterations are required with 50% outliers and 99% confidence)
+  EXPECT_LT(sac.get_num_iterations(), 100);
+}
+
+TEST(ransac, terminate_without_outliers) {
+  std::vector<bool> is_outlier;
+  const auto pts = create_points(100, 0.0, is_outlier);
+  const line_problem problem(pts, 1e-6);
+
+  solve::ransac<line_problem> sac(problem, true);
+  EXPECT_TRUE(sac.run(1000));
+  EXPECT_EQ(sac.get_num_inliers(), pts.size());
+  EXPECT_EQ(sac.get_num_iterations(), 1);
+
+  // the iterations are not terminated if the confidence is 1
+  EXPECT_TRUE(sac.run(50, 1.0));
+  EXPECT_EQ(sac.get_num_iterations(), 50);
+}
+
+TEST(ransac, independent_of_num_threads) {
+  std::vector<bool> is_outlier;
+  const auto pts = create_points(500, 0.7, is_outlier);
+  // the inliers have small noise so that the scores of the hypotheses differ
+  auto noisy_pts = pts;
+  std::mt19937 random_engine(54321);
+  std::normal_distribution<double> noise(0.0, 0.01);
+  for (auto& pt : noisy_pts) {
+    pt(1) += noise(random_engine);
+  }
+  const line_problem problem(noisy_pts, 0.03);
+
+  solve::ransac<line_problem> serial_sac(problem, true);
+  EXPECT_TRUE(serial_sac.run(500));
+  for (const unsigned int num_threads : {2, 4, 7}) {
+    solve::ransac<line_problem> parallel_sac(problem, true);
+    EXPECT_TRUE(parallel_sac.run(500, 0.99, num_threads));
+    EXPECT_EQ(parallel_sac.get_num_iterations(),
+              serial_sac.get_num_iterations());
+    EXPECT_EQ(parallel_sac.get_best_score(), serial_sac.get_best_score());
+    EXPECT_EQ(parallel_sac.get_best_model(), serial_sac.get_best_model());
+    EXPECT_EQ(parallel_sac.get_inlier_flags(), serial_sac.get_inlier_flags());
+  }
+}
+
+TEST(ransac, insufficient_data) {
+  const eigen_alloc_vector<Vec2_t> pts{Vec2_t{1.0, 2.0}};
+  const line_problem problem(pts, 1e-6);
+
+  solve::ransac<line_problem> sac(problem, true);
+  EXPECT_FALSE(sac.run(100));
+  EXPECT_EQ(sac.get_num_inliers(), 0);
+  EXPECT_EQ(sac.get_inlier_flags().size(), 1);
+}
@@ -0,0 +1,141 @@
+#include "socket_publisher/data_serializer.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cmath>
+#include <string>
+
+using namespace socket_publisher;
+
+namespace {
+
+// decoder of the client
+std::string base64_decode(const std::string& encoded) {
+  static const std::string base64_chars =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  std::string decoded;
+  unsigned int buffer = 0;
+  int num_bits = 0;
+  for (const char c : encoded) {
+    if (c == '=') {
+      break;
+    }
+    buffer = (buffer << 6) | base64_chars.find(c);
+    num_bits += 6;
+    if (8 <= num_bits) {
+      num_bits -= 8;
+      decoded.push_back(static_cast<char>((buffer >> num_bits) & 0xff));
+    }
+  }
+  return decoded;
+}
+
+std::string base64_encode(const std::string& bytes) {
+  return data_serializer::base64_encode(
+      reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size());
+}
+
+// position which the client decodes from the message
+std::array<double, 3> decode_position(const coordinate_format_t format,
+                                      const double quantization_step,
+                                      const openvslam::Vec3_t& pos,
+                                      const std::array<double, 3>* sent_pos,
+                                      bool& is_quantized) {
+  std::array<long, 3> deltas;
+  const auto encoded_pos = data_serializer::encode_position(
+      format, quantization_step, pos, sent_pos, deltas, is_quantized);
+
+  // the message has the quantized differences or the coordinates
+  std::array<double, 3> decoded_pos;
+  for (int i = 0; i < 3; i++) {
+    if (is_quantized) {
+      EXPECT_LE(std::abs(deltas[i]), 32767);
+      decoded_pos[i] = (*sent_pos)[i] + deltas[i] * quantization_step;
+    } else if (format == coordinate_format_t::Double) {
+      decoded_pos[i] = encoded_pos[i];
+    } else {
+      decoded_pos[i] = static_cast<float>(encoded_pos[i]);
+    }
+  }
+  // the state of the serializer is the same as the client
+  EXPECT_EQ(decoded_pos, encoded_pos);
+  return decoded_pos;
+}
+
+}  // unnamed namespace
+
+TEST(data_serializer, base64_round_trip) {
+  EXPECT_EQ(base64_encode(""), "");
+  EXPECT_EQ(base64_encode("f"), "Zg==");
+  EXPECT_EQ(base64_encode("fo"), "Zm8=");
+  EXPECT_EQ(base64_encode("foo"), "Zm9v");
+  EXPECT_EQ(base64_encode("foob"), "Zm9vYg==");
+
+  // all of the byte values with all of the lengths of the padding
+  std::string bytes;
+  for (unsigned int i = 0; i < 256; i++) {
+    bytes.push_back(static_cast<char>(i));
+  }
+  for (unsigned int len = 253; len <= 256; len++) {
+    const auto input = bytes.substr(0, len);
+    const auto encoded = base64_encode(input);
+    EXPECT_EQ(encoded.size(), 4 * ((len + 2) / 3));
+    EXPECT_EQ(base64_decode(encoded), input);
+  }
+}
+
+TEST(data_serializer, float32_round_trip) {
+  const openvslam::Vec3_t pos{1.0 / 3.0, -12345.678901, 1e-7};
+  bool is_quantized = true;
+  const auto decoded_pos = decode_position(coordinate_format_t::Float32, 0.001,
+                                           pos, nullptr, is_quantized);
+  EXPECT_FALSE(is_quantized);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(decoded_pos[i], static_cast<float>(pos(i)));
+  }
+
+  // the sent position is not used
+  const std::array<double, 3> sent_pos{{0.0, 0.0, 0.0}};
+  EXPECT_EQ(decode_position(coordinate_format_t::Float32, 0.001, pos,
+                            &sent_pos, is_quantized),
+            decoded_pos);
+  EXPECT_FALSE(is_quantized);
+}
+
+TEST(data_serializer, int16_delta_round_trip) {
+  const double quantization_step = 0.001;
+
+  // the first position is sent as float32
+  openvslam::Vec3_t pos{1.0 / 3.0, -2.5, 10.0};
+  bool is_quantized = true;
+  auto client_pos = decode_position(coordinate_format_t::Int16,
+                                    quantization_step, pos, nullptr,
+                                    is_quantized);
+  EXPECT_FALSE(is_quantized);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(client_pos[i], static_cast<float>(pos(i)));
+  }
+
+  // the small movements are sent as the quantized differences from the
+  // position which the client holds, so that the errors are not accumulated
+  for (unsigned int iter = 0; iter < 1000; iter++) {
+    pos += openvslam::Vec3_t{0.00037, -0.0123, 0.0000049};
+    client_pos = decode_position(coordinate_format_t::Int16, quantization_step,
+                                 pos, &client_pos, is_quantized);
+    EXPECT_TRUE(is_quantized);
+    for (int i = 0; i < 3; i++) {
+      EXPECT_NEAR(client_pos[i], pos(i), quantization_step / 2.0 + 1e-9);
+    }
+  }
+
+  // the large movement is sent as float32
+  pos(0) += 40000.0 * quantization_step;
+  client_pos = decode_position(coordinate_format_t::Int16, quantization_step,
+                               pos, &client_pos, is_quantized);
+  EXPECT_FALSE(is_quantized);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(client_pos[i], static_cast<float>(pos(i)));
+  }
+}